@@ -76,6 +76,7 @@ HEADERS += include/SApp.h \
            include/core/SDefine.h \
            include/core/hostmsg.h \
            include/core/SDropTargetDispatcher.h \
+           include/core/SHitTestIndex.h \
            include/core/SHostDialog.h \
            include/core/SHostWnd.h \
            include/core/SimpleWnd.h \
@@ -104,6 +105,7 @@ HEADERS += include/SApp.h \
            include/helper/DragWnd.h \
            include/helper/MemDC.h \
            include/helper/MenuWndHook.h \
+           include/helper/SAtomTable.h \
            include/helper/SAttrCracker.h \
            include/helper/SMenu.h \
            include/helper/SplitString.h \
@@ -111,6 +113,7 @@ HEADERS += include/SApp.h \
            include/helper/SResID.h \
            include/helper/STime.h \
            include/helper/STimerEx.h \
+           include/helper/STimelineScheduler.h \
            include/helper/SScriptTimer.h \
            include/helper/SToolTip.h \
            include/helper/swndspy.h \
@@ -156,12 +159,15 @@ HEADERS += include/SApp.h \
            include/res.mgr/SStylePool.h \
            include/res.mgr/SNamedValue.h \
            include/res.mgr/SDpiAwareFont.h \
+           include/res.mgr/SXmlDocCache.h \
+           include/res.mgr/SResPreloader.h \
            src/activex/SAxContainer.h \
            src/activex/SAxUtil.h \
            src/updatelayeredwindow/SUpdateLayeredWindow.h \
            include/activex/flash10t.tlh \
            include/activex/flash10t.tli \
-           include/animator/SInterpolatorImpl.h
+           include/animator/SInterpolatorImpl.h \
+           include/animator/SInterpolatorTable.h
            
 SOURCES += src/SApp.cpp \
            src/activex/SAxContainer.cpp \
@@ -197,6 +203,7 @@ SOURCES += src/SApp.cpp \
            src/core/Accelerator.cpp \
            src/core/FocusManager.cpp \
            src/core/SDropTargetDispatcher.cpp \
+           src/core/SHitTestIndex.cpp \
            src/core/SHostDialog.cpp \
            src/core/shostwnd.cpp \
            src/core/SimpleWnd.cpp \
@@ -221,6 +228,8 @@ SOURCES += src/SApp.cpp \
            src/helper/MenuWndHook.cpp \
            src/helper/SMenu.cpp \
            src/helper/STimerEx.cpp \
+           src/helper/STimelineScheduler.cpp \
+           src/helper/SAtomTable.cpp \
            src/helper/SScriptTimer.cpp \
            src/helper/stooltip.cpp \
            src/helper/AppDir.cpp \
@@ -240,6 +249,9 @@ SOURCES += src/SApp.cpp \
            src/res.mgr/SStylePool.cpp \
            src/res.mgr/SNamedValue.cpp \
            src/res.mgr/SDpiAwareFont.cpp \
+           src/res.mgr/SXmlDocCache.cpp \
+           src/res.mgr/SResPreloader.cpp \
            src/updatelayeredwindow/SUpdateLayeredWindow.cpp \
-           src/animator/SInterpolatorImpl.cpp
+           src/animator/SInterpolatorImpl.cpp \
+           src/animator/SInterpolatorTable.cpp
 
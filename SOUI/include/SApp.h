@@ -51,6 +51,27 @@
 namespace SOUI
 {
 
+/**
+ * @class      TplSWindowFactory
+ * @brief      窗口类工厂，创建窗口时标记重载了SwndFromPoint的窗口类
+ */
+template<class T>
+class TplSWindowFactory : public TplSObjectFactory<T>
+{
+public:
+    virtual IObject* NewObject() const
+    {
+        T *pWnd = new T;
+        pWnd->m_bCustomHitTest = !T::IsDefaultHitTest(&T::SwndFromPoint);
+        return pWnd;
+    }
+
+    virtual TplSWindowFactory* Clone() const
+    {
+        return new TplSWindowFactory<T>();
+    }
+};
+
 interface IMsgLoopFactory : public IObjRef
 {
     virtual SMessageLoop * CreateMsgLoop() = 0;
@@ -155,6 +176,17 @@ public:
      */
     BOOL LoadXmlDocment(pugi::xml_document & xmlDoc,const SStringT & strXmlTypeName);
 
+    /**
+     * LoadSharedXmlDocment
+     * @brief    从资源中加载一个共享的只读XML Document
+     * @param    LPCTSTR pszXmlName --  XML文件在资源中的name
+     * @param    LPCTSTR pszType --  XML文件在资源中的type
+     * @return   SCachedXmlDoc * -- 文档对象，使用完成后调用Release，加载失败返回NULL
+     *
+     * Describe  文档来自已解析XML文档的缓存，不需要复制，调用者不能修改文档。不支持file类型
+     */
+    SCachedXmlDoc * LoadSharedXmlDocment(LPCTSTR pszXmlName ,LPCTSTR pszType);
+
     /**
      * GetRenderFactory
      * @brief    获得当前的渲染模块
@@ -271,7 +303,7 @@ public:
     bool RegisterWindowClass()
     {
 		if (T::GetClassType() != Window) return false;
-        return TplRegisterFactory<T>();
+        return RegisterFactory(TplSWindowFactory<T>());
     }
     
     template<class T>
@@ -305,6 +337,7 @@ protected:
     void _CreateSingletons();
     void _DestroySingletons();
     BOOL _LoadXmlDocment(LPCTSTR pszXmlName ,LPCTSTR pszType ,pugi::xml_document & xmlDoc,IResProvider *pResProvider = NULL);
+    SCachedXmlDoc * _LoadSharedXmlDocment(LPCTSTR pszXmlName ,LPCTSTR pszType ,IResProvider *pResProvider);
     
     CAutoRefPtr<IRealWndHandler>    m_pRealWndHandler;
     CAutoRefPtr<IScriptFactory>     m_pScriptFactory;
@@ -0,0 +1,141 @@
+﻿#pragma once
+
+#include "interface/sinterpolator-i.h"
+#include <unknown/obj-ref-impl.hpp>
+
+namespace SOUI
+{
+	/**
+	* @class      SInterpolatorTable
+	* @brief      插值器查找表
+	*
+	* Describe    在[0,1]上对插值器均匀采样，求值时在相邻采样点之间线性插值，避免每次调用pow/sin/cos。
+	*             输入限制在[0,1]之间；插值器属性改变后需要重新Build。
+	*/
+	class SOUI_EXP SInterpolatorTable
+	{
+	public:
+		//光滑曲线的误差与采样数的平方成反比；有折点的曲线(如Bounce)误差约为折点两侧斜率差/(4*采样数)
+		enum PRECISION{
+			PREC_LOW = 64,		/**<内置光滑插值器最大误差约1e-3*/
+			PREC_MEDIUM = 256,	/**<内置光滑插值器最大误差约1e-4*/
+			PREC_HIGH = 1024,	/**<内置光滑插值器最大误差约5e-6*/
+			PREC_ULTRA = 4096,	/**<Bounce最大误差约7e-4*/
+		};
+
+		SInterpolatorTable();
+
+		/**
+		* Build
+		* @brief    对插值器采样生成查找表
+		* @param    IInterpolator * pInterpolator --  插值器
+		* @param    int nSamples --  采样区间数，可以使用PRECISION中的值
+		* @return   BOOL
+		*/
+		BOOL Build(IInterpolator *pInterpolator,int nSamples = PREC_MEDIUM);
+
+		int GetSamples() const {return m_nSamples;}
+
+		float Lookup(float input) const;
+
+		/**
+		* Evaluate
+		* @brief    批量求值，支持SSE2时每次计算4个值
+		* @param    const float * pInput --  输入进度
+		* @param    float * pOutput --  输出值，可以与pInput相同
+		* @param    int nCount --  数量
+		* @return   void
+		*/
+		void Evaluate(const float *pInput,float *pOutput,int nCount) const;
+
+		/**
+		* GetMaxError
+		* @brief    计算查找表与插值器解析值的最大误差
+		* @param    IInterpolator * pInterpolator --  生成查找表的插值器
+		* @param    int nProbes --  在[0,1]上均匀取点的数量
+		* @return   float
+		*/
+		float GetMaxError(IInterpolator *pInterpolator,int nProbes = 10000) const;
+
+	protected:
+		SArray<float>	m_arrSamples;	/**<nSamples+2个值，最后一个重复终点值，避免在1.0处越界*/
+		int				m_nSamples;
+	};
+
+	/**
+	* @class      SAnimationBatch
+	* @brief      动画批量求值器
+	*
+	* Describe    按插值器对动画分组，每组共享一个查找表，每帧对同组动画批量计算进度和插值结果，
+	*             代替每个动画各自调用getInterpolation。时间单位由调用者决定，通常为ms。
+	*/
+	class SOUI_EXP SAnimationBatch
+	{
+	public:
+		SAnimationBatch(int nSamples = SInterpolatorTable::PREC_MEDIUM);
+		~SAnimationBatch();
+
+		/**
+		* Add
+		* @brief    添加一个动画
+		* @param    IInterpolator * pInterpolator --  插值器，批量求值器会持有它的引用
+		* @param    DWORD dwStart --  开始时间
+		* @param    DWORD dwDuration --  持续时间
+		* @return   int -- 动画ID，失败返回-1
+		*/
+		int Add(IInterpolator *pInterpolator,DWORD dwStart,DWORD dwDuration);
+
+		BOOL Remove(int nID);
+
+		void RemoveAll();
+
+		/**
+		* Evaluate
+		* @brief    计算所有动画在指定时刻的值
+		* @param    DWORD dwNow --  当前时间
+		* @return   int -- 还没有结束的动画数量
+		*/
+		int Evaluate(DWORD dwNow);
+
+		//获取最近一次Evaluate的结果
+		float GetValue(int nID) const;
+
+		//最近一次Evaluate时动画是否已经结束
+		BOOL IsFinished(int nID) const;
+
+		int GetCount() const {return m_nCount;}
+
+		//修改查找表精度，已经生成的查找表会重新生成
+		void SetPrecision(int nSamples);
+
+		//插值器属性改变后调用，重新生成它的查找表
+		void Invalidate(IInterpolator *pInterpolator);
+
+	protected:
+		struct GROUP
+		{
+			CAutoRefPtr<IInterpolator>	pInterpolator;	/**<持有引用，同时作为m_mapGroups的键*/
+			SInterpolatorTable			table;
+			SArray<int>					arrID;
+			SArray<DWORD>				arrStart;
+			SArray<DWORD>				arrDuration;
+			SArray<float>				arrScale;	/**<1/duration*/
+			SArray<float>				arrValue;	/**<先保存进度，再原地替换为插值结果*/
+		};
+
+		struct ITEMPOS
+		{
+			GROUP *pGroup;	/**<NULL表示ID空闲*/
+			int		iItem;
+		};
+
+		GROUP * _GetGroup(IInterpolator *pInterpolator);
+
+		SMap<IInterpolator*,GROUP*>	m_mapGroups;	/**<键为GROUP::pInterpolator，与组同生命周期*/
+		SArray<ITEMPOS>				m_arrItems;
+		SArray<int>					m_arrFreeID;
+		int							m_nCount;
+		int							m_nSamples;
+		DWORD						m_dwNow;	/**<最近一次Evaluate的时间*/
+	};
+}
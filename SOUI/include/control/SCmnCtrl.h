@@ -465,7 +465,6 @@ protected:
     int           m_iCurFrame;    /**< 当前帧 */
     BOOL          m_bAutoStart;   /**< 是否自动启动 */
     BOOL          m_bPlaying;     /**< 是否运行中 */
-    int           m_iTimeFrame;   /**< OnNextFrame的执行次数 */
 	int			  m_nRepeat;	  /**< 播放循环次数,-1代表无限循环 */
 	int			  m_iRepeat;	  /**< 当前播放循环轮次 */
 };
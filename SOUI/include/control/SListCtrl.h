@@ -94,6 +94,50 @@ namespace SOUI
         BOOL    checked;
     } DXLVITEM;
 
+    /** 
+    * @class     SLvTextArena
+    * @brief     列表的文本存储区
+    *
+    * Describe   每列的子项文本连续保存在若干大块内存中，代替每个子项单独分配的字符串。
+    *            已分配的文本地址在RemoveAll之前保持不变，不再使用的文本只记录浪费的空间，由SListCtrl在浪费过多时整理。
+    */
+    class SOUI_EXP SLvTextArena
+    {
+    public:
+        SLvTextArena();
+        ~SLvTextArena();
+
+        /**
+        * Alloc
+        * @brief    复制一个字符串到存储区
+        * @param    LPCTSTR pszText --  字符串，NULL作为空字符串处理
+        * @param    int nLen --  字符数，-1表示自动计算
+        * @return   LPTSTR -- 以0结尾的字符串，内存不足时返回NULL
+        */
+        LPTSTR Alloc(LPCTSTR pszText,int nLen=-1);
+
+        //标记长度为nLen的字符串不再使用
+        void Free(int nLen);
+
+        //保证后续分配nChars个字符(含结尾0)不需要申请新的内存块
+        void Reserve(size_t nChars);
+
+        //释放全部内存块，之前分配的字符串全部失效
+        void RemoveAll();
+
+        size_t GetCapacity() const {return m_nCapacity;}    /**<已申请的字符数*/
+        size_t GetUsed() const {return m_nUsed;}            /**<已分配的字符数，包括不再使用的字符*/
+        size_t GetWasted() const {return m_nWasted;}        /**<不再使用的字符数*/
+
+    protected:
+        SArray<LPTSTR>  m_arrBlocks;
+        LPTSTR          m_pCur;     /**<当前内存块中的空闲位置*/
+        size_t          m_nLeft;    /**<当前内存块中的空闲字符数*/
+        size_t          m_nCapacity;
+        size_t          m_nUsed;
+        size_t          m_nWasted;
+    };
+
     //////////////////////////////////////////////////////////////////////////
     //  SListCtrl
     class SOUI_EXP SListCtrl : public SPanel
@@ -138,6 +182,28 @@ namespace SOUI
         */
         int             InsertItem(int nItem, LPCTSTR pszText, int nImage=-1);
         /**
+        * SListCtrl::InsertItems
+        * @brief    批量插入条目
+        * @param    int nItem -- 插入位置，-1表示插入到最后
+        * @param    int nItems -- 条目数
+        * @param    const LPCTSTR * ppszTexts -- 按行保存的nItems*nCols个子项文本，可以为NULL，元素为NULL的子项不设置文本
+        * @param    int nCols -- 每行的子项文本数，不能超过列数
+        * @param    int nImage -- 第一列的图标
+        * @return   int -- 第一个条目的索引，失败返回-1
+        *
+        * Describe  所有条目插入后只更新一次滚动条并重绘一次
+        */
+        int             InsertItems(int nItem, int nItems, const LPCTSTR *ppszTexts, int nCols, int nImage=-1);
+        /**
+        * SListCtrl::ReserveItems
+        * @brief    预先分配条目及文本的空间
+        * @param    int nItems -- 条目总数
+        * @param    int nCharsPerSubItem -- 每个子项的平均字符数，用于预先分配文本空间
+        *
+        * Describe  只分配空间，不改变条目数
+        */
+        void            ReserveItems(int nItems, int nCharsPerSubItem=0);
+        /**
         * SListCtrl::SetItemData
         * @brief    设置附加数据
         * @param    int nItem -- 索引
@@ -514,6 +580,42 @@ namespace SOUI
         */
         void            UpdateScrollBar();
         /**
+        * SListCtrl::_GetTextArena
+        * @brief    获取子项文本的存储区
+        * @param    int iSubItem -- 子项索引
+        * @return   SLvTextArena *
+        *
+        * Describe  表头可以在XML中定义，存储区在使用时创建
+        */
+        SLvTextArena *  _GetTextArena(int iSubItem);
+        /**
+        * SListCtrl::_SetSubItemText
+        * @brief    设置子项文本
+        * @param    DXLVSUBITEM & lvsi -- 子项
+        * @param    int iSubItem -- 子项索引
+        * @param    LPCTSTR pszText -- 文本
+        *
+        * Describe  不刷新界面
+        */
+        void            _SetSubItemText(DXLVSUBITEM & lvsi, int iSubItem, LPCTSTR pszText);
+        /**
+        * SListCtrl::_FreeSubItemText
+        * @brief    释放子项文本
+        * @param    DXLVSUBITEM & lvsi -- 子项
+        * @param    int iSubItem -- 子项索引
+        *
+        * Describe  不整理存储区
+        */
+        void            _FreeSubItemText(DXLVSUBITEM & lvsi, int iSubItem);
+        /**
+        * SListCtrl::_CompactTextArena
+        * @brief    不再使用的文本过多时整理存储区
+        * @param    int iSubItem -- 子项索引
+        *
+        * Describe  将使用中的文本复制到新的存储区并更新子项的文本指针
+        */
+        void            _CompactTextArena(int iSubItem);
+        /**
         * SListCtrl::UpdateHeaderCtrl
         * @brief    更新列表头控件
         *
@@ -552,6 +654,7 @@ namespace SOUI
 
         SHeaderCtrl*  m_pHeader;  /**< 列表头控件 */
         ArrLvItem       m_arrItems;  /**< */
+        SArray<SLvTextArena*> m_arrTextArenas;  /**< 按子项索引保存的文本存储区 */
         CPoint          m_ptOrigin;  /**< */
 
     protected:
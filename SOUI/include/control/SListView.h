@@ -2,6 +2,7 @@
 
 #include "core/Swnd.h"
 #include "core/SItemPanel.h"
+#include "core/SMsgLoop.h"
 #include "interface/Adapter-i.h"
 #include "interface/LvItemLocator-i.h"
 namespace SOUI
@@ -9,6 +10,7 @@ namespace SOUI
     
     class SOUI_EXP SListView : public SPanel
         , protected IItemContainer
+        , protected IIdleHandler
     {
         SOUI_CLASS_NAME(SListView,L"listview")
 
@@ -34,11 +36,25 @@ namespace SOUI
         int  GetSel()const{return m_iSelItem;}
         
         SItemPanel * HitTest(CPoint & pt);
+
+        /**
+        * PrewarmItemPanels
+        * @brief    按滚动速度预先创建即将显示的列表项，放入对应样式的回收站
+        * @param    DWORD dwTimeBudget --  最多占用的时间(ms)
+        * @return   BOOL -- TRUE:还有需要预创建的列表项
+        * Describe  prewarm属性为1时在消息循环空闲时自动调用，每次最多占用8ms，没完成时在下一次空闲时继续
+        */
+        BOOL PrewarmItemPanels(DWORD dwTimeBudget);
     protected:
         virtual void OnItemSetCapture(SItemPanel *pItem,BOOL bCapture);
         virtual BOOL OnItemGetRect(SItemPanel *pItem,CRect &rcItem);
         virtual BOOL IsItemRedrawDelay();
         virtual void OnItemRequestRelayout(SItemPanel *pItem);
+
+    protected:
+        virtual BOOL OnIdle();
+
+        HRESULT OnAttrPrewarm(const SStringW & strValue,BOOL bLoading);
         
     protected:
         void onDataSetChanged();
@@ -65,9 +81,14 @@ namespace SOUI
         void UpdateScrollBar();
         void RedrawItem(SItemPanel *pItem);
         SItemPanel * GetItemPanel(int iItem);
+        SItemPanel * CreateItemPanel();
+        //设置列表项的索引、状态、数据并布局，bMeasure为FALSE时不测量不定高度的列表项
+        void BindItemPanel(SItemPanel *pItem,int iItem,DWORD dwState,BOOL bMeasure,CRect &rcItem);
         
         void UpdateVisibleItems();
+        void UpdateScrollSpeed(int nDelta);
         
+        int  OnCreate(LPVOID);
         void OnPaint(IRenderTarget *pRT);
         void OnSize(UINT nType, CSize size);
         void OnDestroy();
@@ -86,6 +107,7 @@ namespace SOUI
         void OnSetFocus(SWND wndOld);
 
         SOUI_MSG_MAP_BEGIN()
+            MSG_WM_CREATE(OnCreate)
             MSG_WM_PAINT_EX(OnPaint)
             MSG_WM_SIZE(OnSize)
             MSG_WM_DESTROY(OnDestroy)
@@ -103,6 +125,8 @@ namespace SOUI
             ATTR_SKIN(L"dividerSkin",m_pSkinDivider,TRUE)
             ATTR_LAYOUTSIZE(L"dividerSize",m_nDividerSize,FALSE)
             ATTR_INT(L"wantTab",m_bWantTab,FALSE)
+            ATTR_CUSTOM(L"prewarm",OnAttrPrewarm)
+            ATTR_INT(L"prewarmTime",m_nPrewarmTime,FALSE)
         SOUI_ATTRS_END()
 	protected:
         CAutoRefPtr<ILvAdapter>           m_adapter;
@@ -128,5 +152,10 @@ namespace SOUI
         ISkinObj*                       m_pSkinDivider;
         SLayoutSize                     m_nDividerSize;
         BOOL                            m_bWantTab;
+
+        BOOL                            m_bPrewarm;     //空闲时预创建列表项
+        int                             m_nPrewarmTime; //按当前滚动速度预创建多少ms内将要显示的列表项
+        float                           m_fScrollSpeed; //最近的滚动速度，像素/ms，向下为正
+        DWORD                           m_dwLastScroll; //上一次滚动的时间
     };
 }
\ No newline at end of file
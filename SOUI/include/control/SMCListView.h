@@ -17,6 +17,7 @@
 
 namespace SOUI
 {
+    class SMcSortJob;
 
     //////////////////////////////////////////////////////////////////////////
     //  SMCListView
@@ -77,6 +78,12 @@ namespace SOUI
         int  GetSel()const{return m_iSelItem;}
         SItemPanel * HitTest(CPoint & pt);
 
+        //是否正在工作线程中排序
+        BOOL IsSorting() const {return m_pSortJob!=NULL;}
+
+        //放弃正在进行的异步排序，Adapter修改数据前需要调用
+        void CancelSort();
+
     protected:
         virtual void OnItemSetCapture(SItemPanel *pItem,BOOL bCapture);
         virtual BOOL OnItemGetRect(SItemPanel *pItem,CRect &rcItem);
@@ -123,6 +130,7 @@ namespace SOUI
         BOOL OnMouseWheel(UINT nFlags, short zDelta, CPoint pt);
         void OnKillFocus(SWND wndFocus);
         void OnSetFocus(SWND wndOld);
+        void OnTimer(char cTimerID);
 
         SOUI_MSG_MAP_BEGIN()
             MSG_WM_PAINT_EX(OnPaint)
@@ -133,6 +141,7 @@ namespace SOUI
             MSG_WM_KEYDOWN(OnKeyDown)
             MSG_WM_SETFOCUS_EX(OnSetFocus)
             MSG_WM_KILLFOCUS_EX(OnKillFocus)
+            MSG_WM_TIMER_EX(OnTimer)
             MESSAGE_RANGE_HANDLER_EX(WM_MOUSEFIRST,WM_MOUSELAST,OnMouseEvent)
             MESSAGE_RANGE_HANDLER_EX(WM_KEYFIRST,WM_KEYLAST,OnKeyEvent)
             MESSAGE_RANGE_HANDLER_EX(WM_IME_STARTCOMPOSITION,WM_IME_KEYLAST,OnKeyEvent)
@@ -169,6 +178,7 @@ namespace SOUI
         SLayoutSize                     m_nDividerSize;
         BOOL                            m_bWantTab;
         BOOL                            m_bDatasetInvalidated;
+        SMcSortJob *                    m_pSortJob;//正在进行的异步排序
     protected:
 
         /**
@@ -196,6 +206,12 @@ namespace SOUI
         */
         bool            OnHeaderSwap(EventArgs *pEvt);
 
+        //启动异步排序，行数较少时直接排序，完成后按pOrders及pstFlags更新表头的排序状态
+        void            StartSort(const int *pOrders,const SHDSORTFLAG *pstFlags,int nCols);
+
+        //排序完成，按排序结果更新数据
+        void            OnSortDone(SMcSortJob *pJob);
+
         /**
         * SMCListView::GetListRect
         * @brief    获取list位置
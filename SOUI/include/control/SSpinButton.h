@@ -62,7 +62,6 @@ protected:
 	SWindow*							m_pBuddy;
 
 	bool									m_bFirst;
-	int										m_iNextTime;
 };
 
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SHitTestIndex.h
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2018/06/15
+*
+* Describe    窗口命中测试的空间索引
+*/
+
+#pragma once
+
+namespace SOUI
+{
+    class SWindow;
+
+    /**
+    * @class      SHitTestIndex
+    * @brief      窗口命中测试的空间索引
+    *
+    * Describe    将窗口矩形登记到均匀网格中，命中测试时只检查点所在网格中的窗口，
+    *             再按zorder从高到低验证窗口到根窗口的父窗口链，结果与SWindow::SwndFromPoint的递归查找一致。
+    *             窗口的可见性在查询时检查，因此显示/隐藏窗口不需要更新索引。
+    *             bOnlyText为TRUE，或者点所在网格中有重载了SwndFromPoint的窗口(HasCustomHitTest)时，
+    *             改用根窗口的递归查找，保证结果一致。
+    */
+    class SOUI_EXP SHitTestIndex
+    {
+    public:
+        SHitTestIndex(SWindow *pRoot,int nCellSize = 64);
+
+        ~SHitTestIndex();
+
+        //标记索引失效，下次查询时重建
+        void MarkDirty() {m_bDirty = TRUE;}
+
+        //窗口矩形改变后更新该窗口在索引中的位置
+        void UpdateWindow(SWindow *pWnd);
+
+        //登记一个窗口分枝
+        void UpdateTree(SWindow *pWnd);
+
+        //查询点所在的窗口，调用前必须保证窗口树的zorder已经更新
+        SWND SwndFromPoint(const CPoint & pt,BOOL bOnlyText = FALSE);
+
+    protected:
+        void Rebuild();
+
+        void _AddWindow(SWindow *pWnd);
+
+        void _RemoveWindow(SWND swnd,const CRect & rc);
+
+        //获取矩形覆盖的网格范围，返回FALSE表示矩形不在网格内
+        BOOL _GetCellRange(const CRect & rc,CRect & rcCell) const;
+
+        //检查窗口及其父窗口链是否满足递归查找的条件
+        BOOL _IsHitCandidate(SWindow *pWnd,const CPoint & pt) const;
+
+        SWindow *           m_pRoot;
+        int                 m_nCellSize;
+        CRect               m_rcGrid;       /**<网格覆盖的区域，即根窗口矩形*/
+        int                 m_nCols;
+        int                 m_nRows;
+        SArray<SWND> *      m_pCells;
+        SMap<SWND,CRect>    m_mapWndRect;   /**<已登记的窗口矩形*/
+        BOOL                m_bDirty;
+        size_t              m_nDeadWnd;     /**<查询时发现的已销毁窗口数*/
+    };
+
+}//namespace SOUI
@@ -87,6 +87,8 @@ namespace SOUI
             ATTR_ICON(L"bigIcon",m_hAppIconBig,FALSE)
             ATTR_UINT(L"alpha",m_byAlpha,FALSE)
             ATTR_INT(L"allowSpy",m_bAllowSpy,FALSE)
+            ATTR_UINT(L"fps",m_nFps,FALSE)
+            ATTR_INT(L"hitTestIndex",m_bHitTestIndex,FALSE)
             ATTR_INT(L"appMainWnd",m_byWndType,FALSE)
             ATTR_ENUM_BEGIN(L"wndType",DWORD,FALSE)
                 ATTR_ENUM_VALUE(L"undefine",WT_UNDEFINE)
@@ -110,9 +112,11 @@ namespace SOUI
         DWORD m_bTranslucent:1;     //窗口的半透明属性
         DWORD m_bAllowSpy:1;        //允许spy
         DWORD m_bSendWheel2Hover:1; //将滚轮消息发送到hover窗口
+        DWORD m_bHitTestIndex:1;    //使用空间索引做命中测试，适合窗口数量很多的界面
 
         DWORD m_dwStyle;
         DWORD m_dwExStyle;
+        UINT  m_nFps;               //动画的目标帧率
 
         SStringW m_strTrCtx;     //在语言翻译时作为context使用
         STrText  m_strTitle;
@@ -120,6 +124,18 @@ namespace SOUI
         HICON   m_hAppIconBig;
     };
 
+    /**
+    * @struct     SPaintStats
+    * @brief      最近一次绘制的统计数据
+    */
+    struct SPaintStats
+    {
+        DWORD nRenumbered;      /**<zorder重新编号的窗口数*/
+        DWORD nZorderRebuilds;  /**<zorder全量重建的次数*/
+        DWORD nUpdateSwnd;      /**<刷新的非背景混合窗口数*/
+        DWORD nUpdateMerged;    /**<被合并的重复刷新请求数*/
+    };
+
 class SOUI_EXP SHostWnd
     : public SwndContainerImpl
     , public CSimpleWnd
@@ -150,8 +166,15 @@ protected:
     CAutoRefPtr<SSkinPool>  m_privateSkinPool;  /**<局部skin pool*/
 
     SList<SWND>             m_lstUpdateSwnd;    /**<等待刷新的非背景混合窗口列表*/
+    SMap<SWND,BOOL>         m_mapUpdateSwnd;    /**<m_lstUpdateSwnd的索引，用于去重*/
+    SPaintStats             m_paintStats;       /**<最近一次绘制的统计数据*/
+    SZorderStats            m_zorderStatsMark;  /**<上一次绘制时的zorder统计，用于计算增量*/
+    DWORD                   m_nUpdateMerged;    /**<两次绘制之间被合并的刷新请求数*/
     SList<RECT>             m_lstUpdatedRect;   /**<更新的脏矩形列表*/
     BOOL                    m_bRending;         /**<正在渲染过程中*/
+    BOOL                    m_bFrameBatching;   /**<正在执行动画帧，合并帧内的刷新请求*/
+    BOOL                    m_bFramePending;    /**<动画帧内有等待提交的刷新请求*/
+    UINT                    m_nFrameDelay;      /**<当前动画帧定时器的间隔，0表示定时器已停止*/
     
     MSG                     m_msgMouse;         /**<上一次鼠标按下消息*/
     
@@ -194,9 +217,15 @@ public:
 	IToolTip * GetToolTip() const {
 		return m_pTipCtrl;
 	}
+
+	const SPaintStats & GetPaintStats() const {
+		return m_paintStats;
+	}
 protected://辅助函数
     BOOL _InitFromXml(pugi::xml_node xmlNode,int nWidth,int nHeight);
     void _Redraw();
+    void _InvalidateHost(const CRect &rc);
+    void _ScheduleNextFrame();
     void _UpdateNonBkgndBlendSwnd();
     void _DrawCaret(CPoint pt,BOOL bErase);
     void _RestoreClickState();
@@ -314,6 +343,8 @@ protected:// IContainer
 
     virtual BOOL UnregisterTimelineHandler(ITimelineHandler *pHandler);
 
+    virtual BOOL ScheduleTimelineHandler(ITimelineHandler *pHandler,UINT nDelay);
+
     virtual SMessageLoop * GetMsgLoop();
 
     virtual IScriptModule * GetScriptModule();
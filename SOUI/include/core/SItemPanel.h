@@ -72,11 +72,22 @@ public://SwndContainerImpl
     virtual IScriptModule * GetScriptModule();
 
 	virtual int GetScale() const;
+
+    virtual BOOL RegisterTimelineHandler(ITimelineHandler *pHandler);
+
+    virtual BOOL UnregisterTimelineHandler(ITimelineHandler *pHandler);
+
+    virtual BOOL ScheduleTimelineHandler(ITimelineHandler *pHandler,UINT nDelay);
+
+public://ITimelineHandler
+    virtual void OnNextFrame();
 public://SWindow
     virtual void ModifyItemState(DWORD dwStateAdd, DWORD dwStateRemove);
 
     virtual SWND SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText);
 
+    virtual BOOL HasCustomHitTest() const {return TRUE;}
+
     virtual void Draw(IRenderTarget *pRT,const CRect & rc);
 
     virtual void SetSkin(ISkinObj *pSkin);
@@ -98,6 +109,10 @@ public://SWindow
 
     void OnShowWindow(BOOL bShow, UINT nStatus);
     void OnDestroy();
+protected:
+    //只有表项内有活动的动画时才在宿主容器中注册，并同步下一帧的触发时间
+    void _SyncTimeline();
+public:
     SOUI_MSG_MAP_BEGIN()
         MSG_WM_DESTROY(OnDestroy)
         MSG_WM_SHOWWINDOW(OnShowWindow)
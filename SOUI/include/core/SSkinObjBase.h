@@ -37,6 +37,7 @@ namespace SOUI
 
         virtual void Draw(IRenderTarget *pRT, LPCRECT rcDraw, DWORD dwState,BYTE byAlpha)
         {
+            SPROFILE_SCOPE_ARG("ISkinObj::Draw",m_strName.IsEmpty()?GetObjectClass():(LPCWSTR)m_strName);
             _Draw(pRT,rcDraw,dwState,byAlpha);
         }
 
@@ -166,6 +166,20 @@ namespace SOUI
 		SStringT strTr;		//翻译后的字符串
 	};
 
+    /**
+    * @struct     SRenderCacheStats
+    * @brief      窗口绘制缓存的统计数据，所有宿主窗口共享
+    */
+    struct SRenderCacheStats
+    {
+        LONG nCacheHits;        /**<直接使用缓存内容的次数*/
+        LONG nPartialUpdates;   /**<只重绘缓存中脏区域的次数*/
+        LONG nFullUpdates;      /**<重绘整个缓存的次数*/
+        LONG nPromoted;         /**<自动启用缓存的次数*/
+        LONG nEvicted;          /**<自动缓存被释放的次数*/
+        LONG nBytesHeld;        /**<缓存占用的内存(byte)*/
+    };
+
     /**
     * @class     SWindow
     * @brief     SOUI窗口基类 
@@ -182,7 +196,9 @@ namespace SOUI
         friend class SWindowRepos;
         friend class SHostWnd;
         friend class SwndContainerImpl;
+        friend class SHitTestIndex;
         friend class FocusSearch;
+        template<class T> friend class TplSWindowFactory;
     public:
         SWindow();
 
@@ -822,6 +838,30 @@ namespace SOUI
 
         virtual SWND SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText);
 
+        /**
+        * HasCustomHitTest
+        * @brief    窗口是否重载了SwndFromPoint
+        * @return   BOOL -- TRUE:重载了SwndFromPoint
+        *
+        * Describe  通过RegisterWindowClass注册的窗口类在创建时自动检测是否重载了SwndFromPoint，
+        *           直接new出来的子类需要重载该函数并返回TRUE，
+        *           命中测试索引遇到这样的窗口时改用SwndFromPoint的递归查找
+        */
+        virtual BOOL HasCustomHitTest() const {return m_bCustomHitTest;}
+
+        /**
+        * IsDefaultHitTest
+        * @brief    检查SwndFromPoint的成员函数指针是否是SWindow的默认实现
+        * @param    &T::SwndFromPoint
+        * @return   BOOL -- TRUE:T及其基类都没有重载SwndFromPoint
+        *
+        * Describe  子类重载后&T::SwndFromPoint的类型不能隐式转换为SWindow的成员函数指针，只能匹配模板版本
+        */
+        static BOOL IsDefaultHitTest(SWND (SWindow::*)(CPoint,BOOL)) {return TRUE;}
+
+        template<class T>
+        static BOOL IsDefaultHitTest(SWND (T::*)(CPoint,BOOL)) {return FALSE;}
+
         virtual BOOL FireEvent(EventArgs &evt);
 
         virtual UINT OnGetDlgCode();
@@ -1088,7 +1128,27 @@ namespace SOUI
         * @return   void
         * Describe  
         */    
-        void MarkCacheDirty(bool bDirty) {m_bCacheDirty = bDirty;}
+        void MarkCacheDirty(bool bDirty)
+        {
+            m_bCacheDirty = bDirty;
+            if(bDirty) m_rcCacheDirty = m_rcWindow;
+            else m_rcCacheDirty.SetRectEmpty();
+        }
+
+        /**
+        * MarkCacheDirty
+        * @brief    标记Cache中的一个脏区域，绘制时只重绘脏区域
+        * @param    const CRect & rc --  脏区域，窗口坐标
+        * @return   void
+        * Describe  
+        */    
+        void MarkCacheDirty(const CRect & rc)
+        {
+            CRect rcDirty = rc & m_rcWindow;
+            if(rcDirty.IsRectEmpty()) return;
+            m_rcCacheDirty.UnionRect(m_rcCacheDirty,rcDirty);
+            m_bCacheDirty = TRUE;
+        }
 
 
 		/**
@@ -1107,6 +1167,16 @@ namespace SOUI
         */    
         virtual bool IsDrawToCache() const;
 
+        /**
+        * GetRenderCacheStats
+        * @brief    获取窗口绘制缓存的统计数据
+        * @param    SRenderCacheStats & stats --  统计数据
+        * @return   void
+        */
+        static void GetRenderCacheStats(SRenderCacheStats & stats);
+
+        static void ResetRenderCacheStats();
+
 
         /**
          * IsLayeredWindow
@@ -1166,9 +1236,26 @@ namespace SOUI
         void DrawAniStep( CRect rcWnd,IRenderTarget *pRTFore,IRenderTarget * pRTBack,BYTE byAlpha);
         
         void UpdateCacheMode();
+
+        //cache属性或者alpha要求使用缓存
+        bool IsCacheRequired() const;
+
+        //按窗口大小创建或者调整缓存RT
+        void _AllocCacheRT();
+
+        void _FreeCacheRT();
+
+        //cache="auto"时统计窗口内容没有变化的绘制次数，决定是否启用或者释放缓存
+        void _UpdateAutoCache();
         void UpdateLayeredWindowMode();
 
         void TestMainThread();
+
+        //调试版本中沿父窗口链检查缓存的可见及禁用状态位是否正确
+        void TestStateInvariant();
+
+        //从父窗口同步可见状态位，不发送WM_SHOWWINDOW
+        void _UpdateVisibleStateFromParent();
         
 		void GetScaleSkin(ISkinObj * &pSkin,int nScale);
     protected:// Message Handler
@@ -1360,10 +1447,16 @@ namespace SOUI
         DWORD               m_bUpdateLocked:1;  /**< 暂时锁定更新，锁定后，不向宿主发送Invalidate */
         DWORD               m_bCacheDraw:1;     /**< 支持窗口内容的Cache标志 */
         DWORD               m_bCacheDirty:1;    /**< 缓存窗口脏标志 */
+        DWORD               m_bCacheAuto:1;     /**< 内容多次绘制没有变化时自动启用缓存 */
+        DWORD               m_bCacheAutoOn:1;   /**< 当前的缓存是自动启用的 */
+        DWORD               m_bCustomHitTest:1; /**< 窗口类重载了SwndFromPoint，由TplSWindowFactory设置 */
         DWORD               m_bLayeredWindow:1; /**< 指示是否是一个分层窗口 */
 		DWORD               m_layoutDirty:2;    /**< 布局脏标志 参见LayoutDirtyType */
 
         CAutoRefPtr<IRenderTarget> m_cachedRT;  /**< 缓存窗口绘制的RT */
+        CRect               m_rcCacheDirty;     /**< 缓存中需要重绘的区域 */
+        LONG                m_nCacheBytes;      /**< 缓存占用的内存 */
+        UINT                m_nCachePaints;     /**< 自动缓存：连续没有变化(或者缓存后连续变化)的绘制次数 */
         CAutoRefPtr<IRenderTarget> m_layeredRT; /**< 分层窗口绘制的RT */
         CAutoRefPtr<IRegion>       m_rgnWnd;    /**< 窗口Region */
         ISkinObj *          m_pBgSkin;          /**< 背景skin */
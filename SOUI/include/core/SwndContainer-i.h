@@ -21,11 +21,16 @@ namespace SOUI
 {
 
     struct IAcceleratorMgr;
+    class SWindow;
     
     enum{
     ZORDER_MIN  = 0,
     ZORDER_MAX  = (UINT)-1,
     };
+
+    enum{
+    TIMELINE_IDLE = (UINT)-1,   //ScheduleTimelineHandler的延时参数，表示handler休眠直到再次调度
+    };
     
     /**
     * @struct     ITimelineHandler
@@ -99,6 +104,9 @@ namespace SOUI
 
         virtual BOOL UnregisterTimelineHandler(ITimelineHandler *pHandler)=0;
 
+        //设置已注册handler下一次触发的延时(ms)，TIMELINE_IDLE表示休眠
+        virtual BOOL ScheduleTimelineHandler(ITimelineHandler *pHandler,UINT nDelay)=0;
+
         virtual BOOL RegisterTrackMouseEvent(SWND swnd)=0;
 
         virtual BOOL UnregisterTrackMouseEvent(SWND swnd)=0;
@@ -111,6 +119,18 @@ namespace SOUI
         //重建窗口树的zorder
         virtual void BuildWndTreeZorder() = 0;
 
+        //为新插入的窗口分枝分配zorder，相邻zorder之间没有空隙时标记zorder失效
+        virtual void UpdateChildZorder(SWindow *pChild) = 0;
+
+        //窗口矩形改变后更新命中测试索引
+        virtual void UpdateHitTestIndex(SWindow *pWnd) = 0;
+
+        //为cache="auto"的窗口申请缓存，超出预算时释放最久没有使用的自动缓存，返回FALSE表示预算不足
+        virtual BOOL AddAutoCache(SWindow *pWnd) = 0;
+
+        //自动缓存被使用，更新其在淘汰队列中的位置
+        virtual void TouchAutoCache(SWindow *pWnd) = 0;
+
         virtual IScriptModule * GetScriptModule() = 0;
 
 		virtual int GetScale() const = 0;
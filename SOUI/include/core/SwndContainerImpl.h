@@ -15,9 +15,21 @@
 
 #include "SDropTargetDispatcher.h"
 #include "FocusManager.h"
+#include "helper/STimelineScheduler.h"
+#include "SHitTestIndex.h"
 
 namespace SOUI
 {
+    /**
+    * @struct     SZorderStats
+    * @brief      zorder维护的统计数据(累计值)
+    */
+    struct SZorderStats
+    {
+        DWORD nRenumbered;  /**<重新编号的窗口数*/
+        DWORD nRebuilds;    /**<全量重建的次数*/
+        DWORD nIncremental; /**<局部编号的次数*/
+    };
 
     class SOUI_EXP SwndContainerImpl : public ISwndContainer
                                      , public SWindow
@@ -25,10 +37,38 @@ namespace SOUI
         SOUI_CLASS_NAME(SwndContainerImpl,L"SwndContainerImpl")
     public:
         SwndContainerImpl();
+
+        virtual ~SwndContainerImpl();
+
+        /**
+        * EnableHitTestIndex
+        * @brief    启用/禁用命中测试的空间索引
+        * @param    BOOL bEnable --  启用标志
+        * @param    int nCellSize --  网格大小
+        * @return   void
+        *
+        * Describe  窗口数量很多时使用空间索引代替SwndFromPoint的递归查找
+        */
+        void EnableHitTestIndex(BOOL bEnable,int nCellSize = 64);
+
+        /**
+        * SetAutoCacheBudget
+        * @brief    设置cache="auto"的窗口自动启用的缓存可以占用的内存上限
+        * @param    size_t nBytes --  内存上限(byte)，默认16M
+        * @return   void
+        *
+        * Describe  超出上限时释放最久没有使用的自动缓存
+        */
+        void SetAutoCacheBudget(size_t nBytes);
         
         IDropTarget * GetDropTarget(){return &m_dropTarget;}
 
         CFocusManager * GetFocusManager() {return &m_focusMgr;}
+
+        //获取动画帧时序统计
+        const STimelineStats & GetTimelineStats() const {return m_timeline.GetStats();}
+
+        const SZorderStats & GetZorderStats() const {return m_zorderStats;}
     protected:
         //ISwndContainer
         virtual BOOL RegisterDragDrop(SWND swnd,IDropTarget *pDropTarget);
@@ -54,6 +94,8 @@ namespace SOUI
 
         virtual BOOL UnregisterTimelineHandler(ITimelineHandler *pHandler);
 
+        virtual BOOL ScheduleTimelineHandler(ITimelineHandler *pHandler,UINT nDelay);
+
         virtual BOOL RegisterTrackMouseEvent(SWND swnd);
 
         virtual BOOL UnregisterTrackMouseEvent(SWND swnd);
@@ -64,6 +106,18 @@ namespace SOUI
         //重建窗口树的zorder
         virtual void BuildWndTreeZorder();
 
+        //为新插入的窗口分枝分配zorder
+        virtual void UpdateChildZorder(SWindow *pChild);
+
+        virtual void UpdateHitTestIndex(SWindow *pWnd);
+
+        virtual BOOL AddAutoCache(SWindow *pWnd);
+
+        virtual void TouchAutoCache(SWindow *pWnd);
+
+    public://SWindow
+        virtual SWND SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText);
+
     public://ITimelineHandler
         virtual void OnNextFrame();
     protected:
@@ -86,7 +140,12 @@ namespace SOUI
 
         void OnActivateApp(BOOL bActive, DWORD dwThreadID);
 
-        void _BuildWndTreeZorder(SWindow *pWnd,UINT &iOrder);
+        void _BuildWndTreeZorder(SWindow *pWnd,UINT &iOrder,UINT uStep);
+
+        static UINT _GetWndTreeSize(SWindow *pWnd);
+
+        //释放最久没有使用的自动缓存直到占用的内存不超过nBytes
+        void _TrimAutoCache(size_t nBytes);
         
         
     protected:
@@ -99,8 +158,15 @@ namespace SOUI
         SDropTargetDispatcher m_dropTarget;
 
         BOOL        m_bZorderDirty;
+        SZorderStats m_zorderStats;
+
+        SHitTestIndex *             m_pHitTestIndex;
+
+        SList<SWND>                 m_lstAutoCache;     /**<自动缓存的淘汰队列，队尾是最近使用的窗口*/
+        SMap<SWND,SPOSITION>        m_mapAutoCache;     /**<m_lstAutoCache的索引，避免线性查找*/
+        size_t                      m_nAutoCacheBudget;
 
-        SList<ITimelineHandler*>    m_lstTimelineHandler;
+        STimelineScheduler          m_timeline;
         SList<SWND>                 m_lstTrackMouseEvtWnd;
     };
 
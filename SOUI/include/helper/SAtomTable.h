@@ -0,0 +1,135 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SAtomTable.h
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2018/06/20
+*
+* Describe    全局字符串原子表，为属性名、皮肤名等频繁比较的字符串分配整数ID
+*/
+
+#pragma once
+
+#include "core/SSingleton.h"
+#include "helper/SCriticalSection.h"
+
+namespace SOUI
+{
+    typedef UINT SAtom;
+
+    #define SATOM_NULL  0   /**<无效原子*/
+
+    /**
+    * @struct     SAtomStats
+    * @brief      原子表统计数据
+    */
+    struct SAtomStats
+    {
+        LONG nAtoms;        /**<原子数量*/
+        LONG nArenaBytes;   /**<保存字符串占用的内存(byte)*/
+        LONG nLookups;      /**<查找或者添加原子的次数，每次需要计算一次字符串hash*/
+        LONG nCompares;     /**<查找时hash相同需要比较字符串的次数*/
+        LONG nSlotBytes;    /**<hash槽占用的内存(byte)，包括扩容后保留的旧槽*/
+    };
+
+    /**
+    * @class      SAtomTable
+    * @brief      全局字符串原子表
+    *
+    * Describe    原子只增不减，字符串保存在分块分配的内存中，原子的ID、字符串地址及hash在原子表销毁前保持不变。
+    *             原子的hash和CElementTraits<SStringW>::Hash相同，以原子为键的hash表可以和以字符串为键的hash表混合查找。
+    *             添加原子时加锁；查找原子不加锁：hash槽扩容时发布新槽，旧槽保留到原子表销毁，
+    *             原子数据写完后才写入hash槽，因此读者总能看到完整的原子。
+    *             已经得到的原子可以不加锁直接获取字符串及hash。
+    *             原子区分大小写。
+    */
+    class SOUI_EXP SAtomTable : public SSingleton<SAtomTable>
+    {
+    public:
+        SAtomTable();
+
+        ~SAtomTable();
+
+        /**
+        * AddAtom
+        * @brief    获取字符串对应的原子，不存在时添加
+        * @param    LPCWSTR pszName --  字符串
+        * @param    int nLen --  字符串长度，-1表示以0结尾
+        * @return   SAtom -- 空字符串返回SATOM_NULL
+        */
+        SAtom AddAtom(LPCWSTR pszName,int nLen = -1);
+
+        /**
+        * FindAtom
+        * @brief    查找字符串对应的原子
+        * @param    LPCWSTR pszName --  字符串
+        * @param    int nLen --  字符串长度，-1表示以0结尾
+        * @return   SAtom -- 不存在时返回SATOM_NULL
+        * Describe  不加锁，和AddAtom同时进行时可能找不到正在添加的原子
+        */
+        SAtom FindAtom(LPCWSTR pszName,int nLen = -1);
+
+        LPCWSTR GetAtomName(SAtom atom) const;
+
+        int GetAtomLength(SAtom atom) const;
+
+        ULONG GetAtomHash(SAtom atom) const;
+
+        void GetStats(SAtomStats & stats);
+
+        //计算字符串hash，算法和CElementTraits<SStringW>::Hash一致
+        static ULONG HashName(LPCWSTR pszName,int nLen);
+
+    protected:
+        struct ATOMENTRY
+        {
+            LPCWSTR pszName;
+            int     nLen;
+            ULONG   uHash;
+        };
+
+        //开放寻址的hash槽，保存原子，0表示空槽。槽数量和槽一起分配，读者取一次指针就能得到一致的数据
+        struct SLOTTABLE
+        {
+            UINT    nSlots;     /**<hash槽数量，2的幂*/
+            UINT    slots[1];
+        };
+
+        enum{
+            KPageBits = 10,
+            KPageSize = 1<<KPageBits,   /**<每页的原子数*/
+            KMaxPages = 4096,           /**<最多4M个原子*/
+            KArenaChunk = 16*1024,      /**<每次分配的字符串内存(wchar_t)*/
+        };
+
+        const ATOMENTRY & _GetEntry(SAtom atom) const
+        {
+            SASSERT(atom != SATOM_NULL && atom <= m_nAtoms);
+            return m_pPages[(atom-1)>>KPageBits][(atom-1)&(KPageSize-1)];
+        }
+
+        //在hash槽中查找，返回原子或者SATOM_NULL，iSlot返回找到的槽或者可以插入的空槽
+        SAtom _Find(const SLOTTABLE *pTable,LPCWSTR pszName,int nLen,ULONG uHash,UINT & iSlot);
+
+        static SLOTTABLE * _AllocSlots(UINT nSlots);
+
+        //hash槽数量翻倍，旧槽可能还有读者在使用，放到m_lstRetiredSlots中
+        void _GrowSlots();
+
+        LPWSTR _ArenaAlloc(int nLen);
+
+        SCriticalSection    m_cs;               /**<保护添加原子*/
+        ATOMENTRY *         m_pPages[KMaxPages];/**<原子数据分页保存，添加原子时已有数据不会移动*/
+        volatile UINT       m_nAtoms;
+        SLOTTABLE * volatile m_pSlots;          /**<当前的hash槽*/
+        SList<SLOTTABLE*>   m_lstRetiredSlots;  /**<扩容前的hash槽*/
+        SList<LPWSTR>       m_lstArena;         /**<保存字符串的内存块*/
+        LPWSTR              m_pArenaCur;
+        int                 m_nArenaLeft;
+        SAtomStats          m_stats;
+    };
+
+}//namespace SOUI
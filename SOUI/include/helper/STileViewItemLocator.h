@@ -8,19 +8,25 @@ public:
     STileViewItemLocator(int nItemHei, int nItemWid, int nMarginSize = 0);
     STileViewItemLocator(LPCWSTR szItemHei, LPCWSTR szItemWid, SLayoutSize marginSize = SLayoutSize());
     
-    void SetAdapter(ILvAdapter *pAdapter);
+    virtual void SetAdapter(ILvAdapter *pAdapter);
     
-    void OnDataSetChanged() {}
+    virtual void OnDataSetChanged() {}
     
-    int GetItemHeight(int iItem) const;
-    void SetItemHeight(int iItem, int nHeight);
+    //item高度是否固定
+    virtual BOOL IsFixHeight() const
+    {
+        return TRUE;
+    }
+    
+    virtual int GetItemHeight(int iItem) const;
+    virtual void SetItemHeight(int iItem, int nHeight);
     
     //获取item的CRect(相对于TileView)
-    CRect GetItemRect(int iItem);
+    virtual CRect GetItemRect(int iItem);
     
     //设置TileView宽度（在TileView的OnSize中调用）
-    void SetTileViewWidth(LPCWSTR width);
-    void SetTileViewWidth(int width);
+    virtual void SetTileViewWidth(LPCWSTR width);
+    virtual void SetTileViewWidth(int width);
     
     //获取item的行、列位置
     void GetItemRowAndColIndex(int iItem, int &row, int &col);
@@ -33,10 +39,15 @@ public:
     //获取下一行，同一列的元素index
     int GetDownItem(int iItem);
     
-    int GetTotalHeight();
+    virtual int GetTotalHeight();
     
-    int Item2Position(int iItem);
-    int Position2Item(int position);
+    virtual int Item2Position(int iItem);
+    virtual int Position2Item(int position);
+    //顶部位于position之上的最后一个item的下一个index，用于确定显示范围
+    virtual int Position2ItemEnd(int position);
+    
+    //获取和[nTop,nBottom)相交的item，按index升序排列
+    virtual void GetVisibleItems(int nTop, int nBottom, SArray<int> &arrItems);
     
     int GetScrollLineSize() const;
     
@@ -45,7 +56,7 @@ public:
         return m_nItemMargin.toPixelSize(m_scale);
     }
 
-    int SetScale(int scale);
+    virtual int SetScale(int scale);
     
 protected:
     //行高（包括间隔）
@@ -68,4 +79,65 @@ protected:
     CAutoRefPtr<ILvAdapter> m_adapter;
 };
 
+/**
+* @class      STileViewItemLocatorMasonry
+* @brief      瀑布流定位器，item宽度固定，高度可变
+*
+* Describe    第i个item放在第i%列数列，每列用一个树状数组记录item行高的前缀和，
+*             Item2Position、Position2Item、SetItemHeight的复杂度为O(列数*log(行数))
+*/
+class SOUI_EXP STileViewItemLocatorMasonry : public STileViewItemLocator
+{
+public:
+    STileViewItemLocatorMasonry(LPCWSTR szDefHeight, LPCWSTR szItemWid, SLayoutSize marginSize = SLayoutSize());
+    
+    virtual void SetAdapter(ILvAdapter *pAdapter);
+    
+    //数据改变后所有item恢复为默认高度
+    virtual void OnDataSetChanged();
+    
+    virtual BOOL IsFixHeight() const
+    {
+        return FALSE;
+    }
+    
+    virtual int GetItemHeight(int iItem) const;
+    //只更新item所在列的索引
+    virtual void SetItemHeight(int iItem, int nHeight);
+    
+    virtual CRect GetItemRect(int iItem);
+    
+    virtual void SetTileViewWidth(LPCWSTR width);
+    virtual void SetTileViewWidth(int width);
+    
+    virtual int GetTotalHeight();
+    
+    virtual int Item2Position(int iItem);
+    virtual int Position2Item(int position);
+    virtual int Position2ItemEnd(int position);
+    
+    //各列分别查找显示的行，列高相差很大时也只返回一屏左右的item
+    virtual void GetVisibleItems(int nTop, int nBottom, SArray<int> &arrItems);
+    
+    virtual int SetScale(int scale);
+    
+protected:
+    //按当前列数和item高度重建索引
+    void BuildIndex();
+    //第iCol列前nItems个item的行高之和
+    int ColumnPrefix(int iCol, int nItems) const;
+    //第iCol列中行高之和不超过position的最大item数
+    int ColumnSearch(int iCol, int position) const;
+    //第iCol列的item个数
+    int ColumnItemCount(int iCol) const;
+    
+    SArray<int> m_arrHeight;    //每个item的高度，-1表示使用默认高度
+    SArray<int> m_arrTree;      //每列一个树状数组，第iCol列从iCol*(m_nRows+1)开始，下标从1开始
+    SArray<int> m_arrColHeight; //每列的总高度
+    int m_nItems;               //索引中的item数
+    int m_nCols;                //索引中的列数
+    int m_nRows;                //每列的最大item数
+    int m_nTopStep;             //不超过m_nRows的最大的2的幂
+};
+
 }
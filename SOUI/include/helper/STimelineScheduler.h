@@ -0,0 +1,110 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       STimelineScheduler.h
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2018/06/12
+*
+* Describe    时间轴调度器，记录每个ITimelineHandler的下一次触发时间，按目标帧率对齐帧并统计帧时序
+*/
+
+#pragma once
+
+#include "core/SwndContainer-i.h"
+
+namespace SOUI
+{
+    /**
+    * @struct     STimelineStats
+    * @brief      帧时序统计数据
+    *
+    * Describe    抖动以微秒为单位，表示实际帧时间与对齐后的期望帧时间之差
+    */
+    struct STimelineStats
+    {
+        DWORD nFrames;          /**<已执行的帧数*/
+        DWORD nMissedFrames;    /**<由于消息处理延迟而错过的帧数*/
+        DWORD nHandlerCalls;    /**<调用OnNextFrame的次数*/
+        DWORD nSkippedCalls;    /**<未到期而跳过的调用次数*/
+        DWORD dwMaxJitter;      /**<最大帧抖动(us)*/
+        DWORD dwAvgJitter;      /**<平均帧抖动(us)*/
+        ULONGLONG ullTotalJitter;/**<抖动累计值(us)*/
+    };
+
+    class SOUI_EXP STimelineScheduler
+    {
+    public:
+        enum{
+            NEXTFRAME_IDLE = TIMELINE_IDLE,  /**<没有需要触发的handler*/
+        };
+
+        STimelineScheduler();
+
+        /**
+        * SetFrameRate
+        * @brief    设置目标帧率
+        * @param    UINT nFps --  每秒帧数，有效范围1-1000
+        * @return   void
+        */
+        void SetFrameRate(UINT nFps);
+
+        UINT GetFrameInterval() const {return m_nInterval;}
+
+        BOOL Register(ITimelineHandler *pHandler);
+
+        BOOL Unregister(ITimelineHandler *pHandler);
+
+        /**
+        * Schedule
+        * @brief    设置handler下一次触发的延时
+        * @param    ITimelineHandler * pHandler --  已经注册的handler
+        * @param    UINT nDelay --  延时(ms)，0表示下一帧，NEXTFRAME_IDLE表示休眠直到再次调用Schedule
+        * @return   BOOL -- handler没有注册时返回FALSE
+        */
+        BOOL Schedule(ITimelineHandler *pHandler,UINT nDelay);
+
+        BOOL IsEmpty() const {return m_arrHandler.IsEmpty();}
+
+        /**
+        * RunFrame
+        * @brief    执行一帧，只调用已经到期的handler
+        * @return   UINT -- 距下一个对齐帧的延时(ms)，NEXTFRAME_IDLE表示所有handler都处于休眠状态
+        */
+        UINT RunFrame();
+
+        /**
+        * GetNextDelay
+        * @brief    获取距下一个需要触发的对齐帧的延时
+        * @return   UINT -- 延时(ms)，NEXTFRAME_IDLE表示所有handler都处于休眠状态
+        */
+        UINT GetNextDelay() const;
+
+        const STimelineStats & GetStats() const {return m_stats;}
+
+        void ResetStats();
+
+    protected:
+        struct TIMELINEITEM
+        {
+            ITimelineHandler * pHandler;
+            ULONGLONG          ullDue;  /**<下一次触发时间(us)，-1表示休眠*/
+        };
+
+        int FindHandler(ITimelineHandler *pHandler) const;
+
+        //将时间对齐到帧边界之后
+        ULONGLONG AlignToFrame(ULONGLONG ullTime) const;
+
+        static ULONGLONG Now();
+
+        SArray<TIMELINEITEM> m_arrHandler;
+        UINT                 m_nInterval;   /**<帧间隔(ms)*/
+        ULONGLONG            m_ullOrigin;   /**<帧对齐的时间原点(us)*/
+        ULONGLONG            m_ullLastFrame;/**<上一帧的帧序号*/
+        STimelineStats       m_stats;
+    };
+
+}//namespace SOUI
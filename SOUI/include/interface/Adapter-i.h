@@ -144,6 +144,31 @@ namespace SOUI
         // SHDSORTFLAG * stFlags [in, out]:当前列排序标志
         // int nCols:总列数,stFlags数组长度
         virtual bool OnSort(int iCol,SHDSORTFLAG * stFlags,int nCols) PURE;
+
+        //异步排序接口，OnSortPrepare返回true时列表在工作线程中生成排序索引，否则调用OnSort
+        //排序过程中工作线程会同时调用OnSortCompare读取数据，因此排序完成(OnSortDone)前数据不能改变：
+        //Adapter在增删改数据及调用notifyDataSetChanged前必须先调用SMCListView::CancelSort，
+        //否则工作线程会读到正在修改的数据。列表收到notifyDataSetChanged/notifyDataSetInvalidated时也会放弃排序
+        // 参数与OnSort相同，在UI线程中调用，Adapter在这里记录排序列及排序方向
+        virtual bool OnSortPrepare(int iCol,SHDSORTFLAG * stFlags,int nCols)
+        {
+            return false;
+        }
+
+        //比较两行数据，在多个工作线程中同时调用
+        // int iItem1,iItem2: 行号
+        //return: <0 iItem1排在前面, 0 相等, >0 iItem2排在前面
+        virtual int OnSortCompare(int iItem1,int iItem2)
+        {
+            return 0;
+        }
+
+        //排序完成，在UI线程中调用，Adapter按索引重新排列数据
+        // const int * pIndex: 排序后第i行为原来的第pIndex[i]行
+        // int nCount: 行数
+        virtual void OnSortDone(const int * pIndex,int nCount)
+        {
+        }
     };
 
     typedef ULONG_PTR HTREEITEM;
@@ -33,6 +33,16 @@ namespace SOUI
         RES_FILE,
     };
 
+    /**
+    * FunEnumResCallback
+    * @brief    枚举资源的回调函数
+    * @param    LPCTSTR pszType --  资源类型
+    * @param    LPCTSTR pszName --  资源名
+    * @param    LPARAM lp --  EnumResource的参数
+    * @return   BOOL -- 返回FALSE时停止枚举
+    */
+    typedef BOOL (*FunEnumResCallback)(LPCTSTR pszType,LPCTSTR pszName,LPARAM lp);
+
     /**
     * @struct     IResProvider
     * @brief      ResProvider对象
@@ -132,6 +142,24 @@ namespace SOUI
          * Describe  应该先用GetRawBufferSize查询资源大小再分配足够空间
          */    
         virtual BOOL GetRawBuffer(LPCTSTR pszType,LPCTSTR pszResName,LPVOID pBuf,size_t size)=0;
+
+        /**
+         * EnumResource
+         * @brief    枚举资源包中的全部资源
+         * @param    FunEnumResCallback funEnumCB --  回调函数
+         * @param    LPARAM lp --  回调函数的参数
+         * @return   BOOL -- 不支持枚举时返回FALSE
+         * Describe  SResProviderMgr使用枚举结果建立资源索引，不支持枚举的资源包在查找时调用HasResource
+         */    
+        virtual BOOL EnumResource(FunEnumResCallback funEnumCB,LPARAM lp){return FALSE;}
+
+        /**
+         * CheckChanged
+         * @brief    检查资源内容在上次调用之后是否被修改
+         * @return   BOOL -- 被修改时返回TRUE
+         * Describe  SResProviderMgr定期调用，内容被修改时清空已解析XML文档的缓存
+         */    
+        virtual BOOL CheckChanged(){return FALSE;}
         
         
         /**
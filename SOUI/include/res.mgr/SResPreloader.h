@@ -0,0 +1,138 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SResPreloader.h
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2018/06/25
+*
+* Describe    启动时在工作线程中预先解码皮肤引用的图片
+*/
+
+#pragma once
+
+#include "interface/sresprovider-i.h"
+#include "helper/SCriticalSection.h"
+
+namespace SOUI
+{
+    /**
+    * @struct     SResPreloadStats
+    * @brief      预加载统计数据，时间单位为微秒
+    */
+    struct SResPreloadStats
+    {
+        LONG    nSubmitted;     /**<提交的图片数*/
+        LONG    nSkipped;       /**<皮肤类型不通过LoadImage加载图片(如gif,apng)而跳过的皮肤数*/
+        LONG    nDecoded;       /**<工作线程加载的图片数*/
+        LONG    nInline;        /**<使用时还没有开始加载，由UI线程直接加载的图片数*/
+        LONG    nWaited;        /**<使用时正在加载，UI线程需要等待的图片数*/
+        LONG    nDiscarded;     /**<没有被使用的图片数*/
+        LONG    nMaxThreads;    /**<同时运行的最大工作线程数*/
+        DWORD   dwDecodeTime;   /**<工作线程在IResProvider::LoadImage中的时间之和*/
+        DWORD   dwWaitTime;     /**<UI线程等待加载完成的时间*/
+        DWORD   dwSkinTime;     /**<PreloadSkinImages到Discard之间(即创建皮肤)的时间*/
+    };
+
+    /**
+    * @class      SResPreloader
+    * @brief      图片预加载
+    *
+    * Describe    工作线程调用IResProvider::LoadImage加载图片，资源包重载的LoadImage同样生效。
+    *             资源包不保证线程安全，工作线程和UI线程调用资源包前都需要锁定GetProviderLock()。
+    *             使用时正在加载的图片在UI线程等待，还没有开始加载的图片由调用者直接加载。
+    */
+    class SOUI_EXP SResPreloader
+    {
+    public:
+        SResPreloader();
+
+        ~SResPreloader();
+
+        /**
+        * PreloadSkinImages
+        * @brief    为皮肤表中src属性引用的图片提交加载任务，只处理通过LoadImage加载src的皮肤类型(SSkinImgList及其派生类)
+        * @param    IResProvider * pResProvider --  皮肤所在的资源包，只预加载该资源包中存在的图片
+        * @param    pugi::xml_node xmlSkins --  皮肤表
+        * @return   int -- 提交的图片数
+        */
+        int PreloadSkinImages(IResProvider *pResProvider,pugi::xml_node xmlSkins);
+
+        /**
+        * PreloadImage
+        * @brief    提交一个图片加载任务
+        * @param    IResProvider * pResProvider --  资源包
+        * @param    LPCTSTR pszType --  资源类型
+        * @param    LPCTSTR pszName --  资源名
+        * @return   BOOL
+        */
+        BOOL PreloadImage(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName);
+
+        /**
+        * TakeImage
+        * @brief    获取预加载的图片
+        * @param    IResProvider * pResProvider --  资源包
+        * @param    LPCTSTR pszType --  资源类型
+        * @param    LPCTSTR pszName --  资源名
+        * @return   IBitmap * -- 没有预加载或者加载失败时返回NULL
+        * Describe  预加载的图片只能获取一次，调用时不能持有GetProviderLock()
+        */
+        IBitmap * TakeImage(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName);
+
+        //丢弃指定资源包中没有被使用的图片，pResProvider为NULL时丢弃全部图片。返回时工作线程不再访问该资源包
+        void Discard(IResProvider *pResProvider);
+
+        //设置最大工作线程数，0表示1个线程(同一资源包的调用是串行的)，负数表示禁用预加载
+        void SetMaxThreads(int nThreads);
+
+        //调用IResProvider的方法前需要锁定
+        SCriticalSection & GetProviderLock() {return m_csProvider;}
+
+        void GetStats(SResPreloadStats & stats);
+
+    protected:
+        enum JOBSTATE
+        {
+            JOB_PENDING=0,
+            JOB_DECODING,
+            JOB_DONE,
+        };
+
+        struct PRELOADJOB
+        {
+            SStringT        strKey;
+            IResProvider *  pResProvider;
+            SStringT        strType;
+            SStringT        strName;
+            JOBSTATE        state;
+            HANDLE          hDone;      /**<加载完成事件*/
+            IBitmap *       pImg;       /**<IResProvider::LoadImage的结果*/
+        };
+
+        static SStringT MakeKey(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName);
+
+        static unsigned int __stdcall WorkerProc(LPVOID pParam);
+
+        void _Load(PRELOADJOB *pJob);
+
+        void _FreeJob(PRELOADJOB *pJob);
+
+        //调用前需要锁定
+        void _StartWorker();
+
+        void _WaitWorkers();
+
+        SCriticalSection                m_cs;
+        SCriticalSection                m_csProvider;   /**<串行化对资源包的调用*/
+        SMap<SStringT,PRELOADJOB*>      m_mapJobs;
+        SList<PRELOADJOB*>              m_lstPending;   /**<等待解码的任务*/
+        SArray<HANDLE>                  m_arrThreads;
+        LONG                            m_nRunning;     /**<正在运行的工作线程数*/
+        int                             m_nMaxThreads;
+        ULONGLONG                       m_ullSkinStart; /**<PreloadSkinImages的开始时间*/
+        SResPreloadStats                m_stats;
+    };
+
+}//namespace SOUI
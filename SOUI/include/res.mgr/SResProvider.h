@@ -69,6 +69,8 @@ namespace SOUI
 
         SResProviderFiles();
 
+        ~SResProviderFiles();
+
         BOOL Init(WPARAM wParam,LPARAM lParam);
 
         BOOL HasResource(LPCTSTR strType,LPCTSTR pszResName);
@@ -79,6 +81,8 @@ namespace SOUI
         IImgX   * LoadImgX(LPCTSTR strType,LPCTSTR pszResName);
         size_t GetRawBufferSize(LPCTSTR strType,LPCTSTR pszResName);
         BOOL GetRawBuffer(LPCTSTR strType,LPCTSTR pszResName,LPVOID pBuf,size_t size);
+        BOOL EnumResource(FunEnumResCallback funEnumCB,LPARAM lp);
+        BOOL CheckChanged();
         
 #ifdef _DEBUG
         void CheckResUsage(const SMap<SStringT,int> & mapResUsage);
@@ -89,6 +93,7 @@ namespace SOUI
 
         SStringT m_strPath;
         SMap<SResID,SStringT> m_mapFiles;
+        HANDLE   m_hChange;     /**<资源文件夹的修改通知*/
     };
 
     BOOL SOUI_EXP CreateResProvider(BUILTIN_RESTYPE resType,IObjRef **pObj);
@@ -4,6 +4,9 @@
 #include "atl.mini/scomcli.h"
 #include "helper/SCriticalSection.h"
 #include "res.mgr/SUiDef.h"
+#include "res.mgr/SXmlDocCache.h"
+#include "res.mgr/SResPreloader.h"
+#include "helper/SResID.h"
 
 namespace SOUI
 {
@@ -53,13 +56,26 @@ namespace SOUI
         
     public://helper
         //find the match resprovider from tail to head, which contains the specified resource type and name
+        //查找使用资源索引，不需要加锁；需要调用不支持枚举的资源包的HasResource时持有资源包锁
         IResProvider * GetMatchResProvider(LPCTSTR pszType,LPCTSTR pszResName);
 
+        //资源包Init后内容发生变化时重新生成资源索引并清空XML文档缓存
+        void UpdateResIndex();
+
+        //距离上次检查超过KResCheckInterval时调用各资源包的CheckChanged，内容被修改时清空XML文档缓存
+        void CheckResChanged();
+
         //使用type:name形式的字符串加载图片
         IBitmap * LoadImage2(const SStringW & strImgID);
         
         //使用name:size形式的字符串加载图标，如果没有size,则默认系统图标SIZE
         HICON     LoadIcon2(const SStringW & strIconID);
+
+        //已解析XML文档的缓存，可以设置内存限制及获取命中率
+        SXmlDocCache & GetXmlDocCache() {return m_xmlDocCache;}
+
+        //图片预加载，LoadImage优先使用预加载的解码结果
+        SResPreloader & GetResPreloader() {return m_resPreloader;}
     protected:
         
         LPCTSTR SysCursorName2ID(LPCTSTR pszCursorName);
@@ -68,12 +84,55 @@ namespace SOUI
         //使用file:xxx 的形式来引用外部文件资源
         BOOL    IsFileType(LPCTSTR pszType);
 
+        /**
+        * @class      SResIndex
+        * @brief      资源索引快照
+        *
+        * Describe    按从表尾到表头的顺序保存资源包，并记录每个资源所在的第一个支持枚举的资源包。
+        *             快照生成后不再修改，资源包列表改变时生成新的快照替换旧快照。
+        *             快照持有资源包的引用，读者在使用快照期间资源包不会被释放。
+        */
+        class SResIndex
+        {
+        public:
+            SResIndex(const SList<IResProvider*> & lstResPackage);
+            ~SResIndex();
+
+            //先查索引，排在索引结果之前的不支持枚举的资源包仍然调用HasResource，保证查找顺序不变
+            //调用HasResource时锁定csProvider，只查索引时不加锁
+            IResProvider * Find(LPCTSTR pszType,LPCTSTR pszResName,SCriticalSection & csProvider) const;
+
+        protected:
+            static BOOL OnEnumRes(LPCTSTR pszType,LPCTSTR pszName,LPARAM lp);
+
+            SArray<IResProvider*>   m_arrProviders; /**<表尾在前*/
+            SArray<BOOL>            m_arrIndexed;   /**<资源包是否支持枚举*/
+            SMap<SResID,int>        m_mapRes;       /**<资源在m_arrProviders中的位置*/
+            int                     m_iEnum;        /**<正在枚举的资源包*/
+        };
+
+        //生成新的资源索引并替换旧索引，调用前需要锁定
+        void _UpdateResIndex();
+
+        //删除没有读者使用的旧索引，由替换索引的线程或者最后一个离开的读者调用
+        void _FreeRetiredIndex(BOOL bForce);
+
         SList<IResProvider*> m_lstResPackage;
+
+        SResIndex * volatile    m_pResIndex;
+        volatile LONG           m_nReaders;     /**<正在使用索引的读者数*/
+        SList<SResIndex*>       m_lstRetiredIndex;  /**<被替换时可能还有读者在使用的旧索引*/
+        volatile LONG           m_nRetired;     /**<m_lstRetiredIndex中的索引数，读者不加锁检查*/
+        SCriticalSection        m_csRetired;    /**<保护m_lstRetiredIndex，持有期间不获取其它锁*/
         
         typedef SMap<SStringT,HCURSOR> CURSORMAP;
         CURSORMAP  m_mapCachedCursor;
 
         SCriticalSection    m_cs;
+        volatile DWORD      m_dwLastCheck;  /**<上次调用CheckChanged的时间*/
+
+        SXmlDocCache        m_xmlDocCache;  //资源包列表改变时清空
+        SResPreloader       m_resPreloader;
         
         #ifdef _DEBUG
         //资源使用计数
@@ -14,6 +14,7 @@
 #pragma once
 #include "core/SSingletonMap.h"
 #include "interface/Sskinobj-i.h"
+#include "helper/SAtomTable.h"
 #include <unknown/obj-ref-impl.hpp>
 
 #define GETSKIN(p1,scale) SSkinPoolMgr::getSingleton().GetSkin(p1,scale)
@@ -64,11 +65,18 @@ namespace SOUI
 typedef ISkinObj * SSkinPtr;
 
 
+/**
+* @class      SkinKey
+* @brief      皮肤表的键
+* 
+* Describe    atom是strName在SAtomTable中的原子，为SATOM_NULL时使用字符串计算hash及比较
+*/
 class SkinKey
 {
 public:
 	SStringW strName;
 	int		 scale;
+	SAtom	 atom;
 };
 
 template<>
@@ -78,7 +86,9 @@ class CElementTraits<SkinKey > :
 public:
 	static ULONG Hash(INARGTYPE skinKey)
 	{
-		ULONG nHash = CElementTraits<SStringW>::Hash(skinKey.strName);
+		//原子的hash和字符串的hash一致，有原子和没有原子的键可以混合使用
+		ULONG nHash = skinKey.atom != SATOM_NULL ? SAtomTable::getSingleton().GetAtomHash(skinKey.atom)
+			: CElementTraits<SStringW>::Hash(skinKey.strName);
 
 		nHash <<= 5;
 		nHash += skinKey.scale;
@@ -87,8 +97,10 @@ public:
 
 	static bool CompareElements(INARGTYPE element1, INARGTYPE element2)
 	{
-		return element1.strName == element2.strName
-			&& element1.scale == element2.scale;
+		if(element1.scale != element2.scale) return false;
+		if(element1.atom != SATOM_NULL && element2.atom != SATOM_NULL)
+			return element1.atom == element2.atom;
+		return element1.strName == element2.strName;
 	}
 
 	static int CompareElementsOrdered(INARGTYPE element1, INARGTYPE element2)
@@ -121,6 +133,15 @@ public:
      */    
     ISkinObj* GetSkin(const SStringW & strSkinName,int nScale);
 
+    /**
+     * GetSkin
+     * @brief    获得与指定key匹配的SkinObj
+     * @param    const SkinKey & key --  皮肤名、缩放比例及皮肤名的原子
+     * @return   ISkinObj*  -- 找到的Skin Object
+     * Describe  在多个SkinPool中查找时可以复用同一个key
+     */    
+    ISkinObj* GetSkin(const SkinKey & key);
+
     /**
      * LoadSkins
      * @brief    从XML中加载Skin列表
@@ -197,7 +218,10 @@ public:
 		m_bulitinSkinPool = pSkinPool;
 	}
 protected:
+    ISkinObj* GetSkin(const SkinKey & key);
+
     SList<SSkinPool *> m_lstSkinPools;
+    SkinKey            m_builtinSkinKeys[SKIN_SYS_COUNT];   //内建皮肤的键，避免每次查找时构造字符串
     CAutoRefPtr<SSkinPool> m_bulitinSkinPool;
 
 };
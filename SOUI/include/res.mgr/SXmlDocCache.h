@@ -0,0 +1,171 @@
+﻿/**
+* Copyright (C) 2014-2050
+* All rights reserved.
+*
+* @file       SXmlDocCache.h
+* @brief
+* @version    v1.0
+* @author     SOUI group
+* @date       2018/06/22
+*
+* Describe    已解析XML文档的缓存
+*/
+
+#pragma once
+
+#include "interface/sresprovider-i.h"
+#include "helper/SCriticalSection.h"
+#include <unknown/obj-ref-impl.hpp>
+
+namespace SOUI
+{
+    /**
+    * @class      SCachedXmlDoc
+    * @brief      缓存中的XML文档
+    *
+    * Describe    文档在多个使用者之间共享，使用者不能修改文档
+    */
+    class SOUI_EXP SCachedXmlDoc : public TObjRefImpl<IObjRef>
+    {
+        friend class SApplication;
+    public:
+        const pugi::xml_document & GetDoc() const {return m_xmlDoc;}
+
+    protected:
+        pugi::xml_document m_xmlDoc;
+    };
+
+    /**
+    * @struct     SXmlDocCacheStats
+    * @brief      XML文档缓存的统计数据
+    */
+    struct SXmlDocCacheStats
+    {
+        LONG    nHits;      /**<命中次数*/
+        LONG    nMisses;    /**<未命中次数*/
+        LONG    nEvicted;   /**<因超过内存限制淘汰的文档数*/
+        LONG    nDocs;      /**<当前缓存的文档数*/
+        size_t  szBytes;    /**<当前缓存文档的估计内存*/
+    };
+
+    /**
+    * @struct     SXmlDocKey
+    * @brief      XML文档缓存的键，类型和名称不区分大小写
+    *
+    * Describe    缓存中的键指向缓存项保存的字符串，查找时直接指向调用者的字符串，查找不需要分配内存
+    */
+    struct SXmlDocKey
+    {
+        IResProvider *  pResProvider;
+        LPCTSTR         pszType;
+        LPCTSTR         pszName;
+    };
+
+    template<>
+    class CElementTraits<SXmlDocKey> :
+        public CElementTraitsBase<SXmlDocKey>
+    {
+    public:
+        static ULONG Hash(INARGTYPE key)
+        {
+            ULONG nHash = (ULONG)(ULONG_PTR)key.pResProvider;
+            for(const TCHAR *pch = key.pszType;*pch;pch++)
+                nHash = (nHash << 5) + nHash + (TCHAR)_totlower(*pch);
+            for(const TCHAR *pch = key.pszName;*pch;pch++)
+                nHash = (nHash << 5) + nHash + (TCHAR)_totlower(*pch);
+            return nHash;
+        }
+
+        static bool CompareElements(INARGTYPE element1, INARGTYPE element2)
+        {
+            return element1.pResProvider == element2.pResProvider
+                && _tcsicmp(element1.pszType, element2.pszType) == 0
+                && _tcsicmp(element1.pszName, element2.pszName) == 0;
+        }
+
+        static int CompareElementsOrdered(INARGTYPE element1, INARGTYPE element2)
+        {
+            if(element1.pResProvider != element2.pResProvider)
+                return element1.pResProvider < element2.pResProvider ? -1 : 1;
+            int nRet = _tcsicmp(element1.pszType, element2.pszType);
+            if (nRet == 0) nRet = _tcsicmp(element1.pszName, element2.pszName);
+            return nRet;
+        }
+    };
+
+    /**
+    * @class      SXmlDocCache
+    * @brief      按(资源包,类型,名称)缓存已解析的XML文档
+    *
+    * Describe    超过内存限制时淘汰最久没有使用的文档。资源包列表改变时需要清空缓存。
+    *             文档的内存按原始XML数据大小估计。
+    */
+    class SOUI_EXP SXmlDocCache
+    {
+    public:
+        SXmlDocCache();
+
+        ~SXmlDocCache();
+
+        /**
+        * Lookup
+        * @brief    查找缓存的文档
+        * @param    IResProvider * pResProvider --  资源包，NULL表示按资源包列表查找
+        * @param    LPCTSTR pszType --  资源类型
+        * @param    LPCTSTR pszName --  资源名
+        * @return   SCachedXmlDoc * -- 增加了引用计数的文档，没有找到时返回NULL
+        */
+        SCachedXmlDoc * Lookup(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName);
+
+        /**
+        * Add
+        * @brief    将文档加入缓存
+        * @param    IResProvider * pResProvider --  资源包，NULL表示按资源包列表查找
+        * @param    LPCTSTR pszType --  资源类型
+        * @param    LPCTSTR pszName --  资源名
+        * @param    SCachedXmlDoc * pDoc --  文档
+        * @param    size_t szRaw --  原始XML数据大小
+        * @param    DWORD dwGeneration --  加载文档前调用GetGeneration得到的值，加载过程中缓存被清空时不保存文档
+        * @return   void
+        */
+        void Add(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName,SCachedXmlDoc *pDoc,size_t szRaw,DWORD dwGeneration);
+
+        DWORD GetGeneration() const {return m_dwGeneration;}
+
+        void RemoveAll();
+
+        //设置缓存的内存限制，0表示不缓存
+        void SetMaxSize(size_t szMax);
+
+        void GetStats(SXmlDocCacheStats & stats);
+
+    protected:
+        struct CACHEENTRY
+        {
+            IResProvider *  pResProvider;
+            SStringT        strType;
+            SStringT        strName;
+            SCachedXmlDoc * pDoc;
+            size_t          szMem;
+
+            SXmlDocKey GetKey() const
+            {
+                SXmlDocKey key = {pResProvider,strType,strName};
+                return key;
+            }
+        };
+
+        static SXmlDocKey MakeKey(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName);
+
+        //淘汰最久没有使用的文档，直到内存不超过szMax
+        void _Trim(size_t szMax);
+
+        SCriticalSection            m_cs;
+        SList<CACHEENTRY*>          m_lstLru;   /**<表头为最近使用的文档*/
+        SMap<SXmlDocKey,SPOSITION>  m_mapKey;
+        size_t                      m_szMax;
+        DWORD                       m_dwGeneration;
+        SXmlDocCacheStats           m_stats;
+    };
+
+}//namespace SOUI
@@ -48,6 +48,7 @@
 
 #include <trace.h>
 #include <utilities.h>
+#include <profiler.h>
 
 #include <core/SDefine.h>
 
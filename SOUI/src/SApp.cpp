@@ -135,6 +135,7 @@ SApplication::~SApplication(void)
 
 void SApplication::_CreateSingletons()
 {
+    new SAtomTable();
 	new SUiDef();
     new SWindowMgr();
     new STimer2();
@@ -156,34 +157,63 @@ void SApplication::_DestroySingletons()
     delete STimer2::getSingletonPtr();
     delete SWindowMgr::getSingletonPtr();
 	delete SUiDef::getSingletonPtr();
+    delete SAtomTable::getSingletonPtr();
 }
 
 BOOL SApplication::_LoadXmlDocment( LPCTSTR pszXmlName ,LPCTSTR pszType ,pugi::xml_document & xmlDoc,IResProvider *pResProvider/* = NULL*/)
 {
-    if(!pResProvider) 
+    if(!pResProvider && IsFileType(pszType))
     {
-        if(IsFileType(pszType))
-        {
-            pugi::xml_parse_result result= xmlDoc.load_file(pszXmlName,pugi::parse_default,pugi::encoding_utf8);
-            SASSERT_FMTW(result,L"parse xml error! xmlName=%s,desc=%s,offset=%d",pszXmlName,result.description(),result.offset);
-            return result;
-        }else
-        {
-            pResProvider = GetMatchResProvider(pszType,pszXmlName);
-        }
+        pugi::xml_parse_result result= xmlDoc.load_file(pszXmlName,pugi::parse_default,pugi::encoding_utf8);
+        SASSERT_FMTW(result,L"parse xml error! xmlName=%s,desc=%s,offset=%d",pszXmlName,result.description(),result.offset);
+        return result;
     }
-    if(!pResProvider) return FALSE;
-    
-    size_t dwSize=pResProvider->GetRawBufferSize(pszType,pszXmlName);
-    if(dwSize==0) return FALSE;
+    //使用者可能修改文档，从缓存的文档复制一份，省去读取资源及解析的开销
+    //pResProvider为NULL时直接查找缓存，只有缓存未命中时才查找匹配的资源包
+    CAutoRefPtr<SCachedXmlDoc> pDoc;
+    pDoc.Attach(_LoadSharedXmlDocment(pszXmlName,pszType,pResProvider));
+    if(!pDoc) return FALSE;
+    xmlDoc.reset(pDoc->GetDoc());
+    return TRUE;
+}
+
+SCachedXmlDoc * SApplication::_LoadSharedXmlDocment(LPCTSTR pszXmlName ,LPCTSTR pszType ,IResProvider *pResProvider)
+{
+    //缓存键中的资源包为NULL时表示按资源包列表查找，资源包列表改变或者资源文件被修改时缓存会被清空
+    CheckResChanged();
+    SCachedXmlDoc *pDoc = m_xmlDocCache.Lookup(pResProvider,pszType,pszXmlName);
+    if(pDoc) return pDoc;
 
+    DWORD dwGeneration = m_xmlDocCache.GetGeneration();
+    IResProvider *pMatchProvider = pResProvider?pResProvider:GetMatchResProvider(pszType,pszXmlName);
+    if(!pMatchProvider) return NULL;
+    
     CMyBuffer<char> strXml;
-    strXml.Allocate(dwSize);
-    pResProvider->GetRawBuffer(pszType,pszXmlName,strXml,dwSize);
+    size_t dwSize = 0;
+    {
+        SAutoLock lockRes(m_resPreloader.GetProviderLock());
+        dwSize=pMatchProvider->GetRawBufferSize(pszType,pszXmlName);
+        if(dwSize==0) return NULL;
+        strXml.Allocate(dwSize);
+        pMatchProvider->GetRawBuffer(pszType,pszXmlName,strXml,dwSize);
+    }
 
-    pugi::xml_parse_result result= xmlDoc.load_buffer(strXml,strXml.size(),pugi::parse_default,pugi::encoding_utf8);
+    pDoc = new SCachedXmlDoc;
+    pugi::xml_parse_result result= pDoc->m_xmlDoc.load_buffer(strXml,strXml.size(),pugi::parse_default,pugi::encoding_utf8);
     SASSERT_FMTW(result,L"parse xml error! xmlName=%s,desc=%s,offset=%d",pszXmlName,result.description(),result.offset);
-    return result;
+    if(!result)
+    {
+        pDoc->Release();
+        return NULL;
+    }
+    m_xmlDocCache.Add(pResProvider,pszType,pszXmlName,pDoc,dwSize,dwGeneration);
+    return pDoc;
+}
+
+SCachedXmlDoc * SApplication::LoadSharedXmlDocment(LPCTSTR pszXmlName ,LPCTSTR pszType)
+{
+    if(IsFileType(pszType)) return NULL;
+    return _LoadSharedXmlDocment(pszXmlName,pszType,NULL);
 }
 
 BOOL SApplication::LoadXmlDocment( pugi::xml_document & xmlDoc,LPCTSTR pszXmlName ,LPCTSTR pszType )
@@ -0,0 +1,252 @@
+﻿#include "souistd.h"
+#include "animator/SInterpolatorTable.h"
+#include <math.h>
+
+//SSE2 is always available on x64; on x86 it depends on /arch
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define INTERPOLATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace SOUI
+{
+	//////////////////////////////////////////////////////////////////////////
+	// SInterpolatorTable
+	SInterpolatorTable::SInterpolatorTable():m_nSamples(0)
+	{
+	}
+
+	BOOL SInterpolatorTable::Build(IInterpolator *pInterpolator,int nSamples)
+	{
+		if(!pInterpolator || nSamples < 1) return FALSE;
+		if(!m_arrSamples.SetCount(nSamples+2)) return FALSE;
+		m_nSamples = nSamples;
+		float *pSamples = m_arrSamples.GetData();
+		for(int i=0;i<=nSamples;i++)
+		{
+			pSamples[i] = pInterpolator->getInterpolation((float)i/nSamples);
+		}
+		pSamples[nSamples+1] = pSamples[nSamples];
+		return TRUE;
+	}
+
+	float SInterpolatorTable::Lookup(float input) const
+	{
+		SASSERT(m_nSamples>0);
+		//NaN与任何数比较都为false，按0处理，避免转换出越界的下标
+		if(!(input > 0.0f)) input = 0.0f;
+		else if(input > 1.0f) input = 1.0f;
+		float fPos = input*m_nSamples;
+		int iPos = (int)fPos;
+		const float *pSamples = m_arrSamples.GetData();
+		return pSamples[iPos] + (pSamples[iPos+1]-pSamples[iPos])*(fPos-iPos);
+	}
+
+	void SInterpolatorTable::Evaluate(const float *pInput,float *pOutput,int nCount) const
+	{
+		SASSERT(m_nSamples>0);
+		int i=0;
+#ifdef INTERPOLATOR_SSE2
+		const float *pSamples = m_arrSamples.GetData();
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps((float)m_nSamples);
+		for(;i+4<=nCount;i+=4)
+		{
+			__m128 pos = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pInput+i),zero),one),scale);
+			__m128i idx = _mm_cvttps_epi32(pos);
+			__m128 frac = _mm_sub_ps(pos,_mm_cvtepi32_ps(idx));
+			//SSE2没有gather指令，逐个取出相邻的两个采样点
+			int iIdx[4];
+			_mm_storeu_si128((__m128i*)iIdx,idx);
+			__m128 v0 = _mm_setr_ps(pSamples[iIdx[0]],pSamples[iIdx[1]],pSamples[iIdx[2]],pSamples[iIdx[3]]);
+			__m128 v1 = _mm_setr_ps(pSamples[iIdx[0]+1],pSamples[iIdx[1]+1],pSamples[iIdx[2]+1],pSamples[iIdx[3]+1]);
+			_mm_storeu_ps(pOutput+i,_mm_add_ps(v0,_mm_mul_ps(_mm_sub_ps(v1,v0),frac)));
+		}
+#endif
+		for(;i<nCount;i++)
+		{
+			pOutput[i] = Lookup(pInput[i]);
+		}
+	}
+
+	float SInterpolatorTable::GetMaxError(IInterpolator *pInterpolator,int nProbes) const
+	{
+		float fMaxErr = 0.0f;
+		for(int i=0;i<=nProbes;i++)
+		{
+			float t = (float)i/nProbes;
+			float fErr = fabs(Lookup(t) - pInterpolator->getInterpolation(t));
+			if(fErr > fMaxErr) fMaxErr = fErr;
+		}
+		return fMaxErr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// SAnimationBatch
+	SAnimationBatch::SAnimationBatch(int nSamples)
+		:m_nCount(0)
+		,m_nSamples(nSamples)
+		,m_dwNow(0)
+	{
+	}
+
+	SAnimationBatch::~SAnimationBatch()
+	{
+		RemoveAll();
+	}
+
+	SAnimationBatch::GROUP * SAnimationBatch::_GetGroup(IInterpolator *pInterpolator)
+	{
+		SMap<IInterpolator*,GROUP*>::CPair *p = m_mapGroups.Lookup(pInterpolator);
+		if(p) return p->m_value;
+		GROUP *pGroup = new GROUP;
+		pGroup->pInterpolator = pInterpolator;
+		if(!pGroup->table.Build(pGroup->pInterpolator,m_nSamples))
+		{
+			delete pGroup;
+			return NULL;
+		}
+		//以组内持有引用的指针为键，组存在期间插值器不会被释放，地址也不会被复用
+		m_mapGroups[pGroup->pInterpolator] = pGroup;
+		return pGroup;
+	}
+
+	int SAnimationBatch::Add(IInterpolator *pInterpolator,DWORD dwStart,DWORD dwDuration)
+	{
+		GROUP *pGroup = _GetGroup(pInterpolator);
+		if(!pGroup) return -1;
+
+		int nID;
+		if(!m_arrFreeID.IsEmpty())
+		{
+			nID = m_arrFreeID[m_arrFreeID.GetCount()-1];
+			m_arrFreeID.RemoveAt(m_arrFreeID.GetCount()-1);
+		}else
+		{
+			nID = (int)m_arrItems.Add();
+		}
+		ITEMPOS &pos = m_arrItems[nID];
+		pos.pGroup = pGroup;
+		pos.iItem = (int)pGroup->arrID.Add(nID);
+		pGroup->arrStart.Add(dwStart);
+		pGroup->arrDuration.Add(dwDuration);
+		pGroup->arrScale.Add(dwDuration?1.0f/dwDuration:0.0f);
+		pGroup->arrValue.Add(pGroup->table.Lookup(0.0f));
+		m_nCount ++;
+		return nID;
+	}
+
+	BOOL SAnimationBatch::Remove(int nID)
+	{
+		if(nID<0 || nID>=(int)m_arrItems.GetCount()) return FALSE;
+		ITEMPOS &pos = m_arrItems[nID];
+		GROUP *pGroup = pos.pGroup;
+		if(!pGroup) return FALSE;
+
+		//用组内最后一个动画填补空位，保持数组连续
+		int iLast = (int)pGroup->arrID.GetCount()-1;
+		if(pos.iItem != iLast)
+		{
+			int nLastID = pGroup->arrID[iLast];
+			pGroup->arrID[pos.iItem] = nLastID;
+			pGroup->arrStart[pos.iItem] = pGroup->arrStart[iLast];
+			pGroup->arrDuration[pos.iItem] = pGroup->arrDuration[iLast];
+			pGroup->arrScale[pos.iItem] = pGroup->arrScale[iLast];
+			pGroup->arrValue[pos.iItem] = pGroup->arrValue[iLast];
+			m_arrItems[nLastID].iItem = pos.iItem;
+		}
+		pGroup->arrID.RemoveAt(iLast);
+		pGroup->arrStart.RemoveAt(iLast);
+		pGroup->arrDuration.RemoveAt(iLast);
+		pGroup->arrScale.RemoveAt(iLast);
+		pGroup->arrValue.RemoveAt(iLast);
+
+		if(pGroup->arrID.IsEmpty())
+		{
+			m_mapGroups.RemoveKey(pGroup->pInterpolator);
+			delete pGroup;
+		}
+		pos.pGroup = NULL;
+		m_arrFreeID.Add(nID);
+		m_nCount --;
+		return TRUE;
+	}
+
+	void SAnimationBatch::RemoveAll()
+	{
+		SPOSITION pos = m_mapGroups.GetStartPosition();
+		while(pos)
+		{
+			delete m_mapGroups.GetNextValue(pos);
+		}
+		m_mapGroups.RemoveAll();
+		m_arrItems.RemoveAll();
+		m_arrFreeID.RemoveAll();
+		m_nCount = 0;
+	}
+
+	int SAnimationBatch::Evaluate(DWORD dwNow)
+	{
+		m_dwNow = dwNow;
+		int nRunning = 0;
+		SPOSITION pos = m_mapGroups.GetStartPosition();
+		while(pos)
+		{
+			GROUP *pGroup = m_mapGroups.GetNextValue(pos);
+			int nItems = (int)pGroup->arrID.GetCount();
+			const DWORD *pStart = pGroup->arrStart.GetData();
+			const DWORD *pDuration = pGroup->arrDuration.GetData();
+			const float *pScale = pGroup->arrScale.GetData();
+			float *pValue = pGroup->arrValue.GetData();
+			for(int i=0;i<nItems;i++)
+			{
+				LONG nElapse = (LONG)(dwNow - pStart[i]);
+				if(nElapse < 0) nElapse = 0;
+				if((DWORD)nElapse < pDuration[i])
+				{
+					pValue[i] = nElapse*pScale[i];
+					nRunning ++;
+				}else
+				{
+					pValue[i] = 1.0f;
+				}
+			}
+			pGroup->table.Evaluate(pValue,pValue,nItems);
+		}
+		return nRunning;
+	}
+
+	float SAnimationBatch::GetValue(int nID) const
+	{
+		SASSERT(nID>=0 && nID<(int)m_arrItems.GetCount() && m_arrItems[nID].pGroup);
+		const ITEMPOS &pos = m_arrItems[nID];
+		return pos.pGroup->arrValue[pos.iItem];
+	}
+
+	BOOL SAnimationBatch::IsFinished(int nID) const
+	{
+		SASSERT(nID>=0 && nID<(int)m_arrItems.GetCount() && m_arrItems[nID].pGroup);
+		const ITEMPOS &pos = m_arrItems[nID];
+		LONG nElapse = (LONG)(m_dwNow - pos.pGroup->arrStart[pos.iItem]);
+		return nElapse >= 0 && (DWORD)nElapse >= pos.pGroup->arrDuration[pos.iItem];
+	}
+
+	void SAnimationBatch::SetPrecision(int nSamples)
+	{
+		if(nSamples < 1 || nSamples == m_nSamples) return;
+		m_nSamples = nSamples;
+		SPOSITION pos = m_mapGroups.GetStartPosition();
+		while(pos)
+		{
+			GROUP *pGroup = m_mapGroups.GetNextValue(pos);
+			pGroup->table.Build(pGroup->pInterpolator,m_nSamples);
+		}
+	}
+
+	void SAnimationBatch::Invalidate(IInterpolator *pInterpolator)
+	{
+		SMap<IInterpolator*,GROUP*>::CPair *p = m_mapGroups.Lookup(pInterpolator);
+		if(p) p->m_value->table.Build(pInterpolator,m_nSamples);
+	}
+}
@@ -535,7 +535,6 @@ SAnimateImgWnd::SAnimateImgWnd()
 ,m_nSpeed(50)
 ,m_bAutoStart(TRUE)
 ,m_bPlaying(FALSE)
-,m_iTimeFrame(0)
 ,m_nRepeat(-1)
 ,m_iRepeat(0)
 {
@@ -604,23 +603,20 @@ void SAnimateImgWnd::OnNextFrame()
     if(!m_pSkin) GetContainer()->UnregisterTimelineHandler(this);
     else
     {
-        if(m_iTimeFrame > (m_nSpeed/10)) m_iTimeFrame=0;
-        if(m_iTimeFrame==0)
-        {
-            int nStates=m_pSkin->GetStates();
-            m_iCurFrame++;
-			Invalidate();
+        int nStates=m_pSkin->GetStates();
+        m_iCurFrame++;
+        Invalidate();
 
-			if(m_iCurFrame==nStates)
-			{
-				m_iCurFrame = 0;
-				if(m_nRepeat != -1 && ++ m_iRepeat == m_nRepeat)
-				{//检查重复次数
-					Stop();
-				}
-			}
+        if(m_iCurFrame==nStates)
+        {
+            m_iCurFrame = 0;
+            if(m_nRepeat != -1 && ++ m_iRepeat == m_nRepeat)
+            {//检查重复次数
+                Stop();
+            }
         }
-        m_iTimeFrame++;
+        //两帧之间不需要触发，由时间轴按speed指定的间隔再次调度
+        if(m_bPlaying) GetContainer()->ScheduleTimelineHandler(this,m_nSpeed);
     }
 }
 
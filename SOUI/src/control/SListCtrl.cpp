@@ -8,6 +8,80 @@
 #define ITEM_MARGIN 4
 namespace SOUI
 {
+//////////////////////////////////////////////////////////////////////////
+//  SLvTextArena
+//内存块的字符数从KMinArenaBlock开始按已申请的容量翻倍，不超过KMaxArenaBlock
+static const size_t KMinArenaBlock = 256;
+static const size_t KMaxArenaBlock = 64*1024;
+
+SLvTextArena::SLvTextArena()
+    : m_pCur(NULL)
+    , m_nLeft(0)
+    , m_nCapacity(0)
+    , m_nUsed(0)
+    , m_nWasted(0)
+{
+}
+
+SLvTextArena::~SLvTextArena()
+{
+    RemoveAll();
+}
+
+LPTSTR SLvTextArena::Alloc(LPCTSTR pszText,int nLen)
+{
+    if(!pszText)
+    {
+        pszText = _T("");
+        nLen = 0;
+    }
+    if(nLen<0) nLen = (int)_tcslen(pszText);
+    size_t nChars = nLen+1;
+    if(m_nLeft < nChars)
+    {
+        size_t nBlock = m_nCapacity;
+        if(nBlock < KMinArenaBlock) nBlock = KMinArenaBlock;
+        if(nBlock > KMaxArenaBlock) nBlock = KMaxArenaBlock;
+        Reserve(nChars > nBlock ? nChars : nBlock);
+        if(m_nLeft < nChars) return NULL;
+    }
+    LPTSTR pszRet = m_pCur;
+    memcpy(pszRet,pszText,nLen*sizeof(TCHAR));
+    pszRet[nLen] = 0;
+    m_pCur += nChars;
+    m_nLeft -= nChars;
+    m_nUsed += nChars;
+    return pszRet;
+}
+
+void SLvTextArena::Free(int nLen)
+{
+    m_nWasted += nLen+1;
+}
+
+void SLvTextArena::Reserve(size_t nChars)
+{
+    if(m_nLeft >= nChars) return;
+    //当前内存块剩余的空间不再使用
+    LPTSTR pBlock = (LPTSTR)malloc(nChars*sizeof(TCHAR));
+    if(!pBlock) return;
+    m_arrBlocks.Add(pBlock);
+    m_pCur = pBlock;
+    m_nLeft = nChars;
+    m_nCapacity += nChars;
+}
+
+void SLvTextArena::RemoveAll()
+{
+    for(size_t i=0;i<m_arrBlocks.GetCount();i++)
+    {
+        free(m_arrBlocks[i]);
+    }
+    m_arrBlocks.RemoveAll();
+    m_pCur = NULL;
+    m_nLeft = m_nCapacity = m_nUsed = m_nWasted = 0;
+}
+
 //////////////////////////////////////////////////////////////////////////
 //  SListCtrl
 SListCtrl::SListCtrl()
@@ -40,6 +114,55 @@ SListCtrl::SListCtrl()
 
 SListCtrl::~SListCtrl()
 {
+    for(size_t i=0;i<m_arrTextArenas.GetCount();i++)
+    {
+        delete m_arrTextArenas[i];
+    }
+}
+
+SLvTextArena * SListCtrl::_GetTextArena(int iSubItem)
+{
+    while((int)m_arrTextArenas.GetCount() <= iSubItem)
+    {
+        m_arrTextArenas.Add(new SLvTextArena);
+    }
+    return m_arrTextArenas[iSubItem];
+}
+
+void SListCtrl::_FreeSubItemText(DXLVSUBITEM & lvsi, int iSubItem)
+{
+    if(!lvsi.strText) return;
+    _GetTextArena(iSubItem)->Free(lvsi.cchTextMax);
+    lvsi.strText = NULL;
+    lvsi.cchTextMax = 0;
+}
+
+void SListCtrl::_SetSubItemText(DXLVSUBITEM & lvsi, int iSubItem, LPCTSTR pszText)
+{
+    _FreeSubItemText(lvsi, iSubItem);
+    int nLen = pszText?(int)_tcslen(pszText):0;
+    lvsi.strText = _GetTextArena(iSubItem)->Alloc(pszText, nLen);
+    lvsi.cchTextMax = lvsi.strText?nLen:0;
+}
+
+void SListCtrl::_CompactTextArena(int iSubItem)
+{
+    //不再使用的文本超过一半并且超过64K字符时才整理，整理的开销分摊到之前的修改中
+    SLvTextArena *pArena = _GetTextArena(iSubItem);
+    if(pArena->GetWasted() < 64*1024 || pArena->GetWasted()*2 < pArena->GetUsed())
+        return;
+
+    SLvTextArena *pNewArena = new SLvTextArena;
+    pNewArena->Reserve(pArena->GetUsed() - pArena->GetWasted());
+    for(size_t i=0;i<m_arrItems.GetCount();i++)
+    {
+        ArrSubItem *arSubItems = m_arrItems[i].arSubItems;
+        if(!arSubItems || (int)arSubItems->GetCount() <= iSubItem) continue;
+        DXLVSUBITEM &lvsi = arSubItems->GetAt(iSubItem);
+        if(lvsi.strText) lvsi.strText = pNewArena->Alloc(lvsi.strText, lvsi.cchTextMax);
+    }
+    m_arrTextArenas[iSubItem] = pNewArena;
+    delete pArena;
 }
 
 int SListCtrl::InsertColumn(int nIndex, LPCTSTR pszText, int nWidth, LPARAM lParam)
@@ -51,6 +174,7 @@ int SListCtrl::InsertColumn(int nIndex, LPCTSTR pszText, int nWidth, LPARAM lPar
     {
         m_arrItems[i].arSubItems->SetCount(GetColumnCount());
     }
+    _GetTextArena(GetColumnCount()-1);
     UpdateScrollBar();
     return nRet;
 }
@@ -96,8 +220,7 @@ int SListCtrl::InsertItem(int nItem, LPCTSTR pszText, int nImage)
     lvi.arSubItems->SetCount(GetColumnCount());
     
     DXLVSUBITEM &subItem=lvi.arSubItems->GetAt(0);
-    subItem.strText = _tcsdup(pszText);
-    subItem.cchTextMax = _tcslen(pszText);
+    _SetSubItemText(subItem, 0, pszText);
     subItem.nImage  = nImage;
 
     m_arrItems.InsertAt(nItem, lvi);
@@ -107,6 +230,59 @@ int SListCtrl::InsertItem(int nItem, LPCTSTR pszText, int nImage)
     return nItem;
 }
 
+int SListCtrl::InsertItems(int nItem, int nItems, const LPCTSTR *ppszTexts, int nCols, int nImage)
+{
+    int nColumns = GetColumnCount();
+    if(nColumns==0 || nItems<=0 || nCols>nColumns) return -1;
+    if (nItem<0 || nItem>GetItemCount())
+        nItem = GetItemCount();
+
+    DXLVITEM lvi;
+    m_arrItems.InsertAt(nItem, lvi, nItems);
+    for(int i=0;i<nItems;i++)
+    {
+        ArrSubItem *arSubItems = new ArrSubItem();
+        arSubItems->SetCount(nColumns);
+        arSubItems->GetAt(0).nImage = nImage;
+        m_arrItems[nItem+i].arSubItems = arSubItems;
+        if(!ppszTexts) continue;
+
+        const LPCTSTR *pRow = ppszTexts + (size_t)i*nCols;
+        for(int j=0;j<nCols;j++)
+        {
+            if(pRow[j]) _SetSubItemText(arSubItems->GetAt(j), j, pRow[j]);
+        }
+    }
+
+    UpdateScrollBar();
+
+    return nItem;
+}
+
+void SListCtrl::ReserveItems(int nItems, int nCharsPerSubItem)
+{
+    size_t nOldCount = m_arrItems.GetCount();
+    if((size_t)nItems > nOldCount)
+    {
+        if(nOldCount == 0)
+        {//空数组在第一次分配时按nGrowBy分配
+            m_arrItems.SetCount(0, nItems);
+        }else
+        {
+            m_arrItems.SetCount(nItems);
+            m_arrItems.SetCount(nOldCount);
+        }
+    }
+    if(nCharsPerSubItem > 0 && (size_t)nItems > nOldCount)
+    {
+        size_t nChars = (nItems - nOldCount)*(size_t)(nCharsPerSubItem+1);
+        for(int i=0;i<GetColumnCount();i++)
+        {
+            _GetTextArena(i)->Reserve(nChars);
+        }
+    }
+}
+
 BOOL SListCtrl::SetItemData(int nItem, DWORD dwData)
 {
     if (nItem >= GetItemCount())
@@ -134,9 +310,8 @@ BOOL SListCtrl::SetSubItem(int nItem, int nSubItem, const DXLVSUBITEM* plv)
     DXLVSUBITEM & lvsi_dst=m_arrItems[nItem].arSubItems->GetAt(nSubItem);
     if(plv->mask & S_LVIF_TEXT)
     {
-        if(lvsi_dst.strText) free(lvsi_dst.strText);
-        lvsi_dst.strText=_tcsdup(plv->strText);
-        lvsi_dst.cchTextMax=_tcslen(plv->strText);
+        _SetSubItemText(lvsi_dst, nSubItem, plv->strText);
+        _CompactTextArena(nSubItem);
     }
     if(plv->mask&S_LVIF_IMAGE)
         lvsi_dst.nImage=plv->nImage;
@@ -172,12 +347,8 @@ BOOL SListCtrl::SetSubItemText(int nItem, int nSubItem, LPCTSTR pszText)
         return FALSE;
 
     DXLVSUBITEM &lvi=m_arrItems[nItem].arSubItems->GetAt(nSubItem);
-    if(lvi.strText)
-    {
-        free(lvi.strText);
-    }
-    lvi.strText = _tcsdup(pszText);
-    lvi.cchTextMax= _tcslen(pszText);
+    _SetSubItemText(lvi, nSubItem, pszText);
+    _CompactTextArena(nSubItem);
     
     CRect rcItem=GetItemRect(nItem,nSubItem);
     InvalidateRect(rcItem);
@@ -361,11 +532,14 @@ void SListCtrl::DeleteItem(int nItem)
 
         for(int i=0;i<GetColumnCount();i++)
         {
-            DXLVSUBITEM &lvsi =lvi.arSubItems->GetAt(i);
-            if(lvsi.strText) free(lvsi.strText);
+            _FreeSubItemText(lvi.arSubItems->GetAt(i), i);
         }
         delete lvi.arSubItems;
         m_arrItems.RemoveAt(nItem);
+        for(int i=0;i<GetColumnCount();i++)
+        {
+            _CompactTextArena(i);
+        }
 
         UpdateScrollBar();
     }
@@ -377,7 +551,8 @@ void SListCtrl::DeleteColumn( int iCol )
     {
 		int nColumnCount = m_pHeader->GetItemCount();
 
-        for(int i=0;i<GetItemCount();i++)
+        //删除最后一列后GetItemCount返回0，这里需要遍历全部条目，避免子项保留已释放的文本
+        for(int i=0;i<(int)m_arrItems.GetCount();i++)
         {
 			DXLVITEM &lvi = m_arrItems[i];
 
@@ -389,10 +564,13 @@ void SListCtrl::DeleteColumn( int iCol )
 				FireEvent(evt2);
 			}
 
-            DXLVSUBITEM &lvsi=lvi.arSubItems->GetAt(iCol);
-            if(lvsi.strText) free(lvsi.strText);
             m_arrItems[i].arSubItems->RemoveAt(iCol);
         }
+        if(iCol < (int)m_arrTextArenas.GetCount())
+        {//该列的文本随存储区一起释放
+            delete m_arrTextArenas[iCol];
+            m_arrTextArenas.RemoveAt(iCol);
+        }
         UpdateScrollBar();
     }
 }
@@ -409,14 +587,13 @@ void SListCtrl::DeleteAllItems()
 		evt2.dwData = lvi.dwData;
 		FireEvent(evt2);
 
-        for(int j=0;j<GetColumnCount();j++)
-        {
-            DXLVSUBITEM &lvsi =lvi.arSubItems->GetAt(j);
-            if(lvsi.strText) free(lvsi.strText);
-        }
         delete lvi.arSubItems;
     }
     m_arrItems.RemoveAll();
+    for(size_t i=0;i<m_arrTextArenas.GetCount();i++)
+    {
+        m_arrTextArenas[i]->RemoveAll();
+    }
 
     UpdateScrollBar();
 }
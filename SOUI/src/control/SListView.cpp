@@ -1,11 +1,29 @@
 ﻿#include "souistd.h"
 #include "control/SListView.h"
 #include "helper/SListViewItemLocator.h"
+#include "helper/SplitString.h"
 #include <algorithm>
 
 namespace SOUI
 {
-
+    //停止滚动超过该时间(ms)后认为滚动速度为0
+    const DWORD KScrollSpeedTimeout = 200;
+    //估算滚动速度时两次滚动的最小间隔(ms)，约为一帧
+    const DWORD KScrollFrameTime = 16;
+    //一次预创建最多检查的列表项数
+    const int KMaxPrewarmItems = 32;
+    //每次消息循环空闲时预创建列表项最多占用的时间(ms)
+    const DWORD KPrewarmBudget = 8;
+
+    //当前时间(us)，GetTickCount的精度只有10-16ms，不能用来控制几ms的时间片
+    static ULONGLONG NowUs()
+    {
+        static LARGE_INTEGER s_freq = {0};
+        if(s_freq.QuadPart == 0) ::QueryPerformanceFrequency(&s_freq);
+        LARGE_INTEGER cnt;
+        ::QueryPerformanceCounter(&cnt);
+        return (ULONGLONG)(cnt.QuadPart/s_freq.QuadPart*1000000 + cnt.QuadPart%s_freq.QuadPart*1000000/s_freq.QuadPart);
+    }
 
     class SListViewDataSetObserver : public TObjRefImpl<ILvDataSetObserver>
     {
@@ -42,6 +60,10 @@ namespace SOUI
         ,m_pSkinDivider(NULL)
         ,m_bWantTab(FALSE)
         ,m_bDataSetInvalidated(FALSE)
+        ,m_bPrewarm(FALSE)
+        ,m_nPrewarmTime(300)
+        ,m_fScrollSpeed(0.0f)
+        ,m_dwLastScroll(0)
     {
         m_bFocusable = TRUE;
         m_observer.Attach(new SListViewDataSetObserver(this));
@@ -218,6 +240,7 @@ namespace SOUI
         int nNewPos = m_siVer.nPos;
         if(nOldPos != nNewPos)
         {
+            UpdateScrollSpeed(nNewPos-nOldPos);
             UpdateVisibleItems();
 
             //加速滚动时UI的刷新
@@ -278,41 +301,17 @@ namespace SOUI
                     SList<SItemPanel *> *lstRecycle = m_itemRecycle.GetAt(ii.nType);
                     if(lstRecycle->IsEmpty())
                     {//创建一个新的列表项
-                        ii.pItem = SItemPanel::Create(this,pugi::xml_node(),this);
-                        ii.pItem->GetEventSet()->subscribeEvent(EventItemPanelClick::EventID,Subscriber(&SListView::OnItemClick,this));
+                        ii.pItem = CreateItemPanel();
                     }else
                     {
                         ii.pItem = lstRecycle->RemoveHead();
                     }
-                    ii.pItem->SetItemIndex(iNewLastVisible);
                 }
                 ii.pItem->SetVisible(TRUE);
-                CRect rcItem = GetClientRect();
-                rcItem.MoveToXY(0,0);
-                if(m_lvItemLocator->IsFixHeight())
-                {
-                    rcItem.bottom=m_lvItemLocator->GetItemHeight(iNewLastVisible);
-                    ii.pItem->Move(rcItem);
-                }
-
-                //设置状态，同时暂时禁止应用响应statechanged事件。
-                ii.pItem->GetEventSet()->setMutedState(true);
-                ii.pItem->ModifyItemState(dwState,0);
-                ii.pItem->GetEventSet()->setMutedState(false);
+                CRect rcItem;
+                BindItemPanel(ii.pItem,iNewLastVisible,dwState,TRUE,rcItem);
                 if(dwState & WndState_Hover)
                     m_pHoverItem = ii.pItem;
-
-                m_adapter->getView(iNewLastVisible,ii.pItem,m_xmlTemplate.first_child());
-				ii.pItem->DoColorize(GetColorizeColor());
-                if(!m_lvItemLocator->IsFixHeight())
-                {
-                    rcItem.bottom=0;
-                    CSize szItem = m_adapter->getViewDesiredSize(iNewLastVisible,ii.pItem,&rcItem);
-                    rcItem.bottom = rcItem.top + szItem.cy;
-                    ii.pItem->Move(rcItem);
-                    m_lvItemLocator->SetItemHeight(iNewLastVisible,szItem.cy);
-                }                
-                ii.pItem->UpdateLayout();
                     
                 m_lstItems.AddTail(ii);
                 pos += rcItem.bottom + m_lvItemLocator->GetDividerSize();
@@ -351,6 +350,147 @@ namespace SOUI
         }
     }
 
+    SItemPanel * SListView::CreateItemPanel()
+    {
+        SItemPanel *pItem = SItemPanel::Create(this,pugi::xml_node(),this);
+        pItem->GetEventSet()->subscribeEvent(EventItemPanelClick::EventID,Subscriber(&SListView::OnItemClick,this));
+        return pItem;
+    }
+
+    void SListView::BindItemPanel(SItemPanel *pItem,int iItem,DWORD dwState,BOOL bMeasure,CRect &rcItem)
+    {
+        pItem->SetItemIndex(iItem);
+        rcItem = GetClientRect();
+        rcItem.MoveToXY(0,0);
+        if(m_lvItemLocator->IsFixHeight())
+        {
+            rcItem.bottom=m_lvItemLocator->GetItemHeight(iItem);
+            pItem->Move(rcItem);
+        }
+
+        //设置状态，同时暂时禁止应用响应statechanged事件。
+        pItem->GetEventSet()->setMutedState(true);
+        pItem->ModifyItemState(dwState,0);
+        pItem->GetEventSet()->setMutedState(false);
+
+        m_adapter->getView(iItem,pItem,m_xmlTemplate.first_child());
+        pItem->DoColorize(GetColorizeColor());
+        if(!m_lvItemLocator->IsFixHeight())
+        {
+            //不测量时不改变列表项高度，也就不会改变滚动范围
+            if(!bMeasure) return;
+            rcItem.bottom=0;
+            CSize szItem = m_adapter->getViewDesiredSize(iItem,pItem,&rcItem);
+            rcItem.bottom = rcItem.top + szItem.cy;
+            pItem->Move(rcItem);
+            m_lvItemLocator->SetItemHeight(iItem,szItem.cy);
+        }
+        pItem->UpdateLayout();
+    }
+
+    void SListView::UpdateScrollSpeed(int nDelta)
+    {
+        DWORD dwNow = GetTickCount();
+        DWORD dwElapse = dwNow - m_dwLastScroll;
+        m_dwLastScroll = dwNow;
+        if(dwElapse > KScrollSpeedTimeout)
+        {//重新开始滚动
+            m_fScrollSpeed = (float)nDelta/KScrollFrameTime;
+        }else
+        {
+            float fSpeed = (float)nDelta/(std::max)(dwElapse,KScrollFrameTime);
+            m_fScrollSpeed = (m_fScrollSpeed + fSpeed)*0.5f;
+        }
+    }
+
+    BOOL SListView::PrewarmItemPanels(DWORD dwTimeBudget)
+    {
+        if(!m_adapter || m_iFirstVisible==-1 || m_bDataSetInvalidated) return FALSE;
+
+        //预创建的范围：静止时为可见区域上下各一页，滚动时为滚动方向上m_nPrewarmTime内将要显示的区域
+        float fSpeed = (GetTickCount()-m_dwLastScroll) > KScrollSpeedTimeout ? 0.0f : m_fScrollSpeed;
+        int nAhead = fSpeed == 0.0f ? (int)m_siVer.nPage : abs((int)(fSpeed*m_nPrewarmTime));
+        int nCount = m_adapter->getCount();
+        int iFirst = m_iFirstVisible;
+        int iLast = m_iFirstVisible + (int)m_lstItems.GetCount();
+        int nTop = m_siVer.nPos, nBottom = m_siVer.nPos + (int)m_siVer.nPage;
+
+        SArray<int> arrItems;
+        int iDown = iLast, iUp = iFirst-1;
+        while((int)arrItems.GetCount() < KMaxPrewarmItems)
+        {
+            BOOL bDown = fSpeed >= 0.0f && iDown < nCount && m_lvItemLocator->Item2Position(iDown) < nBottom + nAhead;
+            BOOL bUp = fSpeed <= 0.0f && iUp >= 0 && m_lvItemLocator->Item2Position(iUp) + m_lvItemLocator->GetItemHeight(iUp) > nTop - nAhead;
+            if(!bDown && !bUp) break;
+            if(bDown) arrItems.Add(iDown++);
+            if(bUp) arrItems.Add(iUp--);
+        }
+
+        //UpdateVisibleItems在创建新显示项之后才回收移出的项，因此每种样式的回收站需要覆盖将要显示的同样式列表项
+        int nTypes = (int)m_itemRecycle.GetCount();
+        SArray<int> arrAvail;
+        arrAvail.SetCount(nTypes);
+        for(int i=0;i<nTypes;i++)
+        {
+            arrAvail[i] = (int)m_itemRecycle[i]->GetCount();
+        }
+
+        ULONGLONG ullStart = NowUs();
+        ULONGLONG ullBudget = (ULONGLONG)dwTimeBudget*1000;
+        for(size_t i=0;i<arrItems.GetCount();i++)
+        {
+            int iItem = arrItems[i];
+            DWORD dwState = WndState_Normal;
+            if(m_iSelItem == iItem) dwState |= WndState_Check;
+            int nType = m_adapter->getItemViewType(iItem,dwState);
+            if(nType<0 || nType>=nTypes) continue;
+            if(arrAvail[nType]>0)
+            {
+                arrAvail[nType]--;
+                continue;
+            }
+            if(NowUs()-ullStart >= ullBudget) return TRUE;
+
+            //和UpdateVisibleItems一样创建并初始化列表项，完成后直接放入回收站
+            //状态不带入回收站，显示时重新设置
+            SItemPanel *pItem = CreateItemPanel();
+            CRect rcItem;
+            BindItemPanel(pItem,iItem,WndState_Normal,FALSE,rcItem);
+            pItem->GetEventSet()->setMutedState(true);
+            pItem->SetVisible(FALSE);
+            pItem->GetEventSet()->setMutedState(false);
+            m_itemRecycle[nType]->AddTail(pItem);
+        }
+        return FALSE;
+    }
+
+    BOOL SListView::OnIdle()
+    {
+        if(!m_bPrewarm || !IsVisible(TRUE)) return FALSE;
+        if(!PrewarmItemPanels(KPrewarmBudget)) return FALSE;
+        //SMessageLoop不会因为返回TRUE继续空闲处理，投递一个空消息，
+        //处理完队列中的消息后再次进入空闲，继续预创建剩下的列表项
+        ::PostMessage(GetContainer()->GetHostHwnd(),WM_NULL,0,0);
+        return TRUE;
+    }
+
+    HRESULT SListView::OnAttrPrewarm(const SStringW & strValue,BOOL bLoading)
+    {
+        BOOL bPrewarm = _wtoi(strValue)!=0;
+        if(bPrewarm == m_bPrewarm) return S_FALSE;
+        m_bPrewarm = bPrewarm;
+        if(!bLoading)
+        {//创建完成后修改属性，同步空闲处理器，创建时由OnCreate注册
+            SMessageLoop *pMsgLoop = GetContainer()->GetMsgLoop();
+            if(pMsgLoop)
+            {
+                if(m_bPrewarm) pMsgLoop->AddIdleHandler(this);
+                else pMsgLoop->RemoveIdleHandler(this);
+            }
+        }
+        return S_FALSE;
+    }
+
     void SListView::OnSize(UINT nType, CSize size)
     {
         __super::OnSize(nType,size);
@@ -371,8 +511,22 @@ namespace SOUI
         UpdateVisibleItems();
     }
 
+    int SListView::OnCreate(LPVOID)
+    {
+        int nRet = __super::OnCreate(NULL);
+        if(nRet != 0) return nRet;
+        if(m_bPrewarm)
+        {
+            SMessageLoop *pMsgLoop = GetContainer()->GetMsgLoop();
+            if(pMsgLoop) pMsgLoop->AddIdleHandler(this);
+        }
+        return 0;
+    }
+
     void SListView::OnDestroy()
     {
+        SMessageLoop *pMsgLoop = GetContainer()->GetMsgLoop();
+        if(pMsgLoop) pMsgLoop->RemoveIdleHandler(this);
 		if(m_adapter)
 		{
 			m_adapter->unregisterDataSetObserver(m_observer);
@@ -686,12 +840,55 @@ namespace SOUI
     }
 
 
+    //展开模板中的include结点，避免每次创建列表项时重新加载和解析被包含的布局
+    //只展开由SWindow::CreateChildren创建子窗口的位置：模板根结点及普通window结点的子结点，
+    //其它控件可能重载CreateChildren并以不同方式解释子结点(如tab页，combobox下拉列表，嵌套列表的template)，保持原样
+    static void ExpandTemplateInclude(pugi::xml_node xmlNode)
+    {
+        pugi::xml_node xmlChild = xmlNode.first_child();
+        while(xmlChild)
+        {
+            pugi::xml_node xmlNext = xmlChild.next_sibling();
+            if(xmlChild.type() == pugi::node_element && _wcsicmp(xmlChild.name(),L"include")==0)
+            {
+                SStringT strSrc = S_CW2T(xmlChild.attribute(L"src").value());
+                pugi::xml_document xmlDoc;
+                SStringTList strLst;
+                if(2 == ParseResID(strSrc,strLst))
+                {
+                    LOADXML(xmlDoc,strLst[1],strLst[0]);
+                }else
+                {
+                    LOADXML(xmlDoc,strLst[0],RT_LAYOUT);
+                }
+                pugi::xml_node xmlInclude = xmlDoc.child(L"include");
+                if(xmlInclude)
+                {//被包含的结点插入到include的位置，并从第一个插入的结点继续展开，以支持嵌套的include
+                    pugi::xml_node xmlFirst;
+                    for(pugi::xml_node xmlSub = xmlInclude.first_child(); xmlSub; xmlSub = xmlSub.next_sibling())
+                    {
+                        pugi::xml_node xmlCopy = xmlNode.insert_copy_before(xmlSub,xmlChild);
+                        if(!xmlFirst) xmlFirst = xmlCopy;
+                    }
+                    xmlNode.remove_child(xmlChild);
+                    if(xmlFirst) xmlNext = xmlFirst;
+                }
+                //加载失败时保留include结点，由SWindow::CreateChildren处理
+            }else if(xmlChild.type() == pugi::node_element && _wcsicmp(xmlChild.name(),SWindow::GetClassName())==0)
+            {
+                ExpandTemplateInclude(xmlChild);
+            }
+            xmlChild = xmlNext;
+        }
+    }
+
     BOOL SListView::CreateChildren(pugi::xml_node xmlNode)
     {
         pugi::xml_node xmlTemplate = xmlNode.child(L"template");
         if(xmlTemplate)
         {
             m_xmlTemplate.append_copy(xmlTemplate);
+            ExpandTemplateInclude(m_xmlTemplate.first_child());
 			SLayoutSize nItemHei = SLayoutSize::fromString(xmlTemplate.attribute(L"itemHeight").value());
             if(nItemHei.fSize>0.0f)
             {//指定了itemHeight属性时创建一个固定行高的定位器
@@ -1,12 +1,262 @@
 ﻿#include "souistd.h"
 #include "control/SMCListView.h"
 #include "helper/SListViewItemLocator.h"
+#include <process.h>
 
 #pragma warning(disable : 4267 4018)
 
 #define ITEM_MARGIN 4
+#define TIMER_SORT  3       //检查异步排序是否完成的定时器
 namespace SOUI
 {
+    const static int KMinAsyncSortCount = 10000;    //行数少于该值时在UI线程中排序
+    const static int KMinSortChunk = 32768;         //并行排序时每个线程至少处理的行数
+    const static int KMaxSortThreads = 8;
+    const static int KSortRun = 32;                 //先用插入排序处理的序列长度
+    const static int KCancelCheck = 4096;           //合并时每处理这么多行检查一次是否放弃
+
+    //////////////////////////////////////////////////////////////////////////
+    //  SMcSortJob
+    //  使用IMcAdapter::OnSortCompare生成排序索引，数据较多时分块在多个线程中排序再逐层合并
+    //  分块排序及每一层合并都在系统线程池中执行，各层之间复用线程
+    class SMcSortJob
+    {
+    public:
+        SMcSortJob(IMcAdapter *pAdapter,int nCount)
+            :m_pAdapter(pAdapter)
+            ,m_nCount(nCount)
+            ,m_bCancel(0)
+            ,m_hThread(NULL)
+            ,m_hTaskDone(NULL)
+        {
+            m_pIndex = new int[nCount];
+            m_pTemp = new int[nCount];
+            for(int i=0;i<nCount;i++) m_pIndex[i]=i;
+        }
+
+        ~SMcSortJob()
+        {
+            if(m_hThread) ::CloseHandle(m_hThread);
+            delete []m_pIndex;
+            delete []m_pTemp;
+        }
+
+        //记录排序完成后表头需要显示的排序状态
+        void SetHeaderSort(const int *pOrders,const SHDSORTFLAG *pstFlags,int nCols)
+        {
+            m_arrOrders.SetCount(nCols);
+            m_arrFlags.SetCount(nCols);
+            for(int i=0;i<nCols;i++)
+            {
+                m_arrOrders[i] = pOrders[i];
+                m_arrFlags[i] = pstFlags[i];
+            }
+        }
+
+        BOOL Start()
+        {
+            m_hThread = (HANDLE)_beginthreadex(NULL,0,SortProc,this,0,NULL);
+            return m_hThread!=NULL;
+        }
+
+        void Cancel()
+        {
+            InterlockedExchange(&m_bCancel,1);
+        }
+
+        bool IsCancelled() const
+        {
+            return m_bCancel!=0;
+        }
+
+        void Sort();
+
+        CAutoRefPtr<IMcAdapter> m_pAdapter;
+        int             m_nCount;
+        int *           m_pIndex;   /**<排序结果*/
+        HANDLE          m_hThread;
+        SArray<int>         m_arrOrders;    /**<表头列号*/
+        SArray<SHDSORTFLAG> m_arrFlags;     /**<表头各列的排序标志*/
+
+    protected:
+        typedef unsigned int (__stdcall *FunSortTask)(LPVOID);
+        struct SORTTASK
+        {
+            SMcSortJob *pJob;
+            int nLo,nMid,nHi;
+            FunSortTask     pfnProc;
+            volatile LONG * pnPending;  /**<本层未完成的任务数*/
+        };
+
+        static unsigned int __stdcall SortProc(LPVOID pParam);
+        static unsigned int __stdcall SortChunkProc(LPVOID pParam);
+        static unsigned int __stdcall MergeChunkProc(LPVOID pParam);
+        static DWORD WINAPI PoolTaskProc(LPVOID pParam);
+
+        //前面的任务提交到线程池，最后一个任务在当前线程中执行，全部完成后返回
+        void RunTasks(SORTTASK *pTasks,int nTasks,FunSortTask pfnProc);
+
+        bool SortRange(int nLo,int nHi);
+
+        //合并pSrc中[nLo,nMid)及[nMid,nHi)两个有序序列到pDst
+        bool MergeRun(const int *pSrc,int *pDst,int nLo,int nMid,int nHi);
+
+        int *           m_pTemp;
+        volatile LONG   m_bCancel;
+        HANDLE          m_hTaskDone;    /**<一层任务全部完成时触发*/
+    };
+
+    unsigned int SMcSortJob::SortProc(LPVOID pParam)
+    {
+        SMcSortJob *_this = (SMcSortJob*)pParam;
+        _this->Sort();
+        return 0;
+    }
+
+    unsigned int SMcSortJob::SortChunkProc(LPVOID pParam)
+    {
+        SORTTASK *pTask = (SORTTASK*)pParam;
+        pTask->pJob->SortRange(pTask->nLo,pTask->nHi);
+        return 0;
+    }
+
+    unsigned int SMcSortJob::MergeChunkProc(LPVOID pParam)
+    {
+        SORTTASK *pTask = (SORTTASK*)pParam;
+        SMcSortJob *pJob = pTask->pJob;
+        if(pJob->MergeRun(pJob->m_pIndex,pJob->m_pTemp,pTask->nLo,pTask->nMid,pTask->nHi))
+        {
+            memcpy(pJob->m_pIndex+pTask->nLo,pJob->m_pTemp+pTask->nLo,(pTask->nHi-pTask->nLo)*sizeof(int));
+        }
+        return 0;
+    }
+
+    DWORD SMcSortJob::PoolTaskProc(LPVOID pParam)
+    {
+        SORTTASK *pTask = (SORTTASK*)pParam;
+        HANDLE hDone = pTask->pJob->m_hTaskDone;
+        pTask->pfnProc(pTask);
+        if(InterlockedDecrement(pTask->pnPending)==0) ::SetEvent(hDone);
+        return 0;
+    }
+
+    void SMcSortJob::RunTasks(SORTTASK *pTasks,int nTasks,FunSortTask pfnProc)
+    {
+        //先计入所有任务再提交，避免提前完成的任务触发事件
+        volatile LONG nPending = nTasks;
+        for(int i=0;i<nTasks-1;i++)
+        {
+            pTasks[i].pfnProc = pfnProc;
+            pTasks[i].pnPending = &nPending;
+            if(!m_hTaskDone || !::QueueUserWorkItem(PoolTaskProc,pTasks+i,WT_EXECUTELONGFUNCTION))
+            {
+                pfnProc(pTasks+i);
+                InterlockedDecrement(&nPending);
+            }
+        }
+        pfnProc(pTasks+nTasks-1);
+        if(InterlockedDecrement(&nPending)!=0) ::WaitForSingleObject(m_hTaskDone,INFINITE);
+    }
+
+    void SMcSortJob::Sort()
+    {
+        SYSTEM_INFO si;
+        ::GetSystemInfo(&si);
+        int nThreads = m_nCount/KMinSortChunk;
+        if(nThreads > (int)si.dwNumberOfProcessors) nThreads = si.dwNumberOfProcessors;
+        if(nThreads > KMaxSortThreads) nThreads = KMaxSortThreads;
+        if(nThreads <= 1)
+        {
+            SortRange(0,m_nCount);
+            return;
+        }
+
+        m_hTaskDone = ::CreateEvent(NULL,FALSE,FALSE,NULL);
+        SORTTASK tasks[KMaxSortThreads];
+        int nBounds[KMaxSortThreads+1];
+        for(int i=0;i<=nThreads;i++)
+        {
+            nBounds[i] = (int)((__int64)m_nCount*i/nThreads);
+        }
+        for(int i=0;i<nThreads;i++)
+        {
+            tasks[i].pJob = this;
+            tasks[i].nLo = nBounds[i];
+            tasks[i].nHi = nBounds[i+1];
+        }
+        RunTasks(tasks,nThreads,SortChunkProc);
+
+        //逐层合并相邻的块
+        for(int nStep=1;nStep<nThreads && !IsCancelled();nStep*=2)
+        {
+            int nTasks = 0;
+            for(int i=0;i+nStep<nThreads;i+=2*nStep)
+            {
+                tasks[nTasks].nLo = nBounds[i];
+                tasks[nTasks].nMid = nBounds[i+nStep];
+                tasks[nTasks].nHi = nBounds[smin(i+2*nStep,nThreads)];
+                nTasks++;
+            }
+            RunTasks(tasks,nTasks,MergeChunkProc);
+        }
+        if(m_hTaskDone) ::CloseHandle(m_hTaskDone);
+        m_hTaskDone = NULL;
+    }
+
+    bool SMcSortJob::SortRange(int nLo,int nHi)
+    {
+        for(int i=nLo;i<nHi;i+=KSortRun)
+        {
+            int nEnd = smin(i+KSortRun,nHi);
+            for(int j=i+1;j<nEnd;j++)
+            {
+                int iItem = m_pIndex[j];
+                int k = j;
+                while(k>i && m_pAdapter->OnSortCompare(m_pIndex[k-1],iItem)>0)
+                {
+                    m_pIndex[k] = m_pIndex[k-1];
+                    k--;
+                }
+                m_pIndex[k] = iItem;
+            }
+            if(IsCancelled()) return false;
+        }
+
+        int *pSrc = m_pIndex, *pDst = m_pTemp;
+        for(int nWidth=KSortRun;nWidth<nHi-nLo;nWidth*=2)
+        {
+            for(int i=nLo;i<nHi;i+=2*nWidth)
+            {
+                if(!MergeRun(pSrc,pDst,i,smin(i+nWidth,nHi),smin(i+2*nWidth,nHi))) return false;
+            }
+            int *pTmp = pSrc;
+            pSrc = pDst;
+            pDst = pTmp;
+        }
+        if(pSrc != m_pIndex)
+        {
+            memcpy(m_pIndex+nLo,pSrc+nLo,(nHi-nLo)*sizeof(int));
+        }
+        return true;
+    }
+
+    bool SMcSortJob::MergeRun(const int *pSrc,int *pDst,int nLo,int nMid,int nHi)
+    {
+        int i=nLo, j=nMid, k=nLo;
+        while(i<nMid && j<nHi)
+        {
+            //相等时先取前一个序列的行，保证排序是稳定的
+            if(m_pAdapter->OnSortCompare(pSrc[j],pSrc[i])<0)
+                pDst[k++] = pSrc[j++];
+            else
+                pDst[k++] = pSrc[i++];
+            if((k & (KCancelCheck-1))==0 && IsCancelled()) return false;
+        }
+        if(i<nMid) memcpy(pDst+k,pSrc+i,(nMid-i)*sizeof(int));
+        if(j<nHi) memcpy(pDst+k,pSrc+j,(nHi-j)*sizeof(int));
+        return true;
+    }
+
     class SMCListViewDataSetObserver : public TObjRefImpl<ILvDataSetObserver>
     {
     public:
@@ -43,6 +293,7 @@ namespace SOUI
         ,m_pSkinDivider(NULL)
         ,m_bWantTab(FALSE)
         ,m_bDatasetInvalidated(TRUE)
+        ,m_pSortJob(NULL)
     {
         m_bFocusable = TRUE;
         m_bClipClient = TRUE;
@@ -69,6 +320,7 @@ namespace SOUI
             return FALSE;
         }
 
+        CancelSort();
         if(m_adapter)
         {
             m_adapter->unregisterDataSetObserver(m_observer);
@@ -329,7 +581,13 @@ bool SMCListView::OnHeaderClick(EventArgs *pEvt)
         pOrders[hi.iOrder]=i;
         if(i == pEvt2->iItem) iCol = hi.iOrder;
     }
-    if(m_adapter->OnSort(iCol,pstFlags,m_pHeader->GetItemCount()))
+    CancelSort();//放弃上一次点击表头的排序
+    if(m_adapter->OnSortPrepare(iCol,pstFlags,m_pHeader->GetItemCount()))
+    {
+        //表头的排序状态在排序结果应用后更新
+        StartSort(pOrders,pstFlags,m_pHeader->GetItemCount());
+    }
+    else if(m_adapter->OnSort(iCol,pstFlags,m_pHeader->GetItemCount()))
     {
         //更新表头的排序状态
         for(int i=0;i<m_pHeader->GetItemCount();i++)
@@ -383,9 +641,79 @@ bool SMCListView::OnHeaderSwap(EventArgs *pEvt)
     return true;
 }
 
+void SMCListView::StartSort(const int *pOrders,const SHDSORTFLAG *pstFlags,int nCols)
+{
+    SMcSortJob *pJob = new SMcSortJob(m_adapter,m_adapter->getCount());
+    pJob->SetHeaderSort(pOrders,pstFlags,nCols);
+    if(pJob->m_nCount >= KMinAsyncSortCount && pJob->Start())
+    {//排序完成前继续按原来的顺序显示
+        m_pSortJob = pJob;
+        SetTimer(TIMER_SORT,30);
+        return;
+    }
+    pJob->Sort();
+    OnSortDone(pJob);
+    delete pJob;
+}
+
+void SMCListView::OnSortDone(SMcSortJob *pJob)
+{
+    if(pJob->m_nCount != m_adapter->getCount()) return;//排序过程中数据被修改了
+    //选中行跟随数据移动
+    if(m_iSelItem != -1)
+    {
+        for(int i=0;i<pJob->m_nCount;i++)
+        {
+            if(pJob->m_pIndex[i] == m_iSelItem)
+            {
+                m_iSelItem = i;
+                break;
+            }
+        }
+    }
+    m_adapter->OnSortDone(pJob->m_pIndex,pJob->m_nCount);
+    //更新表头的排序状态
+    for(size_t i=0;i<pJob->m_arrOrders.GetCount();i++)
+    {
+        m_pHeader->SetItemSort(pJob->m_arrOrders[i],pJob->m_arrFlags[i]);
+    }
+    onDataSetChanged();
+}
+
+void SMCListView::CancelSort()
+{
+    if(!m_pSortJob) return;
+    KillTimer(TIMER_SORT);
+    m_pSortJob->Cancel();
+    ::WaitForSingleObject(m_pSortJob->m_hThread,INFINITE);
+    delete m_pSortJob;
+    m_pSortJob = NULL;
+}
+
+void SMCListView::OnTimer(char cTimerID)
+{
+    if(cTimerID == TIMER_SORT)
+    {
+        if(m_pSortJob && ::WaitForSingleObject(m_pSortJob->m_hThread,0) != WAIT_OBJECT_0) return;
+        KillTimer(TIMER_SORT);
+        SMcSortJob *pJob = m_pSortJob;
+        m_pSortJob = NULL;
+        if(pJob)
+        {
+            OnSortDone(pJob);
+            delete pJob;
+        }
+    }else
+    {
+        __super::OnTimer(cTimerID);
+    }
+}
+
 
 void SMCListView::onDataSetChanged()
 {
+    //数据已经改变，正在进行的排序结果不再有效
+    CancelSort();
     if(!m_adapter) return;
 
 	//更新列显示状态
@@ -407,6 +735,7 @@ void SMCListView::onDataSetChanged()
 
 void SMCListView::onDataSetInvalidated()
 {
+    CancelSort();
     m_bDatasetInvalidated = TRUE;
     Invalidate();
 }
@@ -647,6 +976,7 @@ void SMCListView::OnSize(UINT nType, CSize size)
 
 void SMCListView::OnDestroy()
 {
+    CancelSort();
 	if(m_adapter)
 	{
 		m_adapter->unregisterDataSetObserver(m_observer);
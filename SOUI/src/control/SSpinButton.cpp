@@ -11,7 +11,6 @@ namespace SOUI
 		, m_nHover(-1)
 		, m_uStep(1)
 		, m_bCircle(true)
-		, m_iNextTime(0)
     {
 		m_bFocusable = TRUE;
 		m_pSpinSkin = GETSKIN(L"_skin.sys.btn.spin", 100);
@@ -114,23 +113,16 @@ namespace SOUI
 	void SSpinButton::OnNextFrame()
 	{
 		if(m_bFirst)
-		{
-			if (m_iNextTime < 50)
-			{
-				++m_iNextTime;
-				return;
-			}
-			m_iNextTime = 0;
+		{//ºʱ500msٿʼ仯
 			m_bFirst = false;
+			GetContainer()->ScheduleTimelineHandler(this, 500);
+			return;
 		}
 
-		if (m_iNextTime > 5) 
-			m_iNextTime = 0;
-
-		if (m_iNextTime == 0 && IsPlaying())
+		if (IsPlaying())
 			ChangeValue(m_nHover);
 
-		++m_iNextTime;
+		GetContainer()->ScheduleTimelineHandler(this, 60);
 	}
 
 	void SSpinButton::OnLButtonDown(UINT nFlags, CPoint pt)
@@ -193,7 +185,6 @@ namespace SOUI
 	void SSpinButton::Start()
 	{
 		m_bFirst = true;
-		m_iNextTime = 0;
 		if (IsVisible(TRUE)) 
 			GetContainer()->RegisterTimelineHandler(this);
 	}
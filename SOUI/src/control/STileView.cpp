@@ -188,21 +188,13 @@ void STileView::OnPaint(IRenderTarget *pRT)
         CRect rcClip, rcInter;
         pRT->GetClipBox(&rcClip);
         
-        int nOffset = m_tvItemLocator->Item2Position(iFirst) - m_siVer.nPos;
-        int nLastBottom = rcClient.top + m_tvItemLocator->GetMarginSize() + nOffset;
-        
+        //显示项不一定连续(瀑布流各列的显示行不同)，按item自己的index定位
         SPOSITION pos = m_lstItems.GetHeadPosition();
-        int i = 0;
-        for(; pos; i++)
+        while(pos)
         {
             ItemInfo ii = m_lstItems.GetNext(pos);
-            CRect rcItem = m_tvItemLocator->GetItemRect(iFirst + i);
-            rcItem.OffsetRect(rcClient.left, 0);
-            rcItem.MoveToY(nLastBottom);
-            if(m_tvItemLocator->IsLastInRow(iFirst + i))
-            {
-                nLastBottom = rcItem.bottom + m_tvItemLocator->GetMarginSize();
-            }
+            CRect rcItem = m_tvItemLocator->GetItemRect((int)ii.pItem->GetItemIndex());
+            rcItem.OffsetRect(rcClient.left, rcClient.top - m_siVer.nPos);
             
             rcInter.IntersectRect(&rcClip, &rcItem);
             if(!rcInter.IsRectEmpty())
@@ -241,16 +233,18 @@ void STileView::UpdateVisibleItems()
     {
         return;
     }
-    int iOldFirstVisible = m_iFirstVisible;
-    int iOldLastVisible = m_iFirstVisible + (int)m_lstItems.GetCount();
+    int nOldTotalHeight = m_tvItemLocator->GetTotalHeight();
     
-    int iNewFirstVisible = m_tvItemLocator->Position2Item(m_siVer.nPos);
-    int iNewLastVisible = iNewFirstVisible;
+    //瀑布流中各列显示的行不同，显示项按列分别查找，只创建和显示区域相交的item
+    SArray<int> arrVisible;
+    m_tvItemLocator->GetVisibleItems(m_siVer.nPos, m_siVer.nPos + (int)m_siVer.nPage, arrVisible);
+    int iNewFirstVisible = arrVisible.IsEmpty() ? -1 : arrVisible[0];
+    BOOL bHeightChanged = FALSE;
     
-    int pos = m_tvItemLocator->Item2Position(iNewFirstVisible);
     int iHoverItem = m_pHoverItem?(int)m_pHoverItem->GetItemIndex():-1;
 
-    ItemInfo *pItemInfos = new ItemInfo[m_lstItems.GetCount()];
+    int nOldItems = (int)m_lstItems.GetCount();
+    ItemInfo *pItemInfos = new ItemInfo[nOldItems];
     SPOSITION spos = m_lstItems.GetHeadPosition();
     int i = 0;
     while(spos)
@@ -260,75 +254,83 @@ void STileView::UpdateVisibleItems()
     
     m_lstItems.RemoveAll();
     
-    if(iNewFirstVisible != -1)
+    int iOld = 0;
+    for(size_t iVisible = 0; iVisible < arrVisible.GetCount(); iVisible++)
     {
-        while(pos < m_siVer.nPos + (int)m_siVer.nPage && iNewLastVisible < m_adapter->getCount())
-        {
-            DWORD dwState = WndState_Normal;
-            if(iHoverItem == iNewLastVisible) dwState |= WndState_Hover;
-            if(m_iSelItem == iNewLastVisible) dwState |= WndState_Check;
+        int iItem = arrVisible[iVisible];
+        DWORD dwState = WndState_Normal;
+        if(iHoverItem == iItem) dwState |= WndState_Hover;
+        if(m_iSelItem == iItem) dwState |= WndState_Check;
 
-            ItemInfo ii = {NULL, -1};
-            ii.nType = m_adapter->getItemViewType(iNewLastVisible,dwState);
-            if(iNewLastVisible >= iOldFirstVisible && iNewLastVisible < iOldLastVisible)
+        ItemInfo ii = {NULL, -1};
+        ii.nType = m_adapter->getItemViewType(iItem,dwState);
+        //新旧显示项都按index升序排列，同时向后查找
+        while(iOld < nOldItems && (int)pItemInfos[iOld].pItem->GetItemIndex() < iItem)
+        {
+            iOld++;
+        }
+        if(iOld < nOldItems && (int)pItemInfos[iOld].pItem->GetItemIndex() == iItem)
+        {
+            //use the old visible item
+            if(ii.nType == pItemInfos[iOld].nType)
+            {
+                ii = pItemInfos[iOld];
+                pItemInfos[iOld].pItem = NULL;//标记该行已经被重用
+            }
+            iOld++;
+        }
+        if(!ii.pItem)
+        {
+            //create new visible item
+            SList<SItemPanel *> *lstRecycle = m_itemRecycle.GetAt(ii.nType);
+            if(lstRecycle->IsEmpty())
             {
-                //use the old visible item
-                int iItem = iNewLastVisible - iOldFirstVisible;
-                SASSERT(iItem >= 0 && iItem <= (iOldLastVisible - iOldFirstVisible));
-                if(ii.nType == pItemInfos[iItem].nType)
-                {
-                    ii = pItemInfos[iItem];
-                    pItemInfos[iItem].pItem = NULL;//标记该行已经被重用
-                }
+                //创建一个新的列表项
+                ii.pItem = SItemPanel::Create(this, pugi::xml_node(), this);
+                ii.pItem->GetEventSet()->subscribeEvent(EventItemPanelClick::EventID,Subscriber(&STileView::OnItemClick,this));
             }
-            if(!ii.pItem)
+            else
             {
-                //create new visible item
-                SList<SItemPanel *> *lstRecycle = m_itemRecycle.GetAt(ii.nType);
-                if(lstRecycle->IsEmpty())
-                {
-                    //创建一个新的列表项
-                    ii.pItem = SItemPanel::Create(this, pugi::xml_node(), this);
-                    ii.pItem->GetEventSet()->subscribeEvent(EventItemPanelClick::EventID,Subscriber(&STileView::OnItemClick,this));
-                }
-                else
-                {
-                    ii.pItem = lstRecycle->RemoveHead();
-                }
-                ii.pItem->SetItemIndex(iNewLastVisible);
+                ii.pItem = lstRecycle->RemoveHead();
             }
-            ii.pItem->SetVisible(TRUE);
-            CRect rcItem = m_tvItemLocator->GetItemRect(iNewLastVisible);
-            rcItem.MoveToXY(0, 0);
-            ii.pItem->Move(rcItem);
+            ii.pItem->SetItemIndex(iItem);
+        }
+        ii.pItem->SetVisible(TRUE);
+        CRect rcItem = m_tvItemLocator->GetItemRect(iItem);
+        rcItem.MoveToXY(0, 0);
+        ii.pItem->Move(rcItem);
 
-            //设置状态，同时暂时禁止应用响应statechanged事件。
-            ii.pItem->GetEventSet()->setMutedState(true);
-            ii.pItem->ModifyItemState(dwState,0);
-            ii.pItem->GetEventSet()->setMutedState(false);
+        //设置状态，同时暂时禁止应用响应statechanged事件。
+        ii.pItem->GetEventSet()->setMutedState(true);
+        ii.pItem->ModifyItemState(dwState,0);
+        ii.pItem->GetEventSet()->setMutedState(false);
 
-            m_adapter->getView(iNewLastVisible, ii.pItem, m_xmlTemplate.first_child());
+        m_adapter->getView(iItem, ii.pItem, m_xmlTemplate.first_child());
 			ii.pItem->DoColorize(GetColorizeColor());
 
-            ii.pItem->UpdateLayout();
-            if(iNewLastVisible == m_iSelItem)
-            {
-                ii.pItem->ModifyItemState(WndState_Check, 0);
-            }
-            
-            m_lstItems.AddTail(ii);
-            
-            if(m_tvItemLocator->IsLastInRow(iNewLastVisible))
+        if(!m_tvItemLocator->IsFixHeight())
+        {
+            rcItem.bottom = 0;
+            CSize szItem = m_adapter->getViewDesiredSize(iItem, ii.pItem, &rcItem);
+            rcItem.bottom = rcItem.top + szItem.cy;
+            ii.pItem->Move(rcItem);
+            if(szItem.cy != m_tvItemLocator->GetItemHeight(iItem))
             {
-                pos += rcItem.Height() + m_tvItemLocator->GetMarginSize();
+                m_tvItemLocator->SetItemHeight(iItem, szItem.cy);
+                bHeightChanged = TRUE;
             }
-            
-            iNewLastVisible ++;
         }
+        ii.pItem->UpdateLayout();
+        if(iItem == m_iSelItem)
+        {
+            ii.pItem->ModifyItemState(WndState_Check, 0);
+        }
+        
+        m_lstItems.AddTail(ii);
     }
     
     //move old visible items which were not reused to recycle
-    for(int i = 0; i < (iOldLastVisible - iOldFirstVisible); i++)
+    for(int i = 0; i < nOldItems; i++)
     {
         ItemInfo ii = pItemInfos[i];
         if(!ii.pItem)
@@ -353,6 +355,17 @@ void STileView::UpdateVisibleItems()
     delete [] pItemInfos;
     
     m_iFirstVisible = iNewFirstVisible;
+    
+    if(bHeightChanged)
+    {
+        //测量后的高度改变了同一列后面item的位置，重新计算显示项
+        if(m_tvItemLocator->GetTotalHeight() != nOldTotalHeight)
+        {
+            //update scroll range
+            UpdateScrollBar();
+        }
+        UpdateVisibleItems();//根据新的滚动条状态重新记录显示列表项
+    }
 }
 
 void STileView::OnSize(UINT nType, CSize size)
@@ -703,10 +716,23 @@ BOOL STileView::CreateChildren(pugi::xml_node xmlNode)
         {
             //创建一个定位器
             //STileViewItemLocator *pItemLocator = new  STileViewItemLocator(nItemHei, nItemWid, m_nMarginSize);
-            STileViewItemLocator *pItemLocator = new STileViewItemLocator(
-                xmlTemplate.attribute(L"itemHeight").as_string(L"10dp"),
-                xmlTemplate.attribute(L"itemWidth").as_string(L"10dp"),
-                m_nMarginSize);
+            STileViewItemLocator *pItemLocator = NULL;
+            pugi::xml_attribute xmlDefHei = xmlTemplate.attribute(L"defHeight");
+            if(xmlDefHei && !xmlTemplate.attribute(L"itemHeight"))
+            {
+                //只指定defHeight时item高度由getViewDesiredSize决定，按瀑布流排列
+                pItemLocator = new STileViewItemLocatorMasonry(
+                    xmlDefHei.as_string(),
+                    xmlTemplate.attribute(L"itemWidth").as_string(L"10dp"),
+                    m_nMarginSize);
+            }
+            else
+            {
+                pItemLocator = new STileViewItemLocator(
+                    xmlTemplate.attribute(L"itemHeight").as_string(L"10dp"),
+                    xmlTemplate.attribute(L"itemWidth").as_string(L"10dp"),
+                    m_nMarginSize);
+            }
             SetItemLocator(pItemLocator);
             pItemLocator->Release();
         }
@@ -0,0 +1,174 @@
+﻿#include "souistd.h"
+#include "core/SHitTestIndex.h"
+
+namespace SOUI
+{
+    SHitTestIndex::SHitTestIndex(SWindow *pRoot,int nCellSize)
+        :m_pRoot(pRoot)
+        ,m_nCellSize(nCellSize>0?nCellSize:64)
+        ,m_nCols(0)
+        ,m_nRows(0)
+        ,m_pCells(NULL)
+        ,m_bDirty(TRUE)
+        ,m_nDeadWnd(0)
+    {
+        SASSERT(m_pRoot);
+    }
+
+    SHitTestIndex::~SHitTestIndex()
+    {
+        if(m_pCells) delete []m_pCells;
+    }
+
+    void SHitTestIndex::Rebuild()
+    {
+        if(m_pCells) delete []m_pCells;
+        m_pCells = NULL;
+        m_mapWndRect.RemoveAll();
+        m_nDeadWnd = 0;
+
+        m_rcGrid = m_pRoot->GetWindowRect();
+        m_nCols = (m_rcGrid.Width() + m_nCellSize - 1)/m_nCellSize;
+        m_nRows = (m_rcGrid.Height() + m_nCellSize - 1)/m_nCellSize;
+        if(m_nCols>0 && m_nRows>0)
+        {
+            m_pCells = new SArray<SWND>[m_nCols*m_nRows];
+        }
+        m_bDirty = FALSE;
+
+        SWindow *pChild = m_pRoot->GetWindow(GSW_FIRSTCHILD);
+        while(pChild)
+        {
+            UpdateTree(pChild);
+            pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+        }
+    }
+
+    BOOL SHitTestIndex::_GetCellRange(const CRect & rc,CRect & rcCell) const
+    {
+        if(!m_pCells) return FALSE;
+        CRect rcInter;
+        if(!rcInter.IntersectRect(rc,m_rcGrid)) return FALSE;
+        rcCell.left = (rcInter.left - m_rcGrid.left)/m_nCellSize;
+        rcCell.top = (rcInter.top - m_rcGrid.top)/m_nCellSize;
+        rcCell.right = (rcInter.right - 1 - m_rcGrid.left)/m_nCellSize;
+        rcCell.bottom = (rcInter.bottom - 1 - m_rcGrid.top)/m_nCellSize;
+        return TRUE;
+    }
+
+    void SHitTestIndex::_AddWindow(SWindow *pWnd)
+    {
+        CRect rc = pWnd->GetWindowRect();
+        SWND swnd = pWnd->GetSwnd();
+        m_mapWndRect[swnd] = rc;
+
+        CRect rcCell;
+        if(!_GetCellRange(rc,rcCell)) return;
+        for(int y=rcCell.top;y<=rcCell.bottom;y++)
+        {
+            for(int x=rcCell.left;x<=rcCell.right;x++)
+            {
+                m_pCells[y*m_nCols+x].Add(swnd);
+            }
+        }
+    }
+
+    void SHitTestIndex::_RemoveWindow(SWND swnd,const CRect & rc)
+    {
+        CRect rcCell;
+        if(!_GetCellRange(rc,rcCell)) return;
+        for(int y=rcCell.top;y<=rcCell.bottom;y++)
+        {
+            for(int x=rcCell.left;x<=rcCell.right;x++)
+            {
+                SArray<SWND> & cell = m_pCells[y*m_nCols+x];
+                for(size_t i=0;i<cell.GetCount();i++)
+                {
+                    if(cell[i] == swnd)
+                    {
+                        cell.RemoveAt(i);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void SHitTestIndex::UpdateWindow(SWindow *pWnd)
+    {
+        if(m_bDirty) return;
+        if(pWnd == m_pRoot)
+        {//根窗口大小改变时重建网格
+            if(!m_rcGrid.EqualRect(pWnd->GetWindowRect())) m_bDirty = TRUE;
+            return;
+        }
+        SMap<SWND,CRect>::CPair *p = m_mapWndRect.Lookup(pWnd->GetSwnd());
+        if(p)
+        {
+            if(p->m_value.EqualRect(pWnd->GetWindowRect())) return;
+            _RemoveWindow(p->m_key,p->m_value);
+        }
+        _AddWindow(pWnd);
+    }
+
+    void SHitTestIndex::UpdateTree(SWindow *pWnd)
+    {
+        if(m_bDirty) return;
+        UpdateWindow(pWnd);
+        SWindow *pChild = pWnd->GetWindow(GSW_FIRSTCHILD);
+        while(pChild)
+        {
+            UpdateTree(pChild);
+            pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+        }
+    }
+
+    BOOL SHitTestIndex::_IsHitCandidate(SWindow *pWnd,const CPoint & pt) const
+    {
+        if(!pWnd->IsVisible(TRUE) || pWnd->IsMsgTransparent()) return FALSE;
+        if(!pWnd->IsContainPoint(pt,FALSE)) return FALSE;
+
+        //递归查找只在点位于父窗口客户区内时才进入子窗口
+        SWindow *pParent = pWnd->GetParent();
+        while(pParent && pParent != m_pRoot)
+        {
+            if(pParent->IsMsgTransparent()) return FALSE;
+            if(!pParent->IsContainPoint(pt,FALSE) || !pParent->IsContainPoint(pt,TRUE)) return FALSE;
+            pParent = pParent->GetParent();
+        }
+        return pParent == m_pRoot;//已经从窗口树上移除的窗口不参与查找
+    }
+
+    SWND SHitTestIndex::SwndFromPoint(const CPoint & pt,BOOL bOnlyText)
+    {
+        if(bOnlyText) return m_pRoot->SWindow::SwndFromPoint(pt,bOnlyText);
+        if(!m_pRoot->IsContainPoint(pt,FALSE)) return NULL;
+        if(!m_pRoot->IsContainPoint(pt,TRUE)) return m_pRoot->GetSwnd();
+
+        if(m_bDirty) Rebuild();
+        if(!m_pCells || !m_rcGrid.PtInRect(pt)) return m_pRoot->GetSwnd();
+
+        //满足条件的窗口中zorder最大的一个就是递归查找的结果
+        SWindow *pHit = NULL;
+        int iCell = ((pt.y - m_rcGrid.top)/m_nCellSize)*m_nCols + (pt.x - m_rcGrid.left)/m_nCellSize;
+        SArray<SWND> & cell = m_pCells[iCell];
+        for(size_t i=0;i<cell.GetCount();i++)
+        {
+            SWindow *pWnd = SWindowMgr::GetWindow(cell[i]);
+            if(!pWnd)
+            {//窗口已经销毁，销毁的窗口较多时重建索引
+                cell.RemoveAt(i--);
+                if(++m_nDeadWnd*4 > m_mapWndRect.GetCount()) m_bDirty = TRUE;
+                continue;
+            }
+            if(pWnd->HasCustomHitTest() && pWnd->IsVisible(TRUE))
+            {//重载的SwndFromPoint可能改变查找结果，改用递归查找
+                return m_pRoot->SWindow::SwndFromPoint(pt,FALSE);
+            }
+            if(pHit && pWnd->m_uZorder <= pHit->m_uZorder) continue;
+            if(_IsHitCandidate(pWnd,pt)) pHit = pWnd;
+        }
+        return pHit?pHit->GetSwnd():m_pRoot->GetSwnd();
+    }
+
+}//namespace SOUI
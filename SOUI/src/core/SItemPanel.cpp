@@ -373,16 +373,54 @@ void SItemPanel::BeforePaint(IRenderTarget *pRT, SPainter &painter)
 void SItemPanel::OnShowWindow(BOOL bShow, UINT nStatus)
 {
     __super::OnShowWindow(bShow,nStatus);
-    if(IsVisible(TRUE))
-        m_pFrmHost->GetContainer()->RegisterTimelineHandler(this);
-    else
-        m_pFrmHost->GetContainer()->UnregisterTimelineHandler(this);
+    _SyncTimeline();
+}
+
+void SItemPanel::_SyncTimeline()
+{
+    ISwndContainer *pHostContainer = m_pFrmHost->GetContainer();
+    if(m_timeline.IsEmpty() || !IsVisible(TRUE))
+    {
+        pHostContainer->UnregisterTimelineHandler(this);
+    }else
+    {
+        pHostContainer->RegisterTimelineHandler(this);
+        pHostContainer->ScheduleTimelineHandler(this,m_timeline.GetNextDelay());
+    }
+}
+
+BOOL SItemPanel::RegisterTimelineHandler(ITimelineHandler *pHandler)
+{
+    BOOL bRet = __super::RegisterTimelineHandler(pHandler);
+    if(bRet) _SyncTimeline();
+    return bRet;
+}
+
+BOOL SItemPanel::UnregisterTimelineHandler(ITimelineHandler *pHandler)
+{
+    BOOL bRet = __super::UnregisterTimelineHandler(pHandler);
+    if(bRet) _SyncTimeline();
+    return bRet;
+}
+
+BOOL SItemPanel::ScheduleTimelineHandler(ITimelineHandler *pHandler,UINT nDelay)
+{
+    BOOL bRet = __super::ScheduleTimelineHandler(pHandler,nDelay);
+    if(bRet) _SyncTimeline();
+    return bRet;
+}
+
+void SItemPanel::OnNextFrame()
+{
+    __super::OnNextFrame();
+    _SyncTimeline();
 }
 
 void SItemPanel::OnDestroy()
 {
-    m_pFrmHost->GetContainer()->UnregisterTimelineHandler(this);
     __super::OnDestroy();
+    //子窗口销毁时会注销各自的handler，最后再从宿主容器中注销
+    m_pFrmHost->GetContainer()->UnregisterTimelineHandler(this);
 }
 
 int SItemPanel::GetScale() const
@@ -63,6 +63,11 @@ namespace SOUI
 		, m_bDrawFocusRect(TRUE)
 		, m_bCacheDraw(FALSE)
 		, m_bCacheDirty(TRUE)
+		, m_bCacheAuto(FALSE)
+		, m_bCacheAutoOn(FALSE)
+		, m_bCustomHitTest(FALSE)
+		, m_nCacheBytes(0)
+		, m_nCachePaints(0)
 		, m_bLayeredWindow(FALSE)
 		, m_layoutDirty(dirty_self)
 		, m_uData(0)
@@ -102,6 +107,7 @@ namespace SOUI
 
 	SWindow::~SWindow()
 	{
+		if(m_cachedRT) _FreeCacheRT();
 		SWindowMgr::DestroyWindow(m_swnd);
 	}
 
@@ -161,6 +167,58 @@ namespace SOUI
 		}
 	}
 
+#ifdef _DEBUG
+	//大于0时窗口状态正在向子窗口传播，子窗口的状态位可能暂时和父窗口不一致
+	static int s_nStateUpdating = 0;
+
+	struct SStateUpdatingScope
+	{
+		SStateUpdatingScope(){s_nStateUpdating++;}
+		~SStateUpdatingScope(){s_nStateUpdating--;}
+	};
+	#define STATE_UPDATING_SCOPE() SStateUpdatingScope stateUpdatingScope
+#else
+	#define STATE_UPDATING_SCOPE()
+#endif
+
+	void SWindow::TestStateInvariant()
+	{
+#ifdef _DEBUG
+		if(s_nStateUpdating>0) return;
+		//沿父窗口链重新计算可见及禁用状态，和缓存的状态位比较
+		BOOL bVisible = TRUE, bDisable = FALSE;
+		SWindow *pWnd = this;
+		while(pWnd->m_pParent)
+		{
+			if(!pWnd->m_bVisible) bVisible = FALSE;
+			if(pWnd->m_bDisable) bDisable = TRUE;
+			pWnd = pWnd->m_pParent;
+		}
+		//根窗口的状态由宿主设置，直接使用缓存的状态位
+		if(pWnd->m_dwState & WndState_Invisible) bVisible = FALSE;
+		if(pWnd->m_dwState & WndState_Disable) bDisable = TRUE;
+
+		SASSERT_FMTW(bVisible == (0 == (m_dwState & WndState_Invisible)), L"cached visible state is out of date, name=%s",GetName());
+		SASSERT_FMTW(bDisable == (0 != (m_dwState & WndState_Disable)), L"cached disable state is out of date, name=%s",GetName());
+#endif
+	}
+
+	void SWindow::_UpdateVisibleStateFromParent()
+	{
+		BOOL bVisible = m_bVisible && (!m_pParent || m_pParent->IsVisible(TRUE));
+		if(bVisible == (0 == (m_dwState & WndState_Invisible))) return;
+		if(bVisible)
+			m_dwState &= ~WndState_Invisible;
+		else
+			m_dwState |= WndState_Invisible;
+		SWindow *pChild = m_pFirstChild;
+		while(pChild)
+		{
+			pChild->_UpdateVisibleStateFromParent();
+			pChild = pChild->m_pNextSibling;
+		}
+	}
+
 	void SWindow::TestMainThread()
 	{
 #ifdef _DEBUG
@@ -431,9 +489,11 @@ namespace SOUI
 
 		//继承父窗口的disable状态
 		pNewChild->OnEnable(!IsDisabled(TRUE),ParentEnable);
+		//继承父窗口的可见状态，移动到新父窗口的窗口分枝需要同步状态位
+		pNewChild->_UpdateVisibleStateFromParent();
 
-		//只在插入新控件时需要标记zorder失效,删除控件不需要标记
-		GetContainer()->MarkWndTreeZorderDirty();
+		//只在插入新控件时需要更新zorder,删除控件不需要
+		GetContainer()->UpdateChildZorder(pNewChild);
 	}
 
 	BOOL SWindow::RemoveChild(SWindow *pChild)
@@ -468,15 +528,25 @@ namespace SOUI
 		return WndState_Check == (m_dwState & WndState_Check);
 	}
 
+	//m_dwState中的WndState_Disable及WndState_Invisible是包含父窗口状态的缓存，
+	//在OnEnable及OnShowWindow中向子窗口传播，因此检查父窗口时不需要遍历父窗口链
 	BOOL SWindow::IsDisabled(BOOL bCheckParent /*= FALSE*/)
 	{
-		if(bCheckParent) return m_dwState & WndState_Disable;
+		if(bCheckParent)
+		{
+			TestStateInvariant();
+			return m_dwState & WndState_Disable;
+		}
 		else return m_bDisable;
 	}
 
 	BOOL SWindow::IsVisible(BOOL bCheckParent /*= FALSE*/)
 	{
-		if(bCheckParent) return (0 == (m_dwState & WndState_Invisible));
+		if(bCheckParent)
+		{
+			TestStateInvariant();
+			return (0 == (m_dwState & WndState_Invisible));
+		}
 		else return m_bVisible;
 	}
 
@@ -515,6 +585,8 @@ namespace SOUI
 	void SWindow::SetContainer(ISwndContainer *pContainer)
 	{
 		TestMainThread();
+		//自动缓存由容器管理，不能带到新的容器
+		if(m_bCacheAutoOn && pContainer != m_pContainer) _FreeCacheRT();
 		m_pContainer=pContainer;
 
 		SWindow *pChild=GetWindow(GSW_FIRSTCHILD);
@@ -762,9 +834,13 @@ namespace SOUI
 		return m_style.GetStates()>1;
 	}
 
-	//如果当前窗口有绘制缓存，它可能是由cache属性定义的，也可能是由于定义了alpha
+	static SRenderCacheStats s_cacheStats = {0};
+
+	//如果当前窗口有绘制缓存，它可能是由cache属性定义的，也可能是由于定义了alpha，或者是cache="auto"时自动启用的
 	void SWindow::_PaintClient(IRenderTarget *pRT)
 	{
+		if(m_bCacheAuto) _UpdateAutoCache();
+
 		if(IsDrawToCache())
 		{
 			IRenderTarget *pRTCache=m_cachedRT;
@@ -773,7 +849,19 @@ namespace SOUI
 				CRect rcWnd=m_rcWindow;
 				if(IsCacheDirty())
 				{
-					pRTCache->ClearRect(&rcWnd,0);
+					//只重绘缓存中的脏区域
+					CRect rcDirty = m_rcCacheDirty & rcWnd;
+					BOOL bPartial = !rcDirty.IsRectEmpty() && rcDirty != rcWnd;
+					if(bPartial)
+					{
+						pRTCache->PushClipRect(&rcDirty,RGN_AND);
+						InterlockedIncrement(&s_cacheStats.nPartialUpdates);
+					}else
+					{
+						rcDirty = rcWnd;
+						InterlockedIncrement(&s_cacheStats.nFullUpdates);
+					}
+					pRTCache->ClearRect(&rcDirty,0);
 
 					CAutoRefPtr<IFont> oldFont;
 					COLORREF crOld=pRT->GetTextColor();
@@ -785,8 +873,12 @@ namespace SOUI
 
 					pRTCache->SelectObject(oldFont);
 					pRTCache->SetTextColor(crOld);
+					if(bPartial) pRTCache->PopClip();
 
 					MarkCacheDirty(false);
+				}else
+				{
+					InterlockedIncrement(&s_cacheStats.nCacheHits);
 				}
 				CRect rcClip , rcInter;
 				pRT->GetClipBox(&rcClip);
@@ -800,6 +892,7 @@ namespace SOUI
 		{
 			SSendMessage(WM_ERASEBKGND, (WPARAM)pRT);
 			SSendMessage(WM_PAINT, (WPARAM)pRT);
+			if(m_bCacheAuto) MarkCacheDirty(false);
 		}
 	}
 
@@ -871,6 +964,7 @@ namespace SOUI
 	{
 		if(!IsVisible(TRUE))  //只在自己完全可见的情况下才绘制
 			return;
+		SPROFILE_SCOPE_ARG("SWindow::_PaintRegion2",GetObjectClass());
 
 		CRect rcWnd,rcClient;
 		GetWindowRect(&rcWnd);
@@ -1028,7 +1122,7 @@ namespace SOUI
 	void SWindow::InvalidateRect(const CRect& rect,BOOL bFromThis/*=TRUE*/)
 	{
 		TestMainThread();
-		if(bFromThis) MarkCacheDirty(true);
+		if(bFromThis) MarkCacheDirty(rect);
 		if(!IsVisible(TRUE) || IsUpdateLocked()) return ;
 		//只能更新窗口有效区域
 		CRect rcIntersect = rect & m_rcWindow;
@@ -1124,6 +1218,7 @@ namespace SOUI
 			InvalidateRect(m_rcWindow);
 
 			SSendMessage(WM_NCCALCSIZE);//计算非客户区大小
+			GetContainer()->UpdateHitTestIndex(this);
 		}
 
 
@@ -1420,6 +1515,7 @@ namespace SOUI
 
 	void SWindow::OnShowWindow(BOOL bShow, UINT nStatus)
 	{
+		STATE_UPDATING_SCOPE();
 		if(nStatus == ParentShow)
 		{
 			if(bShow && !IsVisible(FALSE)) bShow=FALSE;
@@ -1465,6 +1561,7 @@ namespace SOUI
 
 	void SWindow::OnEnable( BOOL bEnable,UINT nStatus )
 	{
+		STATE_UPDATING_SCOPE();
 		if(nStatus == ParentEnable)
 		{
 			if(bEnable && IsDisabled(FALSE)) bEnable=FALSE;
@@ -1628,6 +1725,7 @@ namespace SOUI
 	void SWindow::UpdateLayout()
 	{
 		if(m_layoutDirty == dirty_clean) return;
+		SPROFILE_SCOPE_ARG("SWindow::UpdateLayout",GetObjectClass());
 		UpdateChildrenPosition();
 		m_layoutDirty = dirty_clean;
 	}
@@ -2214,7 +2312,11 @@ namespace SOUI
 	{
 		BOOL bVisible = strValue != L"0";
 		if(!bLoading)   SetVisible(bVisible,TRUE);
-		else m_bVisible=bVisible;
+		else
+		{
+			m_bVisible=bVisible;
+			_UpdateVisibleStateFromParent();
+		}
 		return S_FALSE;
 	}
 
@@ -2223,7 +2325,8 @@ namespace SOUI
 		BOOL bEnable = strValue != L"0";
 		if(bLoading)
 		{
-			if (bEnable)
+			m_bDisable = !bEnable;
+			if (bEnable && !(m_pParent && m_pParent->IsDisabled(TRUE)))
 				ModifyState(0, WndState_Disable);
 			else
 				ModifyState(WndState_Disable, WndState_Hover);
@@ -2295,18 +2398,13 @@ namespace SOUI
 
 	void SWindow::OnSize( UINT nType, CSize size )
 	{
+		if(m_bCacheAutoOn && !GetContainer()->AddAutoCache(this))
+		{//新的大小超出自动缓存预算
+			_FreeCacheRT();
+		}
 		if(IsDrawToCache())
 		{
-			if(!m_cachedRT)
-			{
-				GETRENDERFACTORY->CreateRenderTarget(&m_cachedRT,m_rcWindow.Width(),m_rcWindow.Height());
-			}else
-			{
-				m_cachedRT->Resize(m_rcWindow.Size());
-			}
-			m_cachedRT->SetViewportOrg(-m_rcWindow.TopLeft());
-
-			MarkCacheDirty(true);
+			_AllocCacheRT();
 		}
 		if(IsLayeredWindow())
 		{
@@ -2326,21 +2424,92 @@ namespace SOUI
 
 	void SWindow::UpdateCacheMode()
 	{
-		if(IsDrawToCache() && !m_cachedRT)
+		if(IsCacheRequired())
+		{
+			m_bCacheAutoOn = FALSE;//已经自动启用的缓存转为固定缓存
+			if(!m_cachedRT) _AllocCacheRT();
+		}
+		else if(m_cachedRT && !(m_bCacheAuto && m_bCacheAutoOn))
+		{
+			_FreeCacheRT();
+		}
+	}
+
+	void SWindow::_AllocCacheRT()
+	{
+		if(!m_cachedRT)
 		{
 			GETRENDERFACTORY->CreateRenderTarget(&m_cachedRT,m_rcWindow.Width(),m_rcWindow.Height());
-			m_cachedRT->SetViewportOrg(-m_rcWindow.TopLeft());
-			MarkCacheDirty(true);
+		}else
+		{
+			m_cachedRT->Resize(m_rcWindow.Size());
 		}
-		if(!IsDrawToCache() && m_cachedRT)
+		m_cachedRT->SetViewportOrg(-m_rcWindow.TopLeft());
+
+		LONG nBytes = m_rcWindow.Width()*m_rcWindow.Height()*4;
+		InterlockedExchangeAdd(&s_cacheStats.nBytesHeld,nBytes - m_nCacheBytes);
+		m_nCacheBytes = nBytes;
+
+		MarkCacheDirty(true);
+	}
+
+	void SWindow::_FreeCacheRT()
+	{
+		if(m_bCacheAutoOn) InterlockedIncrement(&s_cacheStats.nEvicted);
+		InterlockedExchangeAdd(&s_cacheStats.nBytesHeld,-m_nCacheBytes);
+		m_nCacheBytes = 0;
+		m_cachedRT = NULL;
+		m_bCacheAutoOn = FALSE;
+		m_nCachePaints = 0;
+	}
+
+	//连续KAutoCachePaints次绘制内容都没有变化时启用缓存，启用缓存后连续KAutoCachePaints次绘制都需要更新缓存时释放缓存
+	static const UINT KAutoCachePaints = 8;
+
+	void SWindow::_UpdateAutoCache()
+	{
+		if(IsCacheRequired()) return;
+		if(!m_bCacheAutoOn)
+		{
+			if(m_bCacheDirty) m_nCachePaints = 0;
+			else m_nCachePaints++;
+			if(m_nCachePaints < KAutoCachePaints) return;
+
+			m_nCachePaints = 0;
+			if(m_rcWindow.IsRectEmpty() || !GetContainer()->AddAutoCache(this)) return;
+			m_bCacheAutoOn = TRUE;
+			_AllocCacheRT();
+			InterlockedIncrement(&s_cacheStats.nPromoted);
+		}else
 		{
-			m_cachedRT=NULL;
+			if(!m_bCacheDirty)
+			{
+				m_nCachePaints = 0;
+				GetContainer()->TouchAutoCache(this);
+			}
+			else if(++m_nCachePaints >= KAutoCachePaints)
+			{//内容一直在变化，缓存只会增加开销
+				_FreeCacheRT();
+			}
 		}
 	}
 
+	void SWindow::GetRenderCacheStats(SRenderCacheStats & stats)
+	{
+		stats = s_cacheStats;
+	}
+
+	void SWindow::ResetRenderCacheStats()
+	{
+		LONG nBytesHeld = s_cacheStats.nBytesHeld;
+		memset(&s_cacheStats,0,sizeof(s_cacheStats));
+		s_cacheStats.nBytesHeld = nBytesHeld;
+	}
+
 	HRESULT SWindow::OnAttrCache( const SStringW& strValue, BOOL bLoading )
 	{
-		m_bCacheDraw = strValue != L"0";
+		m_bCacheAuto = strValue == L"auto";
+		m_bCacheDraw = !m_bCacheAuto && strValue != L"0";
 
 		if(!bLoading)
 		{
@@ -2483,11 +2652,16 @@ namespace SOUI
 	}
 
 
-	bool SWindow::IsDrawToCache() const
+	bool SWindow::IsCacheRequired() const
 	{
 		return m_bCacheDraw || (!IsLayeredWindow() && m_style.m_byAlpha!=0xff);
 	}
 
+	bool SWindow::IsDrawToCache() const
+	{
+		return IsCacheRequired() || m_bCacheAutoOn;
+	}
+
 	IRenderTarget * SWindow::GetLayerRenderTarget()
 	{
 		SASSERT(IsLayeredWindow());
@@ -11,6 +11,9 @@ namespace SOUI
 #define WM_NCMOUSEFIRST WM_NCMOUSEMOVE
 #define WM_NCMOUSELAST  WM_NCMBUTTONDBLCLK
 
+//相邻窗口zorder之间的间隔，为局部插入预留编号空间
+#define ZORDER_GAP      64
+
 
 SwndContainerImpl::SwndContainerImpl()
     :m_hCapture(NULL)
@@ -19,8 +22,95 @@ SwndContainerImpl::SwndContainerImpl()
     ,m_dropTarget(this)
     ,m_focusMgr(this)
     ,m_bZorderDirty(TRUE)
+    ,m_pHitTestIndex(NULL)
+    ,m_nAutoCacheBudget(16*1024*1024)
 {
     SWindow::SetContainer(this);
+    memset(&m_zorderStats,0,sizeof(m_zorderStats));
+}
+
+SwndContainerImpl::~SwndContainerImpl()
+{
+    if(m_pHitTestIndex) delete m_pHitTestIndex;
+}
+
+void SwndContainerImpl::EnableHitTestIndex(BOOL bEnable,int nCellSize)
+{
+    if(m_pHitTestIndex)
+    {
+        delete m_pHitTestIndex;
+        m_pHitTestIndex = NULL;
+    }
+    if(bEnable)
+    {
+        m_pHitTestIndex = new SHitTestIndex(this,nCellSize);
+    }
+}
+
+void SwndContainerImpl::UpdateHitTestIndex(SWindow *pWnd)
+{
+    if(m_pHitTestIndex) m_pHitTestIndex->UpdateWindow(pWnd);
+}
+
+void SwndContainerImpl::SetAutoCacheBudget(size_t nBytes)
+{
+    m_nAutoCacheBudget = nBytes;
+    _TrimAutoCache(m_nAutoCacheBudget);
+}
+
+void SwndContainerImpl::_TrimAutoCache(size_t nBytes)
+{
+    //统计仍然有效的自动缓存，队列中可能有已经销毁或者释放了缓存的窗口
+    size_t nHeld = 0;
+    SPOSITION pos = m_lstAutoCache.GetHeadPosition();
+    while(pos)
+    {
+        SPOSITION posCur = pos;
+        SWindow *pWnd = SWindowMgr::GetWindow(m_lstAutoCache.GetNext(pos));
+        if(!pWnd || !pWnd->m_bCacheAutoOn)
+        {
+            m_mapAutoCache.RemoveKey(m_lstAutoCache.GetAt(posCur));
+            m_lstAutoCache.RemoveAt(posCur);
+        }
+        else
+            nHeld += pWnd->m_nCacheBytes;
+    }
+    while(nHeld > nBytes && !m_lstAutoCache.IsEmpty())
+    {
+        SWND swnd = m_lstAutoCache.RemoveHead();
+        m_mapAutoCache.RemoveKey(swnd);
+        SWindow *pWnd = SWindowMgr::GetWindow(swnd);
+        nHeld -= pWnd->m_nCacheBytes;
+        pWnd->_FreeCacheRT();
+    }
+}
+
+BOOL SwndContainerImpl::AddAutoCache(SWindow *pWnd)
+{
+    size_t nBytes = pWnd->GetWindowRect().Width()*pWnd->GetWindowRect().Height()*4;
+    if(nBytes > m_nAutoCacheBudget) return FALSE;
+    SPOSITION pos = NULL;
+    if(m_mapAutoCache.Lookup(pWnd->GetSwnd(),pos))
+    {//重新申请(如窗口大小改变)时先移出队列，按新的大小重新计算预算
+        m_lstAutoCache.RemoveAt(pos);
+        m_mapAutoCache.RemoveKey(pWnd->GetSwnd());
+    }
+    _TrimAutoCache(m_nAutoCacheBudget - nBytes);
+    m_mapAutoCache[pWnd->GetSwnd()] = m_lstAutoCache.AddTail(pWnd->GetSwnd());
+    return TRUE;
+}
+
+void SwndContainerImpl::TouchAutoCache(SWindow *pWnd)
+{
+    SPOSITION pos = NULL;
+    if(m_mapAutoCache.Lookup(pWnd->GetSwnd(),pos)) m_lstAutoCache.MoveToTail(pos);
+}
+
+SWND SwndContainerImpl::SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText)
+{
+    if(!m_pHitTestIndex) return SWindow::SwndFromPoint(ptHitTest,bOnlyText);
+    BuildWndTreeZorder();
+    return m_pHitTestIndex->SwndFromPoint(ptHitTest,bOnlyText);
 }
 
 LRESULT SwndContainerImpl::DoFrameEvent(UINT uMsg,WPARAM wParam,LPARAM lParam)
@@ -387,32 +477,23 @@ void SwndContainerImpl::OnActivate( UINT nState )
 
 BOOL SwndContainerImpl::RegisterTimelineHandler( ITimelineHandler *pHandler )
 {
-    SPOSITION pos=m_lstTimelineHandler.Find(pHandler);
-    if(pos) return FALSE;
-    m_lstTimelineHandler.AddTail(pHandler);
-    return TRUE;
+    return m_timeline.Register(pHandler);
 }
 
 BOOL SwndContainerImpl::UnregisterTimelineHandler( ITimelineHandler *pHandler )
 {
-    SPOSITION pos=m_lstTimelineHandler.Find(pHandler);
-    if(!pos) return FALSE;
-    m_lstTimelineHandler.RemoveAt(pos);
-    return TRUE;
+    return m_timeline.Unregister(pHandler);
+}
+
+BOOL SwndContainerImpl::ScheduleTimelineHandler( ITimelineHandler *pHandler,UINT nDelay )
+{
+    return m_timeline.Schedule(pHandler,nDelay);
 }
 
 void SwndContainerImpl::OnNextFrame()
 {
     if(!IsVisible(TRUE)) return;
-    
-    SList<ITimelineHandler*> lstCopy;
-    CopyList(m_lstTimelineHandler,lstCopy);
-    SPOSITION pos=lstCopy.GetHeadPosition();
-    while(pos)
-    {
-        ITimelineHandler * pHandler=lstCopy.GetNext(pos);
-        pHandler->OnNextFrame();
-    }
+    m_timeline.RunFrame();
 }
 
 void SwndContainerImpl::OnActivateApp( BOOL bActive, DWORD dwThreadID )
@@ -446,20 +527,89 @@ void SwndContainerImpl::BuildWndTreeZorder()
     if(m_bZorderDirty)
     {
         UINT uInitZorder =0;
-        _BuildWndTreeZorder(this,uInitZorder);
+        _BuildWndTreeZorder(this,uInitZorder,ZORDER_GAP);
         m_bZorderDirty = FALSE;
+        m_zorderStats.nRebuilds++;
+    }
+}
+
+void SwndContainerImpl::UpdateChildZorder(SWindow *pChild)
+{
+    if(m_bZorderDirty)
+    {//等待全量重建
+        if(m_pHitTestIndex) m_pHitTestIndex->UpdateTree(pChild);
+        return;
+    }
+
+    SWindow *pRoot = pChild;
+    while(pRoot->GetParent()) pRoot = pRoot->GetParent();
+    if(pRoot != (SWindow*)this) return;//还没有挂接到窗口树上，挂接时整个分枝一起编号
+
+    //下界:前一个兄弟分枝的最后一个窗口，没有兄弟时为父窗口
+    UINT uLow = 0;
+    SWindow *pPrev = pChild->GetWindow(GSW_PREVSIBLING);
+    if(pPrev)
+    {
+        while(pPrev->GetChildrenCount()) pPrev = pPrev->GetWindow(GSW_LASTCHILD);
+        uLow = pPrev->m_uZorder;
+    }else
+    {
+        uLow = pChild->GetParent()->m_uZorder;
+    }
+
+    //上界:沿父窗口链向上找到的第一个后续兄弟窗口
+    UINT uHigh = ZORDER_MAX;
+    SWindow *pWnd = pChild;
+    while(pWnd)
+    {
+        SWindow *pNext = pWnd->GetWindow(GSW_NEXTSIBLING);
+        if(pNext)
+        {
+            uHigh = pNext->m_uZorder;
+            break;
+        }
+        pWnd = pWnd->GetParent();
+    }
+
+    UINT nCount = _GetWndTreeSize(pChild);
+    if(uHigh <= uLow || uHigh - uLow - 1 < nCount)
+    {//编号空间不足，全量重建
+        m_bZorderDirty = TRUE;
+        if(m_pHitTestIndex) m_pHitTestIndex->UpdateTree(pChild);
+        return;
+    }
+    UINT uStep = (uHigh - uLow)/(nCount+1);
+    if(uStep > ZORDER_GAP) uStep = ZORDER_GAP;
+    UINT uOrder = uLow + uStep;
+    _BuildWndTreeZorder(pChild,uOrder,uStep);
+    m_zorderStats.nIncremental++;
+
+    if(m_pHitTestIndex) m_pHitTestIndex->UpdateTree(pChild);
+}
+
+void SwndContainerImpl::_BuildWndTreeZorder( SWindow *pWnd,UINT & iOrder,UINT uStep )
+{
+    pWnd->m_uZorder = iOrder;
+    iOrder += uStep;
+    m_zorderStats.nRenumbered++;
+    SWindow *pChild = pWnd->GetWindow(GSW_FIRSTCHILD);
+    while(pChild)
+    {
+        _BuildWndTreeZorder(pChild,iOrder,uStep);
+        pChild=pChild->GetWindow(GSW_NEXTSIBLING);
     }
 }
 
-void SwndContainerImpl::_BuildWndTreeZorder( SWindow *pWnd,UINT & iOrder )
+UINT SwndContainerImpl::_GetWndTreeSize( SWindow *pWnd )
 {
-    pWnd->m_uZorder = iOrder++;
+    UINT nRet = 1;
     SWindow *pChild = pWnd->GetWindow(GSW_FIRSTCHILD);
     while(pChild)
     {
-        _BuildWndTreeZorder(pChild,iOrder);
+        nRet += _GetWndTreeSize(pChild);
         pChild=pChild->GetWindow(GSW_NEXTSIBLING);
     }
+    return nRet;
 }
 
 }//namespace SOUI
@@ -5,7 +5,6 @@
 #include "helper/mybuffer.h"
 #include "helper/color.h"
 #include "helper/SplitString.h"
-#include "helper/copylist.hpp"
 
 #include "../updatelayeredwindow/SUpdateLayeredWindow.h"
 
@@ -55,9 +54,11 @@ void SHostWndAttr::Init()
 	m_byWndType = WT_UNDEFINE;
 	m_bAllowSpy = TRUE;
 	m_bSendWheel2Hover = FALSE;
+	m_bHitTestIndex = FALSE;
 	m_byAlpha = (0xFF);
 	m_dwStyle = (0);
 	m_dwExStyle = (0);
+	m_nFps = 100;
 	if (m_hAppIconSmall) DestroyIcon(m_hAppIconSmall);
 	if (m_hAppIconBig) DestroyIcon(m_hAppIconBig);
 	m_hAppIconSmall = (NULL);
@@ -109,10 +110,16 @@ SHostWnd::SHostWnd( LPCTSTR pszResName /*= NULL*/ )
 , m_pTipCtrl(NULL)
 , m_dummyWnd(this)
 , m_bRending(FALSE)
+, m_bFrameBatching(FALSE)
+, m_bFramePending(FALSE)
+, m_nFrameDelay(0)
+, m_nUpdateMerged(0)
 , m_bResizing(FALSE)
 , m_nScale(100)
 {
     m_msgMouse.message = 0;
+    memset(&m_paintStats,0,sizeof(m_paintStats));
+    memset(&m_zorderStatsMark,0,sizeof(m_zorderStatsMark));
     m_privateStylePool.Attach(new SStylePool);
     m_privateSkinPool.Attach(new SSkinPool);
     SetContainer(this);
@@ -242,6 +249,8 @@ BOOL SHostWnd::_InitFromXml(pugi::xml_node xmlNode,int nWidth,int nHeight)
     
     m_hostAttr.Init();
     m_hostAttr.InitFromXml(xmlNode);
+    m_timeline.SetFrameRate(m_hostAttr.m_nFps);
+    EnableHitTestIndex(m_hostAttr.m_bHitTestIndex);
 
     if (m_hostAttr.m_bResizable)
     {
@@ -377,6 +386,7 @@ bool SHostWnd::_IsRootWrapContent()
 
 void SHostWnd::OnPrint(HDC dc, UINT uFlags)
 {
+    SPROFILE_SCOPE("SHostWnd::OnPrint");
     //刷新前重新布局，会自动检查布局脏标志
 	UpdateLayout();
     
@@ -446,6 +456,14 @@ void SHostWnd::OnPrint(HDC dc, UINT uFlags)
     m_bRending = FALSE;
 
     UpdateHost(dc,rcInvalid);
+
+    //记录本次绘制的统计数据
+    const SZorderStats & zorderStats = GetZorderStats();
+    m_paintStats.nRenumbered = zorderStats.nRenumbered - m_zorderStatsMark.nRenumbered;
+    m_paintStats.nZorderRebuilds = zorderStats.nRebuilds - m_zorderStatsMark.nRebuilds;
+    m_paintStats.nUpdateMerged = m_nUpdateMerged;
+    m_zorderStatsMark = zorderStats;
+    m_nUpdateMerged = 0;
 }
 
 void SHostWnd::OnPaint(HDC dc)
@@ -515,6 +533,7 @@ void SHostWnd::OnDestroy()
 
 	m_memRT = NULL;
 	m_rgnInvalidate = NULL;
+	m_nFrameDelay = 0;
 
     //exit app. (copy from wtl)
     if(m_hostAttr.m_byWndType == SHostWndAttr::WT_APPMAIN 
@@ -601,7 +620,21 @@ void SHostWnd::OnSwndTimer( char cTimerID )
         m_bCaretActive=!m_bCaretActive;
     }else if(cTimerID==TIMER_NEXTFRAME)
     {
-        if(!::IsIconic(m_hWnd)) OnNextFrame();
+        if(!::IsIconic(m_hWnd))
+        {
+            //一帧内各个handler产生的刷新请求合并为一次重绘
+            m_bFrameBatching = TRUE;
+            OnNextFrame();
+            m_bFrameBatching = FALSE;
+            if(m_bFramePending)
+            {
+                m_bFramePending = FALSE;
+                CRect rcInvalid;
+                m_rgnInvalidate->GetRgnBox(&rcInvalid);
+                _InvalidateHost(rcInvalid);
+            }
+        }
+        _ScheduleNextFrame();
     }
 }
 
@@ -759,6 +792,7 @@ void SHostWnd::OnReleaseRenderTarget(IRenderTarget * pRT,const CRect &rc,DWORD g
 
 void SHostWnd::UpdateHost(HDC dc, const CRect &rcInvalid )
 {
+    SPROFILE_SCOPE("SHostWnd::UpdateHost");
     if(m_hostAttr.m_bTranslucent)
     {
         SASSERT(m_hostAttr.m_byAlpha>5);
@@ -780,6 +814,16 @@ void SHostWnd::OnRedraw(const CRect &rc)
     
     m_bNeedRepaint = TRUE;
 
+    if(m_bFrameBatching)
+    {//动画帧结束后统一提交
+        m_bFramePending = TRUE;
+        return;
+    }
+    _InvalidateHost(rc);
+}
+
+void SHostWnd::_InvalidateHost(const CRect &rc)
+{
     if(!m_hostAttr.m_bTranslucent)
     {
         CSimpleWnd::InvalidateRect(rc, FALSE);
@@ -1248,17 +1292,43 @@ BOOL SHostWnd::AnimateHostWindow(DWORD dwTime,DWORD dwFlags)
 BOOL SHostWnd::RegisterTimelineHandler( ITimelineHandler *pHandler )
 {
     BOOL bRet = SwndContainerImpl::RegisterTimelineHandler(pHandler);
-    if(bRet && m_lstTimelineHandler.GetCount()==1) SWindow::SetTimer(TIMER_NEXTFRAME,10);
+    if(bRet) _ScheduleNextFrame();
     return bRet;
 }
 
 BOOL SHostWnd::UnregisterTimelineHandler( ITimelineHandler *pHandler )
 {
     BOOL bRet=SwndContainerImpl::UnregisterTimelineHandler(pHandler);
-    if(bRet && m_lstTimelineHandler.IsEmpty()) SWindow::KillTimer(TIMER_NEXTFRAME);
+    if(bRet) _ScheduleNextFrame();
+    return bRet;
+}
+
+BOOL SHostWnd::ScheduleTimelineHandler( ITimelineHandler *pHandler,UINT nDelay )
+{
+    BOOL bRet=SwndContainerImpl::ScheduleTimelineHandler(pHandler,nDelay);
+    if(bRet) _ScheduleNextFrame();
     return bRet;
 }
 
+void SHostWnd::_ScheduleNextFrame()
+{
+    if(m_bFrameBatching) return;//帧结束后统一调度
+
+    UINT nDelay = m_timeline.GetNextDelay();
+    if(nDelay == TIMELINE_IDLE)
+    {//所有handler都处于休眠状态，停止帧定时器
+        if(m_nFrameDelay!=0)
+        {
+            SWindow::KillTimer(TIMER_NEXTFRAME);
+            m_nFrameDelay = 0;
+        }
+    }else if(nDelay != m_nFrameDelay)
+    {
+        if(SWindow::SetTimer(TIMER_NEXTFRAME,nDelay))
+            m_nFrameDelay = nDelay;
+    }
+}
+
 const SStringW & SHostWnd::GetTranslatorContext()
 {
     return m_hostAttr.m_strTrCtx;
@@ -1354,33 +1424,37 @@ LRESULT SHostWnd::OnUpdateSwnd(UINT uMsg,WPARAM wParam,LPARAM)
     SWND swnd = (SWND)wParam;
     SASSERT(SWindowMgr::getSingleton().GetWindow(swnd));
     
-    if(!m_lstUpdateSwnd.Find(swnd))
+    if(m_mapUpdateSwnd.Lookup(swnd))
     {//防止重复加入
-        if(m_lstUpdateSwnd.IsEmpty())
-        {//请求刷新窗口
-            if(!m_hostAttr.m_bTranslucent)
-            {
-                CSimpleWnd::Invalidate(FALSE);
-            }else if(m_dummyWnd.IsWindow()) 
-            {
-                m_dummyWnd.Invalidate(FALSE);
-            }
+        m_nUpdateMerged++;
+        return 0;
+    }
+    if(m_mapUpdateSwnd.IsEmpty())
+    {//请求刷新窗口
+        if(!m_hostAttr.m_bTranslucent)
+        {
+            CSimpleWnd::Invalidate(FALSE);
+        }else if(m_dummyWnd.IsWindow()) 
+        {
+            m_dummyWnd.Invalidate(FALSE);
         }
-        m_lstUpdateSwnd.AddTail(swnd);
     }
+    m_lstUpdateSwnd.AddTail(swnd);
+    m_mapUpdateSwnd[swnd] = TRUE;
     return 0;
 }
 
 void SHostWnd::_UpdateNonBkgndBlendSwnd()
 {
-    SList<SWND> lstUpdateSwnd;
-    CopyList(m_lstUpdateSwnd,lstUpdateSwnd);
-    m_lstUpdateSwnd.RemoveAll();
-    
-    SPOSITION pos = lstUpdateSwnd.GetHeadPosition();
-    while(pos)
+    //只刷新当前在队列中的窗口，逐个从队头摘下，不复制队列。
+    //先清空索引，刷新过程中新加入的窗口会看到空索引并重新请求刷新宿主，它们排在队尾，留到下一次绘制
+    int nUpdate = (int)m_lstUpdateSwnd.GetCount();
+    m_mapUpdateSwnd.RemoveAll();
+    m_paintStats.nUpdateSwnd = (DWORD)nUpdate;
+    for(int i=0;i<nUpdate;i++)
     {
-        SWindow *pWnd = SWindowMgr::getSingleton().GetWindow(lstUpdateSwnd.GetNext(pos));
+        SWND swnd = m_lstUpdateSwnd.RemoveHead();
+        SWindow *pWnd = SWindowMgr::getSingleton().GetWindow(swnd);
         if(pWnd)
         {
             pWnd->_Update();
@@ -1404,6 +1478,7 @@ void SHostWnd::UpdateLayout()
 {
 	if (!IsLayoutDirty()) 
 		return;
+	SPROFILE_SCOPE("SHostWnd::UpdateLayout");
 	if (_IsRootWrapContent())
 	{
 		int nWid = m_hostAttr.m_width.toPixelSize(GetScale());
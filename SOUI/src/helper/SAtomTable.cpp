@@ -0,0 +1,196 @@
+﻿#include "souistd.h"
+#include "helper/SAtomTable.h"
+
+namespace SOUI
+{
+    template<> SAtomTable * SSingleton<SAtomTable>::ms_Singleton = 0;
+
+    SAtomTable::SAtomTable()
+        :m_nAtoms(0)
+        ,m_pArenaCur(NULL)
+        ,m_nArenaLeft(0)
+    {
+        memset(m_pPages,0,sizeof(m_pPages));
+        memset(&m_stats,0,sizeof(m_stats));
+        m_pSlots = _AllocSlots(1024);
+        m_stats.nSlotBytes = (LONG)(sizeof(SLOTTABLE) + 1023*sizeof(UINT));
+    }
+
+    SAtomTable::~SAtomTable()
+    {
+        for(int i=0;i<KMaxPages && m_pPages[i];i++)
+        {
+            delete []m_pPages[i];
+        }
+        free(m_pSlots);
+        SPOSITION pos = m_lstRetiredSlots.GetHeadPosition();
+        while(pos)
+        {
+            free(m_lstRetiredSlots.GetNext(pos));
+        }
+        pos = m_lstArena.GetHeadPosition();
+        while(pos)
+        {
+            delete []m_lstArena.GetNext(pos);
+        }
+    }
+
+    ULONG SAtomTable::HashName(LPCWSTR pszName,int nLen)
+    {
+        ULONG nHash = 0;
+        for(int i=0;i<nLen;i++)
+        {
+            nHash = (nHash << 5) + nHash + pszName[i];
+        }
+        return nHash;
+    }
+
+    SAtom SAtomTable::_Find(const SLOTTABLE *pTable,LPCWSTR pszName,int nLen,ULONG uHash,UINT & iSlot)
+    {
+        InterlockedIncrement(&m_stats.nLookups);
+        UINT uMask = pTable->nSlots - 1;
+        iSlot = uHash & uMask;
+        for(;;)
+        {
+            SAtom atom = ((volatile UINT*)pTable->slots)[iSlot];
+            if(atom == SATOM_NULL) break;
+            const ATOMENTRY & entry = _GetEntry(atom);
+            if(entry.uHash == uHash && entry.nLen == nLen)
+            {
+                InterlockedIncrement(&m_stats.nCompares);
+                if(memcmp(entry.pszName,pszName,nLen*sizeof(wchar_t)) == 0) return atom;
+            }
+            iSlot = (iSlot+1) & uMask;
+        }
+        return SATOM_NULL;
+    }
+
+    SAtomTable::SLOTTABLE * SAtomTable::_AllocSlots(UINT nSlots)
+    {
+        size_t szTable = sizeof(SLOTTABLE) + (nSlots-1)*sizeof(UINT);
+        SLOTTABLE *pTable = (SLOTTABLE*)malloc(szTable);
+        memset(pTable,0,szTable);
+        pTable->nSlots = nSlots;
+        return pTable;
+    }
+
+    void SAtomTable::_GrowSlots()
+    {
+        const SLOTTABLE *pOld = m_pSlots;
+        UINT nSlots = pOld->nSlots*2;
+        SLOTTABLE *pNew = _AllocSlots(nSlots);
+        for(UINT i=0;i<pOld->nSlots;i++)
+        {
+            SAtom atom = pOld->slots[i];
+            if(atom == SATOM_NULL) continue;
+            UINT iSlot = _GetEntry(atom).uHash & (nSlots-1);
+            while(pNew->slots[iSlot] != SATOM_NULL) iSlot = (iSlot+1) & (nSlots-1);
+            pNew->slots[iSlot] = atom;
+        }
+        //新槽填好后再发布，旧槽可能还有没加锁的读者，不能释放
+        InterlockedExchangePointer((PVOID*)&m_pSlots,pNew);
+        m_lstRetiredSlots.AddTail((SLOTTABLE*)pOld);
+        m_stats.nSlotBytes += (LONG)(sizeof(SLOTTABLE) + (nSlots-1)*sizeof(UINT));
+    }
+
+    LPWSTR SAtomTable::_ArenaAlloc(int nLen)
+    {
+        int nSize = nLen + 1;
+        if(nSize > KArenaChunk/4)
+        {//长字符串单独分配，避免浪费当前内存块的剩余空间
+            LPWSTR pBuf = new wchar_t[nSize];
+            m_lstArena.AddTail(pBuf);
+            m_stats.nArenaBytes += nSize*sizeof(wchar_t);
+            return pBuf;
+        }
+        if(nSize > m_nArenaLeft)
+        {
+            m_pArenaCur = new wchar_t[KArenaChunk];
+            m_nArenaLeft = KArenaChunk;
+            m_lstArena.AddTail(m_pArenaCur);
+            m_stats.nArenaBytes += KArenaChunk*sizeof(wchar_t);
+        }
+        LPWSTR pBuf = m_pArenaCur;
+        m_pArenaCur += nSize;
+        m_nArenaLeft -= nSize;
+        return pBuf;
+    }
+
+    SAtom SAtomTable::AddAtom(LPCWSTR pszName,int nLen)
+    {
+        if(!pszName) return SATOM_NULL;
+        if(nLen < 0) nLen = (int)wcslen(pszName);
+        if(nLen == 0) return SATOM_NULL;
+        ULONG uHash = HashName(pszName,nLen);
+
+        SAutoLock lock(m_cs);
+        SLOTTABLE *pTable = m_pSlots;
+        UINT iSlot = 0;
+        SAtom atom = _Find(pTable,pszName,nLen,uHash,iSlot);
+        if(atom != SATOM_NULL) return atom;
+
+        UINT iAtom = m_nAtoms;//新原子的序号，原子=序号+1
+        UINT iPage = iAtom>>KPageBits;
+        if(iPage >= KMaxPages)
+        {
+            SASSERT(FALSE);
+            return SATOM_NULL;
+        }
+        if(!m_pPages[iPage]) m_pPages[iPage] = new ATOMENTRY[KPageSize];
+
+        LPWSTR pszCopy = _ArenaAlloc(nLen);
+        memcpy(pszCopy,pszName,nLen*sizeof(wchar_t));
+        pszCopy[nLen] = 0;
+
+        ATOMENTRY & entry = m_pPages[iPage][iAtom&(KPageSize-1)];
+        entry.pszName = pszCopy;
+        entry.nLen = nLen;
+        entry.uHash = uHash;
+
+        atom = iAtom + 1;
+        m_nAtoms = atom;//原子数据写完后再更新数量
+        m_stats.nAtoms = (LONG)m_nAtoms;
+        //InterlockedExchange带内存屏障，读者从槽中读到原子时原子数据已经可见
+        InterlockedExchange((volatile LONG*)&pTable->slots[iSlot],(LONG)atom);
+
+        //装载率超过1/2时扩大hash槽
+        if(m_nAtoms*2 > pTable->nSlots) _GrowSlots();
+        return atom;
+    }
+
+    SAtom SAtomTable::FindAtom(LPCWSTR pszName,int nLen)
+    {
+        if(!pszName) return SATOM_NULL;
+        if(nLen < 0) nLen = (int)wcslen(pszName);
+        if(nLen == 0) return SATOM_NULL;
+        ULONG uHash = HashName(pszName,nLen);
+
+        UINT iSlot = 0;
+        return _Find(m_pSlots,pszName,nLen,uHash,iSlot);
+    }
+
+    LPCWSTR SAtomTable::GetAtomName(SAtom atom) const
+    {
+        if(atom == SATOM_NULL) return L"";
+        return _GetEntry(atom).pszName;
+    }
+
+    int SAtomTable::GetAtomLength(SAtom atom) const
+    {
+        if(atom == SATOM_NULL) return 0;
+        return _GetEntry(atom).nLen;
+    }
+
+    ULONG SAtomTable::GetAtomHash(SAtom atom) const
+    {
+        if(atom == SATOM_NULL) return 0;
+        return _GetEntry(atom).uHash;
+    }
+
+    void SAtomTable::GetStats(SAtomStats & stats)
+    {
+        SAutoLock lock(m_cs);
+        stats = m_stats;
+    }
+
+}//namespace SOUI
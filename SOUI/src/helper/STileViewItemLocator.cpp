@@ -55,6 +55,31 @@ int STileViewItemLocator::Position2Item(int position)
     return nRet;
 }
 
+int STileViewItemLocator::Position2ItemEnd(int position)
+{
+    if(!m_adapter || position <= 0)
+    {
+        return 0;
+    }
+    int nRet = ((position - 1) / GetItemLineHeight() + 1) * m_nCountInRow;
+    if(nRet > m_adapter->getCount())
+    {
+        nRet = m_adapter->getCount();
+    }
+    return nRet;
+}
+
+void STileViewItemLocator::GetVisibleItems(int nTop, int nBottom, SArray<int> &arrItems)
+{
+    arrItems.RemoveAll();
+    int iFirst = Position2Item(nTop);
+    int iEnd = Position2ItemEnd(nBottom);
+    for(int i = iFirst; i >= 0 && i < iEnd; i++)
+    {
+        arrItems.Add(i);
+    }
+}
+
 int STileViewItemLocator::Item2Position(int iItem)
 {
     return (iItem / m_nCountInRow) * GetItemLineHeight();
@@ -150,4 +175,298 @@ int STileViewItemLocator::GetDownItem(int iItem)
     return m_adapter->getCount() - 1;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// STileViewItemLocatorMasonry
+STileViewItemLocatorMasonry::STileViewItemLocatorMasonry(LPCWSTR szDefHeight, LPCWSTR szItemWid, SLayoutSize marginSize) :
+    STileViewItemLocator(szDefHeight, szItemWid, marginSize),
+    m_nItems(0),
+    m_nCols(1),
+    m_nRows(0),
+    m_nTopStep(0)
+{
+}
+
+void STileViewItemLocatorMasonry::SetAdapter(ILvAdapter *pAdapter)
+{
+    STileViewItemLocator::SetAdapter(pAdapter);
+    OnDataSetChanged();
+}
+
+void STileViewItemLocatorMasonry::OnDataSetChanged()
+{
+    int nCount = m_adapter ? m_adapter->getCount() : 0;
+    m_arrHeight.SetCount(nCount);
+    for(int i = 0; i < nCount; i++)
+    {
+        m_arrHeight[i] = -1;
+    }
+    BuildIndex();
+}
+
+int STileViewItemLocatorMasonry::SetScale(int scale)
+{
+    STileViewItemLocator::SetScale(scale);
+    OnDataSetChanged();
+    return 0;
+}
+
+void STileViewItemLocatorMasonry::SetTileViewWidth(LPCWSTR width)
+{
+    STileViewItemLocator::SetTileViewWidth(width);
+    if(m_nCountInRow != m_nCols)
+    {
+        BuildIndex();
+    }
+}
+
+void STileViewItemLocatorMasonry::SetTileViewWidth(int width)
+{
+    STileViewItemLocator::SetTileViewWidth(width);
+    if(m_nCountInRow != m_nCols)
+    {
+        BuildIndex();
+    }
+}
+
+void STileViewItemLocatorMasonry::BuildIndex()
+{
+    m_nItems = (int)m_arrHeight.GetCount();
+    m_nCols = m_nCountInRow;
+    m_nRows = (m_nItems + m_nCols - 1) / m_nCols;
+    m_nTopStep = 1;
+    while(m_nTopStep * 2 <= m_nRows)
+    {
+        m_nTopStep *= 2;
+    }
+    
+    m_arrColHeight.SetCount(m_nCols);
+    m_arrTree.SetCount(m_nCols * (m_nRows + 1));
+    int nMargin = GetMarginSize();
+    for(int iCol = 0; iCol < m_nCols; iCol++)
+    {
+        int *pTree = m_arrTree.GetData() + iCol * (m_nRows + 1);
+        for(int j = 0; j <= m_nRows; j++)
+        {
+            pTree[j] = 0;
+        }
+        int nTotal = 0;
+        //O(n)建树：每个结点加上自身的值后累加到父结点
+        for(int j = 1; j <= m_nRows; j++)
+        {
+            int iItem = (j - 1) * m_nCols + iCol;
+            if(iItem < m_nItems)
+            {
+                int nLine = GetItemHeight(iItem) + nMargin;
+                pTree[j] += nLine;
+                nTotal += nLine;
+            }
+            int iParent = j + (j & -j);
+            if(iParent <= m_nRows)
+            {
+                pTree[iParent] += pTree[j];
+            }
+        }
+        m_arrColHeight[iCol] = nTotal;
+    }
+}
+
+int STileViewItemLocatorMasonry::ColumnItemCount(int iCol) const
+{
+    if(iCol >= m_nItems)
+    {
+        return 0;
+    }
+    return (m_nItems - iCol - 1) / m_nCols + 1;
+}
+
+int STileViewItemLocatorMasonry::ColumnPrefix(int iCol, int nItems) const
+{
+    if(nItems > m_nRows)
+    {
+        nItems = m_nRows;
+    }
+    const int *pTree = m_arrTree.GetData() + iCol * (m_nRows + 1);
+    int nRet = 0;
+    for(int j = nItems; j > 0; j -= (j & -j))
+    {
+        nRet += pTree[j];
+    }
+    return nRet;
+}
+
+int STileViewItemLocatorMasonry::ColumnSearch(int iCol, int position) const
+{
+    const int *pTree = m_arrTree.GetData() + iCol * (m_nRows + 1);
+    int idx = 0;
+    for(int nStep = m_nTopStep; nStep > 0; nStep >>= 1)
+    {
+        int iNext = idx + nStep;
+        if(iNext <= m_nRows && pTree[iNext] <= position)
+        {
+            idx = iNext;
+            position -= pTree[iNext];
+        }
+    }
+    int nColCount = ColumnItemCount(iCol);
+    return idx < nColCount ? idx : nColCount;
+}
+
+int STileViewItemLocatorMasonry::GetItemHeight(int iItem) const
+{
+    if(iItem >= 0 && iItem < m_nItems && m_arrHeight[iItem] >= 0)
+    {
+        return m_arrHeight[iItem];
+    }
+    return STileViewItemLocator::GetItemHeight(iItem);
+}
+
+void STileViewItemLocatorMasonry::SetItemHeight(int iItem, int nHeight)
+{
+    if(iItem < 0 || iItem >= m_nItems)
+    {
+        return;
+    }
+    if(nHeight < 0)
+    {
+        nHeight = 0;
+    }
+    int nDiff = nHeight - GetItemHeight(iItem);
+    m_arrHeight[iItem] = nHeight;
+    if(nDiff == 0)
+    {
+        return;
+    }
+    int iCol = iItem % m_nCols;
+    int *pTree = m_arrTree.GetData() + iCol * (m_nRows + 1);
+    for(int j = iItem / m_nCols + 1; j <= m_nRows; j += (j & -j))
+    {
+        pTree[j] += nDiff;
+    }
+    m_arrColHeight[iCol] += nDiff;
+}
+
+CRect STileViewItemLocatorMasonry::GetItemRect(int iItem)
+{
+    int nMargin = GetMarginSize();
+    int nWidth = m_nItemWidth.toPixelSize(m_scale);
+    CRect rect;
+    rect.left = nMargin + (iItem % m_nCols) * (nWidth + nMargin);
+    rect.top = nMargin + Item2Position(iItem);
+    rect.right = rect.left + nWidth;
+    rect.bottom = rect.top + GetItemHeight(iItem);
+    return rect;
+}
+
+int STileViewItemLocatorMasonry::Item2Position(int iItem)
+{
+    return ColumnPrefix(iItem % m_nCols, iItem / m_nCols);
+}
+
+int STileViewItemLocatorMasonry::GetTotalHeight()
+{
+    if(m_nItems == 0)
+    {
+        return 0;
+    }
+    int nRet = 0;
+    for(int iCol = 0; iCol < m_nCols; iCol++)
+    {
+        if(m_arrColHeight[iCol] > nRet)
+        {
+            nRet = m_arrColHeight[iCol];
+        }
+    }
+    return nRet + GetMarginSize();
+}
+
+int STileViewItemLocatorMasonry::Position2Item(int position)
+{
+    if(!m_adapter)
+    {
+        return -1;
+    }
+    if(position < 0)
+    {
+        position = 0;
+    }
+    //各列中第一个没有完全位于position之上的item，取最小的index
+    int nRet = m_nItems;
+    for(int iCol = 0; iCol < m_nCols && iCol < m_nItems; iCol++)
+    {
+        int nAbove = ColumnSearch(iCol, position);
+        if(nAbove < ColumnItemCount(iCol))
+        {
+            int iItem = nAbove * m_nCols + iCol;
+            if(iItem < nRet)
+            {
+                nRet = iItem;
+            }
+        }
+    }
+    return nRet;
+}
+
+int STileViewItemLocatorMasonry::Position2ItemEnd(int position)
+{
+    if(!m_adapter || position <= 0)
+    {
+        return 0;
+    }
+    //各列中最后一个顶部位于position之上的item，取最大的index
+    int nRet = 0;
+    for(int iCol = 0; iCol < m_nCols && iCol < m_nItems; iCol++)
+    {
+        int nCount = ColumnSearch(iCol, position - 1) + 1;
+        int nColCount = ColumnItemCount(iCol);
+        if(nCount > nColCount)
+        {
+            nCount = nColCount;
+        }
+        int iEnd = (nCount - 1) * m_nCols + iCol + 1;
+        if(iEnd > nRet)
+        {
+            nRet = iEnd;
+        }
+    }
+    return nRet;
+}
+
+static int __cdecl CompareIndex(const void *p1, const void *p2)
+{
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+void STileViewItemLocatorMasonry::GetVisibleItems(int nTop, int nBottom, SArray<int> &arrItems)
+{
+    arrItems.RemoveAll();
+    if(!m_adapter || nBottom <= 0)
+    {
+        return;
+    }
+    if(nTop < 0)
+    {
+        nTop = 0;
+    }
+    for(int iCol = 0; iCol < m_nCols && iCol < m_nItems; iCol++)
+    {
+        //第一个没有完全位于nTop之上的行，到最后一个顶部位于nBottom之上的行
+        int nColCount = ColumnItemCount(iCol);
+        int iRowFirst = ColumnSearch(iCol, nTop);
+        int iRowEnd = ColumnSearch(iCol, nBottom - 1) + 1;
+        if(iRowEnd > nColCount)
+        {
+            iRowEnd = nColCount;
+        }
+        for(int iRow = iRowFirst; iRow < iRowEnd; iRow++)
+        {
+            arrItems.Add(iRow * m_nCols + iCol);
+        }
+    }
+    //各列的结果合并后按index排序，数量只有一屏左右
+    if(arrItems.GetCount() > 1)
+    {
+        qsort(arrItems.GetData(), arrItems.GetCount(), sizeof(int), CompareIndex);
+    }
+}
+
 }
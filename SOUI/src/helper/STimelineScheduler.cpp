@@ -0,0 +1,153 @@
+﻿#include "souistd.h"
+#include "helper/STimelineScheduler.h"
+
+namespace SOUI
+{
+    static const ULONGLONG KDueIdle = (ULONGLONG)-1;
+
+    STimelineScheduler::STimelineScheduler()
+        :m_nInterval(10)
+        ,m_ullOrigin(Now())
+        ,m_ullLastFrame(0)
+    {
+        ResetStats();
+    }
+
+    void STimelineScheduler::SetFrameRate(UINT nFps)
+    {
+        if(nFps<1) nFps = 1;
+        if(nFps>1000) nFps = 1000;
+        m_nInterval = 1000/nFps;
+        m_ullOrigin = Now();
+        m_ullLastFrame = 0;
+    }
+
+    ULONGLONG STimelineScheduler::Now()
+    {
+        static LARGE_INTEGER s_freq = {0};
+        if(s_freq.QuadPart == 0) ::QueryPerformanceFrequency(&s_freq);
+        LARGE_INTEGER cnt;
+        ::QueryPerformanceCounter(&cnt);
+        return (ULONGLONG)(cnt.QuadPart/s_freq.QuadPart*1000000 + cnt.QuadPart%s_freq.QuadPart*1000000/s_freq.QuadPart);
+    }
+
+    ULONGLONG STimelineScheduler::AlignToFrame(ULONGLONG ullTime) const
+    {
+        ULONGLONG ullInterval = m_nInterval*1000;
+        if(ullTime<=m_ullOrigin) return m_ullOrigin;
+        ULONGLONG ullFrames = (ullTime - m_ullOrigin + ullInterval - 1)/ullInterval;
+        return m_ullOrigin + ullFrames*ullInterval;
+    }
+
+    int STimelineScheduler::FindHandler(ITimelineHandler *pHandler) const
+    {
+        for(size_t i=0;i<m_arrHandler.GetCount();i++)
+        {
+            if(m_arrHandler[i].pHandler == pHandler) return (int)i;
+        }
+        return -1;
+    }
+
+    BOOL STimelineScheduler::Register(ITimelineHandler *pHandler)
+    {
+        if(FindHandler(pHandler)!=-1) return FALSE;
+        TIMELINEITEM item = {pHandler,0};
+        m_arrHandler.Add(item);
+        return TRUE;
+    }
+
+    BOOL STimelineScheduler::Unregister(ITimelineHandler *pHandler)
+    {
+        int idx = FindHandler(pHandler);
+        if(idx==-1) return FALSE;
+        m_arrHandler.RemoveAt(idx);
+        return TRUE;
+    }
+
+    BOOL STimelineScheduler::Schedule(ITimelineHandler *pHandler,UINT nDelay)
+    {
+        int idx = FindHandler(pHandler);
+        if(idx==-1) return FALSE;
+        if(nDelay == NEXTFRAME_IDLE)
+            m_arrHandler[idx].ullDue = KDueIdle;
+        else
+            m_arrHandler[idx].ullDue = Now() + (ULONGLONG)nDelay*1000;
+        return TRUE;
+    }
+
+    UINT STimelineScheduler::GetNextDelay() const
+    {
+        ULONGLONG ullDue = KDueIdle;
+        for(size_t i=0;i<m_arrHandler.GetCount();i++)
+        {
+            if(m_arrHandler[i].ullDue < ullDue) ullDue = m_arrHandler[i].ullDue;
+        }
+        if(ullDue == KDueIdle) return NEXTFRAME_IDLE;
+
+        ULONGLONG ullNow = Now();
+        ULONGLONG ullNext = AlignToFrame(ullDue>ullNow?ullDue:ullNow+1);
+        UINT nDelay = (UINT)((ullNext - ullNow + 999)/1000);
+        return nDelay>0?nDelay:1;
+    }
+
+    UINT STimelineScheduler::RunFrame()
+    {
+        ULONGLONG ullNow = Now();
+        ULONGLONG ullInterval = m_nInterval*1000;
+
+        //统计帧时序
+        ULONGLONG ullFrame = (ullNow - m_ullOrigin)/ullInterval;
+        ULONGLONG ullExpect = m_ullOrigin + ullFrame*ullInterval;
+        DWORD dwJitter = (DWORD)(ullNow - ullExpect);
+        if(dwJitter*2 > ullInterval)
+        {//更靠近下一帧，按提前到达处理
+            dwJitter = (DWORD)(ullInterval - dwJitter);
+            ullFrame ++;
+        }
+        if(m_stats.nFrames>0 && ullFrame>m_ullLastFrame+1)
+        {
+            //只有存在已经到期的handler时错过的帧才有意义
+            ULONGLONG ullLastExpect = m_ullOrigin + m_ullLastFrame*ullInterval;
+            for(size_t i=0;i<m_arrHandler.GetCount();i++)
+            {
+                if(m_arrHandler[i].ullDue <= ullLastExpect + ullInterval)
+                {
+                    m_stats.nMissedFrames += (DWORD)(ullFrame - m_ullLastFrame - 1);
+                    break;
+                }
+            }
+        }
+        m_ullLastFrame = ullFrame;
+        m_stats.nFrames ++;
+        m_stats.ullTotalJitter += dwJitter;
+        m_stats.dwAvgJitter = (DWORD)(m_stats.ullTotalJitter/m_stats.nFrames);
+        if(dwJitter>m_stats.dwMaxJitter) m_stats.dwMaxJitter = dwJitter;
+
+        //先收集到期的handler，handler在OnNextFrame中可能注册或者注销其它handler
+        ULONGLONG ullDeadline = ullNow + ullInterval/2;
+        SArray<ITimelineHandler*> arrDue;
+        for(size_t i=0;i<m_arrHandler.GetCount();i++)
+        {
+            if(m_arrHandler[i].ullDue <= ullDeadline)
+                arrDue.Add(m_arrHandler[i].pHandler);
+            else
+                m_stats.nSkippedCalls ++;
+        }
+
+        for(size_t i=0;i<arrDue.GetCount();i++)
+        {
+            int idx = FindHandler(arrDue[i]);
+            if(idx==-1) continue;//已经在前面的handler中被注销
+            m_arrHandler[idx].ullDue = 0;//默认下一帧继续触发，handler可以在OnNextFrame中调用Schedule修改
+            m_stats.nHandlerCalls ++;
+            arrDue[i]->OnNextFrame();
+        }
+        return GetNextDelay();
+    }
+
+    void STimelineScheduler::ResetStats()
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+}//namespace SOUI
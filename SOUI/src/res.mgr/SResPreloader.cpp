@@ -0,0 +1,288 @@
+﻿#include "souistd.h"
+#include "res.mgr/SResPreloader.h"
+#include "SApp.h"
+#include "core/SSkin.h"
+#include "helper/SplitString.h"
+#include <process.h>
+
+namespace SOUI
+{
+    const static int KMaxPreloadThreads = 8;
+
+    //当前时间(us)，用于统计各阶段耗时
+    static ULONGLONG NowUs()
+    {
+        static LARGE_INTEGER s_freq = {0};
+        if(s_freq.QuadPart == 0) ::QueryPerformanceFrequency(&s_freq);
+        LARGE_INTEGER cnt;
+        ::QueryPerformanceCounter(&cnt);
+        return (ULONGLONG)(cnt.QuadPart/s_freq.QuadPart*1000000 + cnt.QuadPart%s_freq.QuadPart*1000000/s_freq.QuadPart);
+    }
+
+    SResPreloader::SResPreloader()
+        :m_nRunning(0)
+        ,m_nMaxThreads(0)
+        ,m_ullSkinStart(0)
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    SResPreloader::~SResPreloader()
+    {
+        Discard(NULL);
+        _WaitWorkers();
+    }
+
+    SStringT SResPreloader::MakeKey(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName)
+    {
+        SStringT strKey;
+        strKey.Format(_T("%p:%s:%s"),pResProvider,pszType,pszName);
+        strKey.MakeLower();
+        return strKey;
+    }
+
+    int SResPreloader::PreloadSkinImages(IResProvider *pResProvider,pugi::xml_node xmlSkins)
+    {
+        {
+            SAutoLock lock(m_cs);
+            if(m_nMaxThreads < 0) return 0;
+            m_ullSkinStart = NowUs();
+        }
+        //gif,apng等皮肤自己读取并解码src，预加载的结果不会被使用，按类型记录是否需要预加载
+        SMap<SStringW,BOOL> mapClass;
+        int nCount = 0, nSkipped = 0;
+        for(pugi::xml_node xmlSkin = xmlSkins.first_child(); xmlSkin; xmlSkin = xmlSkin.next_sibling())
+        {
+            if(xmlSkin.type() != pugi::node_element) continue;
+            SStringT strSrc = S_CW2T(xmlSkin.attribute(L"src").value());
+            if(strSrc.IsEmpty()) continue;
+            SStringW strClass = xmlSkin.name();
+            SMap<SStringW,BOOL>::CPair *p = mapClass.Lookup(strClass);
+            if(!p)
+            {
+                ISkinObj *pSkin = SApplication::getSingleton().CreateSkinByName(strClass);
+                BOOL bImgSkin = pSkin && sobj_cast<SSkinImgList>(pSkin) != NULL;
+                if(pSkin) pSkin->Release();
+                mapClass[strClass] = bImgSkin;
+                p = mapClass.Lookup(strClass);
+            }
+            if(!p->m_value)
+            {
+                nSkipped++;
+                continue;
+            }
+            SStringTList strLst;
+            if(2 != ParseResID(strSrc,strLst)) continue;
+            if(PreloadImage(pResProvider,strLst[0],strLst[1])) nCount++;
+        }
+        SAutoLock lock(m_cs);
+        m_stats.nSkipped += nSkipped;
+        return nCount;
+    }
+
+    BOOL SResPreloader::PreloadImage(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName)
+    {
+        SStringT strKey = MakeKey(pResProvider,pszType,pszName);
+        {
+            SAutoLock lock(m_cs);
+            if(m_nMaxThreads < 0) return FALSE;
+            if(m_mapJobs.Lookup(strKey)) return FALSE;
+        }
+        {
+            SAutoLock lockRes(m_csProvider);
+            if(!pResProvider->HasResource(pszType,pszName)) return FALSE;
+        }
+
+        PRELOADJOB *pJob = new PRELOADJOB;
+        pJob->strKey = strKey;
+        pJob->pResProvider = pResProvider;
+        pJob->strType = pszType;
+        pJob->strName = pszName;
+        pJob->state = JOB_PENDING;
+        pJob->hDone = ::CreateEvent(NULL,TRUE,FALSE,NULL);
+        pJob->pImg = NULL;
+
+        SAutoLock lock(m_cs);
+        m_mapJobs[strKey] = pJob;
+        m_lstPending.AddTail(pJob);
+        m_stats.nSubmitted ++;
+        if(m_nRunning < (LONG)m_lstPending.GetCount()) _StartWorker();
+        return TRUE;
+    }
+
+    void SResPreloader::_StartWorker()
+    {
+        //同一资源包的调用是串行的，默认只使用一个工作线程和UI线程并行
+        int nMaxThreads = m_nMaxThreads > 0 ? m_nMaxThreads : 1;
+        if(nMaxThreads > KMaxPreloadThreads) nMaxThreads = KMaxPreloadThreads;
+        if(m_nRunning >= nMaxThreads) return;
+
+        //清理已经退出的线程
+        for(int i=(int)m_arrThreads.GetCount()-1;i>=0;i--)
+        {
+            if(::WaitForSingleObject(m_arrThreads[i],0) == WAIT_OBJECT_0)
+            {
+                ::CloseHandle(m_arrThreads[i]);
+                m_arrThreads.RemoveAt(i);
+            }
+        }
+
+        HANDLE hThread = (HANDLE)_beginthreadex(NULL,0,WorkerProc,this,0,NULL);
+        if(!hThread) return;
+        m_arrThreads.Add(hThread);
+        m_nRunning ++;
+        if(m_nRunning > m_stats.nMaxThreads) m_stats.nMaxThreads = m_nRunning;
+    }
+
+    unsigned int SResPreloader::WorkerProc(LPVOID pParam)
+    {
+        SResPreloader *_this = (SResPreloader*)pParam;
+        HRESULT hr = ::CoInitializeEx(NULL,COINIT_MULTITHREADED);//WIC解码需要初始化COM
+        for(;;)
+        {
+            PRELOADJOB *pJob = NULL;
+            {
+                SAutoLock lock(_this->m_cs);
+                if(_this->m_lstPending.IsEmpty())
+                {//没有任务时退出线程，有新任务时重新创建
+                    _this->m_nRunning --;
+                    break;
+                }
+                pJob = _this->m_lstPending.RemoveHead();
+                pJob->state = JOB_DECODING;
+            }
+
+            _this->_Load(pJob);
+
+            //设置事件后任务由TakeImage或者Discard删除
+            SAutoLock lock(_this->m_cs);
+            pJob->state = JOB_DONE;
+            _this->m_stats.nDecoded ++;
+            ::SetEvent(pJob->hDone);
+        }
+        if(SUCCEEDED(hr)) ::CoUninitialize();
+        return 0;
+    }
+
+    void SResPreloader::_Load(PRELOADJOB *pJob)
+    {
+        ULONGLONG ullStart = NowUs();
+        {
+            SAutoLock lockRes(m_csProvider);
+            pJob->pImg = pJob->pResProvider->LoadImage(pJob->strType,pJob->strName);
+        }
+        InterlockedExchangeAdd((LONG*)&m_stats.dwDecodeTime,(LONG)(NowUs() - ullStart));
+    }
+
+    void SResPreloader::_FreeJob(PRELOADJOB *pJob)
+    {
+        if(pJob->pImg) pJob->pImg->Release();
+        ::CloseHandle(pJob->hDone);
+        delete pJob;
+    }
+
+    IBitmap * SResPreloader::TakeImage(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName)
+    {
+        PRELOADJOB *pJob = NULL;
+        {
+            SAutoLock lock(m_cs);
+            //预加载只在创建皮肤期间有任务，其它时间不需要生成查找键
+            if(m_mapJobs.IsEmpty()) return NULL;
+            SStringT strKey = MakeKey(pResProvider,pszType,pszName);
+            SMap<SStringT,PRELOADJOB*>::CPair *p = m_mapJobs.Lookup(strKey);
+            if(!p) return NULL;
+            pJob = p->m_value;
+            m_mapJobs.RemoveKey(strKey);
+            if(pJob->state == JOB_PENDING)
+            {//还没有开始加载，由调用者直接加载
+                SPOSITION pos = m_lstPending.Find(pJob);
+                SASSERT(pos);
+                m_lstPending.RemoveAt(pos);
+                m_stats.nInline ++;
+                _FreeJob(pJob);
+                return NULL;
+            }else if(pJob->state == JOB_DECODING)
+            {
+                m_stats.nWaited ++;
+            }
+        }
+
+        ULONGLONG ullStart = NowUs();
+        ::WaitForSingleObject(pJob->hDone,INFINITE);
+        IBitmap *pImg = pJob->pImg;
+        pJob->pImg = NULL;
+        _FreeJob(pJob);
+
+        SAutoLock lock(m_cs);
+        m_stats.dwWaitTime += (DWORD)(NowUs() - ullStart);
+        return pImg;
+    }
+
+    void SResPreloader::Discard(IResProvider *pResProvider)
+    {
+        SArray<PRELOADJOB*> arrDecoding;
+        {
+            SAutoLock lock(m_cs);
+            SArray<PRELOADJOB*> arrDiscard;
+            SPOSITION pos = m_mapJobs.GetStartPosition();
+            while(pos)
+            {
+                PRELOADJOB *pJob = m_mapJobs.GetNextValue(pos);
+                if(!pResProvider || pJob->pResProvider == pResProvider) arrDiscard.Add(pJob);
+            }
+
+            for(size_t i=0;i<arrDiscard.GetCount();i++)
+            {
+                PRELOADJOB *pJob = arrDiscard[i];
+                m_mapJobs.RemoveKey(pJob->strKey);
+                m_stats.nDiscarded ++;
+                if(pJob->state == JOB_DECODING)
+                {//等待工作线程完成，返回后不再有线程访问该资源包
+                    arrDecoding.Add(pJob);
+                    continue;
+                }
+                if(pJob->state == JOB_PENDING)
+                {
+                    SPOSITION posPending = m_lstPending.Find(pJob);
+                    SASSERT(posPending);
+                    m_lstPending.RemoveAt(posPending);
+                }
+                _FreeJob(pJob);
+            }
+            if(m_ullSkinStart)
+            {
+                m_stats.dwSkinTime += (DWORD)(NowUs() - m_ullSkinStart);
+                m_ullSkinStart = 0;
+            }
+        }
+
+        for(size_t i=0;i<arrDecoding.GetCount();i++)
+        {
+            ::WaitForSingleObject(arrDecoding[i]->hDone,INFINITE);
+            _FreeJob(arrDecoding[i]);
+        }
+    }
+
+    void SResPreloader::_WaitWorkers()
+    {
+        for(size_t i=0;i<m_arrThreads.GetCount();i++)
+        {
+            ::WaitForSingleObject(m_arrThreads[i],INFINITE);
+            ::CloseHandle(m_arrThreads[i]);
+        }
+        m_arrThreads.RemoveAll();
+    }
+
+    void SResPreloader::SetMaxThreads(int nThreads)
+    {
+        SAutoLock lock(m_cs);
+        m_nMaxThreads = nThreads;
+    }
+
+    void SResPreloader::GetStats(SResPreloadStats & stats)
+    {
+        SAutoLock lock(m_cs);
+        stats = m_stats;
+    }
+
+}//namespace SOUI
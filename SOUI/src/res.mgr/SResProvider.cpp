@@ -303,10 +303,15 @@ namespace SOUI
     //////////////////////////////////////////////////////////////////////////
     // SResProviderFiles
 
-    SResProviderFiles::SResProviderFiles()
+    SResProviderFiles::SResProviderFiles():m_hChange(INVALID_HANDLE_VALUE)
     {
     }
 
+    SResProviderFiles::~SResProviderFiles()
+    {
+        if(m_hChange != INVALID_HANDLE_VALUE) FindCloseChangeNotification(m_hChange);
+    }
+
     SStringT SResProviderFiles::GetRes( LPCTSTR strType,LPCTSTR pszResName )
     {
         SResID resID(strType,pszResName);
@@ -400,6 +405,17 @@ namespace SOUI
         TCHAR szFullPath[1025];
         GetFullPathName(pszPath,1024,szFullPath,NULL);
         m_strPath=szFullPath;
+
+        if(m_hChange != INVALID_HANDLE_VALUE) FindCloseChangeNotification(m_hChange);
+        m_hChange = FindFirstChangeNotification(m_strPath,TRUE,FILE_NOTIFY_CHANGE_FILE_NAME|FILE_NOTIFY_CHANGE_LAST_WRITE);
+        return TRUE;
+    }
+
+    BOOL SResProviderFiles::CheckChanged()
+    {
+        if(m_hChange == INVALID_HANDLE_VALUE) return FALSE;
+        if(WaitForSingleObject(m_hChange,0) != WAIT_OBJECT_0) return FALSE;
+        FindNextChangeNotification(m_hChange);
         return TRUE;
     }
 
@@ -409,6 +425,17 @@ namespace SOUI
         SMap<SResID,SStringT>::CPair *p=m_mapFiles.Lookup(resID);
         return (p!=NULL);
     }
+
+    BOOL SResProviderFiles::EnumResource( FunEnumResCallback funEnumCB,LPARAM lp )
+    {
+        SPOSITION pos = m_mapFiles.GetStartPosition();
+        while(pos)
+        {
+            const SResID & resID = m_mapFiles.GetNext(pos)->m_key;
+            if(!funEnumCB(resID.szType,resID.szName,lp)) break;
+        }
+        return TRUE;
+    }
     
 #ifdef _DEBUG
     void SResProviderFiles::CheckResUsage(const SMap<SStringT,int> & mapResUsage)
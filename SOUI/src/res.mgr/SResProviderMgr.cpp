@@ -9,20 +9,143 @@
 namespace SOUI
 {
     const static TCHAR KTypeFile[]      = _T("file");  //从文件加载资源时指定的类型
+    const static DWORD KResCheckInterval = 500;         //检查资源包内容是否被修改的最小间隔(ms)
 
 
+    //////////////////////////////////////////////////////////////////////////
+    // SResIndex
+    SResProviderMgr::SResIndex::SResIndex(const SList<IResProvider*> & lstResPackage)
+        :m_iEnum(0)
+    {
+        SPOSITION pos = lstResPackage.GetTailPosition();
+        while(pos)
+        {
+            IResProvider *pResProvider = lstResPackage.GetPrev(pos);
+            pResProvider->AddRef();
+            m_iEnum = (int)m_arrProviders.Add(pResProvider);
+            m_arrIndexed.Add(pResProvider->EnumResource(OnEnumRes,(LPARAM)this));
+        }
+    }
+
+    SResProviderMgr::SResIndex::~SResIndex()
+    {
+        for(size_t i=0;i<m_arrProviders.GetCount();i++)
+        {
+            m_arrProviders[i]->Release();
+        }
+    }
+
+    BOOL SResProviderMgr::SResIndex::OnEnumRes(LPCTSTR pszType,LPCTSTR pszName,LPARAM lp)
+    {
+        SResIndex *_this = (SResIndex*)lp;
+        SResID resID(pszType,pszName);
+        if(!_this->m_mapRes.Lookup(resID)) _this->m_mapRes[resID] = _this->m_iEnum;
+        return TRUE;
+    }
+
+    IResProvider * SResProviderMgr::SResIndex::Find(LPCTSTR pszType,LPCTSTR pszResName,SCriticalSection & csProvider) const
+    {
+        const SMap<SResID,int>::CPair *p = m_mapRes.IsEmpty()?NULL:m_mapRes.Lookup(SResID(pszType,pszResName));
+        int iIndexed = p?p->m_value:(int)m_arrProviders.GetCount();
+        IResProvider *pRet = p?m_arrProviders[iIndexed]:NULL;
+        BOOL bLocked = FALSE;
+        for(int i=0;i<iIndexed;i++)
+        {
+            if(m_arrIndexed[i]) continue;
+            if(!bLocked)
+            {//资源包不是线程安全的，和其它资源包调用一样在资源包锁内调用HasResource
+                csProvider.Enter();
+                bLocked = TRUE;
+            }
+            if(m_arrProviders[i]->HasResource(pszType,pszResName))
+            {
+                pRet = m_arrProviders[i];
+                break;
+            }
+        }
+        if(bLocked) csProvider.Leave();
+        return pRet;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // SResProviderMgr
     SResProviderMgr::SResProviderMgr()
+        :m_nReaders(0)
+        ,m_nRetired(0)
+        ,m_dwLastCheck(GetTickCount())
     {
+        m_pResIndex = new SResIndex(m_lstResPackage);
     }
 
     SResProviderMgr::~SResProviderMgr(void)
     {
         RemoveAll();
+        _FreeRetiredIndex(TRUE);
+        delete m_pResIndex;
+    }
+
+    void SResProviderMgr::_UpdateResIndex()
+    {
+        SResIndex *pNewIndex = NULL;
+        {
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
+            pNewIndex = new SResIndex(m_lstResPackage);
+        }
+        SResIndex *pOldIndex = (SResIndex*)InterlockedExchangePointer((PVOID*)&m_pResIndex,pNewIndex);
+        {
+            SAutoLock lockRetired(m_csRetired);
+            m_lstRetiredIndex.AddTail(pOldIndex);
+            InterlockedExchange(&m_nRetired,(LONG)m_lstRetiredIndex.GetCount());
+        }
+        //还有读者时由最后一个离开的读者释放
+        _FreeRetiredIndex(FALSE);
+    }
+
+    void SResProviderMgr::_FreeRetiredIndex(BOOL bForce)
+    {
+        SAutoLock lockRetired(m_csRetired);
+        //替换索引之后读者数为0时，之后的读者只能看到新索引
+        if(!bForce && InterlockedCompareExchange(&m_nReaders,0,0) != 0) return;
+        SPOSITION pos = m_lstRetiredIndex.GetHeadPosition();
+        while(pos)
+        {
+            delete m_lstRetiredIndex.GetNext(pos);
+        }
+        m_lstRetiredIndex.RemoveAll();
+        InterlockedExchange(&m_nRetired,0);
+    }
+
+    void SResProviderMgr::UpdateResIndex()
+    {
+        SAutoLock lock(m_cs);
+        _UpdateResIndex();
+        m_xmlDocCache.RemoveAll();
+    }
+
+    void SResProviderMgr::CheckResChanged()
+    {
+        DWORD dwNow = GetTickCount();
+        if(dwNow - m_dwLastCheck < KResCheckInterval) return;
+        SAutoLock lock(m_cs);
+        if(dwNow - m_dwLastCheck < KResCheckInterval) return;
+        m_dwLastCheck = dwNow;
+
+        BOOL bChanged = FALSE;
+        {
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
+            SPOSITION pos = m_lstResPackage.GetHeadPosition();
+            while(pos)
+            {//每个资源包都要调用，清除各自的修改标志
+                if(m_lstResPackage.GetNext(pos)->CheckChanged()) bChanged = TRUE;
+            }
+        }
+        if(bChanged) m_xmlDocCache.RemoveAll();
     }
 
     void SResProviderMgr::RemoveAll()
     {
         SAutoLock lock(m_cs);
+        m_resPreloader.Discard(NULL);
         SPOSITION pos=m_lstResPackage.GetHeadPosition();
         while(pos)
         {
@@ -33,6 +156,8 @@ namespace SOUI
             pResProvider->Release();
         }
         m_lstResPackage.RemoveAll();
+        _UpdateResIndex();
+        m_xmlDocCache.RemoveAll();
         
         pos = m_mapCachedCursor.GetStartPosition();
         while(pos)
@@ -48,20 +173,20 @@ namespace SOUI
     {
         if(!pszType) return NULL;
 
-        SAutoLock lock(m_cs);
-        SPOSITION pos=m_lstResPackage.GetTailPosition();
-        while(pos)
-        {
-            IResProvider * pResProvider = m_lstResPackage.GetPrev(pos);
-            if(pResProvider->HasResource(pszType,pszResName)) 
-            {
+        InterlockedIncrement(&m_nReaders);
+        IResProvider * pResProvider = m_pResIndex->Find(pszType,pszResName,m_resPreloader.GetProviderLock());
+        if(InterlockedDecrement(&m_nReaders) == 0 && m_nRetired != 0)
+        {//替换索引时还有读者，由最后一个离开的读者释放旧索引
+            _FreeRetiredIndex(FALSE);
+        }
 #ifdef _DEBUG
-                m_mapResUsageCount[SStringT().Format(_T("%s:%s"),pszType,pszResName).MakeLower()] ++;
-#endif
-                return pResProvider;
-            }
+        if(pResProvider)
+        {
+            SAutoLock lock(m_cs);
+            m_mapResUsageCount[SStringT().Format(_T("%s:%s"),pszType,pszResName).MakeLower()] ++;
         }
-        return NULL;
+#endif
+        return pResProvider;
     }
    
     void SResProviderMgr::AddResProvider( IResProvider * pResProvider ,LPCTSTR pszUidef)
@@ -69,6 +194,8 @@ namespace SOUI
         SAutoLock lock(m_cs);
         m_lstResPackage.AddTail(pResProvider);
 		pResProvider->AddRef();
+        _UpdateResIndex();
+        m_xmlDocCache.RemoveAll();
 		if(pszUidef) 
 		{
 			IUiDefInfo * pUiDef = SUiDef::getSingleton().CreateUiDefInfo(pResProvider,pszUidef);
@@ -88,6 +215,9 @@ namespace SOUI
             if(pResProvierT == pResProvider)
             {
                 m_lstResPackage.RemoveAt(posPrev);
+                _UpdateResIndex();
+                m_xmlDocCache.RemoveAll();
+                m_resPreloader.Discard(pResProvider);
                 pResProvierT->Release();
                 break;
             }
@@ -146,6 +276,7 @@ namespace SOUI
 #endif
             IResProvider *pResProvider=GetMatchResProvider(strType,pszResName);
             if(!pResProvider) return FALSE;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->GetRawBuffer(strType,pszResName,pBuf,size);
         }
     }
@@ -164,6 +295,7 @@ namespace SOUI
 
             IResProvider *pResProvider=GetMatchResProvider(strType,pszResName);
             if(!pResProvider) return 0;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->GetRawBufferSize(strType,pszResName);
         }
     }
@@ -182,6 +314,7 @@ namespace SOUI
 
             IResProvider *pResProvider=GetMatchResProvider(strType,pszResName);
             if(!pResProvider) return NULL;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->LoadImgX(strType,pszResName);
         }
     }
@@ -201,6 +334,10 @@ namespace SOUI
 
             IResProvider *pResProvider=GetMatchResProvider(pszType,pszResName);
             if(!pResProvider) return NULL;
+            //TakeImage可能等待工作线程，不能持有资源包锁
+            IBitmap *pImg = m_resPreloader.TakeImage(pResProvider,pszType,pszResName);
+            if(pImg) return pImg;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->LoadImage(pszType,pszResName);
         }
     }
@@ -219,6 +356,7 @@ namespace SOUI
 
             IResProvider *pResProvider=GetMatchResProvider(KTypeBitmap,pszResName);
             if(!pResProvider) return NULL;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->LoadBitmap(pszResName);
         }
     }
@@ -250,7 +388,10 @@ namespace SOUI
 
             IResProvider *pResProvider=GetMatchResProvider(KTypeCursor,pszResName);
             if(pResProvider)
+            {
+                SAutoLock lockRes(m_resPreloader.GetProviderLock());
                 hRet =pResProvider->LoadCursor(pszResName);
+            }
         }
         if(hRet)
         {
@@ -272,13 +413,13 @@ namespace SOUI
 #endif
             IResProvider *pResProvider=GetMatchResProvider(KTypeIcon,pszResName);
             if(!pResProvider) return NULL;
+            SAutoLock lockRes(m_resPreloader.GetProviderLock());
             return pResProvider->LoadIcon(pszResName,cx,cy);
         }
     }
 
     BOOL SResProviderMgr::HasResource( LPCTSTR pszType,LPCTSTR pszResName )
     {
-        SAutoLock lock(m_cs);
         if(IsFileType(pszType))
         {
             return ::GetFileAttributes(pszResName) != INVALID_FILE_ATTRIBUTES;
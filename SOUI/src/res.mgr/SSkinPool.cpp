@@ -60,7 +60,7 @@ int SSkinPool::LoadSkins(pugi::xml_node xmlNode)
         if(pSkin)
         {
             pSkin->InitFromXml(xmlSkin);
-			SkinKey key = {strSkinName,pSkin->GetScale()};
+			SkinKey key = {strSkinName,pSkin->GetScale(),SAtomTable::getSingleton().AddAtom(strSkinName,strSkinName.GetLength())};
 			SASSERT(!HasKey(key));
             AddKeyObject(key,pSkin);
             nLoaded++;
@@ -98,7 +98,14 @@ int NormalizeScale(int nScale)
 
 ISkinObj* SSkinPool::GetSkin(const SStringW & strSkinName,int nScale)
 {
-	SkinKey key ={strSkinName,nScale};
+	SkinKey key ={strSkinName,nScale,SAtomTable::getSingleton().FindAtom(strSkinName,strSkinName.GetLength())};
+	return GetSkin(key);
+}
+
+ISkinObj* SSkinPool::GetSkin(const SkinKey & keySrc)
+{
+	SkinKey key = keySrc;
+	int nScale = key.scale;
 
     if(!HasKey(key))
     {
@@ -139,10 +146,51 @@ void SSkinPool::OnKeyRemoved(const SSkinPtr & obj )
 //////////////////////////////////////////////////////////////////////////
 template<> SSkinPoolMgr * SSingleton<SSkinPoolMgr>::ms_Singleton=0;
 
+const wchar_t * BUILDIN_SKIN_NAMES[]=
+{
+    L"_skin.sys.checkbox",
+    L"_skin.sys.radio",
+    L"_skin.sys.focuscheckbox",
+    L"_skin.sys.focusradio",
+    L"_skin.sys.btn.normal",
+    L"_skin.sys.scrollbar",
+    L"_skin.sys.border",
+    L"_skin.sys.dropbtn",
+    L"_skin.sys.tree.toggle",
+    L"_skin.sys.tree.checkbox",
+    L"_skin.sys.tab.page",
+    L"_skin.sys.header",
+    L"_skin.sys.split.vert",
+    L"_skin.sys.split.horz",
+    L"_skin.sys.prog.bkgnd",
+    L"_skin.sys.prog.bar",
+    L"_skin.sys.vert.prog.bkgnd",
+    L"_skin.sys.vert.prog.bar",
+    L"_skin.sys.slider.thumb",
+    L"_skin.sys.btn.close",
+    L"_skin.sys.btn.minimize",
+    L"_skin.sys.btn.maxmize",
+    L"_skin.sys.btn.restore",
+    L"_skin.sys.menu.check",
+    L"_skin.sys.menu.sep",
+    L"_skin.sys.menu.arrow",
+    L"_skin.sys.menu.border",
+    L"_skin.sys.menu.skin",
+    L"_skin.sys.icons",
+    L"_skin.sys.wnd.bkgnd"
+};
+
 SSkinPoolMgr::SSkinPoolMgr()
 {
     m_bulitinSkinPool.Attach(new SSkinPool);
     PushSkinPool(m_bulitinSkinPool);
+
+    for(int i=0;i<SKIN_SYS_COUNT;i++)
+    {
+        m_builtinSkinKeys[i].strName = BUILDIN_SKIN_NAMES[i];
+        m_builtinSkinKeys[i].scale = 100;
+        m_builtinSkinKeys[i].atom = SAtomTable::getSingleton().AddAtom(BUILDIN_SKIN_NAMES[i]);
+    }
 }
 
 SSkinPoolMgr::~SSkinPoolMgr()
@@ -158,16 +206,24 @@ SSkinPoolMgr::~SSkinPoolMgr()
 }
 
 ISkinObj* SSkinPoolMgr::GetSkin( const SStringW & strSkinName, int nScale)
+{
+    //只查找一次原子，各个SkinPool中使用原子的hash及比较
+    SkinKey key = {strSkinName,nScale,SAtomTable::getSingleton().FindAtom(strSkinName,strSkinName.GetLength())};
+    return GetSkin(key);
+}
+
+ISkinObj* SSkinPoolMgr::GetSkin(const SkinKey & key)
 {
     SPOSITION pos=m_lstSkinPools.GetTailPosition();
     while(pos)
     {
         SSkinPool *pSkinPool=m_lstSkinPools.GetPrev(pos);
-        if(ISkinObj* pSkin=pSkinPool->GetSkin(strSkinName,nScale))
+        if(ISkinObj* pSkin=pSkinPool->GetSkin(key))
         {
             return pSkin;
         }
     }
+    const SStringW & strSkinName = key.strName;
 
     if(wcscmp(strSkinName,L"")!=0)
     {
@@ -176,44 +232,11 @@ ISkinObj* SSkinPoolMgr::GetSkin( const SStringW & strSkinName, int nScale)
     return NULL;
 }
 
-const wchar_t * BUILDIN_SKIN_NAMES[]=
-{
-    L"_skin.sys.checkbox",
-    L"_skin.sys.radio",
-    L"_skin.sys.focuscheckbox",
-    L"_skin.sys.focusradio",
-    L"_skin.sys.btn.normal",
-    L"_skin.sys.scrollbar",
-    L"_skin.sys.border",
-    L"_skin.sys.dropbtn",
-    L"_skin.sys.tree.toggle",
-    L"_skin.sys.tree.checkbox",
-    L"_skin.sys.tab.page",
-    L"_skin.sys.header",
-    L"_skin.sys.split.vert",
-    L"_skin.sys.split.horz",
-    L"_skin.sys.prog.bkgnd",
-    L"_skin.sys.prog.bar",
-    L"_skin.sys.vert.prog.bkgnd",
-    L"_skin.sys.vert.prog.bar",
-    L"_skin.sys.slider.thumb",
-    L"_skin.sys.btn.close",
-    L"_skin.sys.btn.minimize",
-    L"_skin.sys.btn.maxmize",
-    L"_skin.sys.btn.restore",
-    L"_skin.sys.menu.check",
-    L"_skin.sys.menu.sep",
-    L"_skin.sys.menu.arrow",
-    L"_skin.sys.menu.border",
-    L"_skin.sys.menu.skin",
-    L"_skin.sys.icons",
-    L"_skin.sys.wnd.bkgnd"
-};
-
-
 ISkinObj * SSkinPoolMgr::GetBuiltinSkin( SYS_SKIN uID ,int nScale)
 {
-    return GetBuiltinSkinPool()->GetSkin(BUILDIN_SKIN_NAMES[uID], nScale);
+    SkinKey key = m_builtinSkinKeys[uID];
+    key.scale = nScale;
+    return GetBuiltinSkinPool()->GetSkin(key);
 }
 
 void SSkinPoolMgr::PushSkinPool( SSkinPool *pSkinPool )
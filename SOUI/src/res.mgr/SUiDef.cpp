@@ -2,6 +2,7 @@
 #include "res.mgr\SUiDef.h"
 #include "helper\SplitString.h"
 #include "helper\mybuffer.h"
+#include "SApp.h"
 
 namespace SOUI{
 
@@ -153,8 +154,17 @@ namespace SOUI{
 						pugi::xml_node     nodeData = GetSourceXmlNode(root,docData,pResProvider,KNodeSkin);
 						if(nodeData)
 						{
+							//皮肤引用的图片先提交到工作线程加载，LoadSkins创建皮肤时直接使用加载结果
+							SResPreloader & preloader = SApplication::getSingleton().GetResPreloader();
+							preloader.PreloadSkinImages(pResProvider,nodeData);
 							pSkinPool.Attach(new SSkinPool);
 							pSkinPool->LoadSkins(nodeData);
+							preloader.Discard(pResProvider);
+
+							SResPreloadStats stats;
+							preloader.GetStats(stats);
+							SLOGFMTI(_T("skin images preloaded (total): skins %uus, submitted %d, skipped %d, inline %d, waited %d for %uus, worker load %uus"),
+								stats.dwSkinTime,stats.nSubmitted,stats.nSkipped,stats.nInline,stats.nWaited,stats.dwWaitTime,stats.dwDecodeTime);
 							SSkinPoolMgr::getSingletonPtr()->PushSkinPool(pSkinPool);
 
 						}
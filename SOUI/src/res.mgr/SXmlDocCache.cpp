@@ -0,0 +1,112 @@
+﻿#include "souistd.h"
+#include "res.mgr/SXmlDocCache.h"
+
+namespace SOUI
+{
+    //解析后的文档保存为wchar_t并且增加了节点结构，内存按原始数据的4倍估计
+    static const size_t KDocMemRatio = 4;
+
+    SXmlDocCache::SXmlDocCache()
+        :m_szMax(4*1024*1024)
+        ,m_dwGeneration(0)
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+    }
+
+    SXmlDocCache::~SXmlDocCache()
+    {
+        RemoveAll();
+    }
+
+    SXmlDocKey SXmlDocCache::MakeKey(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName)
+    {
+        SXmlDocKey key = {pResProvider,pszType?pszType:_T(""),pszName?pszName:_T("")};
+        return key;
+    }
+
+    SCachedXmlDoc * SXmlDocCache::Lookup(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName)
+    {
+        SXmlDocKey key = MakeKey(pResProvider,pszType,pszName);
+        SAutoLock lock(m_cs);
+        SMap<SXmlDocKey,SPOSITION>::CPair *p = m_mapKey.IsEmpty()?NULL:m_mapKey.Lookup(key);
+        if(!p)
+        {
+            m_stats.nMisses++;
+            return NULL;
+        }
+        m_stats.nHits++;
+        m_lstLru.MoveToHead(p->m_value);
+        SCachedXmlDoc *pDoc = m_lstLru.GetAt(p->m_value)->pDoc;
+        pDoc->AddRef();
+        return pDoc;
+    }
+
+    void SXmlDocCache::Add(IResProvider *pResProvider,LPCTSTR pszType,LPCTSTR pszName,SCachedXmlDoc *pDoc,size_t szRaw,DWORD dwGeneration)
+    {
+        SXmlDocKey key = MakeKey(pResProvider,pszType,pszName);
+        size_t szMem = szRaw*KDocMemRatio;
+
+        SAutoLock lock(m_cs);
+        if(dwGeneration != m_dwGeneration) return;//加载过程中资源包列表已经改变
+        if(szMem > m_szMax) return;
+        if(m_mapKey.Lookup(key)) return;//其它线程已经加入
+
+        _Trim(m_szMax - szMem);
+
+        CACHEENTRY *pEntry = new CACHEENTRY;
+        pEntry->pResProvider = pResProvider;
+        pEntry->strType = key.pszType;
+        pEntry->strName = key.pszName;
+        pEntry->pDoc = pDoc;
+        pEntry->szMem = szMem;
+        pDoc->AddRef();
+        m_mapKey[pEntry->GetKey()] = m_lstLru.AddHead(pEntry);
+        m_stats.nDocs++;
+        m_stats.szBytes += szMem;
+    }
+
+    void SXmlDocCache::_Trim(size_t szMax)
+    {
+        while(m_stats.szBytes > szMax && !m_lstLru.IsEmpty())
+        {
+            CACHEENTRY *pEntry = m_lstLru.RemoveTail();
+            m_mapKey.RemoveKey(pEntry->GetKey());
+            m_stats.szBytes -= pEntry->szMem;
+            m_stats.nDocs--;
+            m_stats.nEvicted++;
+            pEntry->pDoc->Release();
+            delete pEntry;
+        }
+    }
+
+    void SXmlDocCache::RemoveAll()
+    {
+        SAutoLock lock(m_cs);
+        SPOSITION pos = m_lstLru.GetHeadPosition();
+        while(pos)
+        {
+            CACHEENTRY *pEntry = m_lstLru.GetNext(pos);
+            pEntry->pDoc->Release();
+            delete pEntry;
+        }
+        m_lstLru.RemoveAll();
+        m_mapKey.RemoveAll();
+        m_stats.nDocs = 0;
+        m_stats.szBytes = 0;
+        m_dwGeneration++;
+    }
+
+    void SXmlDocCache::SetMaxSize(size_t szMax)
+    {
+        SAutoLock lock(m_cs);
+        m_szMax = szMax;
+        _Trim(m_szMax);
+    }
+
+    void SXmlDocCache::GetStats(SXmlDocCacheStats & stats)
+    {
+        SAutoLock lock(m_cs);
+        stats = m_stats;
+    }
+
+}//namespace SOUI
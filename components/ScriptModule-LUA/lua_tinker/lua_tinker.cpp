@@ -9,6 +9,7 @@
 #include <iostream>
 #include <lua.hpp>
 #include "lua_tinker.h"
+#include <string/strcpcvt.h>
 
 
 /*---------------------------------------------------------------------------*/ 
@@ -300,6 +301,107 @@ void lua_tinker::enum_stack(lua_State *L)
 	}
 }
  
+/*---------------------------------------------------------------------------*/ 
+/* utf8 -> utf16                                                             */ 
+/*---------------------------------------------------------------------------*/ 
+// registry keys of the conversion cache. each table maps a utf8 string to its utf16 string,
+// [1] holds the entry count. when the current table is full it becomes the old one.
+static char s_wstr_cache_cur;
+static char s_wstr_cache_old;
+// registry key of the last string returned by read<const wchar_t*> with a negative index.
+// the cache alone would drop it after two rotations, which the caller can not see coming
+static char s_wstr_popped;
+static const int WSTR_CACHE_SIZE = 256;
+
+static void push_utf8_as_wstring(lua_State *L, const char* str, size_t len)
+{
+	// utf16 never needs more units than utf8 bytes, so the result is transcoded once, straight into the lua buffer.
+	// SStrCpCvt is shared with the rest of soui, so invalid sequences become U+FFFD the same way everywhere
+	luaL_Buffer b;
+	wchar_t *p = (wchar_t*)luaL_buffinitsize(L, &b, (len+1)*sizeof(wchar_t));
+	size_t i = 0;
+	while(i < len && (unsigned char)str[i] < 0x80)
+	{
+		p[i] = str[i];
+		i++;
+	}
+	int n = (int)i;
+	if(i < len)
+		n += SOUI::SStrCpCvt::Utf8ToUtf16(str+i, (int)(len-i), p+i, (int)(len-i));
+	p[n] = 0;
+	luaL_pushresultsize(&b, (n+1)*sizeof(wchar_t));
+}
+
+const wchar_t* lua_tinker::push_wstring(lua_State *L, int index)
+{
+	index = lua_absindex(L, index);
+	size_t len = 0;
+	const char* str = lua_tolstring(L, index, &len);
+	if(!str)
+	{
+		lua_pushnil(L);
+		return NULL;
+	}
+
+	lua_rawgetp(L, LUA_REGISTRYINDEX, &s_wstr_cache_cur);
+	if(!lua_istable(L, -1))
+	{
+		lua_pop(L, 1);
+		lua_createtable(L, 0, WSTR_CACHE_SIZE);
+		lua_pushvalue(L, -1);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, &s_wstr_cache_cur);
+	}
+	int cache = lua_gettop(L);
+
+	lua_pushvalue(L, index);
+	lua_rawget(L, cache);
+	if(lua_type(L, -1) == LUA_TSTRING)
+	{
+		lua_remove(L, cache);
+		return (const wchar_t*)lua_tostring(L, -1);
+	}
+	lua_pop(L, 1);
+
+	lua_rawgetp(L, LUA_REGISTRYINDEX, &s_wstr_cache_old);
+	if(lua_istable(L, -1))
+	{
+		lua_pushvalue(L, index);
+		lua_rawget(L, -2);
+	}
+	else
+	{
+		lua_pushnil(L);
+	}
+	if(lua_type(L, -1) != LUA_TSTRING)
+	{
+		lua_pop(L, 1);
+		push_utf8_as_wstring(L, str, len);
+	}
+	lua_remove(L, -2);
+
+	lua_rawgeti(L, cache, 1);
+	int count = (int)lua_tointeger(L, -1);
+	lua_pop(L, 1);
+	if(count >= WSTR_CACHE_SIZE)
+	{
+		lua_pushvalue(L, cache);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, &s_wstr_cache_old);
+		lua_createtable(L, 0, WSTR_CACHE_SIZE);
+		lua_pushvalue(L, -1);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, &s_wstr_cache_cur);
+		lua_replace(L, cache);
+		count = 0;
+	}
+	lua_pushvalue(L, index);
+	lua_pushvalue(L, -2);
+	lua_rawset(L, cache);
+	lua_pushinteger(L, count+1);
+	lua_rawseti(L, cache, 1);
+
+	lua_remove(L, cache);
+	return (const wchar_t*)lua_tostring(L, -1);
+}
+
 /*---------------------------------------------------------------------------*/ 
 /* read                                                                      */ 
 /*---------------------------------------------------------------------------*/ 
@@ -315,6 +417,27 @@ const char* lua_tinker::read(lua_State *L, int index)
 	return (const char*)lua_tostring(L, index);		
 }
 
+template<>
+const wchar_t* lua_tinker::read(lua_State *L, int index)
+{
+	// lua strings are taken as utf8. the converted string is left on the stack so it lives until the call returns,
+	// for pop() it replaces the original value instead and is pinned in the registry until the next such read
+	int type = lua_type(L, index);
+	if(type == LUA_TSTRING || type == LUA_TNUMBER)
+	{
+		int abs_index = lua_absindex(L, index);
+		const wchar_t* ret = push_wstring(L, abs_index);
+		if(index < 0)
+		{
+			lua_pushvalue(L, -1);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, &s_wstr_popped);
+			lua_replace(L, abs_index);
+		}
+		return ret;
+	}
+	return lua2object<const wchar_t*>::invoke(L, index);
+}
+
 template<>
 char lua_tinker::read(lua_State *L, int index)
 {
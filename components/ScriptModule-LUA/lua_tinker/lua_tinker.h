@@ -29,6 +29,10 @@ namespace lua_tinker
 	void	dostring(lua_State *L, const char* buff);
 	void	dobuffer(lua_State *L, const char* buff, size_t sz);
 
+	// utf8 -> utf16
+	// pushes the utf16 form of the string at index and returns it. conversions are cached per lua_State
+	const wchar_t*	push_wstring(lua_State *L, int index);
+
 	// debug helpers
 	void	enum_stack(lua_State *L);
 	int		on_error(lua_State *L);
@@ -250,6 +254,10 @@ namespace lua_tinker
 
 	template<>	char*				read(lua_State *L, int index);
 	template<>	const char*			read(lua_State *L, int index);
+	// lua strings are taken as utf8. with a positive index the utf16 copy is pushed and lives until the call returns.
+	// with a negative index (pop, call) it replaces the value, so once popped only the registry keeps it:
+	// the pointer stays valid until the next negative-index read of a string, copy it before reading another one
+	template<>	const wchar_t*		read(lua_State *L, int index);
 	template<>	char				read(lua_State *L, int index);
 	template<>	unsigned char		read(lua_State *L, int index);
 	template<>	short				read(lua_State *L, int index);
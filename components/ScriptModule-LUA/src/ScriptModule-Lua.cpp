@@ -6,6 +6,7 @@
 #include "ScriptModule-Lua.h"
 #include "../lua_tinker/lua_tinker.h"
 #include <string/strcpcvt.h>
+#include <helper/SCriticalSection.h>
 
 extern BOOL SOUI_Export_Lua(lua_State *L);
 
@@ -19,11 +20,9 @@ namespace SOUI
 
     int Utf8ToW(lua_State* L)
     {
-        size_t n = 0;
-        char* str = (char*)luaL_checklstring(L, -1, &n);
-        if(!str)   return 0;
-        SStringW strW=S_CA2W(str,CP_UTF8);
-        lua_pushlstring(L, (const char*)(LPCWSTR)strW, 2*strW.GetLength()+2);
+        luaL_checklstring(L, -1, NULL);
+        //转换结果缓存在lua_State中，相同的字符串不再重复转换
+        lua_tinker::push_wstring(L, -1);
         return 1;
     }
 
@@ -35,31 +34,36 @@ namespace SOUI
 
     int Utf8ToT(lua_State *L)
     {
+#ifdef _UNICODE
+        return Utf8ToW(L);
+#else
         size_t n = 0;
         char* str = (char*)luaL_checklstring(L, -1, &n);
         if(!str)   return 0;
         SStringT strT=S_CA2T(str,CP_UTF8);
         lua_pushlstring(L, (const char*)(LPCTSTR)strT, (strT.GetLength()+1)*sizeof(TCHAR));
         return 1;
+#endif
     }
 
     class LuaFunctionSlot : public ISlotFunctor
     {
     public:
         //! Slot function type.
-        LuaFunctionSlot(lua_State *pLuaState,LPCSTR pszLuaFun) 
-            : m_pLuaState(pLuaState)
+        LuaFunctionSlot(SScriptModule_Lua *pModule,LPCSTR pszLuaFun) 
+            : m_pModule(pModule)
             , m_luaFun(pszLuaFun)
+            , m_pHandler(pModule->GetHandler(pszLuaFun))
         {}
 
         virtual bool operator()(EventArgs *pArg)
         {
-            return lua_tinker::call<bool>(m_pLuaState,m_luaFun,pArg);
+            return m_pModule->CallHandler(m_pHandler,m_luaFun,pArg);
         }
 
         virtual ISlotFunctor* Clone() const 
         {
-            return new LuaFunctionSlot(m_pLuaState,m_luaFun);
+            return new LuaFunctionSlot(m_pModule,m_luaFun);
         }
 
         virtual bool Equal(const ISlotFunctor & sour)const 
@@ -67,19 +71,141 @@ namespace SOUI
             if(sour.GetSlotType()!=GetSlotType()) return false;
             const LuaFunctionSlot *psour=static_cast<const LuaFunctionSlot*>(&sour);
             SASSERT(psour);
-            return psour->m_luaFun==m_luaFun && psour->m_pLuaState==m_pLuaState;
+            return psour->m_luaFun==m_luaFun && psour->m_pModule==m_pModule;
         }
 
         virtual UINT GetSlotType() const {return SLOT_USER+1;}
 
     private:
         SStringA m_luaFun;
-        lua_State *m_pLuaState;
+        SScriptModule_Lua *m_pModule;
+        SScriptModule_Lua::LUAHANDLER *m_pHandler;
+    };
+
+    /**
+    * @class      SLuaChunkCache
+    * @brief      预编译代码缓存
+    *
+    * Describe    所有脚本模块共享，每个宿主窗口有自己的脚本模块，重复打开的窗口执行相同的脚本时不需要再次编译。
+    *             以脚本内容的hash为key，命中时再比较脚本内容和代码块名称，缓存超过内存限制后不再增加。
+    *             编译后的代码中包含代码块名称(出错信息中的文件名)，名称不同时不能共用。
+    */
+    class SLuaChunkCache
+    {
+    public:
+        struct LUACHUNK
+        {
+            char *  pData;      //编译后的代码
+            size_t  szData;
+            char *  pSource;    //脚本内容，用来排除hash冲突
+            size_t  szSource;
+            SStringA strName;   //代码块名称
+        };
+
+        SLuaChunkCache():m_szTotal(0){}
+
+        ~SLuaChunkCache()
+        {
+            SPOSITION pos = m_mapChunks.GetStartPosition();
+            while(pos)
+            {
+                LUACHUNK *pChunk = m_mapChunks.GetNextValue(pos);
+                free(pChunk->pData);
+                free(pChunk->pSource);
+                delete pChunk;
+            }
+        }
+
+        static ULONGLONG MakeKey(const char *buff,size_t sz)
+        {//FNV-1a
+            ULONGLONG ullHash = 14695981039346656037ULL;
+            for(size_t i=0;i<sz;i++)
+            {
+                ullHash ^= (BYTE)buff[i];
+                ullHash *= 1099511628211ULL;
+            }
+            return ullHash ^ sz;
+        }
+
+        //缓存中的代码不会被删除，返回的指针一直有效
+        const LUACHUNK * Lookup(ULONGLONG ullKey,const char *pSource,size_t szSource,LPCSTR pszName)
+        {
+            SAutoLock lock(m_cs);
+            SMap<ULONGLONG,LUACHUNK*>::CPair *p = m_mapChunks.Lookup(ullKey);
+            if(!p) return NULL;
+            LUACHUNK *pChunk = p->m_value;
+            if(pChunk->szSource != szSource || memcmp(pChunk->pSource,pSource,szSource) != 0) return NULL;
+            if(pChunk->strName != pszName) return NULL;
+            return pChunk;
+        }
+
+        //加入缓存，成功时接管pData，脚本内容复制一份保存
+        BOOL Add(ULONGLONG ullKey,char *pData,size_t szData,const char *pSource,size_t szSource,LPCSTR pszName)
+        {
+            SAutoLock lock(m_cs);
+            if(m_szTotal + szData + szSource > KMaxCacheSize) return FALSE;
+            if(m_mapChunks.Lookup(ullKey)) return FALSE;
+            char *pSourceCopy = (char*)malloc(szSource?szSource:1);
+            if(!pSourceCopy) return FALSE;
+            memcpy(pSourceCopy,pSource,szSource);
+            LUACHUNK *pChunk = new LUACHUNK;
+            pChunk->pData = pData;
+            pChunk->szData = szData;
+            pChunk->pSource = pSourceCopy;
+            pChunk->szSource = szSource;
+            pChunk->strName = pszName;
+            m_mapChunks[ullKey] = pChunk;
+            m_szTotal += szData + szSource;
+            return TRUE;
+        }
+
+    protected:
+        enum {KMaxCacheSize = 4*1024*1024};
+
+        SCriticalSection            m_cs;
+        SMap<ULONGLONG,LUACHUNK*>   m_mapChunks;
+        size_t                      m_szTotal;
     };
 
+    static SLuaChunkCache s_chunkCache;
+
+    //当前时间(us)，用于统计事件分发耗时
+    static ULONGLONG NowUs()
+    {
+        static LARGE_INTEGER s_freq = {0};
+        if(s_freq.QuadPart == 0) ::QueryPerformanceFrequency(&s_freq);
+        LARGE_INTEGER cnt;
+        ::QueryPerformanceCounter(&cnt);
+        return (ULONGLONG)(cnt.QuadPart/s_freq.QuadPart*1000000 + cnt.QuadPart%s_freq.QuadPart*1000000/s_freq.QuadPart);
+    }
+
+    struct CHUNKBUFFER
+    {
+        char *  pData;
+        size_t  szData;
+        size_t  szAlloc;
+    };
+
+    static int ChunkWriter(lua_State *L, const void *p, size_t sz, void *ud)
+    {
+        CHUNKBUFFER *pBuf = (CHUNKBUFFER*)ud;
+        if(pBuf->szData + sz > pBuf->szAlloc)
+        {
+            size_t szAlloc = max(pBuf->szAlloc*2,pBuf->szData + sz);
+            char *pData = (char*)realloc(pBuf->pData,szAlloc);
+            if(!pData) return 1;
+            pBuf->pData = pData;
+            pBuf->szAlloc = szAlloc;
+        }
+        memcpy(pBuf->pData+pBuf->szData,p,sz);
+        pBuf->szData += sz;
+        return 0;
+    }
+
 
-    SScriptModule_Lua::SScriptModule_Lua()
+    SScriptModule_Lua::SScriptModule_Lua():m_dwGeneration(0)
     {
+        memset(&m_stats,0,sizeof(m_stats));
         d_state = luaL_newstate();
         if(d_state)
         {
@@ -98,6 +224,11 @@ namespace SOUI
 
     SScriptModule_Lua::~SScriptModule_Lua()
     {
+        SPOSITION pos = m_mapHandlers.GetStartPosition();
+        while(pos)
+        {
+            delete m_mapHandlers.GetNextValue(pos);
+        }
         if (d_state)
         {
             lua_close( d_state );
@@ -112,19 +243,156 @@ namespace SOUI
 
     void SScriptModule_Lua::executeScriptFile( LPCSTR pszScriptFile )
     {
+        FILE *f = fopen(pszScriptFile,"rb");
+        if(f)
+        {
+            fseek(f,0,SEEK_END);
+            long nLen = ftell(f);
+            fseek(f,0,SEEK_SET);
+            char *buff = nLen>0?(char*)malloc(nLen):NULL;
+            if(buff && fread(buff,1,nLen,f) == (size_t)nLen)
+            {
+                fclose(f);
+                const char *p = buff;
+                size_t sz = nLen;
+                if(sz>=3 && memcmp(p,"\xEF\xBB\xBF",3)==0)
+                {//与luaL_loadfile一样跳过BOM
+                    p+=3;
+                    sz-=3;
+                }
+                if(sz==0 || p[0]!='#')
+                {
+                    SStringA strChunkName = SStringA("@") + pszScriptFile;
+                    RunChunk(p,sz,strChunkName);
+                    free(buff);
+                    return;
+                }
+            }else
+            {
+                fclose(f);
+            }
+            if(buff) free(buff);
+        }
+        //文件不能读取或者以#开头，由luaL_loadfile处理
         lua_tinker::dofile(d_state,pszScriptFile);
+        m_dwGeneration++;
     }
 
 
     void SScriptModule_Lua::executeScriptBuffer( const char* buff, size_t sz )
     {
-        lua_tinker::dobuffer(d_state,buff,sz);
+        RunChunk(buff,sz,"lua_tinker::dobuffer()");
+    }
+
+    void SScriptModule_Lua::RunChunk(const char *buff,size_t sz,LPCSTR pszChunkName)
+    {
+        lua_pushcclosure(d_state, lua_tinker::on_error, 0);
+        int errfunc = lua_gettop(d_state);
+
+        int nRet = 0;
+        ULONGLONG ullKey = SLuaChunkCache::MakeKey(buff,sz);
+        const SLuaChunkCache::LUACHUNK *pChunk = s_chunkCache.Lookup(ullKey,buff,sz,pszChunkName);
+        if(pChunk)
+        {
+            nRet = luaL_loadbufferx(d_state,pChunk->pData,pChunk->szData,pszChunkName,"b");
+            m_stats.nChunkHits++;
+        }else
+        {
+            nRet = luaL_loadbuffer(d_state,buff,sz,pszChunkName);
+            m_stats.nChunkMisses++;
+            if(nRet == 0)
+            {
+                CHUNKBUFFER chunkBuf = {NULL,0,0};
+                if(lua_dump(d_state,ChunkWriter,&chunkBuf) != 0
+                    || !s_chunkCache.Add(ullKey,chunkBuf.pData,chunkBuf.szData,buff,sz,pszChunkName))
+                {
+                    if(chunkBuf.pData) free(chunkBuf.pData);
+                }
+            }
+        }
+
+        if(nRet == 0)
+        {
+            if(lua_pcall(d_state, 0, 0, errfunc) != 0)
+            {
+                lua_pop(d_state, 1);
+            }
+        }
+        else
+        {
+            lua_tinker::print_error(d_state, "%s", lua_tostring(d_state, -1));
+            lua_pop(d_state, 1);
+        }
+
+        lua_pop(d_state, 1);
+        m_dwGeneration++;
+    }
+
+    SScriptModule_Lua::LUAHANDLER * SScriptModule_Lua::GetHandler(LPCSTR pszName)
+    {
+        SMap<SStringA,LUAHANDLER*>::CPair *p = m_mapHandlers.Lookup(pszName);
+        if(p) return p->m_value;
+        LUAHANDLER *pHandler = new LUAHANDLER;
+        pHandler->nRef = LUA_NOREF;
+        pHandler->dwGeneration = m_dwGeneration - 1;//第一次调用时查找
+        m_mapHandlers[pszName] = pHandler;
+        return pHandler;
+    }
+
+    bool SScriptModule_Lua::CallHandler(LUAHANDLER *pHandler,LPCSTR pszName,EventArgs *pArg)
+    {
+        ULONGLONG ullStart = NowUs();
+        //没有找到的函数不缓存，其它事件处理函数执行时可能定义它，这不会改变脚本版本
+        if(pHandler->dwGeneration != m_dwGeneration || pHandler->nRef == LUA_NOREF)
+        {
+            if(pHandler->nRef != LUA_NOREF) luaL_unref(d_state, LUA_REGISTRYINDEX, pHandler->nRef);
+            lua_getglobal(d_state, pszName);
+            if(lua_isfunction(d_state, -1))
+            {
+                pHandler->nRef = luaL_ref(d_state, LUA_REGISTRYINDEX);
+            }else
+            {
+                lua_pop(d_state, 1);
+                pHandler->nRef = LUA_NOREF;
+            }
+            pHandler->dwGeneration = m_dwGeneration;
+            m_stats.nResolves++;
+        }
+
+        //与lua_tinker::call相同，只是用注册表引用代替按名称查找全局变量
+        lua_pushcclosure(d_state, lua_tinker::on_error, 0);
+        int errfunc = lua_gettop(d_state);
+        if(pHandler->nRef != LUA_NOREF)
+        {
+            lua_rawgeti(d_state, LUA_REGISTRYINDEX, pHandler->nRef);
+            lua_tinker::push(d_state, pArg);
+            if(lua_pcall(d_state, 1, 1, errfunc) != 0)
+            {
+                lua_pop(d_state, 1);
+                lua_pushnil(d_state);
+            }
+        }
+        else
+        {
+            lua_tinker::print_error(d_state, "lua_tinker::call() attempt to call global `%s' (not a function)", pszName);
+            lua_pushnil(d_state);
+        }
+        lua_remove(d_state, -2);
+        bool bRet = lua_tinker::pop<bool>(d_state);
+
+        m_stats.nDispatches++;
+        m_stats.ullDispatchTime += NowUs() - ullStart;
+        return bRet;
+    }
+
+    void SScriptModule_Lua::ResetStats()
+    {
+        memset(&m_stats,0,sizeof(m_stats));
     }
 
     bool SScriptModule_Lua::executeScriptedEventHandler( LPCSTR handler_name, EventArgs *pArg)
     {
-        LuaFunctionSlot luaFunSlot(d_state,handler_name);
-        bool bRet =  luaFunSlot(pArg);
+        bool bRet = CallHandler(GetHandler(handler_name),handler_name,pArg);
 		if(bRet) pArg->handled++;
 		return bRet;
     }
@@ -132,16 +400,17 @@ namespace SOUI
     void SScriptModule_Lua::executeString( LPCSTR str )
     {
         lua_tinker::dostring(d_state,str);
+        m_dwGeneration++;
     }
 
     bool SScriptModule_Lua::subscribeEvent(SWindow* target, UINT uEvent, LPCSTR subscriber_name )
     {
-        return target->GetEventSet()->subscribeEvent(uEvent,LuaFunctionSlot(d_state,subscriber_name));
+        return target->GetEventSet()->subscribeEvent(uEvent,LuaFunctionSlot(this,subscriber_name));
     }
 
     bool SScriptModule_Lua::unsubscribeEvent(SWindow* target, UINT uEvent, LPCSTR subscriber_name )
     {
-        return target->GetEventSet()->unsubscribeEvent(uEvent,LuaFunctionSlot(d_state,subscriber_name));
+        return target->GetEventSet()->unsubscribeEvent(uEvent,LuaFunctionSlot(this,subscriber_name));
     }
 
 
@@ -11,8 +11,22 @@ extern "C"
 
 namespace SOUI
 {
+    /**
+    * @struct     SLuaScriptStats
+    * @brief      脚本模块的统计数据，时间单位为微秒
+    */
+    struct SLuaScriptStats
+    {
+        LONG        nDispatches;        /**<事件处理函数的调用次数*/
+        LONG        nResolves;          /**<从全局表查找事件处理函数的次数*/
+        ULONGLONG   ullDispatchTime;    /**<事件处理函数的总执行时间*/
+        LONG        nChunkHits;         /**<执行脚本时使用预编译代码的次数*/
+        LONG        nChunkMisses;       /**<执行脚本时需要编译的次数*/
+    };
+
     class SScriptModule_Lua : public TObjRefImpl<IScriptModule>
     {
+        friend class LuaFunctionSlot;
     public:
         SScriptModule_Lua(void);
 
@@ -30,8 +44,37 @@ namespace SOUI
 
         virtual bool subscribeEvent(SWindow* target, UINT uEvent, LPCSTR subscriber_name);
         virtual bool unsubscribeEvent(SWindow* target, UINT uEvent, LPCSTR subscriber_name );
+
+        const SLuaScriptStats & GetStats() const {return m_stats;}
+
+        void ResetStats();
+
     protected:
+        /**
+        * @struct     LUAHANDLER
+        * @brief      事件处理函数
+        *
+        * Describe    第一次调用时从全局表查找并保存为注册表引用，之后直接通过引用调用。
+        *             执行新的脚本后，或者上次没有找到函数时，在下一次调用时重新查找。
+        */
+        struct LUAHANDLER
+        {
+            int     nRef;           /**<LUA_REGISTRYINDEX中的引用，LUA_NOREF表示全局变量不是函数*/
+            DWORD   dwGeneration;   /**<查找时的脚本版本*/
+        };
+
+        //获取事件处理函数，返回的指针在脚本模块销毁前一直有效
+        LUAHANDLER * GetHandler(LPCSTR pszName);
+
+        bool CallHandler(LUAHANDLER *pHandler,LPCSTR pszName,EventArgs *pArg);
+
+        //编译并执行脚本，相同内容的脚本使用缓存的预编译代码
+        void RunChunk(const char *buff,size_t sz,LPCSTR pszChunkName);
+
         lua_State * d_state;
+        SMap<SStringA,LUAHANDLER*>  m_mapHandlers;
+        DWORD                       m_dwGeneration;     /**<脚本版本，每次执行脚本后增加*/
+        SLuaScriptStats             m_stats;
     };
 
     class SIScriptFactory: public TObjRefImpl<IScriptFactory>
@@ -6,6 +6,7 @@
 #include <gdialpha.h>
 #include <math.h>
 #include <trace.h>
+#include <profiler.h>
 #include <tchar.h>
 #include <algorithm>
 
@@ -530,6 +531,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_GDI::DrawText( LPCTSTR pszText,int cchLen,LPRECT pRc,UINT uFormat)
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawText");
         if(uFormat & DT_CALCRECT)
         {
             int nRet = ::DrawText(m_hdc,pszText,cchLen,pRc,uFormat);
@@ -674,6 +676,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_GDI::DrawBitmap(LPCRECT pRcDest,IBitmap *pBitmap,int xSrc,int ySrc,BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmap");
         SBitmap_GDI *pBmp = (SBitmap_GDI*)pBitmap;
         HBITMAP bmp=pBmp->GetBitmap();
         HDC hmemdc=CreateCompatibleDC(m_hdc);
@@ -703,6 +706,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_GDI::DrawBitmapEx( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmapEx");
         UINT expandModeLow = LOWORD(expendMode);
         
         if(expandModeLow == EM_NULL)
@@ -743,6 +747,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_GDI::DrawBitmap9Patch( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmap9Patch");
         int xDest[4] = {pRcDest->left,pRcDest->left+pRcSourMargin->left,pRcDest->right-pRcSourMargin->right,pRcDest->right};
         int xSrc[4] = {pRcSrc->left,pRcSrc->left+pRcSourMargin->left,pRcSrc->right-pRcSourMargin->right,pRcSrc->right};
         int yDest[4] = {pRcDest->top,pRcDest->top+pRcSourMargin->top,pRcDest->bottom-pRcSourMargin->bottom,pRcDest->bottom};
@@ -12,6 +12,7 @@
 #include "render-skia.h"
 #include "Render-Skia2.h"
 #include "trace.h"
+#include "profiler.h"
 
 #include "skia2rop2.h"
 #include "PathEffect-Skia.h"
@@ -367,6 +368,7 @@ namespace SOUI
 
 	HRESULT SRenderTarget_Skia::DrawText( LPCTSTR pszText,int cchLen,LPRECT pRc,UINT uFormat)
 	{
+		SPROFILE_SCOPE("IRenderTarget::DrawText");
 		if(cchLen<0) cchLen= _tcslen(pszText);
 		if(cchLen==0)
         {
@@ -604,6 +606,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawBitmap(LPCRECT pRcDest,IBitmap *pBitmap,int xSrc,int ySrc,BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmap");
         SBitmap_Skia *pBmp = (SBitmap_Skia*)pBitmap;
         SkBitmap bmp=pBmp->GetSkBitmap();
 
@@ -640,6 +643,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawBitmapEx( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,UINT expendMode, BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmapEx");
         UINT expendModeLow = LOWORD(expendMode);
 
         if(expendModeLow == EM_NULL || (RectWid(pRcDest)==RectWid(pRcSrc) && RectHei(pRcDest)==RectHei(pRcSrc)))
@@ -689,6 +693,7 @@ namespace SOUI
 
     HRESULT SRenderTarget_Skia::DrawBitmap9Patch( LPCRECT pRcDest,IBitmap *pBitmap,LPCRECT pRcSrc,LPCRECT pRcSourMargin,UINT expendMode,BYTE byAlpha/*=0xFF*/ )
     {
+        SPROFILE_SCOPE("IRenderTarget::DrawBitmap9Patch");
         int xDest[4] = {pRcDest->left,pRcDest->left+pRcSourMargin->left,pRcDest->right-pRcSourMargin->right,pRcDest->right};
         int xSrc[4] = {pRcSrc->left,pRcSrc->left+pRcSourMargin->left,pRcSrc->right-pRcSourMargin->right,pRcSrc->right};
         int yDest[4] = {pRcDest->top,pRcDest->top+pRcSourMargin->top,pRcDest->bottom-pRcSourMargin->bottom,pRcDest->bottom};
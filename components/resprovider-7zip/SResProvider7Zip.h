@@ -31,6 +31,7 @@ public:
     virtual IImgX   * LoadImgX(LPCTSTR strType,LPCTSTR pszResName);
     virtual size_t GetRawBufferSize(LPCTSTR strType,LPCTSTR pszResName);
     virtual BOOL GetRawBuffer(LPCTSTR strType,LPCTSTR pszResName,LPVOID pBuf,size_t size);
+    virtual BOOL EnumResource(FunEnumResCallback funEnumCB,LPARAM lp);
 
 protected:
     BOOL _Init(LPCTSTR pszZipFile ,LPCSTR pszPsw);
@@ -170,6 +170,17 @@ namespace SOUI{
 		return p!=NULL;
 	}
 
+	BOOL SResProviderZip::EnumResource( FunEnumResCallback funEnumCB,LPARAM lp )
+	{
+		SPOSITION pos = m_mapFiles.GetStartPosition();
+		while(pos)
+		{
+			const SResID & resID = m_mapFiles.GetNext(pos)->m_key;
+			if(!funEnumCB(resID.szType,resID.szName,lp)) break;
+		}
+		return TRUE;
+	}
+
 	BOOL SResProviderZip::_LoadSkin()
 	{
 		CZipFile zf;
@@ -10,83 +10,74 @@ using namespace pugi;
 
 namespace SOUI
 {
-    int StringCmp(const SStringW &str1,const SStringW &str2)
-    {
-        if(str1 == str2) return 0;
-        else return str1<str2?-1:1;
-    }
-
-    class SStrMap
-    {
-        friend class STranslatorMgr;
-    public:
-        SStringW strSource;
-        SStringW strTranslation;
-
-        static int  Compare(const void * e1, const void * e2);
-        static int  CompareInSearch(const void * e1, const void * e2);
-    };
-
-    class SStrMapEntry
-    {
-        friend class STranslatorMgr;
-    public:
-        ~SStrMapEntry();
-        SStringW strCtx;
-        SArray<SStrMap*> m_arrStrMap;
-        static int  Compare(const void * e1, const void * e2);
-        static int  CompareInSearch(const void * e1, const void * e2);
-    };
+    static const ULONGLONG KFnvOffset = 14695981039346656037ULL;
+    static const ULONGLONG KFnvPrime = 1099511628211ULL;
 
-
-    int SStrMap::Compare( const void * e1, const void * e2)
+    static ULONGLONG HashString(LPCWSTR psz,int nLen,ULONGLONG ullHash)
     {
-        SStrMap **p1=(SStrMap**) e1;
-        SStrMap **p2=(SStrMap**) e2;
-        return StringCmp((*p1)->strSource,(*p2)->strSource);
+        for(int i=0;i<nLen;i++)
+        {
+            ullHash ^= (WORD)psz[i];
+            ullHash *= KFnvPrime;
+        }
+        return ullHash;
     }
 
-    int SStrMap::CompareInSearch( const void * e1, const void * e2 )
+    //上下文与原字符串之间加入一个不是合法字符的分隔符
+    static ULONGLONG HashKey(LPCWSTR pszCtx,int nCtxLen,LPCWSTR pszSrc,int nSrcLen)
     {
-        SStringW * pKey=(SStringW *)e1;
-        SStrMap **p2=(SStrMap**) e2;
-        return StringCmp(*pKey,(*p2)->strSource);     
+        ULONGLONG ullHash = HashString(pszCtx,nCtxLen,KFnvOffset);
+        ullHash ^= 0xFFFF;
+        ullHash *= KFnvPrime;
+        return HashString(pszSrc,nSrcLen,ullHash);
     }
 
-
-    int SStrMapEntry::Compare( const void * e1, const void * e2 )
+    struct BUILDENTRY
     {
-        SStrMapEntry **p1=(SStrMapEntry**) e1;
-        SStrMapEntry **p2=(SStrMapEntry**) e2;
-        return StringCmp((*p1)->strCtx,(*p2)->strCtx);
-    }
-    
-    int SStrMapEntry::CompareInSearch( const void * e1, const void * e2 )
+        LANGPACKENTRY   entry;      /**<字符串偏移为字符串区中的字符数*/
+        DWORD           nOrder;     /**<在XML中的顺序*/
+    };
+
+    static int CompareBuildEntry(const void * e1, const void * e2)
     {
-        SStringW *pKey=(SStringW*) e1;
-        SStrMapEntry **p2=(SStrMapEntry**) e2;
-        return StringCmp(*pKey,(*p2)->strCtx);
+        const BUILDENTRY *p1 = (const BUILDENTRY*)e1;
+        const BUILDENTRY *p2 = (const BUILDENTRY*)e2;
+        if(p1->entry.ullHash != p2->entry.ullHash) return p1->entry.ullHash<p2->entry.ullHash?-1:1;
+        //哈希值相同时保持XML中的顺序，重复的翻译使用第一条
+        return p1->nOrder<p2->nOrder?-1:1;
     }
 
-    SStrMapEntry::~SStrMapEntry()
+    //相同的字符串只保存一次，返回字符串在字符串区中的偏移（字符数）
+    static DWORD AddString(SArray<WCHAR> & arrStr,SMap<SStringW,DWORD> & mapStr,LPCWSTR pszStr,DWORD cchStr)
     {
-        for(UINT i=0;i<m_arrStrMap.GetCount();i++)
-            delete m_arrStrMap.GetAt(i);
+        SStringW strKey(pszStr,cchStr);
+        const SMap<SStringW,DWORD>::CPair *p = mapStr.Lookup(strKey);
+        if(p) return p->m_value;
+        DWORD offStr = (DWORD)arrStr.GetCount();
+        arrStr.SetCount(offStr+cchStr+1);
+        memcpy(arrStr.GetData()+offStr,pszStr,cchStr*sizeof(WCHAR));
+        arrStr[offStr+cchStr] = 0;
+        mapStr[strKey] = offStr;
+        return offStr;
     }
 
 
     //////////////////////////////////////////////////////////////////////////
     // SLang
     STranslator::STranslator()
+        :m_pData(NULL)
+        ,m_dwSize(0)
+        ,m_pEntries(NULL)
+        ,m_nEntries(0)
+        ,m_hFile(INVALID_HANDLE_VALUE)
+        ,m_hMapping(NULL)
     {
-        m_arrEntry = new SArray<SStrMapEntry*>;
+        memset(&m_guid,0,sizeof(m_guid));
     }
 
     STranslator::~STranslator()
     {
-        for(UINT i=0;i<m_arrEntry->GetCount();i++)
-            delete m_arrEntry->GetAt(i);
-        delete m_arrEntry;
+        Free();
     }
 
     SStringW STranslator::name()
@@ -105,78 +96,212 @@ namespace SOUI
         {
         case LD_XML:
             return LoadFromXml((*(pugi::xml_node*)pData));
+        case LD_COMPILEDFILE:
+            return LoadFromFile((LPCWSTR)pData);
+        case LD_COMPILEDDATA:
+            return LoadFromData((const BYTE*)pData);
         }
         return FALSE;
     }
-    
-    BOOL STranslator::LoadFromXml( pugi::xml_node xmlLang )
+
+    void STranslator::Compile( pugi::xml_node xmlLang,SArray<BYTE> & arrData )
     {
-        m_strLang=xmlLang.attribute(L"name").value();
-        
-        OLECHAR szIID[100] = { 0 };
-        wcscpy(szIID,xmlLang.attribute(L"guid").value());
+        SArray<WCHAR> arrStr;
+        SMap<SStringW,DWORD> mapStr;
+        SArray<BUILDENTRY> arrEntry;
 
-        IIDFromString(szIID,&m_guid);
-        
-        int ctxCount=0;
-        xml_node nodeCtx=xmlLang.child(L"context");
-        while(nodeCtx)
-        {
-            ctxCount++;
-            nodeCtx=nodeCtx.next_sibling(L"context");
-        }
-        m_arrEntry->SetCount(ctxCount);
-        nodeCtx=xmlLang.child(L"context");
-        for(int i=0;i<ctxCount;i++)
+        LPCWSTR pszName = xmlLang.attribute(L"name").value();
+        DWORD cchName = (DWORD)wcslen(pszName);
+        DWORD offName = AddString(arrStr,mapStr,pszName,cchName);
+
+        for(xml_node nodeCtx=xmlLang.child(L"context");nodeCtx;nodeCtx=nodeCtx.next_sibling(L"context"))
         {
-            SASSERT(nodeCtx);
-            int strCount=0;
-            xml_node nodeStr=nodeCtx.child(L"message");
-            while(nodeStr)
+            LPCWSTR pszCtx = nodeCtx.attribute(L"name").value();
+            DWORD cchCtx = (DWORD)wcslen(pszCtx);
+            DWORD offCtx = AddString(arrStr,mapStr,pszCtx,cchCtx);
+            for(xml_node nodeStr=nodeCtx.child(L"message");nodeStr;nodeStr=nodeStr.next_sibling(L"message"))
             {
-                strCount++;
-                nodeStr=nodeStr.next_sibling(L"message");
+                LPCWSTR pszSrc = nodeStr.child(L"source").text().get();
+                LPCWSTR pszTrans = nodeStr.child(L"translation").text().get();
+                BUILDENTRY be;
+                be.entry.offCtx = offCtx;
+                be.entry.cchCtx = cchCtx;
+                be.entry.cchSrc = (DWORD)wcslen(pszSrc);
+                be.entry.offSrc = AddString(arrStr,mapStr,pszSrc,be.entry.cchSrc);
+                be.entry.cchTrans = (DWORD)wcslen(pszTrans);
+                be.entry.offTrans = AddString(arrStr,mapStr,pszTrans,be.entry.cchTrans);
+                be.entry.ullHash = HashKey(pszCtx,cchCtx,pszSrc,be.entry.cchSrc);
+                be.nOrder = (DWORD)arrEntry.GetCount();
+                arrEntry.Add(be);
             }
-            
-            SStrMapEntry * strMapEntry = new SStrMapEntry;
-            strMapEntry->strCtx=nodeCtx.attribute(L"name").value();
-            strMapEntry->m_arrStrMap.SetCount(strCount);
-            nodeStr=nodeCtx.child(L"message");
-            for(int j=0;j<strCount;j++)
+        }
+        qsort(arrEntry.GetData(),arrEntry.GetCount(),sizeof(BUILDENTRY),CompareBuildEntry);
+
+        DWORD nEntries = (DWORD)arrEntry.GetCount();
+        DWORD offEntries = sizeof(LANGPACKHEADER);
+        DWORD offStrings = offEntries + nEntries*sizeof(LANGPACKENTRY);
+        DWORD dwSize = offStrings + (DWORD)arrStr.GetCount()*sizeof(WCHAR);
+        arrData.SetCount(dwSize);
+        LPBYTE pData = arrData.GetData();
+
+        LANGPACKHEADER *pHeader = (LANGPACKHEADER*)pData;
+        memset(pHeader,0,sizeof(LANGPACKHEADER));
+        pHeader->dwMagic = LANGPACK_MAGIC;
+        pHeader->dwVersion = LANGPACK_VERSION;
+        pHeader->dwSize = dwSize;
+        OLECHAR szIID[100] = { 0 };
+        wcsncpy(szIID,xmlLang.attribute(L"guid").value(),ARRAYSIZE(szIID)-1);
+        IIDFromString(szIID,&pHeader->guid);
+        pHeader->offName = offStrings + offName*sizeof(WCHAR);
+        pHeader->cchName = cchName;
+        pHeader->offEntries = offEntries;
+        pHeader->nEntries = nEntries;
+
+        LANGPACKENTRY *pEntries = (LANGPACKENTRY*)(pData+offEntries);
+        for(DWORD i=0;i<nEntries;i++)
+        {
+            pEntries[i] = arrEntry[i].entry;
+            pEntries[i].offCtx = offStrings + pEntries[i].offCtx*sizeof(WCHAR);
+            pEntries[i].offSrc = offStrings + pEntries[i].offSrc*sizeof(WCHAR);
+            pEntries[i].offTrans = offStrings + pEntries[i].offTrans*sizeof(WCHAR);
+        }
+        memcpy(pData+offStrings,arrStr.GetData(),arrStr.GetCount()*sizeof(WCHAR));
+    }
+
+    BOOL STranslator::LoadFromXml( pugi::xml_node xmlLang )
+    {
+        Free();
+        Compile(xmlLang,m_arrData);
+        return Attach(m_arrData.GetData(),(DWORD)m_arrData.GetCount());
+    }
+
+    BOOL STranslator::LoadFromFile( LPCWSTR pszFileName )
+    {
+        Free();
+        m_hFile = ::CreateFileW(pszFileName,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+        if(m_hFile == INVALID_HANDLE_VALUE) return FALSE;
+        DWORD dwSize = ::GetFileSize(m_hFile,NULL);
+        if(dwSize != INVALID_FILE_SIZE && dwSize >= sizeof(LANGPACKHEADER))
+        {
+            m_hMapping = ::CreateFileMapping(m_hFile,NULL,PAGE_READONLY,0,0,NULL);
+            if(m_hMapping)
             {
-                SASSERT(nodeStr);
-                SStrMap * strMap= new SStrMap;
-                strMap->strSource=nodeStr.child(L"source").text().get();
-                strMap->strTranslation=nodeStr.child(L"translation").text().get();
-                strMapEntry->m_arrStrMap.SetAt(j,strMap);
-                nodeStr=nodeStr.next_sibling(L"message");
+                const BYTE *pData = (const BYTE*)::MapViewOfFile(m_hMapping,FILE_MAP_READ,0,0,0);
+                if(pData && Attach(pData,dwSize)) return TRUE;
+                if(pData) ::UnmapViewOfFile(pData);
             }
-            qsort(strMapEntry->m_arrStrMap.GetData(),strMapEntry->m_arrStrMap.GetCount(),sizeof(SStrMap*),SStrMap::Compare);
-            m_arrEntry->SetAt(i,strMapEntry);
-            nodeCtx=nodeCtx.next_sibling(L"context");
         }
-        
-        qsort(m_arrEntry->GetData(),m_arrEntry->GetCount(),sizeof(SStrMapEntry*),SStrMapEntry::Compare);
+        m_pData = NULL;
+        Free();
+        return FALSE;
+    }
+
+    BOOL STranslator::LoadFromData( const BYTE *pData )
+    {
+        Free();
+        const LANGPACKHEADER *pHeader = (const LANGPACKHEADER*)pData;
+        if(pHeader->dwMagic != LANGPACK_MAGIC || pHeader->dwSize < sizeof(LANGPACKHEADER))
+            return FALSE;
+        m_arrData.SetCount(pHeader->dwSize);
+        memcpy(m_arrData.GetData(),pData,pHeader->dwSize);
+        if(Attach(m_arrData.GetData(),(DWORD)m_arrData.GetCount())) return TRUE;
+        m_arrData.RemoveAll();
+        return FALSE;
+    }
+
+    BOOL STranslator::Attach( const BYTE *pData,DWORD dwSize )
+    {
+        const LANGPACKHEADER *pHeader = (const LANGPACKHEADER*)pData;
+        if(dwSize < sizeof(LANGPACKHEADER)
+            || pHeader->dwMagic != LANGPACK_MAGIC
+            || pHeader->dwVersion != LANGPACK_VERSION
+            || pHeader->dwSize > dwSize
+            || pHeader->offEntries % 8 != 0
+            || (ULONGLONG)pHeader->offEntries + (ULONGLONG)pHeader->nEntries*sizeof(LANGPACKENTRY) > pHeader->dwSize)
+            return FALSE;
+
+        m_pData = pData;
+        m_dwSize = pHeader->dwSize;
+        LPCWSTR pszName = GetString(pHeader->offName,pHeader->cchName);
+        if(!pszName)
+        {
+            m_pData = NULL;
+            m_dwSize = 0;
+            return FALSE;
+        }
+        m_pEntries = (const LANGPACKENTRY*)(pData+pHeader->offEntries);
+        m_nEntries = pHeader->nEntries;
+        m_strLang = SStringW(pszName,pHeader->cchName);
+        m_guid = pHeader->guid;
         return TRUE;
     }
 
-    BOOL STranslator::tr( const SStringW & strSrc,const SStringW & strCtx,SStringW & strRet )
+    void STranslator::Free()
     {
-        SStrMapEntry** pEntry = (SStrMapEntry**)bsearch(&strCtx,m_arrEntry->GetData(),m_arrEntry->GetCount(),sizeof(SStrMapEntry*),SStrMapEntry::CompareInSearch);
-        if(pEntry)
+        if(m_hMapping)
         {
-            SStrMap ** pMap=(SStrMap**)bsearch(&strSrc,(*pEntry)->m_arrStrMap.GetData(),(*pEntry)->m_arrStrMap.GetCount(),sizeof(SStrMap*),SStrMap::CompareInSearch);
-            if(pMap)
-            {//从指定的上下文中查找翻译
-                strRet=(*pMap)->strTranslation;
-                return TRUE;
-            }
+            if(m_pData) ::UnmapViewOfFile(m_pData);
+            ::CloseHandle(m_hMapping);
+            m_hMapping = NULL;
         }
-		if(!strCtx.IsEmpty())
-		{//从空白上下文中查找
-			return tr(strSrc,SStringW(),strRet);
-		}
-        return FALSE;
+        if(m_hFile != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+        }
+        m_arrData.RemoveAll();
+        m_pData = NULL;
+        m_dwSize = 0;
+        m_pEntries = NULL;
+        m_nEntries = 0;
+    }
+
+    LPCWSTR STranslator::GetString( DWORD offStr,DWORD cchStr ) const
+    {
+        if(offStr % sizeof(WCHAR) != 0 || (ULONGLONG)offStr + ((ULONGLONG)cchStr+1)*sizeof(WCHAR) > m_dwSize)
+            return NULL;
+        LPCWSTR pszStr = (LPCWSTR)(m_pData+offStr);
+        if(pszStr[cchStr] != 0) return NULL;
+        return pszStr;
+    }
+
+    LPCWSTR STranslator::Lookup( LPCWSTR pszSrc,int nSrcLen,LPCWSTR pszCtx,int nCtxLen,int *pnLen ) const
+    {
+        ULONGLONG ullHash = HashKey(pszCtx,nCtxLen,pszSrc,nSrcLen);
+        //查找第一个哈希值不小于ullHash的条目
+        DWORD iLow = 0, iHigh = m_nEntries;
+        while(iLow < iHigh)
+        {
+            DWORD iMid = iLow + (iHigh-iLow)/2;
+            if(m_pEntries[iMid].ullHash < ullHash) iLow = iMid+1;
+            else iHigh = iMid;
+        }
+        for(;iLow < m_nEntries && m_pEntries[iLow].ullHash == ullHash;iLow++)
+        {
+            const LANGPACKENTRY & entry = m_pEntries[iLow];
+            if(entry.cchSrc != (DWORD)nSrcLen || entry.cchCtx != (DWORD)nCtxLen) continue;
+            LPCWSTR pszEntrySrc = GetString(entry.offSrc,entry.cchSrc);
+            LPCWSTR pszEntryCtx = GetString(entry.offCtx,entry.cchCtx);
+            LPCWSTR pszTrans = GetString(entry.offTrans,entry.cchTrans);
+            if(!pszEntrySrc || !pszEntryCtx || !pszTrans) continue;
+            if(wmemcmp(pszEntrySrc,pszSrc,nSrcLen) != 0 || wmemcmp(pszEntryCtx,pszCtx,nCtxLen) != 0) continue;
+            if(pnLen) *pnLen = (int)entry.cchTrans;
+            return pszTrans;
+        }
+        return NULL;
+    }
+
+    BOOL STranslator::tr( const SStringW & strSrc,const SStringW & strCtx,SStringW & strRet )
+    {
+        int nLen = 0;
+        LPCWSTR pszTrans = Lookup(strSrc,strSrc.GetLength(),strCtx,strCtx.GetLength(),&nLen);
+        if(!pszTrans && !strCtx.IsEmpty())
+        {//从空白上下文中查找
+            pszTrans = Lookup(strSrc,strSrc.GetLength(),L"",0,&nLen);
+        }
+        if(!pszTrans) return FALSE;
+        strRet = SStringW(pszTrans,nLen);
+        return TRUE;
     }
 
 
@@ -287,5 +412,21 @@ namespace SOUI
             *ppTrans = new STranslatorMgr;
             return TRUE;
         }
+
+        BOOL SCompileLang( LPCWSTR pszXmlFile,LPCWSTR pszOutFile )
+        {
+            pugi::xml_document xmlDoc;
+            if(!xmlDoc.load_file(pszXmlFile,pugi::parse_default,pugi::encoding_auto)) return FALSE;
+            pugi::xml_node xmlLang = xmlDoc.child(L"language");
+            if(!xmlLang) return FALSE;
+
+            SArray<BYTE> arrData;
+            STranslator::Compile(xmlLang,arrData);
+            FILE *f = _wfopen(pszOutFile,L"wb");
+            if(!f) return FALSE;
+            size_t szWrite = fwrite(arrData.GetData(),1,arrData.GetCount(),f);
+            fclose(f);
+            return szWrite == arrData.GetCount();
+        }
     }
 }
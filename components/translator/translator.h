@@ -14,14 +14,45 @@
 
 namespace SOUI
 {
-    class SStrMap;
-    class SStrMapEntry;
-
     enum LANGDATA{
         LD_UNKNOWN=0,
-        LD_XML,
-        LD_COMPILEDFILE,
-        LD_COMPILEDDATA,
+        LD_XML,             //pData为pugi::xml_node*，指向language节点
+        LD_COMPILEDFILE,    //pData为LPCWSTR，编译后的语言包文件名，文件被映射到内存中使用
+        LD_COMPILEDDATA,    //pData为编译后的语言包数据，数据被复制一次
+    };
+
+    #define LANGPACK_MAGIC      0x4b504c53  //"SLPK"
+    #define LANGPACK_VERSION    1
+
+    /**
+    * @struct     LANGPACKHEADER
+    * @brief      编译后的语言包文件头
+    *
+    * Describe    文件由文件头、按哈希值排序的LANGPACKENTRY数组及字符串区组成。
+    *             偏移都相对于文件开始位置，字符串为以0结尾的UTF16，相同的字符串只保存一次。
+    */
+    struct LANGPACKHEADER
+    {
+        DWORD   dwMagic;        /**<LANGPACK_MAGIC*/
+        DWORD   dwVersion;      /**<LANGPACK_VERSION*/
+        DWORD   dwSize;         /**<语言包的字节数*/
+        GUID    guid;
+        DWORD   offName;        /**<语言名称的偏移*/
+        DWORD   cchName;
+        DWORD   offEntries;     /**<LANGPACKENTRY数组的偏移*/
+        DWORD   nEntries;
+        DWORD   dwReserved;     /**<保证LANGPACKENTRY数组8字节对齐*/
+    };
+
+    struct LANGPACKENTRY
+    {
+        ULONGLONG   ullHash;    /**<上下文及原字符串的64位哈希值*/
+        DWORD       offCtx;
+        DWORD       cchCtx;
+        DWORD       offSrc;
+        DWORD       cchSrc;
+        DWORD       offTrans;
+        DWORD       cchTrans;
     };
 
     class STranslator : public TObjRefImpl<ITranslator>
@@ -36,12 +67,55 @@ namespace SOUI
         virtual SStringW name();
         virtual GUID     guid();
         virtual BOOL tr(const SStringW & strSrc,const SStringW & strCtx,SStringW & strRet);
+
+        /**
+        * Lookup
+        * @brief    在指定的上下文中查找翻译
+        * @param    LPCWSTR pszSrc --  原字符串
+        * @param    int nSrcLen --  原字符串长度
+        * @param    LPCWSTR pszCtx --  上下文
+        * @param    int nCtxLen --  上下文长度
+        * @param    int * pnLen --  返回翻译的长度，可以为NULL
+        * @return   LPCWSTR -- 指向语言包数据的以0结尾的翻译，没有找到时返回NULL
+        * Describe  不查找空白上下文，返回的字符串在语言包释放前有效
+        */
+        LPCWSTR Lookup(LPCWSTR pszSrc,int nSrcLen,LPCWSTR pszCtx,int nCtxLen,int *pnLen) const;
+
+        /**
+        * Compile
+        * @brief    将XML语言包编译为二进制格式
+        * @param    pugi::xml_node xmlLang --  language节点
+        * @param    SArray<BYTE> & arrData --  编译结果
+        * @return   void
+        */
+        static void Compile(pugi::xml_node xmlLang,SArray<BYTE> & arrData);
+
     protected:
         BOOL LoadFromXml(pugi::xml_node xmlLang);
 
+        BOOL LoadFromFile(LPCWSTR pszFileName);
+
+        BOOL LoadFromData(const BYTE *pData);
+
+        //使用编译后的语言包数据，只检查文件头及条目表的范围
+        BOOL Attach(const BYTE *pData,DWORD dwSize);
+
+        void Free();
+
+        //返回偏移处的字符串，超出语言包范围时返回NULL
+        LPCWSTR GetString(DWORD offStr,DWORD cchStr) const;
+
         SStringW m_strLang;
         GUID     m_guid;
-        SArray<SStrMapEntry*> * m_arrEntry;
+
+        const BYTE *            m_pData;        /**<语言包数据*/
+        DWORD                   m_dwSize;
+        const LANGPACKENTRY *   m_pEntries;
+        DWORD                   m_nEntries;
+
+        SArray<BYTE>    m_arrData;      /**<从XML编译或者复制的语言包数据*/
+        HANDLE          m_hFile;        /**<映射的语言包文件*/
+        HANDLE          m_hMapping;
     };
 
     class STranslatorMgr : public TObjRefImpl<ITranslatorMgr>
@@ -73,6 +147,15 @@ namespace SOUI
     namespace TRANSLATOR
     {
         SOUI_COM_C BOOL SOUI_COM_API SCreateInstance(IObjRef **ppTrans);
+
+        /**
+        * SCompileLang
+        * @brief    将XML语言包文件编译为二进制语言包文件
+        * @param    LPCWSTR pszXmlFile --  XML语言包文件
+        * @param    LPCWSTR pszOutFile --  输出文件，使用LD_COMPILEDFILE加载
+        * @return   BOOL
+        */
+        SOUI_COM_C BOOL SOUI_COM_API SCompileLang(LPCWSTR pszXmlFile,LPCWSTR pszOutFile);
     }
 
 }
@@ -4,7 +4,7 @@
 namespace SOUI
 {
 
-SImagePlayer::SImagePlayer() :m_aniSkin(NULL), m_iCurFrame(0),m_nNextInterval(0)
+SImagePlayer::SImagePlayer() :m_aniSkin(NULL), m_iCurFrame(0),m_dwNextFrame(0)
 {
 
 }
@@ -32,28 +32,39 @@ void SImagePlayer::OnShowWindow( BOOL bShow, UINT nStatus )
 	}else if(m_aniSkin && m_aniSkin->GetStates()>1)
 	{
         GetContainer()->RegisterTimelineHandler(this);
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 90;
-        else
-            m_nNextInterval = m_aniSkin->GetFrameDelay()*10;
+        m_dwNextFrame = GetTickCount() + _GetFrameDelay();
 	}
 }
 
+int SImagePlayer::_GetFrameDelay()
+{
+    if(m_aniSkin->GetFrameDelay()==0)
+        return 60;
+    return m_aniSkin->GetFrameDelay()*10;
+}
+
 void SImagePlayer::OnNextFrame()
 {
-    m_nNextInterval -= 10;
-    if(m_nNextInterval <= 0 && m_aniSkin)
+    if(!m_aniSkin) return;
+    //Եʱ任֡ٶȲʱ֡Ӱ
+    DWORD dwNow = GetTickCount();
+    int nRemain = (int)(m_dwNextFrame - dwNow);
+    if(nRemain <= 0)
     {
         int nStates=m_aniSkin->GetStates();
         m_iCurFrame++;
         m_iCurFrame%=nStates;
         Invalidate();
 
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 60;
-        else
-            m_nNextInterval =m_aniSkin->GetFrameDelay()*10;	
+        m_dwNextFrame += _GetFrameDelay();
+        nRemain = (int)(m_dwNextFrame - dwNow);
+        if(nRemain <= 0)
+        {//󳬹һ֡ʱ׷ϣӵǰʱ¼ʱ
+            nRemain = _GetFrameDelay();
+            m_dwNextFrame = dwNow + nRemain;
+        }
     }
+    GetContainer()->ScheduleTimelineHandler(this,nRemain);
 }
 
 HRESULT SImagePlayer::OnAttrSkin( const SStringW & strValue, BOOL bLoading )
@@ -65,10 +76,7 @@ HRESULT SImagePlayer::OnAttrSkin( const SStringW & strValue, BOOL bLoading )
     if(!bLoading)
     {
         m_iCurFrame = 0;
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 90;
-        else
-            m_nNextInterval =m_aniSkin->GetFrameDelay()*10;	
+        m_dwNextFrame = GetTickCount() + _GetFrameDelay();
     }
 	return bLoading?S_OK:S_FALSE;
 }
@@ -115,6 +123,7 @@ void SImagePlayer::Resume()
     if (m_aniSkin && m_aniSkin->GetStates() > 1)
     {
         GetContainer()->RegisterTimelineHandler(this);
+        m_dwNextFrame = GetTickCount() + _GetFrameDelay();
     }
 }
 
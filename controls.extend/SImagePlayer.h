@@ -45,6 +45,9 @@ namespace SOUI
         
     protected:
         BOOL _PlayFile(LPCTSTR pszFileName, BOOL bGif);
+
+        //ǰ֡ʾʱ(ms)
+        int _GetFrameDelay();
     protected://ϢSOUIؼϢWTLMFCƣƵӳͬƵϢӳ
         
         /**
@@ -78,6 +81,6 @@ namespace SOUI
     protected:
         SSkinAni *  m_aniSkin;
         int	        m_iCurFrame;
-        int         m_nNextInterval;
+        DWORD       m_dwNextFrame;  //һ֡ĵʱ(GetTickCount)
     };
 }
\ No newline at end of file
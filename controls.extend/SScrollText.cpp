@@ -3,7 +3,7 @@
 
 namespace SOUI
 {
-    SScrollText::SScrollText(void):m_nSpeed(20),m_nOffset(0),m_nScrollWidth(0),m_nRollType(0)
+    SScrollText::SScrollText(void):m_nSpeed(20),m_nOffset(0),m_nScrollWidth(0),m_nRollType(0),m_dwNextStep(0)
     {
     }
 
@@ -56,7 +56,7 @@ namespace SOUI
             if(IsVisible(TRUE))
             {
                 GetContainer()->RegisterTimelineHandler(this);
-                m_nNextInterval = m_nSpeed;
+                m_dwNextStep = GetTickCount() + _GetStepDelay();
             }
             else
             {
@@ -91,7 +91,7 @@ namespace SOUI
                 if(IsVisible(TRUE))
                 {
                     GetContainer()->RegisterTimelineHandler(this);
-                    m_nNextInterval = m_nSpeed;
+                    m_dwNextStep = GetTickCount() + _GetStepDelay();
                 }
                 else
                 {
@@ -107,15 +107,24 @@ namespace SOUI
         }
     }
 
+    int SScrollText::_GetStepDelay() const
+    {
+        return m_nSpeed>0?m_nSpeed:1;
+    }
+
     void SScrollText::OnNextFrame()
     {
-        m_nNextInterval -= 10;
-        if(m_nNextInterval < 0)
+        //ԵʱҪٶȲʱ֡Ӱ
+        DWORD dwNow = GetTickCount();
+        int nRemain = (int)(m_dwNextStep - dwNow);
+        if(nRemain <= 0)
         {
-            m_nNextInterval = m_nSpeed;
+            int nSteps = 1 - nRemain/_GetStepDelay();
+            m_dwNextStep += nSteps*_GetStepDelay();
+            nRemain = (int)(m_dwNextStep - dwNow);
 			if (m_nScrollWidth>0)
 			{ 
-				m_nOffset ++;
+				m_nOffset += nSteps;
 				if(m_nOffset>m_nScrollWidth)
 				{
 					if (m_nRollType==0)
@@ -130,6 +139,7 @@ namespace SOUI
 				Invalidate();
 			}
         }
+        GetContainer()->ScheduleTimelineHandler(this,nRemain);
     }
 
     void SScrollText::OnDestroy()
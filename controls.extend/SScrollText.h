@@ -19,6 +19,9 @@ namespace SOUI
         void OnDestroy();
 
         void UpdateScrollInfo(CSize size);
+
+        //һصʱ(ms)
+        int _GetStepDelay() const;
         
         SOUI_MSG_MAP_BEGIN()
             MSG_WM_PAINT_EX(OnPaint)
@@ -35,7 +38,7 @@ namespace SOUI
         int m_nSpeed;
         int m_nOffset;
         int m_nScrollWidth;
-        int m_nNextInterval;
+        DWORD m_dwNextStep;//һιĵʱ(GetTickCount)
 		int m_nRollType;//0λν 1 ν
     };
 
@@ -3,18 +3,60 @@
 #include <interface/render-i.h>
 namespace SOUI
 {
+    /**
+    * @class     SAniImgFrame
+    * @brief     һ֡
+    * 
+    * Describe   ؼ֡ͼƬpBmpֻ֡һ֡ȷ仯ľأ
+    *            ʾʱĹؼ֡ʼκϳ
+    */
     class SAniImgFrame
     {
     public:
+        SAniImgFrame():nDelay(0),pDelta(NULL)
+        {
+        }
+
+        ~SAniImgFrame()
+        {
+            if(pDelta) free(pDelta);
+        }
+
+        BOOL IsDelta() const {return !pBmp;}
+
         CAutoRefPtr<IBitmap> pBmp;
         int                  nDelay;
+        CRect                rcDelta;   //֡仯
+        LPBYTE               pDelta;    //֡仯أΪNULLʾһ֡ͬ
+        CAutoRefPtr<IBitmap> pComposed; //GetFrameImageϳɵͼƬһλȡʱ
+    };
+
+    /**
+    * @struct    SAniCanvas
+    * @brief     ֡ĺϳͼ
+    * 
+    * Describe   ɻ߱棬һƤĶԺϳԼĵǰ֡Ӱ
+    */
+    struct SAniCanvas
+    {
+        SAniCanvas():iFrame(-1),nVer(0){}
+
+        void Reset()
+        {
+            pBmp = NULL;
+            iFrame = -1;
+        }
+
+        CAutoRefPtr<IBitmap> pBmp;
+        int                  iFrame;    //ϳͼǰӦ֡
+        int                  nVer;      //ϳʱƤ֡ݵİ汾Ƥ¼غϳͼʧЧ
     };
 
     class SSkinAni : public SSkinObjBase
     {
         SOUI_CLASS_NAME(SSkinAni,L"skinani")
     public:
-        SSkinAni():m_nFrames(0),m_iFrame(0),m_pFrames(NULL)
+        SSkinAni():m_nFrames(0),m_iFrame(0),m_pFrames(NULL),m_nFramesVer(0)
         {
 
         }
@@ -42,7 +84,7 @@ namespace SOUI
         virtual SIZE GetSkinSize()
         {
             SIZE sz={0};
-            if(m_nFrames>0 && m_pFrames)
+            if(m_nFrames>0 && m_pFrames && m_pFrames[0].pBmp)
             {
                 sz=m_pFrames[0].pBmp->Size();
             }
@@ -67,19 +109,52 @@ namespace SOUI
             return nRet;
         }
         
+        /**
+        * GetFrameImage
+        * @brief    ָ֡ͼƬ
+        * @param    int iFrame --  ֡,Ϊ-1ʱǰ֡
+        * @return   IBitmap * -- Ƥ¼ǰһֱЧݲı
+        * Describe  ֡һλȡʱϳһͼƬ֡
+        */    
         IBitmap * GetFrameImage(int iFrame=-1)
         {
             if(iFrame==-1) iFrame=m_iFrame;
             long nRet=-1;
             if(m_nFrames>1 && iFrame>=0 && iFrame<m_nFrames)
             {
-                return m_pFrames[iFrame].pBmp;
+                SAniImgFrame & frame = m_pFrames[iFrame];
+                if(!frame.IsDelta()) return frame.pBmp;
+                if(!frame.pComposed)
+                {
+                    SAniCanvas canvas;
+                    frame.pComposed = _GetFrameBitmap(iFrame,canvas);
+                }
+                return frame.pComposed;
             }else
             {
                 return NULL;
             }
         }
 
+        /**
+        * DrawFrame
+        * @brief    ʹûԼĺϳͼָ֡
+        * @param    IRenderTarget * pRT --  Ŀ
+        * @param    LPCRECT rcDraw --  ƷΧ
+        * @param    int iFrame --  ֡
+        * @param    SAniCanvas & canvas --  ߵĺϳͼ˳򲥷ʱÿֻ֡Ҫϳɱ仯
+        * @return   void
+        * Describe  ıƤĵǰ֡
+        */    
+        void DrawFrame(IRenderTarget *pRT, LPCRECT rcDraw, int iFrame, SAniCanvas & canvas)
+        {
+            if(m_nFrames == 0 || !m_pFrames || iFrame<0 || iFrame>=m_nFrames) return;
+            IBitmap *pBmp = _GetFrameBitmap(iFrame,canvas);
+            if(!pBmp) return;
+            CRect rcSrc(CPoint(0,0),GetSkinSize());
+            pRT->DrawBitmapEx(rcDraw,pBmp,rcSrc,EM_STRETCH,GetAlpha());
+        }
+
 
         /**
         * ActiveNextFrame
@@ -130,14 +205,135 @@ namespace SOUI
         {
             if(m_nFrames == 0 || !m_pFrames) return;
             if(dwState!=-1) SelectActiveFrame(dwState);
+            IBitmap *pBmp = _GetFrameBitmap(m_iFrame,m_canvas);
+            if(!pBmp) return;
             CRect rcSrc(CPoint(0,0),GetSkinSize());
-            pRT->DrawBitmapEx(rcDraw,m_pFrames[m_iFrame].pBmp,rcSrc,EM_STRETCH,byAlpha);
+            pRT->DrawBitmapEx(rcDraw,pBmp,rcSrc,EM_STRETCH,byAlpha);
+        }
+
+        enum{
+            KKeyFrameInterval = 16, //ؼ֮֡֡ʱҪϳɵ֡
+        };
+
+        /**
+        * _SetFramePixels
+        * @brief    һ֡
+        * @param    int iFrame --  ֡ţҪ˳
+        * @param    SIZE szFrame --  ֡С֡ͬ
+        * @param    const BYTE * pBits --  32λأмû
+        * @param    const BYTE * pPrevBits --  һ֡أΪNULLʱΪؼ֡
+        * @return   void
+        * Describe  仯򲻳һ֡Ϊ֡ڴ治ʱΪؼ֡
+        */    
+        void _SetFramePixels(int iFrame,SIZE szFrame,const BYTE *pBits,const BYTE *pPrevBits)
+        {
+            SAniImgFrame & frame = m_pFrames[iFrame];
+            if(iFrame>0 && pPrevBits && iFrame%KKeyFrameInterval != 0)
+            {
+                const DWORD *pCur = (const DWORD*)pBits;
+                const DWORD *pPrev = (const DWORD*)pPrevBits;
+                CRect rc(szFrame.cx,szFrame.cy,0,0);
+                for(int y=0;y<szFrame.cy;y++)
+                {
+                    const DWORD *pLine = pCur + y*szFrame.cx;
+                    const DWORD *pPrevLine = pPrev + y*szFrame.cx;
+                    int x0 = 0;
+                    while(x0<szFrame.cx && pLine[x0]==pPrevLine[x0]) x0++;
+                    if(x0 == szFrame.cx) continue;
+                    int x1 = szFrame.cx;
+                    while(pLine[x1-1]==pPrevLine[x1-1]) x1--;
+                    if(x0<rc.left) rc.left = x0;
+                    if(x1>rc.right) rc.right = x1;
+                    if(y<rc.top) rc.top = y;
+                    rc.bottom = y+1;
+                }
+                if(rc.IsRectEmpty())
+                {//һ֡ͬ
+                    frame.rcDelta.SetRectEmpty();
+                    return;
+                }
+                if(rc.Width()*rc.Height()*2 <= szFrame.cx*szFrame.cy
+                    && (frame.pDelta = (LPBYTE)malloc(rc.Width()*rc.Height()*4)) != NULL)
+                {
+                    frame.rcDelta = rc;
+                    for(int y=rc.top;y<rc.bottom;y++)
+                    {
+                        memcpy(frame.pDelta+(y-rc.top)*rc.Width()*4,pBits+(y*szFrame.cx+rc.left)*4,rc.Width()*4);
+                    }
+                    return;
+                }
+            }
+            GETRENDERFACTORY->CreateBitmap(&frame.pBmp);
+            frame.pBmp->Init(szFrame.cx,szFrame.cy,(const LPVOID)pBits);
+        }
+
+        /**
+        * _GetFrameBitmap
+        * @brief    һ֡ͼƬ
+        * @param    int iFrame --  ֡
+        * @param    SAniCanvas & canvas --  ֡ĺϳͼ
+        * @return   IBitmap * -- ֡canvasеĺϳͼ´ʹͬһcanvasϳɺݸı
+        */    
+        IBitmap * _GetFrameBitmap(int iFrame,SAniCanvas & canvas)
+        {
+            if(!m_pFrames[iFrame].IsDelta()) return m_pFrames[iFrame].pBmp;
+            if(canvas.nVer != m_nFramesVer)
+            {
+                canvas.Reset();
+                canvas.nVer = m_nFramesVer;
+            }
+            if(iFrame == canvas.iFrame) return canvas.pBmp;
+
+            int iKey = iFrame;
+            while(m_pFrames[iKey].IsDelta()) iKey--;
+            int iStart = iKey+1;
+            IBitmap *pKey = m_pFrames[iKey].pBmp;
+            CSize szFrame = pKey->Size();
+            if(canvas.iFrame>=iKey && canvas.iFrame<iFrame)
+            {//ӵǰϳɵ֡ϳ
+                iStart = canvas.iFrame+1;
+            }else if(!canvas.pBmp)
+            {
+                GETRENDERFACTORY->CreateBitmap(&canvas.pBmp);
+                if(!canvas.pBmp) return pKey;
+                canvas.pBmp->Init(szFrame.cx,szFrame.cy,pKey->GetPixelBits());
+            }else
+            {
+                LPBYTE pCanvas = (LPBYTE)canvas.pBmp->LockPixelBits();
+                memcpy(pCanvas,pKey->GetPixelBits(),szFrame.cx*szFrame.cy*4);
+                canvas.pBmp->UnlockPixelBits(pCanvas);
+            }
+
+            LPBYTE pCanvas = (LPBYTE)canvas.pBmp->LockPixelBits();
+            for(int i=iStart;i<=iFrame;i++)
+            {
+                const SAniImgFrame & frame = m_pFrames[i];
+                if(!frame.pDelta) continue;
+                const CRect & rc = frame.rcDelta;
+                for(int y=rc.top;y<rc.bottom;y++)
+                {
+                    memcpy(pCanvas+(y*szFrame.cx+rc.left)*4,frame.pDelta+(y-rc.top)*rc.Width()*4,rc.Width()*4);
+                }
+            }
+            canvas.pBmp->UnlockPixelBits(pCanvas);
+            canvas.iFrame = iFrame;
+            return canvas.pBmp;
+        }
+
+        //ϳͼ¼֡ʱãߵĺϳͼ´ʹʱʧЧ
+        void _ResetCanvas()
+        {
+            m_canvas.Reset();
+            m_nFramesVer++;
         }
 
         int m_nFrames;
         int m_iFrame;
 
         SAniImgFrame * m_pFrames;
+
+        SAniCanvas  m_canvas;       //ֱʹƤʱĺϳͼ
+        int         m_nFramesVer;   //֡ݵİ汾ÿμغ
     };
 
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
 namespace SOUI
 {
 
-SGifPlayer::SGifPlayer() :m_aniSkin(NULL), m_iCurFrame(0),m_nNextInterval(0)
+SGifPlayer::SGifPlayer() :m_aniSkin(NULL), m_iCurFrame(0),m_dwNextFrame(0),m_bSleeping(FALSE)
 {
 
 }
@@ -21,41 +21,80 @@ void SGifPlayer::OnPaint( IRenderTarget *pRT )
 	__super::OnPaint(pRT);
 	if(m_aniSkin)
 	{		
-		m_aniSkin->Draw(pRT, GetWindowRect(),m_iCurFrame);
+		m_aniSkin->DrawFrame(pRT, GetWindowRect(),m_iCurFrame,m_canvas);
+	}
+	if(m_bSleeping)
+	{//³ĻʱŻػ棬ָ
+		m_bSleeping = FALSE;
+		m_dwNextFrame = GetTickCount() + _GetFrameDelay();
+		GetContainer()->ScheduleTimelineHandler(this,_GetFrameDelay());
 	}
 }
 
 void SGifPlayer::OnShowWindow( BOOL bShow, UINT nStatus )
 {
 	__super::OnShowWindow(bShow,nStatus);
+	m_bSleeping = FALSE;
 	if(!bShow)
 	{
         GetContainer()->UnregisterTimelineHandler(this);
 	}else if(m_aniSkin && m_aniSkin->GetStates()>1)
 	{
         GetContainer()->RegisterTimelineHandler(this);
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 90;
-        else
-            m_nNextInterval = m_aniSkin->GetFrameDelay()*10;
+        m_dwNextFrame = GetTickCount() + _GetFrameDelay();
 	}
 }
 
+int SGifPlayer::_GetFrameDelay()
+{
+    if(m_aniSkin->GetFrameDelay(m_iCurFrame)==0)
+        return 90;
+    return m_aniSkin->GetFrameDelay(m_iCurFrame)*10;
+}
+
+BOOL SGifPlayer::_IsOnScreen()
+{
+    HWND hHost = GetContainer()->GetHostHwnd();
+    if(::IsIconic(hHost) || !::IsWindowVisible(hHost)) return FALSE;
+
+    CRect rc = GetWindowRect();
+    SWindow *pParent = GetParent();
+    while(pParent && !rc.IsRectEmpty())
+    {
+        rc.IntersectRect(rc,pParent->GetClientRect());
+        pParent = pParent->GetParent();
+    }
+    return !rc.IsRectEmpty();
+}
+
 void SGifPlayer::OnNextFrame()
 {
-    m_nNextInterval -= 10;
-    if(m_nNextInterval <= 0 && m_aniSkin)
+    if(!m_aniSkin) return;
+    if(!_IsOnScreen())
+    {//ĻʱߣѯOnPaintлָ
+        m_bSleeping = TRUE;
+        GetContainer()->ScheduleTimelineHandler(this,TIMELINE_IDLE);
+        return;
+    }
+    //Եʱ任֡ٶȲʱ֡Ӱ
+    DWORD dwNow = GetTickCount();
+    int nRemain = (int)(m_dwNextFrame - dwNow);
+    if(nRemain <= 0)
     {
         int nStates=m_aniSkin->GetStates();
         m_iCurFrame++;
         m_iCurFrame%=nStates;
         Invalidate();
 
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 90;
-        else
-            m_nNextInterval =m_aniSkin->GetFrameDelay()*10;	
+        m_dwNextFrame += _GetFrameDelay();
+        nRemain = (int)(m_dwNextFrame - dwNow);
+        if(nRemain <= 0)
+        {//󳬹һ֡ʱ׷ϣӵǰʱ¼ʱ
+            nRemain = _GetFrameDelay();
+            m_dwNextFrame = dwNow + nRemain;
+        }
     }
+    GetContainer()->ScheduleTimelineHandler(this,nRemain);
 }
 
 HRESULT SGifPlayer::OnAttrSkin( const SStringW & strValue, BOOL bLoading )
@@ -64,13 +103,11 @@ HRESULT SGifPlayer::OnAttrSkin( const SStringW & strValue, BOOL bLoading )
 	if(!pSkin) return E_FAIL;
 	if(!pSkin->IsClass(SSkinAni::GetClassName())) return S_FALSE;
 	m_aniSkin=static_cast<SSkinAni*>(pSkin);
+	m_canvas.Reset();
     if(!bLoading)
     {
         m_iCurFrame = 0;
-        if(m_aniSkin->GetFrameDelay()==0)
-            m_nNextInterval = 90;
-        else
-            m_nNextInterval =m_aniSkin->GetFrameDelay()*10;	
+        m_dwNextFrame = GetTickCount() + _GetFrameDelay();
     }
 	return bLoading?S_OK:S_FALSE;
 }
@@ -105,6 +142,8 @@ BOOL SGifPlayer::_PlayFile( LPCTSTR pszFileName, BOOL bGif )
 	}
 
 	m_aniSkin = pGifSkin;
+	m_canvas.Reset();
+	m_iCurFrame = 0;
 
 	if(GetLayoutParam()->IsWrapContent(Any))
 	{
@@ -113,6 +152,8 @@ BOOL SGifPlayer::_PlayFile( LPCTSTR pszFileName, BOOL bGif )
 	if(IsVisible(TRUE))
 	{
 		GetContainer()->RegisterTimelineHandler(this);
+		m_dwNextFrame = GetTickCount() + _GetFrameDelay();
+		m_bSleeping = FALSE;
 	}
 	return TRUE;
 }
@@ -52,6 +52,12 @@ namespace SOUI
         
     protected:
         BOOL _PlayFile(LPCTSTR pszFileName, BOOL bGif);
+
+        //ؼǷвĻϿɼڲüСʱͣ
+        BOOL _IsOnScreen();
+
+        //ǰ֡ʾʱ(ms)
+        int _GetFrameDelay();
     protected://ϢSOUIؼϢWTLMFCƣƵӳͬƵϢӳ
         
         /**
@@ -84,8 +90,10 @@ namespace SOUI
 
     protected:
         SSkinAni *m_aniSkin;
+        SAniCanvas m_canvas;    //ǰ֡ĺϳͼƤĲԱ
         int	m_iCurFrame;
-        int     m_nNextInterval;
+        DWORD   m_dwNextFrame;  //һ֡ĵʱ(GetTickCount)
+        BOOL    m_bSleeping;    //Ļϣʱᴦ״̬
     };
 
 }
\ No newline at end of file
@@ -64,16 +64,38 @@ int SSkinAPNG::_InitImgFrame( IImgX *pImgX )
     m_pFrames = NULL;
     m_nFrames =0;
     m_iFrame = 0;
-    if(!pImgX) return 0;
+    _ResetCanvas();
+    if(!pImgX || pImgX->GetFrameCount()==0) return 0;
+
+    UINT nWid=0,nHei=0;
+    pImgX->GetFrame(0)->GetSize(&nWid,&nHei);
+    if(nWid==0 || nHei==0) return 0;
+    SIZE szFrame={(LONG)nWid,(LONG)nHei};
+    UINT nFrameSize = nWid*nHei*4;
+
+    //֡ȡأֻһ֡ȱ仯
+    LPBYTE pBits[2];
+    pBits[0] = (LPBYTE)malloc(nFrameSize);
+    pBits[1] = (LPBYTE)malloc(nFrameSize);
+    if(!pBits[0] || !pBits[1])
+    {
+        free(pBits[0]);
+        free(pBits[1]);
+        return 0;
+    }
 
     m_nFrames = pImgX->GetFrameCount();
     m_pFrames = new SAniImgFrame[m_nFrames];
     for(int i=0;i<m_nFrames;i++)
     {
-        GETRENDERFACTORY->CreateBitmap(&m_pFrames[i].pBmp);
-        m_pFrames[i].pBmp->Init(pImgX->GetFrame(i));
-        m_pFrames[i].nDelay=pImgX->GetFrame(i)->GetDelay();
+        IImgFrame *pFrame = pImgX->GetFrame(i);
+        LPBYTE pCur = pBits[i&1];
+        pFrame->CopyPixels(NULL,nWid*4,nFrameSize,pCur);
+        _SetFramePixels(i,szFrame,pCur,i>0?pBits[(i-1)&1]:NULL);
+        m_pFrames[i].nDelay=pFrame->GetDelay();
     }
+    free(pBits[0]);
+    free(pBits[1]);
     return m_nFrames;
 }
 
@@ -93,6 +93,7 @@ int SSkinGif::LoadFromGdipImage( Gdiplus::Bitmap * pImage )
         delete pDimensionIDs;
     }
     m_pFrames = new SAniImgFrame [m_nFrames];
+    _ResetCanvas();
     UINT nSize = pImage->GetPropertyItemSize(PropertyTagFrameDelay);
     SASSERT (nSize);
 
@@ -107,21 +108,34 @@ int SSkinGif::LoadFromGdipImage( Gdiplus::Bitmap * pImage )
         free(pPropertyItem);
     }
     
+    //һ֡أһ֡ȱ仯Сֻ֡仯
+    SIZE szFrame={(LONG)pImage->GetWidth(),(LONG)pImage->GetHeight()};
+    UINT nFrameSize = szFrame.cx*szFrame.cy*4;
+    LPBYTE pPrevBits = (LPBYTE)malloc(nFrameSize);
+    if(!pPrevBits)
+    {
+        delete []m_pFrames;
+        m_pFrames = NULL;
+        m_nFrames = 0;
+        return 0;
+    }
     for(int i=0;i<m_nFrames;i++)
     {
-        GETRENDERFACTORY->CreateBitmap(&m_pFrames[i].pBmp);
         pImage->SelectActiveFrame(&FrameDimensionTime,i);
-        Bitmap bmp(pImage->GetWidth(),pImage->GetHeight(),PixelFormat32bppPARGB);
+        Bitmap bmp(szFrame.cx,szFrame.cy,PixelFormat32bppPARGB);
         Graphics g(&bmp);
         g.DrawImage(pImage,0,0);
         Gdiplus::Rect rc;
-        rc.Width=pImage->GetWidth();
-        rc.Height=pImage->GetHeight();
+        rc.Width=szFrame.cx;
+        rc.Height=szFrame.cy;
         BitmapData data;
         bmp.LockBits(&rc,0,PixelFormat32bppPARGB,&data);
-        m_pFrames[i].pBmp->Init(data.Width,data.Height,data.Scan0);
+        SASSERT(data.Stride == szFrame.cx*4);
+        _SetFramePixels(i,szFrame,(const BYTE*)data.Scan0,i>0?pPrevBits:NULL);
+        memcpy(pPrevBits,data.Scan0,nFrameSize);
         bmp.UnlockBits(&data);
     }
+    free(pPrevBits);
     return m_nFrames;
 }
 
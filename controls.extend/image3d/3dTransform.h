@@ -58,6 +58,16 @@ namespace IMAGE3D
 		// Parameter: int nBitsPixel:ȣֻ֧2432λָʽ
 		//************************************
 		BOOL SetImage(LPBYTE pSour,LPBYTE pDest,int nWid,int nHei,int nBitsPixel);
+
+		//************************************
+		// Method:    EnableSSE2
+		// FullName:  IMAGE3D::C3DTransform::EnableSSE2
+		// Access:    public 
+		// Returns:   void
+		// Qualifier:
+		// Parameter: bool bEnable : ǷʹSSE2ָȾCPU֧ʱЧĬ֧ʱʹãرպʹñ
+		//************************************
+		void EnableSSE2(bool bEnable);
 	protected:
 		void  Initialize();
 		void  GetQuadByAnimateValue(int nDegreeX, int nDegreeY, int nDegreeZ, int nZOffset, Quad* pOut);
@@ -68,6 +78,7 @@ namespace IMAGE3D
 		int		m_nSrcPitch;
 		LPBYTE  m_pSrcBits;
 		LPBYTE  m_pDstBits;
+		bool    m_bSSE2;
 	};
 
 }
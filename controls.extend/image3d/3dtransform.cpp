@@ -5,7 +5,14 @@
 #include <float.h>
 #include <malloc.h>
 
+#if defined(_M_IX86) || defined(_M_X64)
+#define IMAGE3D_SSE2
+#include <emmintrin.h>
+#endif
+
 bool  g_bInitSinCosTable = false;
+static bool  s_bSSE2 = false;		// ǷʹSSE2ָ
+static int   s_nCpuCount = 1;
 
 #define STRIDELEN(WID,BITPIXEL) ((WID*BITPIXEL+31)/32*4)
 namespace IMAGE3D
@@ -21,11 +28,27 @@ void  C3DTransform::Initialize()
 
     if (false == g_bInitSinCosTable)
     {
-        _control87(_MCW_RC, _RC_DOWN); //FPUģʽBilinearҪʹûӿfloat->int
+        _control87(_MCW_RC, _RC_DOWN); //FPUģʽRenderĹ̻߳ʹͬģʽ
 
         Build_Sin_Cos_Tables();
+
+#if defined(_M_X64)
+        s_bSSE2 = true;
+#elif defined(_M_IX86)
+        s_bSSE2 = !!IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+#endif
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        s_nCpuCount = max((int)si.dwNumberOfProcessors, 1);
+
         g_bInitSinCosTable = true;
     }
+    m_bSSE2 = s_bSSE2;
+}
+
+void C3DTransform::EnableSSE2(bool bEnable)
+{
+    m_bSSE2 = bEnable && s_bSSE2;
 }
 
 // ʹ3Dͼ㷨ȡͼƬתĸλ
@@ -187,6 +210,221 @@ void C3DTransform::GetQuadByAnimateValue(int nDegreeX, int nDegreeY, int nDegree
 #define GetLine(pBits, nPitch,y) \
 	(pBits + nPitch*(y))
 
+#define MIN_BAND_PIXELS		(256*256)	// ÿдٵͼƬСʱֵô߳
+#define MAX_RENDER_BANDS	8			// ֳɵд
+
+	// Ⱦһ֡ҪĲд
+	struct RENDERCONTEXT
+	{
+		int     A, B, C;		// ʽ͸ӱ任ϵ
+		int     D, E, F;
+		int     G, H, I;
+		LPBYTE  pSrcBits;
+		int     nSrcPitch;
+		int     nPixByte;
+		LPBYTE  pDstBits;
+		int     nDstPitch;
+		int     nMinX, nMaxX;	// ҪзΧ[nMinX,nMaxX)
+		int     nWidthDst;
+		int     nHeightDst;
+		bool    bSSE2;
+		unsigned int uFpCtrl;	// ̵߳ĸ֣߳ʹͬģʽ֤뵥߳һ
+	};
+
+	// һд[nBeginY,nEndY)
+	struct RENDERBAND
+	{
+		const RENDERCONTEXT * pCtx;
+		int     nBeginY;
+		int     nEndY;
+		volatile LONG * pnPending;	// δɵĹ߳д
+		HANDLE  hDone;				// й߳дʱ
+	};
+
+	//
+	// ԲֵʽƵ
+	// http://blog.csdn.net/dakistudio/article/details/1767100 ԲֵʽƵ
+	//
+	// ѽԭʼͼƬright/bottom1pxڻȡ x+1, y+1ʱﵽԵҲ
+	// ȡĸصɫֵ(x,y) (x+1, y) (x, y+1) (x+1, y+1)
+	//
+	static inline void BilinearPixel(const RENDERCONTEXT & ctx, LPBYTE pDest, float fxSrc, float fySrc)
+	{
+		// ȡ(int)0ȡҪټ1
+		int nx = (int)fxSrc;
+		if (fxSrc < nx) nx--;
+		int ny = (int)fySrc;
+		if (fySrc < ny) ny--;
+
+		// heightΪ300ySrc=299.99999999ʱת(int)õĽ300˵ySrc>299ʱ˳
+		if (nx < 0 || nx >= ctx.nWidthDst || ny < 0 || ny >= ctx.nHeightDst)
+			return;
+
+		LPBYTE pValue=GetLine(ctx.pSrcBits, ctx.nSrcPitch, ny);
+		pValue += nx*ctx.nPixByte;
+
+		LPBYTE p0=pValue;//(x,y);
+		LPBYTE p2=pValue+ctx.nPixByte;//(x+1,y)
+		pValue+=ctx.nSrcPitch;//y+1
+		LPBYTE p1=pValue;//(x,y+1)
+		LPBYTE p3=pValue+ctx.nPixByte;//(x+1,y+1)
+
+		// ˷תΪ˷
+		float u = fxSrc - nx;
+		float v = fySrc - ny;
+		int pm3_16 = int(FLOAT_TO_FIXP16(u*v));
+		int pm2_16 = int(FLOAT_TO_FIXP16(u*(1.0f-v)));
+		int pm1_16 = int(FLOAT_TO_FIXP16(v*(1.0f-u)));
+		int pm0_16 = int(FLOAT_TO_FIXP16((1.0f-u)*(1.0f-v)));
+
+		for (int i = 0; i < ctx.nPixByte; i++)
+		{
+			*pDest++=(BYTE)((pm0_16*(*p0++) + pm1_16*(*p1++) + pm2_16*(*p2++) + pm3_16*(*p3++)) >> FIXP16_SHIFT);
+		}
+	}
+
+	// һ[nBeginX,nEndX)
+	// ͸ӱ任ķӷĸɨ߶ԵģۼӶϵɣҪÿض˷
+	static void RenderSpan(const RENDERCONTEXT & ctx, int Y, int nBeginX, int nEndX, LPBYTE pDstRow)
+	{
+		int nU = nBeginX*ctx.A + Y*ctx.B + ctx.C;
+		int nV = nBeginX*ctx.D + Y*ctx.E + ctx.F;
+		int nW = nBeginX*ctx.G + Y*ctx.H + ctx.I;
+		LPBYTE pDest = pDstRow + nBeginX*ctx.nPixByte;
+		for (int X = nBeginX; X < nEndX; X++)
+		{
+			float m = 1.0f / nW;
+			BilinearPixel(ctx, pDest, m * nU, m * nV);
+			nU += ctx.A;
+			nV += ctx.D;
+			nW += ctx.G;
+			pDest += ctx.nPixByte;
+		}
+	}
+
+#ifdef IMAGE3D_SSE2
+	// һ32λչΪ4float
+	static inline __m128 LoadPixelSSE2(const BYTE * p)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i c = _mm_cvtsi32_si128(*(const int*)p);
+		c = _mm_unpacklo_epi8(c, zero);
+		c = _mm_unpacklo_epi16(c, zero);
+		return _mm_cvtepi32_ps(c);
+	}
+
+	// 4ͨͬʱֵȨǲ65538ֵ255˻ͶС2^24
+	// floatûȫһ
+	static inline void BilinearPixelSSE2(const RENDERCONTEXT & ctx, LPBYTE pDest, int nx, int ny, const float * pWeight)
+	{
+		const BYTE * p0 = GetLine(ctx.pSrcBits, ctx.nSrcPitch, ny) + nx*4;
+		const BYTE * p1 = p0 + ctx.nSrcPitch;
+
+		__m128 sum = _mm_mul_ps(LoadPixelSSE2(p0), _mm_set1_ps(pWeight[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(p1), _mm_set1_ps(pWeight[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(p0+4), _mm_set1_ps(pWeight[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(p1+4), _mm_set1_ps(pWeight[3])));
+
+		__m128i c = _mm_srli_epi32(_mm_cvttps_epi32(sum), FIXP16_SHIFT);
+		c = _mm_packs_epi32(c, c);
+		c = _mm_packus_epi16(c, c);
+		*(int*)pDest = _mm_cvtsi128_si32(c);
+	}
+
+	// ȡģʽ޹
+	static inline __m128i FloorSSE2(__m128 f)
+	{
+		__m128i n = _mm_cvttps_epi32(f);
+		__m128 mask = _mm_cmplt_ps(f, _mm_cvtepi32_ps(n));
+		return _mm_add_epi32(n, _mm_castps_si128(mask));	// maskΪ-1ʱ1
+	}
+
+	static inline __m128i WeightSSE2(__m128 w)
+	{
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, _mm_set1_ps((float)FIXP16_MAG)), _mm_set1_ps(0.5f)));
+	}
+
+	// 32λصһУÿμ4صԴͲֵȨ
+	static void RenderRowSSE2(const RENDERCONTEXT & ctx, int Y, LPBYTE pDstRow)
+	{
+		int X = ctx.nMinX;
+		int nU = X*ctx.A + Y*ctx.B + ctx.C;
+		int nV = X*ctx.D + Y*ctx.E + ctx.F;
+		int nW = X*ctx.G + Y*ctx.H + ctx.I;
+		__m128i vU = _mm_setr_epi32(nU, nU+ctx.A, nU+2*ctx.A, nU+3*ctx.A);
+		__m128i vV = _mm_setr_epi32(nV, nV+ctx.D, nV+2*ctx.D, nV+3*ctx.D);
+		__m128i vW = _mm_setr_epi32(nW, nW+ctx.G, nW+2*ctx.G, nW+3*ctx.G);
+		const __m128i vStepU = _mm_set1_epi32(4*ctx.A);
+		const __m128i vStepV = _mm_set1_epi32(4*ctx.D);
+		const __m128i vStepW = _mm_set1_epi32(4*ctx.G);
+		const __m128 vOne = _mm_set1_ps(1.0f);
+
+		int   anx[4], any[4];
+		float aw0[4], aw1[4], aw2[4], aw3[4];
+		for (; X + 4 <= ctx.nMaxX; X += 4)
+		{
+			__m128 m = _mm_div_ps(vOne, _mm_cvtepi32_ps(vW));	// һγõ4صĵ
+			__m128 fx = _mm_mul_ps(m, _mm_cvtepi32_ps(vU));
+			__m128 fy = _mm_mul_ps(m, _mm_cvtepi32_ps(vV));
+			__m128i nx = FloorSSE2(fx);
+			__m128i ny = FloorSSE2(fy);
+			__m128 u = _mm_sub_ps(fx, _mm_cvtepi32_ps(nx));
+			__m128 v = _mm_sub_ps(fy, _mm_cvtepi32_ps(ny));
+			__m128 u1 = _mm_sub_ps(vOne, u);
+			__m128 v1 = _mm_sub_ps(vOne, v);
+
+			_mm_storeu_si128((__m128i*)anx, nx);
+			_mm_storeu_si128((__m128i*)any, ny);
+			_mm_storeu_ps(aw0, _mm_cvtepi32_ps(WeightSSE2(_mm_mul_ps(u1, v1))));
+			_mm_storeu_ps(aw1, _mm_cvtepi32_ps(WeightSSE2(_mm_mul_ps(v, u1))));
+			_mm_storeu_ps(aw2, _mm_cvtepi32_ps(WeightSSE2(_mm_mul_ps(u, v1))));
+			_mm_storeu_ps(aw3, _mm_cvtepi32_ps(WeightSSE2(_mm_mul_ps(u, v))));
+
+			for (int i = 0; i < 4; i++)
+			{
+				if (anx[i] < 0 || anx[i] >= ctx.nWidthDst || any[i] < 0 || any[i] >= ctx.nHeightDst)
+					continue;
+				float aw[4] = {aw0[i], aw1[i], aw2[i], aw3[i]};
+				BilinearPixelSSE2(ctx, pDstRow + (X+i)*4, anx[i], any[i], aw);
+			}
+
+			vU = _mm_add_epi32(vU, vStepU);
+			vV = _mm_add_epi32(vV, vStepV);
+			vW = _mm_add_epi32(vW, vStepW);
+		}
+		// ʣ಻4
+		RenderSpan(ctx, Y, X, ctx.nMaxX, pDstRow);
+	}
+#endif//IMAGE3D_SSE2
+
+	static void RenderBand(const RENDERBAND & band)
+	{
+		const RENDERCONTEXT & ctx = *band.pCtx;
+		LPBYTE pDstRow = GetLine(ctx.pDstBits, ctx.nDstPitch, band.nBeginY);
+		for (int Y = band.nBeginY; Y < band.nEndY; Y++)
+		{
+#ifdef IMAGE3D_SSE2
+			if (ctx.bSSE2 && ctx.nPixByte == 4)
+				RenderRowSSE2(ctx, Y, pDstRow);
+			else
+#endif
+				RenderSpan(ctx, Y, ctx.nMinX, ctx.nMaxX, pDstRow);
+			pDstRow += ctx.nDstPitch;
+		}
+	}
+
+	// ϵͳִ̳߳У߳ǸõģȾɺָԭģʽ
+	static DWORD WINAPI RenderBandProc(LPVOID pParam)
+	{
+		RENDERBAND * pBand = (RENDERBAND*)pParam;
+		unsigned int uFpCtrl = _control87(0, 0);
+		_control87(pBand->pCtx->uFpCtrl, _MCW_RC);
+		RenderBand(*pBand);
+		_control87(uFpCtrl, _MCW_RC);
+		if (InterlockedDecrement(pBand->pnPending) == 0)
+			SetEvent(pBand->hDone);
+		return 0;
+	}
 
 void C3DTransform::Render(const PARAM3DTRANSFORM & param3d)
 {
@@ -206,131 +444,71 @@ void C3DTransform::Render(const PARAM3DTRANSFORM & param3d)
 
 	int nDstPitch = nWidthDst*4;
 
-	float fxSrc = 0;
-	float fySrc = 0;
-	float *pfxSrc = &fxSrc;  // Ϊperspective_transformʹָ
-	float *pfySrc = &fySrc;
-
-	LPBYTE pDstBits=m_pDstBits;
-	
-	int nPixByte=m_nBitsPixel/8;
-
-#if 1  // ڴѭ֮ǰ޳һЩհ
 	//ĿͼƬ
-	memset(pDstBits, 0, nDstPitch * nHeightDst);
-
-	int nMinX = max(0, min(min(min(quad.Ax,quad.Bx),quad.Cx),quad.Dx));
+	memset(m_pDstBits, 0, nDstPitch * nHeightDst);
+
+	RENDERCONTEXT ctx;
+	ctx.A = perspective.A_16; ctx.B = perspective.B_16; ctx.C = perspective.C_16;
+	ctx.D = perspective.D_16; ctx.E = perspective.E_16; ctx.F = perspective.F_16;
+	ctx.G = perspective.G_16; ctx.H = perspective.H_16; ctx.I = perspective.I_16;
+	ctx.pSrcBits = m_pSrcBits;
+	ctx.nSrcPitch = m_nSrcPitch;
+	ctx.nPixByte = m_nBitsPixel/8;
+	ctx.pDstBits = m_pDstBits;
+	ctx.nDstPitch = nDstPitch;
+	ctx.nWidthDst = nWidthDst;
+	ctx.nHeightDst = nHeightDst;
+	ctx.bSSE2 = m_bSSE2;
+	ctx.uFpCtrl = _control87(0, 0);
+
+	// ڴѭ֮ǰ޳һЩհ
+	ctx.nMinX = max(0, min(min(min(quad.Ax,quad.Bx),quad.Cx),quad.Dx));
+	ctx.nMaxX = min(nWidthDst,  max(max(max(quad.Ax,quad.Bx),quad.Cx),quad.Dx));
 	int nMinY = max(0, min(min(min(quad.Ay,quad.By),quad.Cy),quad.Dy));
-	int nMaxX = min(nWidthDst,  max(max(max(quad.Ax,quad.Bx),quad.Cx),quad.Dx));
 	int nMaxY = min(nHeightDst, max(max(max(quad.Ay,quad.By),quad.Cy),quad.Dy));
+	if (ctx.nMinX >= ctx.nMaxX || nMinY >= nMaxY)
+		return;
 
-	
-	pDstBits += (nMinY*nDstPitch);
-	for (int Y = nMinY; Y < nMaxY; Y++)
-	{
-		LPBYTE pDest=pDstBits;
-		for (int X = nMinX; X < nMaxX; X++)
-		{
-#else
-	for (int X = 0, Y = 0; Y < m_nSrcWndHeight; Y++)
-	{
-		for (X = 0; X < m_nSrcWndWidth; X++)
-		{
-#endif
-			perspective_transform_fp(perspective, X, Y, pfxSrc, pfySrc);
-
-			int nx = 0; //fx;   // ע: ֱӸֵ int i = floatvalue; һ _ftol()
-			int ny = 0; //fy;   //     Чʽ͡ʹǶָ(3DϷ̴ʦ P918)
-
-			// ת ע⣺ĬϵfistpģʽҪͨ_control87(_MCW_RC, _RC_DOWN);е
-#ifndef _WIN64
-			__asm	fld    fxSrc;
-			__asm	fistp  nx;
-
-			__asm	fld    fySrc;
-			__asm	fistp  ny;
-#else
-            nx = int(fxSrc);
-            ny = int(fySrc);
-#endif//WIN32
-
-			// 1. ceilЧʷǳǳ!ǧ
-			// һheightΪ300ySrc=299.99999999ʱת(int)õĽ300
-			// жϵĻǳɹģ˵ySrc>299ʱ˳
-			if (nx < 0 || nx >= nWidthDst || ny < 0 || ny >= nHeightDst)
-			{        
-				continue;
-			}
+	// зֳɶдÿ߳Ⱦһдǰ߳Ⱦһ
+	// ߳ϵͳ̳߳أỵ̈֡߳ͼƬСʱֻõǰ߳
+	int nBands = (ctx.nMaxX - ctx.nMinX) * (nMaxY - nMinY) / MIN_BAND_PIXELS;
+	nBands = min(nBands, min(s_nCpuCount, MAX_RENDER_BANDS));
+	nBands = max(nBands, 1);
 
-			// ĿԴͼضӦ
-#if 0
-			//////////////////////////////////////////////////////////////////////////
-			// ڽȡ, ٶȿ죬о
-			((DWORD*)pDstBits)[X] = ((DWORD*)(m_pSrcBits + m_nSrcPitch*(int)ySrc))[(int)xSrc];
-#else
-			//////////////////////////////////////////////////////////////////////////
-			// ԲֵЧȥݣٶȷǳ
-			//((DWORD*)pDstBits)[X] = Bilinear(m_pSrcBits, m_nSrcPitch, nx, ny, (float)fxSrc, (float)fySrc);
-
-			//
-			// ԲֵʽƵ
-			// http://blog.csdn.net/dakistudio/article/details/1767100 ԲֵʽƵ
-			//
-			// xΪfxȡyΪfyȡ
-			//
-			//inline DWORD& Bilinear(BYTE* pBits, const int& nPitch, const int& x, const int& y, const float& fx, const float& fy)
-			{
-				// ѽԭʼͼƬright/bottom1pxڻȡ x+1, y+1ʱﵽԵҲ
-				// ȡĸصɫֵ(x,y) (x+1, y) (x, y+1) (x+1, y+1)
-
-				LPBYTE pValue=GetLine(m_pSrcBits, m_nSrcPitch, ny);
-				pValue += nx*nPixByte;
+	HANDLE hDone = NULL;
+	if (nBands > 1)
+	{
+		hDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (!hDone) nBands = 1;
+	}
 
-				LPBYTE p0=pValue;//(x,y);
-				LPBYTE p2=pValue+nPixByte;//(x+1,y)
-				pValue+=m_nSrcPitch;//y+1
-				LPBYTE p1=pValue;//(x,y+1)
-				LPBYTE p3=pValue+nPixByte;//(x+1,y+1)
+	// ȼй߳дύǰɵд¼
+	volatile LONG nPending = nBands;
+	RENDERBAND bands[MAX_RENDER_BANDS];
+	for (int i = 0; i < nBands; i++)
+	{
+		bands[i].pCtx = &ctx;
+		bands[i].nBeginY = nMinY + (nMaxY - nMinY) * i / nBands;
+		bands[i].nEndY = nMinY + (nMaxY - nMinY) * (i + 1) / nBands;
+		bands[i].pnPending = &nPending;
+		bands[i].hDone = hDone;
+	}
 
-				// ˷תΪ˷ͬʱŻת
-				float u = (float)fxSrc - nx;
-				float v = (float)fySrc - ny;
-			
-#ifndef _WIN64
-				float fpm3 = FLOAT_TO_FIXP16(u*v);
-				float fpm2 = FLOAT_TO_FIXP16(u*(1.0f-v));
-				float fpm1 = FLOAT_TO_FIXP16(v*(1.0f-u));
-				float fpm0 = FLOAT_TO_FIXP16((1.0f-u)*(1.0f-v));
-				int pm3_16 = 0;
-				int pm2_16 = 0;
-				int pm1_16 = 0;
-				int pm0_16 = 0;
-				__asm
-				{
-					fld    fpm3;
-					fistp  pm3_16;
-					fld    fpm2;
-					fistp  pm2_16;
-					fld    fpm1;
-					fistp  pm1_16;
-					fld    fpm0;
-					fistp  pm0_16;
-				}
-#else
-                int pm3_16 = int(FLOAT_TO_FIXP16(u*v));
-                int pm2_16 = int(FLOAT_TO_FIXP16(u*(1.0f-v)));
-                int pm1_16 = int(FLOAT_TO_FIXP16(v*(1.0f-u)));
-                int pm0_16 = int(FLOAT_TO_FIXP16((1.0f-u)*(1.0f-v)));
-#endif//WIN32
-                pDest = pDstBits + X * nPixByte;
-				*pDest++=(BYTE)((pm0_16*(*p0++) + pm1_16*(*p1++) + pm2_16*(*p2++) + pm3_16*(*p3++)) >> FIXP16_SHIFT);
-				*pDest++=(BYTE)((pm0_16*(*p0++) + pm1_16*(*p1++) + pm2_16*(*p2++) + pm3_16*(*p3++)) >> FIXP16_SHIFT);
-				*pDest++=(BYTE)((pm0_16*(*p0++) + pm1_16*(*p1++) + pm2_16*(*p2++) + pm3_16*(*p3++)) >> FIXP16_SHIFT);
-				if(nPixByte==4) *pDest++=(BYTE)((pm0_16*(*p0++) + pm1_16*(*p1++) + pm2_16*(*p2++) + pm3_16*(*p3++)) >> FIXP16_SHIFT);
-			}
-#endif
+	for (int i = 1; i < nBands; i++)
+	{
+		if (!QueueUserWorkItem(RenderBandProc, &bands[i], WT_EXECUTEDEFAULT))
+		{
+			RenderBand(bands[i]);	// ύʧʱڵǰ߳Ⱦ
+			InterlockedDecrement(&nPending);
 		}
-		pDstBits += nDstPitch;
+	}
+	RenderBand(bands[0]);
+
+	if (hDone)
+	{
+		if (InterlockedDecrement(&nPending) != 0)
+			WaitForSingleObject(hDone, INFINITE);
+		CloseHandle(hDone);
 	}
 }
 
@@ -0,0 +1,414 @@
+#include "stdafx.h"
+#include "SSqliteAdapter.h"
+#include <helper/SplitString.h>
+#include <process.h>
+
+namespace SOUI
+{
+    const static int KPrefetchBusyTimeout = 100;  //Ԥдʱĵȴʱ(ms)
+
+    SSqliteRowSource::SSqliteRowSource()
+        :m_nCount(0)
+        ,m_nPageSize(256)
+        ,m_nMaxPages(64)
+        ,m_nPrefetchPages(2)
+        ,m_dwGeneration(0)
+        ,m_iLastPage(-1)
+        ,m_nDirection(1)
+        ,m_hThread(NULL)
+        ,m_bPrefetching(FALSE)
+    {
+        memset(&m_stats,0,sizeof(m_stats));
+        memset(&m_queryUi,0,sizeof(m_queryUi));
+        memset(&m_queryPrefetch,0,sizeof(m_queryPrefetch));
+    }
+
+    SSqliteRowSource::~SSqliteRowSource()
+    {
+        Close();
+    }
+
+    SStringW SSqliteRowSource::QuoteName(const SStringW & strName)
+    {
+        if(strName.IsEmpty()) return SStringW();
+        SStringW strRet = strName;
+        strRet.Replace(L"\"",L"\"\"");
+        return L"\"" + strRet + L"\"";
+    }
+
+    BOOL SSqliteRowSource::Open(sqlite3 *pDb,LPCWSTR pszTable,LPCWSTR pszColumns,LPCWSTR pszKey)
+    {
+        Close();
+
+        SStringW strTable = QuoteName(pszTable);
+        SStringW strKey = QuoteName(pszKey);
+        SStringW strColumns;
+        SStringWList lstCols;
+        SplitString(SStringW(pszColumns),L',',lstCols);
+        for(size_t i=0;i<lstCols.GetCount();i++)
+        {
+            lstCols[i].TrimBlank();
+            if(lstCols[i].IsEmpty()) return FALSE;
+            if(!strColumns.IsEmpty()) strColumns += L",";
+            strColumns += QuoteName(lstCols[i]);
+        }
+        if(strTable.IsEmpty() || strKey.IsEmpty() || strColumns.IsEmpty()) return FALSE;
+
+        m_strOffsetSql.Format(L"SELECT %s,%s FROM %s ORDER BY %s LIMIT ? OFFSET ?",
+            (LPCWSTR)strKey,(LPCWSTR)strColumns,(LPCWSTR)strTable,(LPCWSTR)strKey);
+        m_strKeysetSql.Format(L"SELECT %s,%s FROM %s WHERE %s>? ORDER BY %s LIMIT ?",
+            (LPCWSTR)strKey,(LPCWSTR)strColumns,(LPCWSTR)strTable,(LPCWSTR)strKey,(LPCWSTR)strKey);
+        if(!_PrepareQuery(m_queryUi,pDb)) return FALSE;
+
+        //sqliteҲ˫ֵַҪÿһжԱ(third-part/sqlite3ʹSQLITE_ENABLE_COLUMN_METADATA)
+        int nCols = sqlite3_column_count(m_queryUi.pStmtOffset);
+        for(int i=0;i<nCols;i++)
+        {
+            if(!sqlite3_column_table_name16(m_queryUi.pStmtOffset,i))
+            {
+                _FinalizeQuery(m_queryUi);
+                return FALSE;
+            }
+        }
+        //0Ϊkey
+        for(int i=1;i<nCols;i++)
+        {
+            m_arrColNames.Add((const wchar_t*)sqlite3_column_name16(m_queryUi.pStmtOffset,i));
+        }
+        m_strCountSql.Format(L"SELECT COUNT(*) FROM %s",(LPCWSTR)strTable);
+
+        //ԤʹöֻӣڴݿߴʧʱԤ
+        const char *pszFile = sqlite3_db_filename(pDb,"main");
+        if(pszFile && pszFile[0])
+        {
+            sqlite3 *pDbPrefetch = NULL;
+            if(sqlite3_open_v2(pszFile,&pDbPrefetch,SQLITE_OPEN_READONLY,NULL) == SQLITE_OK)
+            {
+                sqlite3_busy_timeout(pDbPrefetch,KPrefetchBusyTimeout);
+                if(!_PrepareQuery(m_queryPrefetch,pDbPrefetch)) sqlite3_close(pDbPrefetch);
+            }else if(pDbPrefetch)
+            {
+                sqlite3_close(pDbPrefetch);
+            }
+        }
+        Refresh();
+        return TRUE;
+    }
+
+    BOOL SSqliteRowSource::_PrepareQuery(PAGEQUERY & query,sqlite3 *pDb)
+    {
+        if(sqlite3_prepare16_v2(pDb,(LPCWSTR)m_strOffsetSql,-1,&query.pStmtOffset,NULL) != SQLITE_OK
+            || sqlite3_prepare16_v2(pDb,(LPCWSTR)m_strKeysetSql,-1,&query.pStmtKeyset,NULL) != SQLITE_OK)
+        {
+            _FinalizeQuery(query);
+            return FALSE;
+        }
+        query.pDb = pDb;
+        return TRUE;
+    }
+
+    void SSqliteRowSource::_FinalizeQuery(PAGEQUERY & query)
+    {
+        if(query.pStmtOffset) sqlite3_finalize(query.pStmtOffset);
+        if(query.pStmtKeyset) sqlite3_finalize(query.pStmtKeyset);
+        memset(&query,0,sizeof(query));
+    }
+
+    void SSqliteRowSource::Close()
+    {
+        _StopPrefetch();
+        {
+            SAutoLock lock(m_cs);
+            _RemoveAllPages();
+        }
+        //Ԥ߳Ѿ˳Ԥر
+        sqlite3 *pDbPrefetch = m_queryPrefetch.pDb;
+        _FinalizeQuery(m_queryPrefetch);
+        if(pDbPrefetch) sqlite3_close(pDbPrefetch);
+
+        SAutoLock lock(m_csDb);
+        _FinalizeQuery(m_queryUi);
+        m_arrColNames.RemoveAll();
+        m_nCount = 0;
+    }
+
+    void SSqliteRowSource::Refresh()
+    {
+        int nCount = 0;
+        {
+            SAutoLock lock(m_csDb);
+            if(!m_queryUi.pDb) return;
+            sqlite3_stmt *pStmt = NULL;
+            if(sqlite3_prepare16_v2(m_queryUi.pDb,(LPCWSTR)m_strCountSql,-1,&pStmt,NULL) == SQLITE_OK)
+            {
+                if(sqlite3_step(pStmt) == SQLITE_ROW) nCount = sqlite3_column_int(pStmt,0);
+                sqlite3_finalize(pStmt);
+            }
+        }
+        SAutoLock lock(m_cs);
+        _RemoveAllPages();
+        m_nCount = nCount;
+    }
+
+    SStringW SSqliteRowSource::GetColumnName(int iCol) const
+    {
+        if(iCol<0 || iCol>=(int)m_arrColNames.GetCount()) return SStringW();
+        return m_arrColNames[iCol];
+    }
+
+    void SSqliteRowSource::SetPageSize(int nRows)
+    {
+        SASSERT(!m_queryUi.pDb);
+        if(nRows > 0) m_nPageSize = nRows;
+    }
+
+    void SSqliteRowSource::SetMaxPages(int nPages)
+    {
+        SAutoLock lock(m_cs);
+        m_nMaxPages = smax(nPages,1);
+    }
+
+    void SSqliteRowSource::SetPrefetchPages(int nPages)
+    {
+        SAutoLock lock(m_cs);
+        m_nPrefetchPages = smax(nPages,0);
+    }
+
+    void SSqliteRowSource::GetStats(SSqliteRowStats & stats)
+    {
+        SAutoLock lock(m_cs);
+        stats = m_stats;
+    }
+
+    void SSqliteRowSource::ResetStats()
+    {
+        SAutoLock lock(m_cs);
+        LONG nPages = m_stats.nPages;
+        memset(&m_stats,0,sizeof(m_stats));
+        m_stats.nPages = nPages;
+    }
+
+    BOOL SSqliteRowSource::GetRow(int iRow,SArray<SStringW> & arrValues,__int64 *pKey)
+    {
+        if(iRow<0 || iRow>=m_nCount) return FALSE;
+        int iPage = iRow/m_nPageSize;
+        BOOL bHit = FALSE;
+        {
+            SAutoLock lock(m_cs);
+            bHit = _CopyRow(iRow,arrValues,pKey);
+            if(bHit) m_stats.nHits++;
+            else m_stats.nMisses++;
+            _QueuePrefetch(iPage);
+        }
+        if(bHit) return TRUE;
+
+        ROWPAGE *pPage = NULL;
+        {
+            SAutoLock lock(m_csDb);
+            if(m_queryUi.pDb) pPage = _LoadPage(iPage,m_queryUi);
+        }
+        if(!pPage) return FALSE;
+        SAutoLock lock(m_cs);
+        _AddPage(pPage);
+        return _CopyRow(iRow,arrValues,pKey);
+    }
+
+    SSqliteRowSource::ROWPAGE * SSqliteRowSource::_LoadPage(int iPage,PAGEQUERY & query)
+    {
+        ROWPAGE *pPage = new ROWPAGE;
+        pPage->iPage = iPage;
+        pPage->nRows = 0;
+        BOOL bKeyset = FALSE;
+        __int64 llAfter = 0;
+        {
+            SAutoLock lock(m_cs);
+            pPage->dwGeneration = m_dwGeneration;
+            SMap<int,__int64>::CPair *p = m_mapAnchors.Lookup(iPage);
+            if(p)
+            {
+                bKeyset = TRUE;
+                llAfter = p->m_value;
+            }
+        }
+
+        int nCols = (int)m_arrColNames.GetCount();
+        pPage->pKeys = new __int64[m_nPageSize];
+        pPage->pValues = new SStringW[m_nPageSize*nCols];
+
+        sqlite3_stmt *pStmt = bKeyset?query.pStmtKeyset:query.pStmtOffset;
+        if(bKeyset)
+        {
+            sqlite3_bind_int64(pStmt,1,llAfter);
+            sqlite3_bind_int(pStmt,2,m_nPageSize);
+        }else
+        {
+            sqlite3_bind_int(pStmt,1,m_nPageSize);
+            sqlite3_bind_int64(pStmt,2,(__int64)iPage*m_nPageSize);
+        }
+        int nRet = SQLITE_DONE;
+        while(pPage->nRows < m_nPageSize && (nRet = sqlite3_step(pStmt)) == SQLITE_ROW)
+        {
+            pPage->pKeys[pPage->nRows] = sqlite3_column_int64(pStmt,0);
+            SStringW *pValues = pPage->pValues + pPage->nRows*nCols;
+            for(int i=0;i<nCols;i++)
+            {
+                const wchar_t *pszValue = (const wchar_t*)sqlite3_column_text16(pStmt,i+1);
+                if(pszValue) pValues[i] = SStringW(pszValue,sqlite3_column_bytes16(pStmt,i+1)/sizeof(wchar_t));
+            }
+            pPage->nRows++;
+        }
+        sqlite3_reset(pStmt);
+        if(nRet != SQLITE_ROW && nRet != SQLITE_DONE)
+        {//ݿæ߳治ҳ
+            _FreePage(pPage);
+            return NULL;
+        }
+
+        if(pPage->nRows == m_nPageSize)
+        {//¼һҳʼλ
+            SAutoLock lock(m_cs);
+            if(pPage->dwGeneration == m_dwGeneration)
+                m_mapAnchors[iPage+1] = pPage->pKeys[pPage->nRows-1];
+        }
+        return pPage;
+    }
+
+    void SSqliteRowSource::_FreePage(ROWPAGE *pPage)
+    {
+        delete []pPage->pKeys;
+        delete []pPage->pValues;
+        delete pPage;
+    }
+
+    void SSqliteRowSource::_AddPage(ROWPAGE *pPage)
+    {
+        if(pPage->dwGeneration != m_dwGeneration || m_mapPages.Lookup(pPage->iPage))
+        {//Ѿˢ£߳Ѿȡһҳ
+            _FreePage(pPage);
+            return;
+        }
+        while((int)m_lstLru.GetCount() >= m_nMaxPages)
+        {
+            ROWPAGE *pOld = m_lstLru.RemoveTail();
+            m_mapPages.RemoveKey(pOld->iPage);
+            _FreePage(pOld);
+            m_stats.nEvicted++;
+        }
+        m_mapPages[pPage->iPage] = m_lstLru.AddHead(pPage);
+        m_stats.nPages = (LONG)m_lstLru.GetCount();
+    }
+
+    BOOL SSqliteRowSource::_CopyRow(int iRow,SArray<SStringW> & arrValues,__int64 *pKey)
+    {
+        SMap<int,SPOSITION>::CPair *p = m_mapPages.Lookup(iRow/m_nPageSize);
+        if(!p) return FALSE;
+        m_lstLru.MoveToHead(p->m_value);
+        ROWPAGE *pPage = m_lstLru.GetAt(p->m_value);
+        int iPageRow = iRow%m_nPageSize;
+        if(iPageRow >= pPage->nRows) return FALSE;//Ѿı䣬ҪRefresh
+
+        int nCols = (int)m_arrColNames.GetCount();
+        arrValues.SetCount(nCols);
+        for(int i=0;i<nCols;i++)
+        {
+            arrValues[i] = pPage->pValues[iPageRow*nCols+i];
+        }
+        if(pKey) *pKey = pPage->pKeys[iPageRow];
+        return TRUE;
+    }
+
+    void SSqliteRowSource::_QueuePrefetch(int iPage)
+    {
+        if(!m_queryPrefetch.pDb) return;//ûԤ
+        int nDirection = m_nDirection;
+        if(m_iLastPage != -1 && iPage != m_iLastPage)
+            nDirection = iPage > m_iLastPage ? 1 : -1;
+        if(iPage == m_iLastPage && nDirection == m_nDirection) return;
+        if(nDirection != m_nDirection)
+        {//ı䣬ԭԤ
+            m_lstPrefetch.RemoveAll();
+        }
+        m_iLastPage = iPage;
+        m_nDirection = nDirection;
+
+        int nPages = (m_nCount + m_nPageSize - 1)/m_nPageSize;
+        for(int i=1;i<=m_nPrefetchPages;i++)
+        {
+            int iNext = iPage + i*nDirection;
+            if(iNext<0 || iNext>=nPages) break;
+            if(m_mapPages.Lookup(iNext) || m_lstPrefetch.Find(iNext)) continue;
+            m_lstPrefetch.AddTail(iNext);
+        }
+        if(m_lstPrefetch.IsEmpty() || m_bPrefetching) return;
+
+        if(m_hThread)
+        {//һ߳Ѿ˳ѭ
+            ::WaitForSingleObject(m_hThread,INFINITE);
+            ::CloseHandle(m_hThread);
+        }
+        m_hThread = (HANDLE)_beginthreadex(NULL,0,PrefetchProc,this,0,NULL);
+        m_bPrefetching = m_hThread != NULL;
+    }
+
+    unsigned int SSqliteRowSource::PrefetchProc(LPVOID pParam)
+    {
+        SSqliteRowSource *_this = (SSqliteRowSource*)pParam;
+        for(;;)
+        {
+            int iPage = -1;
+            {
+                SAutoLock lock(_this->m_cs);
+                while(!_this->m_lstPrefetch.IsEmpty())
+                {
+                    iPage = _this->m_lstPrefetch.RemoveHead();
+                    if(!_this->m_mapPages.Lookup(iPage)) break;
+                    iPage = -1;
+                }
+                if(iPage == -1)
+                {
+                    _this->m_bPrefetching = FALSE;
+                    break;
+                }
+            }
+
+            ROWPAGE *pPage = _this->_LoadPage(iPage,_this->m_queryPrefetch);
+            if(!pPage) continue;
+            SAutoLock lock(_this->m_cs);
+            _this->m_stats.nPrefetched++;
+            _this->_AddPage(pPage);
+        }
+        return 0;
+    }
+
+    void SSqliteRowSource::_StopPrefetch()
+    {
+        {
+            SAutoLock lock(m_cs);
+            m_lstPrefetch.RemoveAll();
+        }
+        if(m_hThread)
+        {
+            ::WaitForSingleObject(m_hThread,INFINITE);
+            ::CloseHandle(m_hThread);
+            m_hThread = NULL;
+        }
+        m_bPrefetching = FALSE;
+    }
+
+    void SSqliteRowSource::_RemoveAllPages()
+    {
+        SPOSITION pos = m_lstLru.GetHeadPosition();
+        while(pos)
+        {
+            _FreePage(m_lstLru.GetNext(pos));
+        }
+        m_lstLru.RemoveAll();
+        m_mapPages.RemoveAll();
+        m_mapAnchors.RemoveAll();
+        m_lstPrefetch.RemoveAll();
+        m_stats.nPages = 0;
+        m_iLastPage = -1;
+        m_dwGeneration++;
+    }
+
+}
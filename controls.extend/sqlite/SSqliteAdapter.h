@@ -0,0 +1,225 @@
+/**
+* Copyright (C) 2014-2050 SOUIŶ
+* All rights reserved.
+* 
+* @file       SSqliteAdapter.h
+* @brief      sqlite3бAdapter
+* @version    v1.0      
+* @author     soui      
+* @date       2018-07-02
+* 
+* Describe    ݰҳݿȡڴֻʹõҳʺʾϵı
+*             ʹʱҪthird-part/sqlite3
+*/
+#pragma once
+
+#include <sqlite3/sqlite3.h>
+#include <helper/SAdapterBase.h>
+#include <helper/SCriticalSection.h>
+
+namespace SOUI
+{
+    /**
+    * @struct     SSqliteRowStats
+    * @brief      лͳ
+    */
+    struct SSqliteRowStats
+    {
+        LONG    nHits;          /**<GetRowʱѾڻеĴ*/
+        LONG    nMisses;        /**<GetRowʱҪȡݿĴ*/
+        LONG    nPrefetched;    /**<̨߳Ԥҳ*/
+        LONG    nEvicted;       /**<򳬹ҳ̭ҳ*/
+        LONG    nPages;         /**<ǰҳ*/
+    };
+
+    /**
+    * @class      SSqliteRowSource
+    * @brief      ҳȡsqlite3е
+    *
+    * Describe    ݰһΨһ(ĬΪrowid)Ѿҳ¼һҳʼkey
+    *             ȡʱʹkey > ? ѯûм¼ҳʹOFFSETѯ
+    *             GetRowݷʷں̨߳Ԥҳ̨߳ʹֻʽͬһݿļĶӣ
+    *             ԤʱUI̵߳ĲѯֻܶѾύݣڴݿⲻԤ
+    *             ԤӶȡڼߵдSQLITE_BUSYߵҪbusy_timeoutʹWALģʽ
+    */
+    class SSqliteRowSource
+    {
+    public:
+        SSqliteRowSource();
+
+        ~SSqliteRowSource();
+
+        /**
+        * Open
+        * @brief    ݿеı
+        * @param    sqlite3 * pDb --  ݿӣɵClose֮ر
+        * @param    LPCWSTR pszTable --  
+        * @param    LPCWSTR pszColumns --  ʾУŷָ
+        * @param    LPCWSTR pszKey --  ΨһУͷҳ
+        * @return   BOOL
+        * Describe  ΪʶźSQLֻǱеУǱʽ
+        */
+        BOOL Open(sqlite3 *pDb,LPCWSTR pszTable,LPCWSTR pszColumns,LPCWSTR pszKey=L"rowid");
+
+        void Close();
+
+        //еݸıͳջ
+        void Refresh();
+
+        int GetCount() const {return m_nCount;}
+
+        int GetColumnCount() const {return (int)m_arrColNames.GetCount();}
+
+        SStringW GetColumnName(int iCol) const;
+
+        /**
+        * GetRow
+        * @brief    ȡһ
+        * @param    int iRow --  к
+        * @param    SArray<SStringW> & arrValues --  еı
+        * @param    __int64 * pKey --  ظеkeyΪNULL
+        * @return   BOOL
+        * Describe  вڻʱڵǰ̶߳ȡڵҳ
+        */
+        BOOL GetRow(int iRow,SArray<SStringW> & arrValues,__int64 *pKey=NULL);
+
+        //ÿҳҪOpen֮ǰ
+        void SetPageSize(int nRows);
+
+        //ҳ
+        void SetMaxPages(int nPages);
+
+        //طʷԤҳ0ʾԤ
+        void SetPrefetchPages(int nPages);
+
+        void GetStats(SSqliteRowStats & stats);
+
+        void ResetStats();
+
+        //˫ţе˫תΪ˫šΪʱؿմ
+        static SStringW QuoteName(const SStringW & strName);
+
+    protected:
+        struct ROWPAGE
+        {
+            int         iPage;
+            int         nRows;
+            DWORD       dwGeneration;
+            __int64 *   pKeys;
+            SStringW *  pValues;    /**<nRows*ֵ*/
+        };
+
+        //һݿϵķҳѯ
+        struct PAGEQUERY
+        {
+            sqlite3 *       pDb;
+            sqlite3_stmt *  pStmtOffset;
+            sqlite3_stmt *  pStmtKeyset;
+        };
+
+        static unsigned int __stdcall PrefetchProc(LPVOID pParam);
+
+        BOOL _PrepareQuery(PAGEQUERY & query,sqlite3 *pDb);
+
+        static void _FinalizeQuery(PAGEQUERY & query);
+
+        //ʹָӶȡһҳ֤߱ûб߳ʹáݿæ߳ʱNULL
+        ROWPAGE * _LoadPage(int iPage,PAGEQUERY & query);
+
+        void _FreePage(ROWPAGE *pPage);
+
+        //ºǰҪm_cs
+        void _AddPage(ROWPAGE *pPage);
+
+        BOOL _CopyRow(int iRow,SArray<SStringW> & arrValues,__int64 *pKey);
+
+        void _QueuePrefetch(int iPage);
+
+        void _RemoveAllPages();
+
+        void _StopPrefetch();
+
+        SCriticalSection            m_cs;       /**<漰Ԥ*/
+        SCriticalSection            m_csDb;     /**<m_queryUi*/
+        PAGEQUERY                   m_queryUi;      /**<ߵӣGetRowRefreshʹ*/
+        PAGEQUERY                   m_queryPrefetch;/**<Ԥ̶߳ռֻӣOpen*/
+        SStringW                    m_strOffsetSql;
+        SStringW                    m_strKeysetSql;
+        SStringW                    m_strCountSql;
+        SArray<SStringW>            m_arrColNames;
+        int                         m_nCount;
+        int                         m_nPageSize;
+        int                         m_nMaxPages;
+        int                         m_nPrefetchPages;
+
+        SList<ROWPAGE*>             m_lstLru;       /**<ͷΪʹõҳ*/
+        SMap<int,SPOSITION>         m_mapPages;
+        SMap<int,__int64>           m_mapAnchors;   /**<ҳ->һҳһеkey*/
+        DWORD                       m_dwGeneration; /**<Refreshʱӣ֮ǰȡҳ*/
+
+        SList<int>                  m_lstPrefetch;  /**<ȴԤҳ*/
+        int                         m_iLastPage;
+        int                         m_nDirection;   /**<1:, -1:*/
+        HANDLE                      m_hThread;
+        BOOL                        m_bPrefetching;
+        SSqliteRowStats             m_stats;
+    };
+
+    /**
+    * @class      SSqliteAdapterT
+    * @brief      ʾsqlite3Adapter
+    *
+    * Describe    ģʾеĴôڵıΪеֵ
+    *             SSqliteLvAdapterSListViewSSqliteMcAdapterSMCListView
+    */
+    template<class BaseClass>
+    class SSqliteAdapterT : public BaseClass
+    {
+    public:
+        SSqliteRowSource & GetRowSource() {return m_rowSource;}
+
+        //еݸı
+        void Refresh()
+        {
+            m_rowSource.Refresh();
+            this->notifyDataSetChanged();
+        }
+
+        virtual int getCount()
+        {
+            return m_rowSource.GetCount();
+        }
+
+        virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate)
+        {
+            if(pItem->GetChildrenCount() == 0)
+            {
+                pItem->InitFromXml(xmlTemplate);
+            }
+            SArray<SStringW> arrValues;
+            if(!m_rowSource.GetRow(position,arrValues)) return;
+            for(int i=0;i<(int)arrValues.GetCount();i++)
+            {
+                SWindow *pCol = pItem->FindChildByName(m_rowSource.GetColumnName(i));
+                if(pCol) pCol->SetWindowText(S_CW2T(arrValues[i]));
+            }
+            OnBindRow(position,pItem,arrValues);
+        }
+
+        virtual SStringW GetColumnName(int iCol) const
+        {
+            return m_rowSource.GetColumnName(iCol);
+        }
+
+    protected:
+        //ʾֱıʾ
+        virtual void OnBindRow(int position,SWindow *pItem,const SArray<SStringW> & arrValues)
+        {
+        }
+
+        SSqliteRowSource m_rowSource;
+    };
+
+    typedef SSqliteAdapterT<SAdapterBase>   SSqliteLvAdapter;
+    typedef SSqliteAdapterT<SMcAdapterBase> SSqliteMcAdapter;
+}
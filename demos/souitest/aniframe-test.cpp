@@ -0,0 +1,160 @@
+﻿/*
+	测试SSkinAni的增量帧合成
+	需要render-gdi和imgdecoder模块
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include "../../controls.extend/gif/SAniImgFrame.h"
+
+using namespace SOUI;
+
+//第i帧：灰色背景上一个8x8的方块从左向右移动，每16帧背景颜色变化一次
+static void MakeFrame(int iFrame,SIZE sz,DWORD *pBits)
+{
+	DWORD crBack = 0xFF000000 | ((iFrame/16)*0x101010 & 0xFFFFFF);
+	for(int i=0;i<sz.cx*sz.cy;i++) pBits[i] = crBack;
+	int x0 = (iFrame*2)%(sz.cx-8);
+	for(int y=0;y<8;y++)
+	{
+		for(int x=0;x<8;x++)
+		{
+			pBits[(y+sz.cy/2)*sz.cx+x0+x] = 0xFF0000FF;
+		}
+	}
+}
+
+class CProbeAniSkin : public SSkinAni
+{
+public:
+	void Load(int nFrames,SIZE sz)
+	{
+		m_nFrames = nFrames;
+		m_pFrames = new SAniImgFrame[nFrames];
+		_ResetCanvas();
+		DWORD *pBits[2];
+		pBits[0] = new DWORD[sz.cx*sz.cy];
+		pBits[1] = new DWORD[sz.cx*sz.cy];
+		for(int i=0;i<nFrames;i++)
+		{
+			MakeFrame(i,sz,pBits[i&1]);
+			_SetFramePixels(i,sz,(const BYTE*)pBits[i&1],i>0?(const BYTE*)pBits[(i-1)&1]:NULL);
+		}
+		delete []pBits[0];
+		delete []pBits[1];
+	}
+
+	IBitmap * Compose(int iFrame,SAniCanvas &canvas)
+	{
+		return _GetFrameBitmap(iFrame,canvas);
+	}
+
+	//保存帧数据占用的内存
+	size_t GetFramesSize()
+	{
+		size_t szRet = 0;
+		for(int i=0;i<m_nFrames;i++)
+		{
+			if(m_pFrames[i].pBmp)
+			{
+				CSize sz = m_pFrames[i].pBmp->Size();
+				szRet += sz.cx*sz.cy*4;
+			}else if(m_pFrames[i].pDelta)
+			{
+				szRet += m_pFrames[i].rcDelta.Width()*m_pFrames[i].rcDelta.Height()*4;
+			}
+		}
+		return szRet;
+	}
+};
+
+static BOOL IsFrame(IBitmap *pBmp,int iFrame,SIZE sz,DWORD *pRef)
+{
+	if(!pBmp) return FALSE;
+	MakeFrame(iFrame,sz,pRef);
+	return memcmp(pBmp->GetPixelBits(),pRef,sz.cx*sz.cy*4) == 0;
+}
+
+class SSkinAniTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+	}
+
+	virtual void TearDown()
+	{
+		delete m_theApp;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+};
+
+//两个播放器共用一个皮肤，一个顺序播放，一个倒序播放，各自的合成结果都正确
+TEST_F(SSkinAniTest, sharedSkin) {
+	const int KFrames = 50;
+	SIZE sz = {64,32};
+	CProbeAniSkin *pSkin = new CProbeAniSkin;
+	pSkin->Load(KFrames,sz);
+	DWORD *pRef = new DWORD[sz.cx*sz.cy];
+
+	SAniCanvas canvas1,canvas2;
+	for(int i=0;i<KFrames;i++)
+	{
+		IBitmap *pBmp1 = pSkin->Compose(i,canvas1);
+		IBitmap *pBmp2 = pSkin->Compose(KFrames-1-i,canvas2);
+		EXPECT_TRUE(IsFrame(pBmp1,i,sz,pRef)) << "frame " << i;
+		EXPECT_TRUE(IsFrame(pBmp2,KFrames-1-i,sz,pRef)) << "frame " << KFrames-1-i;
+	}
+
+	//GetFrameImage返回的图片不受之后合成的影响
+	IBitmap *pImg = pSkin->GetFrameImage(5);
+	for(int i=0;i<KFrames;i++)
+	{
+		pSkin->GetFrameImage(i);
+		pSkin->Compose(i,canvas1);
+	}
+	EXPECT_TRUE(IsFrame(pImg,5,sz,pRef));
+	EXPECT_EQ(pImg,pSkin->GetFrameImage(5));
+
+	delete []pRef;
+	pSkin->Release();
+}
+
+//输出增量帧节省的内存和合成耗时
+TEST_F(SSkinAniTest, DISABLED_bench) {
+	const int KFrames = 200;
+	SIZE sz = {256,256};
+	CProbeAniSkin *pSkin = new CProbeAniSkin;
+	pSkin->Load(KFrames,sz);
+	size_t szFull = (size_t)KFrames*sz.cx*sz.cy*4;
+	printf("frames memory: %u bytes, full frames %u bytes (%.1f%%)\n",(UINT)pSkin->GetFramesSize(),(UINT)szFull,pSkin->GetFramesSize()*100.0/szFull);
+
+	LARGE_INTEGER liFreq,liStart,liEnd;
+	QueryPerformanceFrequency(&liFreq);
+	SAniCanvas canvas;
+	QueryPerformanceCounter(&liStart);
+	for(int n=0;n<10;n++)
+	{
+		for(int i=0;i<KFrames;i++) pSkin->Compose(i,canvas);
+	}
+	QueryPerformanceCounter(&liEnd);
+	printf("sequential: %.3fus/frame\n",(liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart/(10*KFrames));
+
+	srand(0);
+	QueryPerformanceCounter(&liStart);
+	for(int n=0;n<10*KFrames;n++)
+	{
+		pSkin->Compose(rand()%KFrames,canvas);
+	}
+	QueryPerformanceCounter(&liEnd);
+	printf("random:     %.3fus/frame\n",(liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart/(10*KFrames));
+	pSkin->Release();
+}
@@ -0,0 +1,174 @@
+﻿/*
+	SAtomTable测试
+	需要render-gdi和imgdecoder模块
+	性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <process.h>
+
+using namespace SOUI;
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+class SAtomTableTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_pApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+	}
+
+	virtual void TearDown()
+	{
+		delete m_pApp;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_pApp;
+};
+
+struct FINDPARAM
+{
+	volatile LONG nAdded;   //已经添加的原子数
+	volatile LONG bStop;
+	volatile LONG nErrors;
+	LONG          nFinds;
+};
+
+//不加锁查找已经添加的原子，检查原子的字符串
+static unsigned int __stdcall FindAtoms(void *p)
+{
+	FINDPARAM *param = (FINDPARAM*)p;
+	SAtomTable & atomTable = SAtomTable::getSingleton();
+	while(!param->bStop)
+	{
+		LONG nAdded = param->nAdded;
+		if(nAdded == 0) continue;
+		int i = rand()%nAdded;
+		SStringW strName = SStringW().Format(L"atom.test.%d",i);
+		SAtom atom = atomTable.FindAtom(strName,strName.GetLength());
+		if(atom == SATOM_NULL || strName != atomTable.GetAtomName(atom))
+			InterlockedIncrement(&param->nErrors);
+		InterlockedIncrement(&param->nFinds);
+	}
+	return 0;
+}
+
+TEST_F(SAtomTableTest, concurrentFind) {
+	SAtomTable & atomTable = SAtomTable::getSingleton();
+	FINDPARAM param = {0,0,0,0};
+	HANDLE hThreads[3];
+	for(int i=0;i<ARRAYSIZE(hThreads);i++) hThreads[i] = (HANDLE)_beginthreadex(NULL,0,FindAtoms,&param,0,NULL);
+
+	//添加的原子足够多，hash槽会扩容多次
+	const int KAtoms = 20000;
+	for(int i=0;i<KAtoms;i++)
+	{
+		SStringW strName = SStringW().Format(L"atom.test.%d",i);
+		SAtom atom = atomTable.AddAtom(strName,strName.GetLength());
+		ASSERT_NE(atom,(SAtom)SATOM_NULL);
+		InterlockedExchange(&param.nAdded,i+1);
+	}
+	InterlockedExchange(&param.bStop,1);
+	WaitForMultipleObjects(ARRAYSIZE(hThreads),hThreads,TRUE,INFINITE);
+	for(int i=0;i<ARRAYSIZE(hThreads);i++) CloseHandle(hThreads[i]);
+
+	EXPECT_EQ(0,param.nErrors);
+	EXPECT_GT(param.nFinds,0);
+	for(int i=0;i<KAtoms;i++)
+	{
+		SStringW strName = SStringW().Format(L"atom.test.%d",i);
+		EXPECT_STREQ(strName,atomTable.GetAtomName(atomTable.FindAtom(strName)));
+	}
+}
+
+//比较原子键和字符串键的hash及比较开销，以及FindAtom加锁和不加锁的开销
+TEST_F(SAtomTableTest, DISABLED_bench) {
+	SAtomTable & atomTable = SAtomTable::getSingleton();
+	const int KNames = 200;
+	const int KRounds = 2000;
+	SStringW strSkins = L"<skin>";
+	SArray<SStringW> lstNames;
+	for(int i=0;i<KNames;i++)
+	{
+		SStringW strName = SStringW().Format(L"skin.bench.button.%d",i);
+		lstNames.Add(strName);
+		strSkins += SStringW().Format(L"<colorrect name=\"%s\" normal=\"#ff0000\"/>",(LPCWSTR)strName);
+	}
+	strSkins += L"</skin>";
+
+	SMap<SkinKey,int> mapAtom,mapStr;
+	SArray<SkinKey> lstAtomKeys,lstStrKeys;
+	for(int i=0;i<KNames;i++)
+	{
+		SkinKey key = {lstNames[i],100,atomTable.AddAtom(lstNames[i],lstNames[i].GetLength())};
+		mapAtom[key] = i;
+		lstAtomKeys.Add(key);
+		key.atom = SATOM_NULL;
+		mapStr[key] = i;
+		lstStrKeys.Add(key);
+	}
+
+	SAtomStats stats1,stats2;
+	LARGE_INTEGER liStart;
+	int nSum = 0;
+
+	//1. 只比较键的开销：同一个key在多个SkinPool中查找时的开销
+	QueryPerformanceCounter(&liStart);
+	for(int r=0;r<KRounds;r++) for(int i=0;i<KNames;i++) nSum += mapStr.Lookup(lstStrKeys[i])->m_value;
+	double dStrKey = Elapse(liStart)*1000/(KRounds*KNames);
+	QueryPerformanceCounter(&liStart);
+	for(int r=0;r<KRounds;r++) for(int i=0;i<KNames;i++) nSum += mapAtom.Lookup(lstAtomKeys[i])->m_value;
+	double dAtomKey = Elapse(liStart)*1000/(KRounds*KNames);
+
+	//2. FindAtom：不加锁和加锁(原实现)的开销，FindAtom需要计算一次字符串hash
+	atomTable.GetStats(stats1);
+	QueryPerformanceCounter(&liStart);
+	for(int r=0;r<KRounds;r++) for(int i=0;i<KNames;i++) nSum += atomTable.FindAtom(lstNames[i],lstNames[i].GetLength());
+	double dFind = Elapse(liStart)*1000/(KRounds*KNames);
+	atomTable.GetStats(stats2);
+	SCriticalSection cs;
+	QueryPerformanceCounter(&liStart);
+	for(int r=0;r<KRounds;r++) for(int i=0;i<KNames;i++)
+	{
+		SAutoLock lock(cs);
+		nSum += atomTable.FindAtom(lstNames[i],lstNames[i].GetLength());
+	}
+	double dFindLocked = Elapse(liStart)*1000/(KRounds*KNames);
+
+	//3. 完整的GetSkin：查找一次原子，在两个SkinPool中用原子键查找
+	CAutoRefPtr<SSkinPool> pSkinPool;
+	pSkinPool.Attach(new SSkinPool);
+	pugi::xml_document xmlDoc;
+	xmlDoc.load_buffer((LPCWSTR)strSkins,strSkins.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+	ASSERT_EQ(KNames,pSkinPool->LoadSkins(xmlDoc.child(L"skin")));
+	CAutoRefPtr<SSkinPool> pTopPool;//空的顶层SkinPool，模拟对话框私有皮肤
+	pTopPool.Attach(new SSkinPool);
+	SSkinPoolMgr::getSingleton().PushSkinPool(pSkinPool);
+	SSkinPoolMgr::getSingleton().PushSkinPool(pTopPool);
+	QueryPerformanceCounter(&liStart);
+	for(int r=0;r<KRounds;r++) for(int i=0;i<KNames;i++) nSum += GETSKIN(lstNames[i],100)!=NULL;
+	double dGetSkin = Elapse(liStart)*1000/(KRounds*KNames);
+	SSkinPoolMgr::getSingleton().PopSkinPool(pTopPool);
+	SSkinPoolMgr::getSingleton().PopSkinPool(pSkinPool);
+
+	printf("SMap<SkinKey> lookup: string key %.1fns, atom key %.1fns\n",dStrKey,dAtomKey);
+	printf("FindAtom: lock-free %.1fns, with critical section %.1fns, %.2f string compares/find\n",
+		dFind,dFindLocked,(double)(stats2.nCompares-stats1.nCompares)/(stats2.nLookups-stats1.nLookups));
+	printf("GETSKIN: %.1fns/call\n",dGetSkin);
+	atomTable.GetStats(stats2);
+	printf("atoms %d, arena %d bytes, slots %d bytes (%d)\n",stats2.nAtoms,stats2.nArenaBytes,stats2.nSlotBytes,nSum);
+}
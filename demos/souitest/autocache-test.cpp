@@ -0,0 +1,111 @@
+﻿/*
+	cache="auto"自动缓存的淘汰队列测试
+	需要render-gdi和imgdecoder模块，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+
+using namespace SOUI;
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+class SAutoCache : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+	}
+
+	virtual void TearDown()
+	{
+		delete m_theApp;
+	}
+
+	//nCols*nRows个cache="auto"的窗口，每个窗口nSize*nSize
+	void CreateHost(SHostWnd &host, int nCols, int nRows, int nSize)
+	{
+		int nWid = nCols*nSize, nHei = nRows*nSize;
+		SStringW strXml = SStringW().Format(L"<SOUI width=\"%d\" height=\"%d\"><root>",nWid,nHei);
+		for(int i=0;i<nCols*nRows;i++)
+		{
+			strXml += SStringW().Format(L"<window pos=\"%d,%d,@%d,@%d\" cache=\"auto\" colorBkgnd=\"#%06x\"/>",
+				(i%nCols)*nSize,(i/nCols)*nSize,nSize,nSize,rand()&0xFFFFFF);
+		}
+		strXml += L"</root></SOUI>";
+		host.Create(NULL,0,0,nWid,nHei);
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer((LPCWSTR)strXml,strXml.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+		host.InitFromXml(xmlDoc.child(L"SOUI"));
+		host.GetRoot()->UpdateLayout();
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+};
+
+//窗口变大后按新的大小重新计算预算
+TEST_F(SAutoCache, resizeBudget) {
+	const size_t KBudget = 500*1024;
+	SHostWnd host;
+	CreateHost(host,5,2,100);
+	host.SetAutoCacheBudget(KBudget);
+
+	SRenderCacheStats stats;
+	SWindow::GetRenderCacheStats(stats);
+	LONG nBase = stats.nBytesHeld;
+
+	CAutoRefPtr<IRenderTarget> pRT;
+	m_pRenderFactory->CreateRenderTarget(&pRT,500,200);
+	for(int i=0;i<10;i++) host.GetRoot()->RedrawRegion(pRT,NULL);
+	SWindow::GetRenderCacheStats(stats);
+	EXPECT_EQ(stats.nBytesHeld-nBase,10*100*100*4);
+
+	SWindow *pChild = host.GetRoot()->GetWindow(GSW_FIRSTCHILD);
+	while(pChild)
+	{
+		CRect rc = pChild->GetWindowRect();
+		pChild->Move(rc.left,rc.top,200,200);
+		pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+	}
+	SWindow::GetRenderCacheStats(stats);
+	EXPECT_GT(stats.nBytesHeld-nBase,0);
+	EXPECT_LE((size_t)(stats.nBytesHeld-nBase),KBudget);
+	host.DestroyWindow();
+}
+
+//所有窗口都启用自动缓存后每次重绘都要更新淘汰队列
+TEST_F(SAutoCache, DISABLED_bench) {
+	srand(5);
+	SHostWnd host;
+	CreateHost(host,80,50,20);
+
+	CAutoRefPtr<IRenderTarget> pRT;
+	m_pRenderFactory->CreateRenderTarget(&pRT,1600,1000);
+	for(int i=0;i<10;i++) host.GetRoot()->RedrawRegion(pRT,NULL);
+
+	SWindow::ResetRenderCacheStats();
+	const int KPaints = 50;
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KPaints;i++) host.GetRoot()->RedrawRegion(pRT,NULL);
+	double dPaint = Elapse(liStart)/1000/KPaints;
+
+	SRenderCacheStats stats;
+	SWindow::GetRenderCacheStats(stats);
+	EXPECT_EQ(stats.nCacheHits,4000*KPaints);
+	printf("4000 auto cached windows: repaint %.3fms, cache hits %d, bytes held %d\n",dPaint,stats.nCacheHits,stats.nBytesHeld);
+	host.DestroyWindow();
+}
@@ -0,0 +1,4 @@
+﻿// 编译controls.extend中的文件使用
+#pragma once
+
+#include <souistd.h>
@@ -0,0 +1,186 @@
+﻿/*
+	比较SHitTestIndex与SWindow::SwndFromPoint递归查找的结果
+	需要render-gdi和imgdecoder模块
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+
+using namespace SOUI;
+
+//只有左半边响应鼠标的窗口，用来测试重载了SwndFromPoint的窗口
+class CHalfHitWnd : public SWindow
+{
+	SOUI_CLASS_NAME(CHalfHitWnd, L"halfhit")
+public:
+	virtual SWND SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText)
+	{
+		if(ptHitTest.x >= GetWindowRect().CenterPoint().x) return NULL;
+		return __super::SwndFromPoint(ptHitTest,bOnlyText);
+	}
+
+	virtual BOOL HasCustomHitTest() const
+	{
+		return TRUE;
+	}
+};
+
+//只重载了SwndFromPoint，没有重载HasCustomHitTest，依赖窗口类工厂的自动检测
+class CHalfOnlyWnd : public SWindow
+{
+	SOUI_CLASS_NAME(CHalfOnlyWnd, L"halfonly")
+public:
+	virtual SWND SwndFromPoint(CPoint ptHitTest, BOOL bOnlyText)
+	{
+		if(ptHitTest.x >= GetWindowRect().CenterPoint().x) return NULL;
+		return __super::SwndFromPoint(ptHitTest,bOnlyText);
+	}
+};
+
+//派生自CHalfOnlyWnd但不再重载SwndFromPoint，同样需要检测到基类的重载
+class CHalfOnlyDerivedWnd : public CHalfOnlyWnd
+{
+	SOUI_CLASS_NAME(CHalfOnlyDerivedWnd, L"halfonlyderived")
+};
+
+//随机生成窗口树，子窗口可以超出父窗口的右边和下边，部分窗口隐藏、消息透明或者有margin
+static void AddRandomChildren(SStringW &strXml, int nDepth, int nWid, int nHei, int nMaxChildren, LPCWSTR pszCustomTag)
+{
+	if(nDepth == 0 || nWid < 4 || nHei < 4) return;
+	int nChildren = rand()%(nMaxChildren+1);
+	for(int i=0;i<nChildren;i++)
+	{
+		int w = 2+rand()%(nWid/2+1);
+		int h = 2+rand()%(nHei/2+1);
+		int x = rand()%nWid;
+		int y = rand()%nHei;
+		LPCWSTR pszTag = (pszCustomTag && rand()%8==0)?pszCustomTag:L"window";
+		SStringW strAttr;
+		if(rand()%10==0) strAttr += L" visible=\"0\"";
+		if(rand()%10==0) strAttr += L" msgTransparent=\"1\"";
+		if(rand()%6==0) strAttr += L" margin=\"3\"";
+		strXml += SStringW().Format(L"<%s pos=\"%d,%d,@%d,@%d\"%s>",pszTag,x,y,w,h,(LPCWSTR)strAttr);
+		AddRandomChildren(strXml,nDepth-1,w,h,nMaxChildren,pszCustomTag);
+		strXml += SStringW().Format(L"</%s>",pszTag);
+	}
+}
+
+static void InitHost(SHostWnd &host, int nDepth, int nMaxChildren, LPCWSTR pszCustomTag)
+{
+	SStringW strXml = L"<SOUI width=\"800\" height=\"600\"><root>";
+	AddRandomChildren(strXml,nDepth,800,600,nMaxChildren,pszCustomTag);
+	strXml += L"</root></SOUI>";
+	host.Create(NULL,0,0,800,600);
+	pugi::xml_document xmlDoc;
+	xmlDoc.load_buffer((LPCWSTR)strXml,strXml.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+	host.InitFromXml(xmlDoc.child(L"SOUI"));
+	host.GetRoot()->UpdateLayout();
+}
+
+class HitTestIndexTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_pApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+		m_pApp->RegisterWindowClass<CHalfHitWnd>();
+		m_pApp->RegisterWindowClass<CHalfOnlyWnd>();
+		m_pApp->RegisterWindowClass<CHalfOnlyDerivedWnd>();
+	}
+
+	virtual void TearDown()
+	{
+		delete m_pApp;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_pApp;
+};
+
+static void CheckEquivalence(LPCWSTR pszCustomTag)
+{
+	int nChildHits = 0;
+	for(int nTree=0;nTree<20;nTree++)
+	{
+		SHostWnd host;
+		InitHost(host,4,5,nTree%2==1?pszCustomTag:NULL);
+
+		const int KPoints = 2000;
+		CPoint pts[KPoints];
+		SWND swndTree[KPoints];
+		for(int i=0;i<KPoints;i++)
+		{
+			pts[i] = CPoint(rand()%820-10,rand()%620-10);
+			swndTree[i] = host.SwndFromPoint(pts[i],FALSE);
+			if(swndTree[i] && swndTree[i] != host.GetSwnd()) nChildHits++;
+		}
+		host.EnableHitTestIndex(TRUE,32);
+		for(int i=0;i<KPoints;i++)
+		{
+			ASSERT_EQ(host.SwndFromPoint(pts[i],FALSE),swndTree[i]);
+		}
+		host.EnableHitTestIndex(FALSE);
+		host.DestroyWindow();
+	}
+	//确认测试覆盖了子窗口
+	EXPECT_GT(nChildHits,0);
+}
+
+TEST_F(HitTestIndexTest, equivalence) {
+	srand(1);
+	CheckEquivalence(L"halfhit");
+}
+
+TEST_F(HitTestIndexTest, overrideOnly) {
+	EXPECT_TRUE(SWindow::IsDefaultHitTest(&SPanel::SwndFromPoint));
+	EXPECT_FALSE(SWindow::IsDefaultHitTest(&CHalfOnlyWnd::SwndFromPoint));
+	EXPECT_FALSE(SWindow::IsDefaultHitTest(&CHalfOnlyDerivedWnd::SwndFromPoint));
+
+	SWindow *pWnd = m_pApp->CreateWindowByName(CHalfOnlyDerivedWnd::GetClassName());
+	ASSERT_TRUE(pWnd != NULL);
+	EXPECT_TRUE(pWnd->HasCustomHitTest());
+	pWnd->Release();
+
+	srand(3);
+	CheckEquivalence(L"halfonly");
+	srand(4);
+	CheckEquivalence(L"halfonlyderived");
+}
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+TEST_F(HitTestIndexTest, DISABLED_bench) {
+	srand(2);
+	SHostWnd host;
+	InitHost(host,3,20,NULL);
+
+	const int KPoints = 10000;
+	CPoint *pts = new CPoint[KPoints];
+	for(int i=0;i<KPoints;i++) pts[i] = CPoint(rand()%800,rand()%600);
+
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KPoints;i++) host.SwndFromPoint(pts[i],FALSE);
+	double dTree = Elapse(liStart)/KPoints;
+
+	host.EnableHitTestIndex(TRUE);
+	host.SwndFromPoint(pts[0],FALSE);//建立索引
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KPoints;i++) host.SwndFromPoint(pts[i],FALSE);
+	double dIndex = Elapse(liStart)/KPoints;
+	printf("tree walk: %.3fus/query, index: %.3fus/query\n",dTree,dIndex);
+
+	delete []pts;
+	host.DestroyWindow();
+}
@@ -0,0 +1,95 @@
+﻿/*
+	比较image3d透视变换的SSE2路径与标量路径，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include "../../controls.extend/image3d/3dTransform.h"
+
+using namespace IMAGE3D;
+
+static const int KWid = 640;
+static const int KHei = 480;
+
+//渐变加噪声的32位图片，相邻像素不同，插值误差能够反映出来
+static void MakeImage(LPBYTE pBits)
+{
+	srand(0);
+	for(int y=0;y<KHei;y++)
+	{
+		for(int x=0;x<KWid;x++)
+		{
+			LPBYTE p = pBits + (y*KWid+x)*4;
+			p[0] = (BYTE)(x*255/KWid);
+			p[1] = (BYTE)(y*255/KHei);
+			p[2] = (BYTE)(rand()&0xFF);
+			p[3] = 0xFF;
+		}
+	}
+}
+
+static const PARAM3DTRANSFORM KParams[] = {
+	{0,0,0,0},
+	{30,0,0,0},
+	{0,45,0,100},
+	{20,30,10,-100},
+	{0,80,0,0},
+	{60,60,60,200},
+};
+
+TEST(Image3D, sse2MatchesScalar) {
+	LPBYTE pSrc = new BYTE[KWid*KHei*4];
+	LPBYTE pDst1 = new BYTE[KWid*KHei*4];
+	LPBYTE pDst2 = new BYTE[KWid*KHei*4];
+	MakeImage(pSrc);
+
+	C3DTransform sse2,scalar;
+	sse2.SetImage(pSrc,pDst1,KWid,KHei,32);
+	scalar.SetImage(pSrc,pDst2,KWid,KHei,32);
+	scalar.EnableSSE2(false);
+	for(int i=0;i<ARRAYSIZE(KParams);i++)
+	{
+		sse2.Render(KParams[i]);
+		scalar.Render(KParams[i]);
+		int nMaxDiff = 0, nDiffCount = 0;
+		for(int j=0;j<KWid*KHei*4;j++)
+		{
+			int nDiff = abs((int)pDst1[j]-(int)pDst2[j]);
+			if(nDiff > nMaxDiff) nMaxDiff = nDiff;
+			if(nDiff) nDiffCount++;
+		}
+		EXPECT_LE(nMaxDiff,1) << "param " << i << ", " << nDiffCount << " bytes differ";
+	}
+	delete []pSrc;
+	delete []pDst1;
+	delete []pDst2;
+}
+
+static double RenderTime(bool bSSE2)
+{
+	LPBYTE pSrc = new BYTE[KWid*KHei*4];
+	LPBYTE pDst = new BYTE[KWid*KHei*4];
+	MakeImage(pSrc);
+	C3DTransform trans;
+	trans.SetImage(pSrc,pDst,KWid,KHei,32);
+	trans.EnableSSE2(bSSE2);
+
+	LARGE_INTEGER liFreq,liStart,liEnd;
+	QueryPerformanceFrequency(&liFreq);
+	QueryPerformanceCounter(&liStart);
+	const int KFrames = 90;
+	for(int i=0;i<KFrames;i++)
+	{
+		PARAM3DTRANSFORM param = {0,i*2,0,0};
+		trans.Render(param);
+	}
+	QueryPerformanceCounter(&liEnd);
+	delete []pSrc;
+	delete []pDst;
+	return (liEnd.QuadPart-liStart.QuadPart)*1000.0/liFreq.QuadPart/KFrames;
+}
+
+TEST(Image3D, DISABLED_bench) {
+	double dScalar = RenderTime(false);
+	double dSSE2 = RenderTime(true);
+	printf("%dx%d turn: scalar %.3fms/frame, sse2 %.3fms/frame\n",KWid,KHei,dScalar,dSSE2);
+}
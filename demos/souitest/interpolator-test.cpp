@@ -0,0 +1,153 @@
+﻿/*
+	测试插值器查找表和动画批量求值
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <animator/SInterpolatorImpl.h>
+#include <animator/SInterpolatorTable.h>
+#include <math.h>
+
+using namespace SOUI;
+
+static IInterpolator * CreateInterpolator(int i)
+{
+	switch(i)
+	{
+	case 0:return new SLinearInterpolator();
+	case 1:return new SAccelerateInterpolator(2.5f);
+	case 2:return new SDecelerateInterpolator(2.0f);
+	case 3:return new SAccelerateDecelerateInterpolator();
+	case 4:return new SAnticipateInterpolator();
+	case 5:return new SAnticipateOvershootInterpolator();
+	case 6:return new SCycleInterpolator();
+	case 7:return new SOvershootInterpolator();
+	case 8:return new SBounceInterpolator();
+	}
+	return NULL;
+}
+
+static const int KInterpolators = 9;
+static const int KSmoothInterpolators = 8;	//Bounce有折点，误差单独检查
+
+TEST(SInterpolatorTable, accuracy) {
+	for(int i=0;i<KInterpolators;i++)
+	{
+		CAutoRefPtr<IInterpolator> pInterpolator;
+		pInterpolator.Attach(CreateInterpolator(i));
+		SInterpolatorTable table;
+		ASSERT_TRUE(table.Build(pInterpolator,SInterpolatorTable::PREC_LOW));
+		float fErrLow = table.GetMaxError(pInterpolator);
+		table.Build(pInterpolator,SInterpolatorTable::PREC_HIGH);
+		float fErrHigh = table.GetMaxError(pInterpolator);
+		EXPECT_LE(fErrHigh,fErrLow+1e-6f);
+		if(i<KSmoothInterpolators)
+		{
+			EXPECT_LT(fErrLow,2e-3f);
+			EXPECT_LT(fErrHigh,1e-5f);
+		}else
+		{
+			EXPECT_LT(fErrHigh,5e-3f);
+		}
+
+		//批量求值与逐个求值结果一致，超出[0,1]的输入被截断
+		float fInput[103],fOutput[103];
+		for(int j=0;j<103;j++) fInput[j] = j/100.0f - 0.01f;
+		table.Evaluate(fInput,fOutput,103);
+		for(int j=0;j<103;j++) EXPECT_FLOAT_EQ(fOutput[j],table.Lookup(fInput[j]));
+		EXPECT_FLOAT_EQ(fOutput[0],table.Lookup(0.0f));
+		EXPECT_FLOAT_EQ(fOutput[102],table.Lookup(1.0f));
+
+		//NaN按0处理
+		float fNaN = sqrtf(-1.0f);
+		EXPECT_FLOAT_EQ(table.Lookup(fNaN),table.Lookup(0.0f));
+		float fNaNs[5] = {fNaN,fNaN,fNaN,fNaN,fNaN};
+		table.Evaluate(fNaNs,fOutput,5);
+		for(int j=0;j<5;j++) EXPECT_FLOAT_EQ(fOutput[j],table.Lookup(0.0f));
+	}
+}
+
+TEST(SAnimationBatch, evaluate) {
+	CAutoRefPtr<IInterpolator> pAccel,pLinear;
+	pAccel.Attach(new SAccelerateInterpolator());
+	pLinear.Attach(new SLinearInterpolator());
+
+	SAnimationBatch batch(SInterpolatorTable::PREC_HIGH);
+	int id1 = batch.Add(pAccel,100,200);
+	int id2 = batch.Add(pLinear,0,100);
+	int id3 = batch.Add(pAccel,0,1000);
+	EXPECT_EQ(batch.GetCount(),3);
+
+	EXPECT_EQ(batch.Evaluate(50),2);
+	EXPECT_FLOAT_EQ(batch.GetValue(id1),0.0f);	//还没有开始
+	EXPECT_NEAR(batch.GetValue(id2),0.5f,1e-5f);
+	EXPECT_NEAR(batch.GetValue(id3),0.0025f,1e-5f);
+	EXPECT_FALSE(batch.IsFinished(id1));
+
+	EXPECT_EQ(batch.Evaluate(200),2);
+	EXPECT_NEAR(batch.GetValue(id1),0.25f,1e-5f);
+	EXPECT_FLOAT_EQ(batch.GetValue(id2),1.0f);
+	EXPECT_TRUE(batch.IsFinished(id2));
+
+	//删除后同组的其它动画不受影响，ID被重用
+	EXPECT_TRUE(batch.Remove(id1));
+	EXPECT_FALSE(batch.Remove(id1));
+	batch.Evaluate(500);
+	EXPECT_NEAR(batch.GetValue(id3),0.25f,1e-5f);
+	int id4 = batch.Add(pLinear,500,100);
+	EXPECT_EQ(id4,id1);
+	EXPECT_EQ(batch.GetCount(),3);
+
+	batch.RemoveAll();
+	EXPECT_EQ(batch.GetCount(),0);
+}
+
+//大量动画同时运行时，比较逐个调用getInterpolation与批量查表的每帧耗时及最大误差
+TEST(SAnimationBatch, DISABLED_bench) {
+	const int KAnimations = 5000;
+	const int KFrames = 1000;
+	IInterpolator * pInterpolators[KInterpolators];
+	for(int i=0;i<KInterpolators;i++) pInterpolators[i] = CreateInterpolator(i);
+
+	int nPrecisions[] = {SInterpolatorTable::PREC_LOW,SInterpolatorTable::PREC_MEDIUM,SInterpolatorTable::PREC_HIGH};
+	for(int p=0;p<ARRAYSIZE(nPrecisions);p++)
+	{
+		SAnimationBatch batch(nPrecisions[p]);
+		SArray<int> arrID;
+		for(int i=0;i<KAnimations;i++)
+		{
+			arrID.Add(batch.Add(pInterpolators[i%KInterpolators],i%300,KFrames));
+		}
+
+		LARGE_INTEGER freq,t0,t1,t2;
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&t0);
+		volatile float fSum = 0.0f;
+		for(int f=0;f<KFrames;f++)
+		{
+			for(int i=0;i<KAnimations;i++)
+			{
+				float fProg = (float)(f-i%300)/KFrames;
+				if(fProg<0.0f) fProg = 0.0f;
+				fSum += pInterpolators[i%KInterpolators]->getInterpolation(fProg);
+			}
+		}
+		QueryPerformanceCounter(&t1);
+		for(int f=0;f<KFrames;f++)
+		{
+			batch.Evaluate(f);
+		}
+		QueryPerformanceCounter(&t2);
+
+		float fMaxErr = 0.0f;
+		for(int i=0;i<KAnimations;i++)
+		{
+			float fProg = (float)(KFrames-1-i%300)/KFrames;
+			float fErr = fabs(batch.GetValue(arrID[i]) - pInterpolators[i%KInterpolators]->getInterpolation(fProg));
+			if(fErr>fMaxErr) fMaxErr = fErr;
+		}
+		printf("%d animations, %d samples: per frame direct %.1f us, batch %.1f us, max error %g\n",KAnimations,nPrecisions[p],
+			(t1.QuadPart-t0.QuadPart)*1e6/freq.QuadPart/KFrames,(t2.QuadPart-t1.QuadPart)*1e6/freq.QuadPart/KFrames,fMaxErr);
+	}
+
+	for(int i=0;i<KInterpolators;i++) pInterpolators[i]->Release();
+}
@@ -0,0 +1,184 @@
+﻿/*
+	测试SListView预创建列表项对快速滚动的影响
+	需要render-gdi和imgdecoder模块，性能对比默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <control/SListView.h>
+#include <helper/SAdapterBase.h>
+
+using namespace SOUI;
+
+static const wchar_t KBenchLayout[] =
+L"<SOUI width=\"400\" height=\"600\">"
+L"<root>"
+L"<probelistview pos=\"0,0,-0,-0\" name=\"lv_bench\">"
+L"<template itemHeight=\"40\">"
+L"<itemA colorHover=\"#cccccc\" colorSelected=\"#0000ff\">"
+L"<check pos=\"5,5,@20,@20\" name=\"chk\"/>"
+L"<text pos=\"[5,5\" name=\"txt_title\" colorText=\"#000000\">title</text>"
+L"<text pos=\"[5,{0\" name=\"txt_desc\" colorText=\"#888888\">desc</text>"
+L"<button pos=\"-85,5,@80,@25\" name=\"btn_op\">op</button>"
+L"</itemA>"
+L"<itemB colorHover=\"#cccccc\" colorSelected=\"#0000ff\">"
+L"<img pos=\"5,5,@30,@30\" name=\"img_icon\"/>"
+L"<text pos=\"[5,5\" name=\"txt_title\" colorText=\"#000000\">title</text>"
+L"<progress pos=\"[5,{0,@100,@10\" name=\"prog\" min=\"0\" max=\"100\"/>"
+L"<link pos=\"-85,5,@80,@25\" name=\"lnk_op\">link</link>"
+L"</itemB>"
+L"</template>"
+L"</probelistview>"
+L"</root>"
+L"</SOUI>";
+
+//按快速滑动的方式滚动列表
+class CProbeListView : public SListView
+{
+	SOUI_CLASS_NAME(CProbeListView,L"probelistview")
+public:
+	void ScrollTo(int nPos)
+	{
+		OnScroll(TRUE,SB_THUMBTRACK,nPos);
+	}
+};
+
+//两种样式每3行交替一次，记录新建的列表项数量
+class CBenchAdapter : public SAdapterBase
+{
+public:
+	CBenchAdapter():m_nCreated(0){}
+
+	virtual int getCount()
+	{
+		return 100000;
+	}
+
+	virtual int getViewTypeCount()
+	{
+		return 2;
+	}
+
+	virtual int getItemViewType(int position,DWORD dwState)
+	{
+		return (position/3)%2;
+	}
+
+	virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate)
+	{
+		if(pItem->GetChildrenCount() == 0)
+		{
+			m_nCreated++;
+			pItem->InitFromXml(xmlTemplate.child(getItemViewType(position,0)?L"itemB":L"itemA"));
+		}
+		pItem->FindChildByName(L"txt_title")->SetWindowText(SStringT().Format(_T("item %d"),position));
+	}
+
+	int m_nCreated;
+};
+
+struct FLINGRESULT
+{
+	double dCreateTime;	//首屏每个列表项的创建时间(ms)
+	double dMaxFrame;	//滚动过程中最长的一帧(ms)
+	double dAvgFrame;
+	int nFrameCreated;	//滚动过程中在帧内新建的列表项数量
+};
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000.0/liFreq.QuadPart;
+}
+
+//模拟一次快速滑动：初速度每帧300像素，每帧衰减2%，帧间隔16ms
+static FLINGRESULT Fling(BOOL bPrewarm)
+{
+	FLINGRESULT ret = {0};
+	SHostWnd host;
+	host.Create(NULL,0,0,400,600);
+	pugi::xml_document xmlDoc;
+	xmlDoc.load_buffer(KBenchLayout,sizeof(KBenchLayout),pugi::parse_default,pugi::encoding_utf16);
+	host.InitFromXml(xmlDoc.child(L"SOUI"));
+	host.GetRoot()->UpdateLayout();
+	CProbeListView *pLv = host.FindChildByName2<CProbeListView>(L"lv_bench");
+
+	CBenchAdapter *pAdapter = new CBenchAdapter;
+	CAutoRefPtr<ILvAdapter> adapter;
+	adapter.Attach(pAdapter);
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	pLv->SetAdapter(adapter);
+	ret.dCreateTime = Elapse(liStart)/(600/40);
+
+	if(bPrewarm)
+	{//首屏显示后的空闲时间
+		while(pLv->PrewarmItemPanels(8));
+	}
+
+	float fSpeed = 300.0f;
+	int nPos = 0, nFrames = 0;
+	double dTotal = 0.0;
+	while(fSpeed > 5.0f)
+	{
+		nPos += (int)fSpeed;
+		fSpeed *= 0.98f;
+		int nCreated = pAdapter->m_nCreated;
+		QueryPerformanceCounter(&liStart);
+		pLv->ScrollTo(nPos);
+		double dFrame = Elapse(liStart);
+		ret.nFrameCreated += pAdapter->m_nCreated - nCreated;
+		if(dFrame > ret.dMaxFrame) ret.dMaxFrame = dFrame;
+		dTotal += dFrame;
+		nFrames++;
+		//帧间的空闲时间
+		QueryPerformanceCounter(&liStart);
+		if(bPrewarm) pLv->PrewarmItemPanels(8);
+		double dIdle = Elapse(liStart);
+		if(dIdle < 16.0) Sleep((DWORD)(16.0-dIdle));
+	}
+	ret.dAvgFrame = dTotal/nFrames;
+	host.DestroyWindow();
+	return ret;
+}
+
+class SListViewPrewarm : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+		m_theApp->RegisterWindowClass<CProbeListView>();
+	}
+
+	virtual void TearDown()
+	{
+		delete m_theApp;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+};
+
+//预创建后滚动过程中不再在帧内创建列表项
+TEST_F(SListViewPrewarm, fling) {
+	FLINGRESULT r1 = Fling(FALSE);
+	FLINGRESULT r2 = Fling(TRUE);
+	EXPECT_GT(r1.nFrameCreated,0);
+	EXPECT_EQ(r2.nFrameCreated,0);
+}
+
+TEST_F(SListViewPrewarm, DISABLED_bench) {
+	FLINGRESULT r1 = Fling(FALSE);
+	FLINGRESULT r2 = Fling(TRUE);
+	printf("panel create: %.3fms/item\n",r1.dCreateTime);
+	printf("fling without prewarm: max frame %.3fms, avg frame %.3fms, %d panels created in frames\n",r1.dMaxFrame,r1.dAvgFrame,r1.nFrameCreated);
+	printf("fling with prewarm:    max frame %.3fms, avg frame %.3fms, %d panels created in frames\n",r2.dMaxFrame,r2.dAvgFrame,r2.nFrameCreated);
+}
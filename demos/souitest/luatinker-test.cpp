@@ -0,0 +1,85 @@
+﻿/*
+	测试lua_tinker的utf8到utf16转换缓存，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <lua.hpp>
+#include "../../components/ScriptModule-LUA/lua_tinker/lua_tinker.h"
+
+TEST(LuaTinker, pushWString) {
+	lua_State *L = luaL_newstate();
+	lua_pushstring(L,"abc\xE4\xB8\xAD\xE6\x96\x87");
+	const wchar_t *p1 = lua_tinker::push_wstring(L,-1);
+	EXPECT_STREQ(p1,L"abc\x4e2d\x6587");
+	lua_pop(L,1);
+	//第二次从缓存中取，返回同一个字符串
+	const wchar_t *p2 = lua_tinker::push_wstring(L,-1);
+	EXPECT_EQ(p1,p2);
+	lua_settop(L,0);
+
+	lua_pushinteger(L,123);
+	EXPECT_STREQ(lua_tinker::read<const wchar_t*>(L,1),L"123");
+	lua_close(L);
+}
+
+//pop返回的指针在下一次pop字符串之前有效，不受转换缓存淘汰及垃圾回收的影响
+TEST(LuaTinker, popLifetime) {
+	lua_State *L = luaL_newstate();
+	lua_pushstring(L,"popped string");
+	const wchar_t *p = lua_tinker::pop<const wchar_t*>(L);
+	for(int i=0;i<2000;i++)
+	{
+		char szBuf[32];
+		sprintf(szBuf,"filler %d",i);
+		lua_pushstring(L,szBuf);
+		lua_tinker::push_wstring(L,-1);
+		lua_pop(L,2);
+	}
+	lua_gc(L,LUA_GCCOLLECT,0);
+	EXPECT_STREQ(p,L"popped string");
+	EXPECT_EQ(lua_gettop(L),0);
+	lua_close(L);
+}
+
+//输出缓存命中及未命中时每次转换的耗时
+TEST(LuaTinker, DISABLED_bench) {
+	lua_State *L = luaL_newstate();
+	const int KStrings = 200;
+	const int KLoops = 1000;
+	for(int i=0;i<KStrings;i++)
+	{
+		char szBuf[64];
+		sprintf(szBuf,"\xE6\x8C\x89\xE9\x92\xAE button %d",i);
+		lua_pushstring(L,szBuf);
+	}
+
+	LARGE_INTEGER liFreq,liStart,liEnd;
+	QueryPerformanceFrequency(&liFreq);
+	QueryPerformanceCounter(&liStart);
+	for(int n=0;n<KLoops;n++)
+	{
+		for(int i=1;i<=KStrings;i++)
+		{
+			lua_tinker::push_wstring(L,i);
+			lua_pop(L,1);
+		}
+	}
+	QueryPerformanceCounter(&liEnd);
+	double dHit = (liEnd.QuadPart-liStart.QuadPart)*1e9/liFreq.QuadPart/(KLoops*KStrings);
+
+	//每个字符串只转换一次，全部未命中
+	int nMiss = KLoops*KStrings/10;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<nMiss;i++)
+	{
+		char szBuf[64];
+		sprintf(szBuf,"\xE6\x8C\x89\xE9\x92\xAE miss %d",i);
+		lua_pushstring(L,szBuf);
+		lua_tinker::push_wstring(L,-1);
+		lua_pop(L,2);
+	}
+	QueryPerformanceCounter(&liEnd);
+	double dMiss = (liEnd.QuadPart-liStart.QuadPart)*1e9/liFreq.QuadPart/nMiss;
+	printf("push_wstring: cached %.1fns, uncached %.1fns (including lua_pushstring)\n",dHit,dMiss);
+	lua_close(L);
+}
@@ -0,0 +1,123 @@
+﻿/*
+	测试SListCtrl的列文本存储区
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <control/SListCtrl.h>
+#include <psapi.h>
+#pragma comment(lib,"psapi.lib")
+
+using namespace SOUI;
+
+TEST(SLvTextArena, alloc) {
+	SLvTextArena arena;
+	SArray<LPTSTR> arrText;
+	for(int i=0;i<10000;i++)
+	{
+		SStringT str;
+		str.Format(_T("item%d"),i);
+		arrText.Add(arena.Alloc(str,str.GetLength()));
+	}
+	//申请新的内存块后已分配的文本保持不变
+	for(int i=0;i<10000;i++)
+	{
+		SStringT str;
+		str.Format(_T("item%d"),i);
+		EXPECT_EQ(str.Compare(arrText[i]),0);
+	}
+	EXPECT_GE(arena.GetCapacity(),arena.GetUsed());
+
+	LPTSTR pszEmpty = arena.Alloc(NULL);
+	EXPECT_EQ(pszEmpty[0],0);
+
+	size_t nUsed = arena.GetUsed();
+	arena.Free(4);
+	EXPECT_EQ(arena.GetWasted(),5u);
+	EXPECT_EQ(arena.GetUsed(),nUsed);
+
+	arena.RemoveAll();
+	EXPECT_EQ(arena.GetCapacity(),0u);
+	EXPECT_EQ(arena.GetUsed(),0u);
+	EXPECT_EQ(arena.GetWasted(),0u);
+}
+
+TEST(SLvTextArena, reserve) {
+	SLvTextArena arena;
+	arena.Reserve(1000);
+	size_t nCapacity = arena.GetCapacity();
+	EXPECT_EQ(nCapacity,1000u);
+	for(int i=0;i<100;i++)
+	{
+		arena.Alloc(_T("123456789"));
+	}
+	//预留的空间用完之前不申请新的内存块
+	EXPECT_EQ(arena.GetCapacity(),nCapacity);
+	EXPECT_EQ(arena.GetUsed(),1000u);
+}
+
+static size_t GetPrivateBytes()
+{
+	PROCESS_MEMORY_COUNTERS_EX pmc = {sizeof(pmc)};
+	GetProcessMemoryInfo(GetCurrentProcess(),(PROCESS_MEMORY_COUNTERS*)&pmc,sizeof(pmc));
+	return pmc.PrivateUsage;
+}
+
+//比较每个子项单独分配字符串与按列保存文本的加载时间和内存
+TEST(SLvTextArena, DISABLED_load) {
+	const int KRows = 200000;
+	const int KCols = 4;
+	TCHAR szText[32];
+
+	size_t szStart = GetPrivateBytes();
+	DWORD dwStart = GetTickCount();
+	SArray<DXLVITEM> arrItems;
+	for(int i=0;i<KRows;i++)
+	{
+		DXLVITEM lvi;
+		lvi.arSubItems = new ArrSubItem();
+		lvi.arSubItems->SetCount(KCols);
+		for(int j=0;j<KCols;j++)
+		{
+			_stprintf(szText,_T("row%d col%d"),i,j);
+			DXLVSUBITEM &lvsi = lvi.arSubItems->GetAt(j);
+			lvsi.strText = _tcsdup(szText);
+			lvsi.cchTextMax = _tcslen(szText);
+		}
+		arrItems.Add(lvi);
+	}
+	DWORD dwItem = GetTickCount()-dwStart;
+	size_t szItem = GetPrivateBytes()-szStart;
+	for(size_t i=0;i<arrItems.GetCount();i++)
+	{
+		for(int j=0;j<KCols;j++) free(arrItems[i].arSubItems->GetAt(j).strText);
+		delete arrItems[i].arSubItems;
+	}
+	arrItems.RemoveAll();
+
+	szStart = GetPrivateBytes();
+	dwStart = GetTickCount();
+	SLvTextArena arenas[KCols];
+	arrItems.SetCount(0,KRows);
+	for(int i=0;i<KRows;i++)
+	{
+		DXLVITEM lvi;
+		lvi.arSubItems = new ArrSubItem();
+		lvi.arSubItems->SetCount(KCols);
+		for(int j=0;j<KCols;j++)
+		{
+			int nLen = _stprintf(szText,_T("row%d col%d"),i,j);
+			DXLVSUBITEM &lvsi = lvi.arSubItems->GetAt(j);
+			lvsi.strText = arenas[j].Alloc(szText,nLen);
+			lvsi.cchTextMax = nLen;
+		}
+		arrItems.Add(lvi);
+	}
+	DWORD dwArena = GetTickCount()-dwStart;
+	size_t szArena = GetPrivateBytes()-szStart;
+	for(size_t i=0;i<arrItems.GetCount();i++)
+	{
+		delete arrItems[i].arSubItems;
+	}
+
+	printf("%d rows x %d cols: per item %u ms %u KB, arena %u ms %u KB\n",KRows,KCols,dwItem,(UINT)(szItem/1024),dwArena,(UINT)(szArena/1024));
+}
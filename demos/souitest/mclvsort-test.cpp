@@ -0,0 +1,228 @@
+﻿/*
+	测试SMCListView的异步排序
+	需要render-gdi和imgdecoder模块，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <control/SMCListView.h>
+#include <helper/SAdapterBase.h>
+
+using namespace SOUI;
+
+static const wchar_t KMcLayout[] =
+L"<SOUI width=\"400\" height=\"600\">"
+L"<root>"
+L"<probemclistview pos=\"0,0,-0,-0\" name=\"mclv_sort\" headerHeight=\"30\">"
+L"<header sortHeader=\"1\">"
+L"<items><item width=\"200\">value</item></items>"
+L"</header>"
+L"<template itemHeight=\"30\">"
+L"<window name=\"col1\"><text pos=\"0,0,-0,-0\" name=\"txt_val\"/></window>"
+L"</template>"
+L"</probemclistview>"
+L"</root>"
+L"</SOUI>";
+
+//暴露SMCListView的排序入口，与点击表头的第一列相同
+class CProbeMcListView : public SMCListView
+{
+	SOUI_CLASS_NAME(CProbeMcListView,L"probemclistview")
+public:
+	void SortFirstColumn()
+	{
+		int nOrder = 0;
+		SHDSORTFLAG stFlag = ST_UP;
+		CancelSort();
+		if(m_adapter->OnSortPrepare(0,&stFlag,1))
+		{
+			StartSort(&nOrder,&stFlag,1);
+		}
+	}
+};
+
+class CSortAdapter : public SMcAdapterBase
+{
+public:
+	CSortAdapter(int nCount):m_nSortDone(0),m_hGate(NULL)
+	{
+		srand(0);
+		m_arrData.SetCount(nCount);
+		for(int i=0;i<nCount;i++) m_arrData[i] = rand()*RAND_MAX+rand();
+	}
+
+	virtual int getCount()
+	{
+		return (int)m_arrData.GetCount();
+	}
+
+	virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate)
+	{
+		if(pItem->GetChildrenCount() == 0)
+		{
+			pItem->InitFromXml(xmlTemplate);
+		}
+	}
+
+	virtual SStringW GetColumnName(int iCol) const
+	{
+		return L"col1";
+	}
+
+	virtual bool OnSortPrepare(int iCol,SHDSORTFLAG * stFlags,int nCols)
+	{
+		return true;
+	}
+
+	virtual int OnSortCompare(int iItem1,int iItem2)
+	{
+		if(m_hGate) ::WaitForSingleObject(m_hGate,INFINITE);
+		return m_arrData[iItem1]<m_arrData[iItem2]?-1:(m_arrData[iItem1]>m_arrData[iItem2]?1:0);
+	}
+
+	virtual void OnSortDone(const int * pIndex,int nCount)
+	{
+		SArray<int> arrData;
+		arrData.SetCount(nCount);
+		for(int i=0;i<nCount;i++) arrData[i] = m_arrData[pIndex[i]];
+		m_arrData.Copy(arrData);
+		m_nSortDone++;
+	}
+
+	BOOL IsSorted() const
+	{
+		for(size_t i=1;i<m_arrData.GetCount();i++)
+		{
+			if(m_arrData[i-1] > m_arrData[i]) return FALSE;
+		}
+		return TRUE;
+	}
+
+	SArray<int> m_arrData;
+	int         m_nSortDone;
+	HANDLE      m_hGate;    //有效时比较函数等待它触发，用来让排序停在工作线程中
+};
+
+//处理消息直到排序完成，排序结果由TIMER_SORT定时器应用
+static void WaitSort(CProbeMcListView *pLv)
+{
+	while(pLv->IsSorting())
+	{
+		MSG msg;
+		if(::PeekMessage(&msg,NULL,0,0,PM_REMOVE))
+		{
+			::TranslateMessage(&msg);
+			::DispatchMessage(&msg);
+		}else
+		{
+			Sleep(1);
+		}
+	}
+}
+
+class SMCListViewSort : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+		m_theApp->RegisterWindowClass<CProbeMcListView>();
+		m_pHost = new SHostWnd;
+		m_pHost->Create(NULL,0,0,400,600);
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer(KMcLayout,sizeof(KMcLayout),pugi::parse_default,pugi::encoding_utf16);
+		m_pHost->InitFromXml(xmlDoc.child(L"SOUI"));
+		m_pHost->GetRoot()->UpdateLayout();
+		m_pLv = m_pHost->FindChildByName2<CProbeMcListView>(L"mclv_sort");
+		ASSERT_TRUE(m_pLv != NULL);
+	}
+
+	virtual void TearDown()
+	{
+		m_pHost->DestroyWindow();
+		delete m_pHost;
+		delete m_theApp;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+	SHostWnd *m_pHost;
+	CProbeMcListView *m_pLv;
+};
+
+TEST_F(SMCListViewSort, async) {
+	CSortAdapter *pAdapter = new CSortAdapter(100000);
+	m_pLv->SetAdapter(pAdapter);
+	m_pLv->SortFirstColumn();
+	EXPECT_TRUE(m_pLv->IsSorting());
+	WaitSort(m_pLv);
+	EXPECT_EQ(pAdapter->m_nSortDone,1);
+	EXPECT_TRUE(pAdapter->IsSorted());
+	pAdapter->Release();
+}
+
+//排序过程中数据变化，排序被放弃，结果不会应用到新数据上
+TEST_F(SMCListViewSort, cancelOnChange) {
+	CSortAdapter *pAdapter = new CSortAdapter(100000);
+	m_pLv->SetAdapter(pAdapter);
+	pAdapter->m_hGate = ::CreateEvent(NULL,TRUE,FALSE,NULL);
+	m_pLv->SortFirstColumn();
+	EXPECT_TRUE(m_pLv->IsSorting());
+	//放行工作线程，放弃排序时需要等待它退出
+	::SetEvent(pAdapter->m_hGate);
+	pAdapter->notifyDataSetChanged();
+	EXPECT_FALSE(m_pLv->IsSorting());
+
+	m_pLv->SortFirstColumn();
+	EXPECT_TRUE(m_pLv->IsSorting());
+	pAdapter->notifyDataSetInvalidated();
+	EXPECT_FALSE(m_pLv->IsSorting());
+
+	//定时器不会再应用已经放弃的排序
+	DWORD dwEnd = GetTickCount() + 100;
+	while(GetTickCount() < dwEnd)
+	{
+		MSG msg;
+		if(::PeekMessage(&msg,NULL,0,0,PM_REMOVE)) ::DispatchMessage(&msg);
+		else Sleep(1);
+	}
+	EXPECT_EQ(pAdapter->m_nSortDone,0);
+	::CloseHandle(pAdapter->m_hGate);
+	pAdapter->m_hGate = NULL;
+	pAdapter->Release();
+}
+
+//输出排序时UI线程的阻塞时间、排序总耗时及放弃排序的等待时间
+TEST_F(SMCListViewSort, DISABLED_bench) {
+	LARGE_INTEGER liFreq,liStart,liEnd;
+	QueryPerformanceFrequency(&liFreq);
+	int nCounts[] = {100000,1000000};
+	for(int i=0;i<ARRAYSIZE(nCounts);i++)
+	{
+		CSortAdapter *pAdapter = new CSortAdapter(nCounts[i]);
+		m_pLv->SetAdapter(pAdapter);
+
+		QueryPerformanceCounter(&liStart);
+		m_pLv->SortFirstColumn();
+		QueryPerformanceCounter(&liEnd);
+		double dBlock = (liEnd.QuadPart-liStart.QuadPart)*1000.0/liFreq.QuadPart;
+		WaitSort(m_pLv);
+		QueryPerformanceCounter(&liEnd);
+		double dTotal = (liEnd.QuadPart-liStart.QuadPart)*1000.0/liFreq.QuadPart;
+
+		m_pLv->SortFirstColumn();
+		Sleep(5);
+		QueryPerformanceCounter(&liStart);
+		pAdapter->notifyDataSetChanged();
+		QueryPerformanceCounter(&liEnd);
+		double dCancel = (liEnd.QuadPart-liStart.QuadPart)*1000.0/liFreq.QuadPart;
+
+		printf("%d rows: ui blocked %.3fms, sorted in %.3fms, cancel on change %.3fms\n",nCounts[i],dBlock,dTotal,dCancel);
+		pAdapter->Release();
+	}
+}
@@ -0,0 +1,265 @@
+﻿/*
+	soui_mem_wrapper内存池测试
+	内存池需要使用ENABLE_SOUI_MEM_POOL(定义SOUI_MEM_POOL)编译utilities
+	性能测试需要render-gdi和imgdecoder模块，默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <process.h>
+
+using namespace SOUI;
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+//跨越各级大小及CRT分配的内存块，重新分配后内容保持不变
+TEST(SouiMemPool, realloc) {
+	const size_t KSizes[] = {1,15,16,17,100,255,256,257,511,512,513,4000};
+	for(int i=0;i<(int)ARRAYSIZE(KSizes);i++)
+	{
+		for(int j=0;j<(int)ARRAYSIZE(KSizes);j++)
+		{
+			BYTE *p = (BYTE*)soui_mem_wrapper::SouiMalloc(KSizes[i]);
+			ASSERT_TRUE(p!=NULL);
+			EXPECT_EQ((ULONG_PTR)0,(ULONG_PTR)p % MEMORY_ALLOCATION_ALIGNMENT);
+			for(size_t k=0;k<KSizes[i];k++) p[k] = (BYTE)(k*7+i);
+			p = (BYTE*)soui_mem_wrapper::SouiRealloc(p,KSizes[j]);
+			ASSERT_TRUE(p!=NULL);
+			size_t szKeep = KSizes[i]<KSizes[j]?KSizes[i]:KSizes[j];
+			int nBad = 0;
+			for(size_t k=0;k<szKeep;k++) if(p[k] != (BYTE)(k*7+i)) nBad++;
+			EXPECT_EQ(0,nBad) << KSizes[i] << "->" << KSizes[j];
+			soui_mem_wrapper::SouiFree(p);
+		}
+	}
+}
+
+//分配轨迹：大小按加载布局时采样到的分布生成，释放以后进先出为主，夹杂随机释放和重新分配
+struct MEMTRACE
+{
+	SArray<UINT> arrSize;   //0表示释放
+	SArray<UINT> arrSlot;
+};
+
+class SizeSampler
+{
+public:
+	SizeSampler():m_nTotal(0){}
+
+	void Add(UINT uMin, UINT uMax, LONG nWeight)
+	{
+		if(nWeight<=0) return;
+		RANGE r={uMin,uMax,m_nTotal+nWeight};
+		m_arrRange.Add(r);
+		m_nTotal = r.nCumul;
+	}
+
+	UINT Sample() const
+	{
+		LONG n = (LONG)(((rand()<<15)|rand()) % m_nTotal);
+		for(size_t i=0;i<m_arrRange.GetCount();i++)
+		{
+			const RANGE &r = m_arrRange[i];
+			if(n < r.nCumul) return r.uMin + rand()%(r.uMax-r.uMin+1);
+		}
+		return 16;
+	}
+
+	BOOL IsEmpty() const {return m_nTotal==0;}
+private:
+	struct RANGE{UINT uMin,uMax;LONG nCumul;};
+	SArray<RANGE> m_arrRange;
+	LONG m_nTotal;
+};
+
+static void BuildTrace(const SizeSampler &sampler, int nOps, int nSlots, MEMTRACE &trace)
+{
+	SArray<int> arrLive;    //已分配的槽位，按分配顺序
+	SArray<int> arrFree;
+	for(int i=nSlots-1;i>=0;i--) arrFree.Add(i);
+	for(int i=0;i<nOps;i++)
+	{
+		int nAction = rand()%100;
+		if(arrLive.IsEmpty() || (nAction<55 && !arrFree.IsEmpty()))
+		{
+			int iSlot = arrFree[arrFree.GetCount()-1];
+			arrFree.RemoveAt(arrFree.GetCount()-1);
+			arrLive.Add(iSlot);
+			trace.arrSize.Add(sampler.Sample());
+			trace.arrSlot.Add(iSlot);
+		}else
+		{
+			size_t iLive = nAction<85?arrLive.GetCount()-1:rand()%arrLive.GetCount();
+			int iSlot = arrLive[iLive];
+			if(nAction>=95)
+			{//重新分配，槽位保持已分配
+				trace.arrSize.Add(sampler.Sample()|0x80000000);
+			}else
+			{//随机释放时用最后一个元素填补空位
+				arrLive[iLive] = arrLive[arrLive.GetCount()-1];
+				arrLive.RemoveAt(arrLive.GetCount()-1);
+				arrFree.Add(iSlot);
+				trace.arrSize.Add(0);
+			}
+			trace.arrSlot.Add(iSlot);
+		}
+	}
+	for(size_t i=0;i<arrLive.GetCount();i++)
+	{
+		trace.arrSize.Add(0);
+		trace.arrSlot.Add(arrLive[i]);
+	}
+}
+
+typedef void * (*FunMalloc)(size_t);
+typedef void * (*FunRealloc)(void *,size_t);
+typedef void (*FunFree)(void *);
+
+struct REPLAYPARAM
+{
+	const MEMTRACE *pTrace;
+	int nSlots;
+	FunMalloc fnMalloc;
+	FunRealloc fnRealloc;
+	FunFree fnFree;
+};
+
+static unsigned int __stdcall Replay(void *p)
+{
+	REPLAYPARAM *param = (REPLAYPARAM*)p;
+	void **pSlots = (void**)calloc(param->nSlots,sizeof(void*));
+	const MEMTRACE &trace = *param->pTrace;
+	for(size_t i=0;i<trace.arrSize.GetCount();i++)
+	{
+		UINT uSize = trace.arrSize[i];
+		void *&pMem = pSlots[trace.arrSlot[i]];
+		if(uSize == 0)
+			param->fnFree(pMem),pMem=NULL;
+		else if(uSize & 0x80000000)
+			pMem = param->fnRealloc(pMem,uSize&0x7FFFFFFF);
+		else
+			pMem = param->fnMalloc(uSize);
+	}
+	free(pSlots);
+	return 0;
+}
+
+static double ReplayThreads(REPLAYPARAM &param, int nThreads)
+{
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	if(nThreads == 1)
+	{
+		Replay(&param);
+	}else
+	{
+		HANDLE hThreads[8];
+		for(int i=0;i<nThreads;i++) hThreads[i] = (HANDLE)_beginthreadex(NULL,0,Replay,&param,0,NULL);
+		WaitForMultipleObjects(nThreads,hThreads,TRUE,INFINITE);
+		for(int i=0;i<nThreads;i++) CloseHandle(hThreads[i]);
+	}
+	return Elapse(liStart);
+}
+
+static void * CrtMalloc(size_t sz){return malloc(sz);}
+static void * CrtRealloc(void *p,size_t sz){return realloc(p,sz);}
+static void CrtFree(void *p){free(p);}
+
+//加载一个包含各种控件的布局，采样期间各级内存块的分配次数
+static BOOL CaptureLayoutSizes(SizeSampler &sampler)
+{
+	SComMgr comMgr;
+	CAutoRefPtr<IImgDecoderFactory> pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> pRenderFactory;
+	if(!comMgr.CreateRender_GDI((IObjRef**)&pRenderFactory)) return FALSE;
+	if(!comMgr.CreateImgDecoder((IObjRef**)&pImgDecoderFactory)) return FALSE;
+	pRenderFactory->SetImgDecoderFactory(pImgDecoderFactory);
+	SApplication *theApp = new SApplication(pRenderFactory,GetModuleHandle(NULL));
+
+	SStringW strXml = L"<SOUI width=\"800\" height=\"600\"><root layout=\"vbox\">";
+	for(int i=0;i<200;i++)
+	{
+		strXml += SStringW().Format(L"<window layout=\"hbox\" size=\"-1,24\" name=\"row%d\">"
+			L"<text size=\"100,-1\" colorText=\"#333333\">label %d</text>"
+			L"<button size=\"80,-1\" name=\"btn%d\" tip=\"button %d\">ok</button>"
+			L"<check size=\"80,-1\" checked=\"%d\">option</check>"
+			L"</window>",i,i,i,i,i%2);
+	}
+	strXml += L"</root></SOUI>";
+
+	SouiMemStats before,after;
+	BOOL bPool = soui_mem_wrapper::SouiGetMemStats(&before);
+	{
+		SHostWnd host;
+		host.Create(NULL,0,0,800,600);
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer((LPCWSTR)strXml,strXml.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+		host.InitFromXml(xmlDoc.child(L"SOUI"));
+		host.GetRoot()->UpdateLayout();
+		host.DestroyWindow();
+	}
+	soui_mem_wrapper::SouiGetMemStats(&after);
+	delete theApp;
+	if(!bPool) return FALSE;
+
+	UINT uMin = 1;
+	for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+	{
+		sampler.Add(uMin,after.uClassSize[i],after.nClassAllocs[i]-before.nClassAllocs[i]);
+		uMin = after.uClassSize[i]+1;
+	}
+	sampler.Add(uMin,4096,after.nLargeAllocs-before.nLargeAllocs);
+	return !sampler.IsEmpty();
+}
+
+TEST(SouiMemPool, DISABLED_bench) {
+	SizeSampler sampler;
+	if(CaptureLayoutSizes(sampler))
+	{
+		printf("size distribution captured from loading a 200-row layout\n");
+	}else
+	{//没有启用内存池时无法采样，使用典型分布
+		printf("SOUI_MEM_POOL is not defined, replaying a default distribution against the CRT twice\n");
+		const UINT KSizes[] = {16,32,48,64,96,128,192,256,512,4096};
+		const LONG KWeights[] = {30,25,12,10,8,5,4,3,2,1};
+		UINT uMin = 1;
+		for(int i=0;i<(int)ARRAYSIZE(KSizes);i++)
+		{
+			sampler.Add(uMin,KSizes[i],KWeights[i]);
+			uMin = KSizes[i]+1;
+		}
+	}
+
+	srand(6);
+	const int KOps = 1000000, KSlots = 20000;
+	MEMTRACE trace;
+	BuildTrace(sampler,KOps,KSlots,trace);
+
+	REPLAYPARAM param = {&trace,KSlots,soui_mem_wrapper::SouiMalloc,soui_mem_wrapper::SouiRealloc,soui_mem_wrapper::SouiFree};
+	REPLAYPARAM paramCrt = {&trace,KSlots,CrtMalloc,CrtRealloc,CrtFree};
+	size_t nOps = trace.arrSize.GetCount();
+
+	SouiMemStats before;
+	soui_mem_wrapper::SouiGetMemStats(&before);
+	double dPool1 = ReplayThreads(param,1);
+	SouiMemStats after;
+	soui_mem_wrapper::SouiGetMemStats(&after);
+	double dCrt1 = ReplayThreads(paramCrt,1);
+	double dPool4 = ReplayThreads(param,4);
+	double dCrt4 = ReplayThreads(paramCrt,4);
+
+	printf("%d ops, 1 thread: pool %.1fns/op, crt %.1fns/op\n",(int)nOps,dPool1*1000/nOps,dCrt1*1000/nOps);
+	printf("%d ops, 4 threads: pool %.1fns/op, crt %.1fns/op\n",(int)nOps*4,dPool4*1000/(nOps*4),dCrt4*1000/(nOps*4));
+	if(after.szPeakBytes)
+	{
+		printf("peak live (process) %u bytes, pool holds %u bytes from crt, live after replay %u (was %u)\n",
+			(UINT)after.szPeakBytes,(UINT)after.szPoolBytes,(UINT)after.szLiveBytes,(UINT)before.szLiveBytes);
+		EXPECT_EQ(before.szLiveBytes,after.szLiveBytes);
+	}
+}
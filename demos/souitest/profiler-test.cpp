@@ -0,0 +1,106 @@
+﻿/*
+	测试帧性能分析器
+*/
+#define SOUI_PROFILER
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <process.h>
+#include <profiler.h>
+#include <stdio.h>
+#include <string>
+
+using namespace SOUI;
+
+static void ProfiledWork(int nDepth)
+{
+	SPROFILE_SCOPE_ARG("work",L"\"arg\"\\");
+	if(nDepth>0) ProfiledWork(nDepth-1);
+}
+
+static unsigned int __stdcall ProfileThread(void *)
+{
+	for(int i=0;i<100;i++) ProfiledWork(0);
+	return 0;
+}
+
+static std::string ReadFileA(LPCWSTR pszFileName)
+{
+	std::string str;
+	FILE *f = _wfopen(pszFileName,L"rb");
+	if(!f) return str;
+	char szBuf[4096];
+	size_t nRead;
+	while((nRead = fread(szBuf,1,sizeof(szBuf),f))>0) str.append(szBuf,nRead);
+	fclose(f);
+	return str;
+}
+
+TEST(SProfiler, record) {
+	SProfiler::Enable(FALSE);
+	SProfiler::Reset();
+	ProfiledWork(3);
+	EXPECT_EQ(SProfiler::GetEventCount(),0u);	//没有开始记录时不写入
+
+	SProfiler::Enable(TRUE);
+	ProfiledWork(3);
+	EXPECT_EQ(SProfiler::GetEventCount(),4u);
+
+	HANDLE hThread = (HANDLE)_beginthreadex(NULL,0,ProfileThread,NULL,0,NULL);
+	WaitForSingleObject(hThread,INFINITE);
+	CloseHandle(hThread);
+	SProfiler::Enable(FALSE);
+	EXPECT_EQ(SProfiler::GetEventCount(),104u);
+
+	WCHAR szPath[MAX_PATH],szFile[MAX_PATH];
+	GetTempPathW(MAX_PATH,szPath);
+	GetTempFileNameW(szPath,L"prf",0,szFile);
+	EXPECT_TRUE(SProfiler::ExportChromeTrace(szFile));
+	std::string strJson = ReadFileA(szFile);
+	DeleteFileW(szFile);
+
+	EXPECT_EQ(strJson.find("{\"traceEvents\":["),0u);
+	EXPECT_NE(strJson.find("\"ph\":\"X\""),std::string::npos);
+	EXPECT_NE(strJson.find("\"args\":{\"arg\":\"\\\"arg\\\"\\\\\"}"),std::string::npos);
+	size_t nEvents = 0;
+	for(size_t pos = strJson.find("\"name\":\"work\"");pos!=std::string::npos;pos = strJson.find("\"name\":\"work\"",pos+1)) nEvents++;
+	EXPECT_EQ(nEvents,104u);
+
+	SProfiler::Reset();
+	EXPECT_EQ(SProfiler::GetEventCount(),0u);
+}
+
+//编译了计时标记但没有开始记录时的开销
+TEST(SProfiler, DISABLED_overhead) {
+	const int KLoops = 100000000;
+	SProfiler::Enable(FALSE);
+	volatile int nSum = 0;
+
+	LARGE_INTEGER freq,t0,t1,t2,t3;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t0);
+	for(int i=0;i<KLoops;i++)
+	{
+		nSum += i;
+	}
+	QueryPerformanceCounter(&t1);
+	for(int i=0;i<KLoops;i++)
+	{
+		SPROFILE_SCOPE("disabled");
+		nSum += i;
+	}
+	QueryPerformanceCounter(&t2);
+	SProfiler::Enable(TRUE);
+	for(int i=0;i<KLoops/100;i++)
+	{
+		SPROFILE_SCOPE("enabled");
+		nSum += i;
+	}
+	QueryPerformanceCounter(&t3);
+	SProfiler::Enable(FALSE);
+	SProfiler::Reset();
+
+	double dScale = 1e9/freq.QuadPart;
+	printf("per scope: disabled %.2f ns, enabled %.2f ns\n",
+		((t2.QuadPart-t1.QuadPart)-(t1.QuadPart-t0.QuadPart))*dScale/KLoops,
+		(t3.QuadPart-t2.QuadPart)*dScale/(KLoops/100));
+}
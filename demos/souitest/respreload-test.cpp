@@ -0,0 +1,226 @@
+﻿/*
+	测试皮肤图片预加载
+	需要render-gdi和imgdecoder模块，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <res.mgr/SResProvider.h>
+#include <res.mgr/SResPreloader.h>
+#include <helper/SplitString.h>
+#include <vector>
+
+using namespace SOUI;
+
+//生成nWid*nHei的32位BMP文件数据
+static void MakeBmp(int nWid, int nHei, DWORD dwSeed, std::vector<BYTE> &arrBmp)
+{
+	BITMAPFILEHEADER bfh = {0};
+	BITMAPINFOHEADER bih = {0};
+	DWORD szBits = nWid*nHei*4;
+	bfh.bfType = 0x4D42;
+	bfh.bfOffBits = sizeof(bfh)+sizeof(bih);
+	bfh.bfSize = bfh.bfOffBits + szBits;
+	bih.biSize = sizeof(bih);
+	bih.biWidth = nWid;
+	bih.biHeight = -nHei;
+	bih.biPlanes = 1;
+	bih.biBitCount = 32;
+	bih.biCompression = BI_RGB;
+	arrBmp.resize(bfh.bfSize);
+	memcpy(&arrBmp[0],&bfh,sizeof(bfh));
+	memcpy(&arrBmp[sizeof(bfh)],&bih,sizeof(bih));
+	DWORD *pBits = (DWORD*)&arrBmp[bfh.bfOffBits];
+	for(int i=0;i<nWid*nHei;i++) pBits[i] = 0xFF000000 | (dwSeed*2654435761u + i);
+}
+
+//内存中的资源包，img:imgN为BMP图片。LoadImage被重载：只返回左上角的一半，用来确认预加载使用了资源包的LoadImage
+class SMemImgProvider : public TObjRefImpl<IResProvider>
+{
+public:
+	SMemImgProvider(int nImgs, int nSize):m_nImgs(nImgs),m_nSize(nSize),m_nLoadImage(0),m_nRawBuffer(0)
+	{
+		m_arrBmp.resize(nImgs);
+		for(int i=0;i<nImgs;i++) MakeBmp(nSize,nSize,i,m_arrBmp[i]);
+	}
+
+	int m_nImgs, m_nSize;
+	volatile LONG m_nLoadImage, m_nRawBuffer;
+	std::vector<std::vector<BYTE> > m_arrBmp;
+
+	int Index(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		if(_tcsicmp(pszType,_T("img"))!=0 || _tcsnicmp(pszResName,_T("img"),3)!=0) return -1;
+		int i = _ttoi(pszResName+3);
+		return (i>=0 && i<m_nImgs)?i:-1;
+	}
+
+	BOOL Init(WPARAM wParam,LPARAM lParam){return TRUE;}
+	BOOL HasResource(LPCTSTR pszType,LPCTSTR pszResName){return Index(pszType,pszResName)!=-1;}
+	HICON LoadIcon(LPCTSTR pszResName,int cx=0,int cy=0){return NULL;}
+	HBITMAP LoadBitmap(LPCTSTR pszResName){return NULL;}
+	HCURSOR LoadCursor(LPCTSTR pszResName){return NULL;}
+	IBitmap * LoadImage(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		int i = Index(pszType,pszResName);
+		if(i == -1) return NULL;
+		InterlockedIncrement(&m_nLoadImage);
+		CAutoRefPtr<IBitmap> pFull;
+		pFull.Attach(SResLoadFromMemory::LoadImage(&m_arrBmp[i][0],m_arrBmp[i].size()));
+		if(!pFull) return NULL;
+		IBitmap *pHalf = NULL;
+		GETRENDERFACTORY->CreateBitmap(&pHalf);
+		pHalf->Init(m_nSize/2,m_nSize/2,NULL);
+		return pHalf;
+	}
+	IImgX * LoadImgX(LPCTSTR pszType,LPCTSTR pszResName){return NULL;}
+	size_t GetRawBufferSize(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		int i = Index(pszType,pszResName);
+		return i==-1?0:m_arrBmp[i].size();
+	}
+	BOOL GetRawBuffer(LPCTSTR pszType,LPCTSTR pszResName,LPVOID pBuf,size_t size)
+	{
+		int i = Index(pszType,pszResName);
+		if(i==-1 || size<m_arrBmp[i].size()) return FALSE;
+		InterlockedIncrement(&m_nRawBuffer);
+		memcpy(pBuf,&m_arrBmp[i][0],m_arrBmp[i].size());
+		return TRUE;
+	}
+};
+
+//和gif,apng皮肤一样自己读取src的数据，不调用LoadImage
+class SProbeRawSkin : public SSkinObjBase
+{
+	SOUI_CLASS_NAME(SProbeRawSkin,L"proberawskin")
+public:
+	SOUI_ATTRS_BEGIN()
+		ATTR_CUSTOM(L"src",OnAttrSrc)
+	SOUI_ATTRS_END()
+protected:
+	HRESULT OnAttrSrc(const SStringW &strValue,BOOL bLoading)
+	{
+		SStringTList strLst;
+		if(2 != ParseResID(S_CW2T(strValue),strLst)) return E_FAIL;
+		size_t szBuf = GETRESPROVIDER->GetRawBufferSize(strLst[0],strLst[1]);
+		SArray<BYTE> arrBuf;
+		arrBuf.SetCount(szBuf);
+		return (szBuf && GETRESPROVIDER->GetRawBuffer(strLst[0],strLst[1],arrBuf.GetData(),szBuf))?S_OK:E_FAIL;
+	}
+	virtual void _Draw(IRenderTarget *pRT, LPCRECT rcDraw, DWORD dwState,BYTE byAlpha){}
+};
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+class SResPreload : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+		m_theApp->RegisterSkinClass<SProbeRawSkin>();
+	}
+
+	virtual void TearDown()
+	{
+		delete m_theApp;
+	}
+
+	//和SUiDefInfo相同的流程：提交预加载任务，创建皮肤，丢弃没有使用的任务
+	double LoadSkins(IResProvider *pResProvider, const SStringW &strSkins, SSkinPool *pSkinPool)
+	{
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer((LPCWSTR)strSkins,strSkins.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+		LARGE_INTEGER liStart;
+		QueryPerformanceCounter(&liStart);
+		SResPreloader &preloader = m_theApp->GetResPreloader();
+		preloader.PreloadSkinImages(pResProvider,xmlDoc.child(L"skin"));
+		pSkinPool->LoadSkins(xmlDoc.child(L"skin"));
+		preloader.Discard(pResProvider);
+		return Elapse(liStart);
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+};
+
+//预加载通过资源包的LoadImage加载，每个图片只加载一次，不使用LoadImage的皮肤类型不预加载
+TEST_F(SResPreload, providerLoadImage) {
+	const int KImgs = 20;
+	SMemImgProvider *pProvider = new SMemImgProvider(KImgs,64);
+	m_theApp->AddResProvider(pProvider,NULL);
+
+	SStringW strSkins = L"<skin>";
+	for(int i=0;i<KImgs;i++) strSkins += SStringW().Format(L"<imglist name=\"s%d\" src=\"img:img%d\"/>",i,i);
+	strSkins += L"<proberawskin name=\"raw\" src=\"img:img0\"/>";
+	strSkins += L"</skin>";
+
+	SResPreloadStats before,after;
+	m_theApp->GetResPreloader().GetStats(before);
+	SSkinPool *pSkinPool = new SSkinPool;
+	LoadSkins(pProvider,strSkins,pSkinPool);
+	m_theApp->GetResPreloader().GetStats(after);
+
+	EXPECT_EQ(KImgs,(int)pProvider->m_nLoadImage);
+	EXPECT_EQ(1,(int)pProvider->m_nRawBuffer);
+	EXPECT_EQ(KImgs,after.nSubmitted-before.nSubmitted);
+	EXPECT_EQ(1,after.nSkipped-before.nSkipped);
+	EXPECT_EQ(0,after.nDiscarded-before.nDiscarded);
+	for(int i=0;i<KImgs;i++)
+	{
+		SSkinImgList *pSkin = sobj_cast<SSkinImgList>(pSkinPool->GetSkin(SStringW().Format(L"s%d",i),100));
+		ASSERT_TRUE(pSkin && pSkin->GetImage());
+		EXPECT_EQ(32u,pSkin->GetImage()->Width());
+	}
+	pSkinPool->Release();
+	m_theApp->RemoveResProvider(pProvider);
+	pProvider->Release();
+}
+
+//200个256*256图片的皮肤，比较预加载和直接加载的启动时间
+TEST_F(SResPreload, DISABLED_bench) {
+	const int KImgs = 200;
+	SMemImgProvider *pProvider = new SMemImgProvider(KImgs,256);
+	m_theApp->AddResProvider(pProvider,NULL);
+
+	SStringW strSkins = L"<skin>";
+	for(int i=0;i<KImgs;i++) strSkins += SStringW().Format(L"<imgframe name=\"s%d\" src=\"img:img%d\" margin=\"4,4,4,4\"/>",i,i);
+	strSkins += L"</skin>";
+
+	SResPreloader &preloader = m_theApp->GetResPreloader();
+	const int KRounds = 5;
+	double dDirect = 0, dPreload = 0;
+	SResPreloadStats before,after;
+	preloader.GetStats(before);
+	for(int n=0;n<KRounds;n++)
+	{
+		preloader.SetMaxThreads(-1);
+		SSkinPool *pSkinPool = new SSkinPool;
+		dDirect += LoadSkins(pProvider,strSkins,pSkinPool);
+		pSkinPool->Release();
+
+		preloader.SetMaxThreads(0);
+		pSkinPool = new SSkinPool;
+		dPreload += LoadSkins(pProvider,strSkins,pSkinPool);
+		pSkinPool->Release();
+	}
+	preloader.GetStats(after);
+
+	printf("%d skins: direct %.2fms, preloaded %.2fms\n",KImgs,dDirect/1000/KRounds,dPreload/1000/KRounds);
+	printf("per round: worker load %.2fms, ui wait %.2fms (%d waits), inline %d\n",
+		(after.dwDecodeTime-before.dwDecodeTime)/1000.0/KRounds,(after.dwWaitTime-before.dwWaitTime)/1000.0/KRounds,
+		(after.nWaited-before.nWaited)/KRounds,(after.nInline-before.nInline)/KRounds);
+	m_theApp->RemoveResProvider(pProvider);
+	pProvider->Release();
+}
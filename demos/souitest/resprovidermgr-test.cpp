@@ -0,0 +1,198 @@
+﻿/*
+	测试SResProviderMgr的资源索引
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <res.mgr/SResProviderMgr.h>
+#include <helper/SplitString.h>
+
+using namespace SOUI;
+
+//不支持枚举的资源包，只能通过HasResource查找
+class SProbeOnlyProvider : public TObjRefImpl<IResProvider>
+{
+public:
+	SStringT m_strName;
+
+	BOOL Init(WPARAM wParam,LPARAM lParam){return TRUE;}
+	BOOL HasResource(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		return _tcsicmp(pszType,_T("img"))==0 && m_strName.CompareNoCase(pszResName)==0;
+	}
+	HICON LoadIcon(LPCTSTR pszResName,int cx=0,int cy=0){return NULL;}
+	HBITMAP LoadBitmap(LPCTSTR pszResName){return NULL;}
+	HCURSOR LoadCursor(LPCTSTR pszResName){return NULL;}
+	IBitmap * LoadImage(LPCTSTR pszType,LPCTSTR pszResName){return NULL;}
+	IImgX * LoadImgX(LPCTSTR pszType,LPCTSTR pszResName){return NULL;}
+	size_t GetRawBufferSize(LPCTSTR pszType,LPCTSTR pszResName){return 0;}
+	BOOL GetRawBuffer(LPCTSTR pszType,LPCTSTR pszResName,LPVOID pBuf,size_t size){return FALSE;}
+};
+
+//在HasResource中移除另一个资源包，模拟替换索引时还有读者在使用旧索引
+class SReentrantProvider : public SProbeOnlyProvider
+{
+public:
+	SResProviderMgr *m_pMgr;
+	IResProvider *m_pRemove;
+
+	BOOL HasResource(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		if(m_pRemove)
+		{
+			IResProvider *pRemove = m_pRemove;
+			m_pRemove = NULL;
+			m_pMgr->RemoveResProvider(pRemove);
+		}
+		return SProbeOnlyProvider::HasResource(pszType,pszResName);
+	}
+};
+
+//记录同时进入资源包的线程数，资源包的调用都在资源包锁内时不会重叠
+class SSerialCheckProvider : public SProbeOnlyProvider
+{
+public:
+	volatile LONG m_nInside;
+	volatile LONG m_nOverlaps;
+
+	SSerialCheckProvider():m_nInside(0),m_nOverlaps(0){}
+
+	BOOL HasResource(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		Enter();
+		BOOL bRet = _tcsicmp(pszType,_T("img"))==0;
+		Leave();
+		return bRet;
+	}
+	IBitmap * LoadImage(LPCTSTR pszType,LPCTSTR pszResName)
+	{
+		Enter();
+		Sleep(1);
+		Leave();
+		return NULL;
+	}
+protected:
+	void Enter()
+	{
+		if(InterlockedIncrement(&m_nInside)>1) InterlockedIncrement(&m_nOverlaps);
+		Sleep(0);
+	}
+	void Leave()
+	{
+		InterlockedDecrement(&m_nInside);
+	}
+};
+
+//在临时目录中生成只有索引文件的文件夹资源包，pszImgs为逗号分隔的img资源名
+static IResProvider * CreateFilesProvider(LPCTSTR pszDir,LPCTSTR pszImgs)
+{
+	TCHAR szPath[MAX_PATH];
+	GetTempPath(MAX_PATH,szPath);
+	SStringT strDir = SStringT(szPath) + pszDir;
+	CreateDirectory(strDir,NULL);
+
+	pugi::xml_document xmlDoc;
+	pugi::xml_node xmlImg = xmlDoc.append_child(L"resource").append_child(L"img");
+	SStringTList lstImg;
+	SplitString(SStringT(pszImgs),_T(','),lstImg);
+	for(size_t i=0;i<lstImg.GetCount();i++)
+	{
+		pugi::xml_node xmlFile = xmlImg.append_child(L"file");
+		xmlFile.append_attribute(L"name").set_value(S_CT2W(lstImg[i]));
+		xmlFile.append_attribute(L"path").set_value(S_CT2W(lstImg[i]+_T(".png")));
+	}
+	xmlDoc.save_file(strDir+_T("\\")+UIRES_INDEX);
+
+	CAutoRefPtr<IResProvider> pResProvider;
+	CreateResProvider(RES_FILE,(IObjRef**)&pResProvider);
+	if(!pResProvider->Init((WPARAM)(LPCTSTR)strDir,0)) return NULL;
+	pResProvider->AddRef();
+	return pResProvider;
+}
+
+TEST(ResProviderMgr, precedence) {
+	SResProviderMgr mgr;
+	IResProvider *pRes1 = CreateFilesProvider(_T("souitest-res1"),_T("a,b,c"));
+	IResProvider *pRes2 = CreateFilesProvider(_T("souitest-res2"),_T("b,d"));
+	IResProvider *pRes3 = CreateFilesProvider(_T("souitest-res3"),_T("c,d,e"));
+	ASSERT_TRUE(pRes1 && pRes2 && pRes3);
+	SProbeOnlyProvider *pProbe = new SProbeOnlyProvider;
+	pProbe->m_strName = _T("e");
+
+	mgr.AddResProvider(pRes1,NULL);
+	mgr.AddResProvider(pRes2,NULL);
+	mgr.AddResProvider(pProbe,NULL);
+	mgr.AddResProvider(pRes3,NULL);
+
+	//从表尾向表头查找
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("a")),pRes1);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("b")),pRes2);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("c")),pRes3);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("IMG"),_T("D")),pRes3);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("e")),pRes3);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("x")),(IResProvider*)NULL);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("layout"),_T("a")),(IResProvider*)NULL);
+
+	//不支持枚举的资源包排在索引结果之前时优先使用
+	mgr.RemoveResProvider(pRes3);
+	pProbe->m_strName = _T("b");
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("b")),(IResProvider*)pProbe);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("c")),pRes1);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("e")),(IResProvider*)NULL);
+
+	mgr.RemoveResProvider(pProbe);
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("b")),pRes2);
+	EXPECT_TRUE(mgr.HasResource(_T("img"),_T("a")));
+
+	mgr.RemoveAll();
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("a")),(IResProvider*)NULL);
+
+	pRes1->Release();
+	pRes2->Release();
+	pRes3->Release();
+	pProbe->Release();
+}
+
+TEST(ResProviderMgr, retiredIndexFreedByLastReader) {
+	SResProviderMgr mgr;
+	IResProvider *pRes1 = CreateFilesProvider(_T("souitest-res1"),_T("a,b,c"));
+	ASSERT_TRUE(pRes1 != NULL);
+	SReentrantProvider *pProbe = new SReentrantProvider;
+	pProbe->m_strName = _T("e");
+	pProbe->m_pMgr = &mgr;
+	pProbe->m_pRemove = pRes1;
+
+	mgr.AddResProvider(pRes1,NULL);
+	mgr.AddResProvider(pProbe,NULL);
+
+	//查找时先调用pProbe->HasResource，其中移除pRes1并替换索引，旧索引还在使用，仍然返回pRes1
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("a")),pRes1);
+	//离开查找后旧索引被释放，只剩下测试代码持有的引用
+	EXPECT_EQ(2,pRes1->AddRef());
+	pRes1->Release();
+	EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("a")),(IResProvider*)NULL);
+
+	mgr.RemoveAll();
+	pRes1->Release();
+	pProbe->Release();
+}
+
+TEST(ResProviderMgr, hasResourceUnderProviderLock) {
+	SResProviderMgr mgr;
+	SSerialCheckProvider *pProbe = new SSerialCheckProvider;
+	mgr.AddResProvider(pProbe,NULL);
+
+	//工作线程调用LoadImage的同时在当前线程查找资源，不支持枚举的资源包需要调用HasResource
+	for(int i=0;i<50;i++)
+	{
+		EXPECT_TRUE(mgr.GetResPreloader().PreloadImage(pProbe,_T("img"),SStringT().Format(_T("p%d"),i)));
+	}
+	for(int i=0;i<2000;i++)
+	{
+		EXPECT_EQ(mgr.GetMatchResProvider(_T("img"),_T("x")),(IResProvider*)pProbe);
+	}
+	mgr.GetResPreloader().Discard(NULL);
+	EXPECT_EQ(0,pProbe->m_nOverlaps);
+
+	mgr.RemoveAll();
+	pProbe->Release();
+}
@@ -13,15 +13,20 @@ INCLUDEPATH += . \
 			   ../../soui/include \
 			   ../../components \
 			   ../../third-part/gtest/include \
+			   ../../third-part \
+			   ../../third-part/lua-52/src \
+
+#controls.extendеļstdafx.hqmakeΪļð·extend-incֻһļ
+INCLUDEPATH += extend-inc
 
 dir = ../..
 include($$dir/common.pri)
 
 CONFIG(debug,debug|release){
-	LIBS += utilitiesd.lib souid.lib gtestd.lib
+	LIBS += utilitiesd.lib souid.lib gtestd.lib sqlite3d.lib translatord.lib lua-52d.lib
 }
 else{
-	LIBS += utilities.lib soui.lib gtest.lib
+	LIBS += utilities.lib soui.lib gtest.lib sqlite3.lib translator.lib lua-52.lib
 }
 
 #ָɵexeǻڿ̨
@@ -32,7 +37,33 @@ DEFINES += _VARIADIC_MAX=10
 
 # Input
 SOURCES += souitest.cpp \
-           slog-test.cpp
+           slog-test.cpp \
+           lvtextarena-test.cpp \
+           resprovidermgr-test.cpp \
+           interpolator-test.cpp \
+           profiler-test.cpp \
+           listviewprewarm-test.cpp \
+           tilelocator-test.cpp \
+           hittestindex-test.cpp \
+           sqliteadapter-test.cpp \
+           ../../controls.extend/sqlite/SSqliteAdapter.cpp \
+           ../../controls.extend/image3d/3dtransform.cpp \
+           ../../controls.extend/image3d/3dlib.cpp \
+           ../../controls.extend/image3d/3dmatrix.cpp \
+           ../../components/ScriptModule-LUA/lua_tinker/lua_tinker.cpp \
+           strcpcvt-test.cpp \
+           translator-test.cpp \
+           aniframe-test.cpp \
+           mclvsort-test.cpp \
+           image3d-test.cpp \
+           luatinker-test.cpp \
+           wndstate-test.cpp \
+           autocache-test.cpp \
+           tstringformat-test.cpp \
+           mempool-test.cpp \
+           respreload-test.cpp \
+           xmldoccache-test.cpp \
+           atomtable-test.cpp
 
 
 
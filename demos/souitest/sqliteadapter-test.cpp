@@ -0,0 +1,154 @@
+﻿/*
+	测试基于sqlite3的列表Adapter
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include "../../controls.extend/sqlite/SSqliteAdapter.h"
+
+using namespace SOUI;
+
+static const int KRows = 100000;
+
+//生成数据库，默认为内存数据库，第i行(0开始)的id为i+1，name为row<i>
+static sqlite3 * CreateTestDb(const char *pszFile = ":memory:")
+{
+	sqlite3 *pDb = NULL;
+	sqlite3_open(pszFile,&pDb);
+	sqlite3_exec(pDb,"CREATE TABLE t(id INTEGER PRIMARY KEY,name TEXT,val INTEGER)",NULL,NULL,NULL);
+	sqlite3_exec(pDb,"BEGIN",NULL,NULL,NULL);
+	sqlite3_stmt *pStmt = NULL;
+	sqlite3_prepare_v2(pDb,"INSERT INTO t(id,name,val) VALUES(?,?,?)",-1,&pStmt,NULL);
+	for(int i=0;i<KRows;i++)
+	{
+		char szName[32];
+		sprintf(szName,"row%d",i);
+		sqlite3_bind_int(pStmt,1,i+1);
+		sqlite3_bind_text(pStmt,2,szName,-1,SQLITE_TRANSIENT);
+		sqlite3_bind_int(pStmt,3,i*2);
+		sqlite3_step(pStmt);
+		sqlite3_reset(pStmt);
+	}
+	sqlite3_finalize(pStmt);
+	sqlite3_exec(pDb,"COMMIT",NULL,NULL,NULL);
+	return pDb;
+}
+
+static bool CheckRow(SSqliteRowSource & src,int iRow,int iData)
+{
+	SArray<SStringW> arrValues;
+	__int64 llKey = 0;
+	if(!src.GetRow(iRow,arrValues,&llKey)) return false;
+	return llKey == iData+1
+		&& arrValues[0] == SStringW().Format(L"row%d",iData)
+		&& arrValues[1] == SStringW().Format(L"%d",iData*2);
+}
+
+TEST(SqliteAdapter, rows) {
+	sqlite3 *pDb = CreateTestDb();
+	SSqliteRowSource src;
+	src.SetPageSize(100);
+	src.SetMaxPages(8);
+	ASSERT_TRUE(src.Open(pDb,L"t",L"name,val",L"id"));
+	EXPECT_EQ(KRows,src.GetCount());
+	EXPECT_EQ(2,src.GetColumnCount());
+	EXPECT_TRUE(src.GetColumnName(0) == L"name");
+	EXPECT_TRUE(src.GetColumnName(1) == L"val");
+
+	//向下滚动，每页最多读取一次
+	for(int i=0;i<10000;i++) ASSERT_TRUE(CheckRow(src,i,i));
+	SSqliteRowStats stats;
+	src.GetStats(stats);
+	EXPECT_EQ(10000,stats.nHits+stats.nMisses);
+	EXPECT_LE(stats.nMisses,100);
+	EXPECT_LE(stats.nPages,8);
+
+	//跳转后向上滚动
+	for(int i=77777;i>75000;i--) ASSERT_TRUE(CheckRow(src,i,i));
+	SArray<SStringW> arrValues;
+	EXPECT_FALSE(src.GetRow(KRows,arrValues));
+
+	//删除数据后刷新
+	sqlite3_exec(pDb,"DELETE FROM t WHERE id<=1000",NULL,NULL,NULL);
+	src.Refresh();
+	EXPECT_EQ(KRows-1000,src.GetCount());
+	for(int i=0;i<500;i++) ASSERT_TRUE(CheckRow(src,i,i+1000));
+
+	src.Close();
+	sqlite3_close(pDb);
+}
+
+TEST(SqliteAdapter, adapter) {
+	sqlite3 *pDb = CreateTestDb();
+	CAutoRefPtr<SSqliteMcAdapter> pAdapter;
+	pAdapter.Attach(new SSqliteMcAdapter);
+	ASSERT_TRUE(pAdapter->GetRowSource().Open(pDb,L"t",L"name,val"));
+	EXPECT_EQ(KRows,pAdapter->getCount());
+	EXPECT_TRUE(pAdapter->GetColumnName(1) == L"val");
+	pAdapter->GetRowSource().Close();
+	sqlite3_close(pDb);
+}
+
+TEST(SqliteAdapter, quotedNames) {
+	sqlite3 *pDb = CreateTestDb();
+	sqlite3_exec(pDb,"CREATE TABLE \"my \"\"t\"\"\"(id INTEGER PRIMARY KEY,\"select\" TEXT)",NULL,NULL,NULL);
+	sqlite3_exec(pDb,"INSERT INTO \"my \"\"t\"\"\"(id,\"select\") VALUES(1,'a')",NULL,NULL,NULL);
+
+	//名字中有空格、双引号或者是关键字
+	SSqliteRowSource src;
+	ASSERT_TRUE(src.Open(pDb,L"my \"t\"",L" select ",L"id"));
+	EXPECT_EQ(1,src.GetCount());
+	EXPECT_TRUE(src.GetColumnName(0) == L"select");
+	SArray<SStringW> arrValues;
+	ASSERT_TRUE(src.GetRow(0,arrValues));
+	EXPECT_TRUE(arrValues[0] == L"a");
+	src.Close();
+
+	//名字不能带入其它SQL
+	EXPECT_FALSE(src.Open(pDb,L"t; DROP TABLE t",L"name"));
+	EXPECT_FALSE(src.Open(pDb,L"t",L"name FROM t; DROP TABLE t; --"));
+	EXPECT_FALSE(src.Open(pDb,L"t",L"name, ,val"));
+	EXPECT_FALSE(src.Open(pDb,L"t",L"name,nosuchcol"));
+	ASSERT_TRUE(src.Open(pDb,L"t",L"name,val",L"id"));
+	EXPECT_EQ(KRows,src.GetCount());
+	src.Close();
+	sqlite3_close(pDb);
+}
+
+TEST(SqliteAdapter, prefetchConnection) {
+	char szPath[MAX_PATH];
+	GetTempPathA(MAX_PATH,szPath);
+	strcat(szPath,"souitest-sqliteadapter.db");
+	DeleteFileA(szPath);
+	sqlite3 *pDb = CreateTestDb(szPath);
+	//预读连接读取期间写入需要等待读锁释放
+	sqlite3_busy_timeout(pDb,1000);
+
+	SSqliteRowSource src;
+	src.SetPageSize(100);
+	src.SetPrefetchPages(2);
+	ASSERT_TRUE(src.Open(pDb,L"t",L"name,val",L"id"));
+	ASSERT_TRUE(CheckRow(src,0,0));
+
+	//预读在后台线程中使用独立的连接
+	SSqliteRowStats stats;
+	for(int i=0;i<200;i++)
+	{
+		src.GetStats(stats);
+		if(stats.nPrefetched >= 2) break;
+		Sleep(10);
+	}
+	EXPECT_EQ(2,stats.nPrefetched);
+	for(int i=100;i<300;i++) ASSERT_TRUE(CheckRow(src,i,i));
+	src.GetStats(stats);
+	EXPECT_EQ(1,stats.nMisses);
+
+	//预读连接只读，调用者的连接仍然可以写入
+	EXPECT_EQ(SQLITE_OK,sqlite3_exec(pDb,"DELETE FROM t WHERE id<=1000",NULL,NULL,NULL));
+	src.Refresh();
+	EXPECT_EQ(KRows-1000,src.GetCount());
+	for(int i=0;i<500;i++) ASSERT_TRUE(CheckRow(src,i,i+1000));
+
+	src.Close();
+	sqlite3_close(pDb);
+	DeleteFileA(szPath);
+}
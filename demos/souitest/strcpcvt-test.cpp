@@ -0,0 +1,126 @@
+﻿/*
+	测试UTF8/UTF16转换
+*/
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <string/strcpcvt.h>
+
+using namespace SOUI;
+
+TEST(StrCpCvt, ascii) {
+	char szSrc[100];
+	for(int i=0;i<99;i++) szSrc[i] = (char)('!'+i%90);
+	szSrc[99]=0;
+	wchar_t szDst[100];
+	EXPECT_EQ(100,SStrCpCvt::Utf8ToUtf16(szSrc,-1,NULL,0));
+	EXPECT_EQ(100,SStrCpCvt::Utf8ToUtf16(szSrc,-1,szDst,100));
+	for(int i=0;i<100;i++) EXPECT_EQ((wchar_t)(unsigned char)szSrc[i],szDst[i]);
+
+	char szBack[100];
+	EXPECT_EQ(100,SStrCpCvt::Utf16ToUtf8(szDst,-1,szBack,100));
+	EXPECT_EQ(0,memcmp(szSrc,szBack,100));
+}
+
+TEST(StrCpCvt, multibyte) {
+	//a é 中 😀
+	const char szSrc[] = "a\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+	const wchar_t szExpect[] = {L'a',0xE9,0x4E2D,0xD83D,0xDE00};
+	wchar_t szDst[8];
+	int n = SStrCpCvt::Utf8ToUtf16(szSrc,sizeof(szSrc)-1,szDst,8);
+	ASSERT_EQ(5,n);
+	EXPECT_EQ(0,memcmp(szExpect,szDst,sizeof(szExpect)));
+
+	char szBack[16];
+	EXPECT_EQ((int)sizeof(szSrc)-1,SStrCpCvt::Utf16ToUtf8(szExpect,5,NULL,0));
+	EXPECT_EQ((int)sizeof(szSrc)-1,SStrCpCvt::Utf16ToUtf8(szExpect,5,szBack,16));
+	EXPECT_EQ(0,memcmp(szSrc,szBack,sizeof(szSrc)-1));
+
+	EXPECT_TRUE(SStrCpCvt::IsValidUtf8(szSrc));
+	EXPECT_TRUE(SStrCpCvt::CvtW2A(SStrCpCvt::CvtA2W(szSrc,CP_UTF8),CP_UTF8) == szSrc);
+}
+
+TEST(StrCpCvt, invalid) {
+	struct
+	{
+		const char * pszSrc;
+		int          nExpect;   //U+FFFD的个数
+	}cases[]={
+		{"\x80",1},                 //单独的后续字节
+		{"\xC0\xAF",2},             //过长编码
+		{"\xE0\x80\xAF",3},         //过长编码
+		{"\xED\xA0\x80",3},         //代理项
+		{"\xF4\x90\x80\x80",4},     //超过U+10FFFF
+		{"\xE4\xB8",1},             //截断的序列
+		{"\xF0\x9F\x98",1},         //截断的序列
+		{"\xFF",1},
+	};
+	for(int i=0;i<ARRAYSIZE(cases);i++)
+	{
+		wchar_t szDst[8];
+		int n = SStrCpCvt::Utf8ToUtf16(cases[i].pszSrc,(int)strlen(cases[i].pszSrc),szDst,8);
+		EXPECT_EQ(cases[i].nExpect,n);
+		for(int j=0;j<n;j++) EXPECT_EQ(0xFFFD,szDst[j]);
+		EXPECT_FALSE(SStrCpCvt::IsValidUtf8(cases[i].pszSrc));
+	}
+
+	//不成对的代理项
+	const wchar_t szSrc[] = {0xD800,L'a',0xDC00};
+	char szDst[16];
+	EXPECT_EQ(7,SStrCpCvt::Utf16ToUtf8(szSrc,3,szDst,16));
+	EXPECT_EQ(0,memcmp("\xEF\xBF\xBD" "a\xEF\xBF\xBD",szDst,7));
+}
+
+TEST(StrCpCvt, buffer) {
+	const char szSrc[] = "abcdefghijklmnopqrstuvwxyz\xE4\xB8\xAD";
+	wchar_t szDst[32];
+	SetLastError(0);
+	EXPECT_EQ(0,SStrCpCvt::Utf8ToUtf16(szSrc,-1,szDst,27));
+	EXPECT_EQ(ERROR_INSUFFICIENT_BUFFER,GetLastError());
+	EXPECT_EQ(28,SStrCpCvt::Utf8ToUtf16(szSrc,-1,szDst,28));
+
+	char szBack[32];
+	SetLastError(0);
+	EXPECT_EQ(0,SStrCpCvt::Utf16ToUtf8(szDst,-1,szBack,29));
+	EXPECT_EQ(ERROR_INSUFFICIENT_BUFFER,GetLastError());
+	EXPECT_EQ(30,SStrCpCvt::Utf16ToUtf8(szDst,-1,szBack,30));
+}
+
+TEST(StrCpCvt, compatible) {
+	//合法输入的结果和系统API一致
+	SStringA strSrc;
+	for(int i=0;i<1000;i++)
+	{
+		strSrc += "soui\xE7\x95\x8C\xE9\x9D\xA2\xF0\x9F\x98\x80 ";
+	}
+	int nLen = strSrc.GetLength();
+	SStringW strWin,strCvt;
+	int nWin = MultiByteToWideChar(CP_UTF8,0,strSrc,nLen,strWin.GetBufferSetLength(nLen),nLen);
+	strWin.ReleaseBuffer(nWin);
+	int nCvt = SStrCpCvt::Utf8ToUtf16(strSrc,nLen,strCvt.GetBufferSetLength(nLen),nLen);
+	strCvt.ReleaseBuffer(nCvt);
+	EXPECT_TRUE(strWin == strCvt);
+	EXPECT_TRUE(SStrCpCvt::CvtW2A(strWin,CP_UTF8) == strSrc);
+}
+
+//性能测试，使用--gtest_also_run_disabled_tests运行
+TEST(StrCpCvt, DISABLED_throughput) {
+	SStringA strSrc;
+	for(int i=0;i<100000;i++)
+	{
+		strSrc += "<item name=\"soui\" text=\"\xE7\x95\x8C\xE9\x9D\xA2\"/>\n";
+	}
+	int nLen = strSrc.GetLength();
+	wchar_t *pBuf = new wchar_t[nLen];
+	const int KLoops = 20;
+
+	DWORD dwStart = GetTickCount();
+	for(int i=0;i<KLoops;i++) MultiByteToWideChar(CP_UTF8,0,strSrc,nLen,pBuf,nLen);
+	DWORD dwWin = GetTickCount()-dwStart;
+
+	dwStart = GetTickCount();
+	for(int i=0;i<KLoops;i++) SStrCpCvt::Utf8ToUtf16(strSrc,nLen,pBuf,nLen);
+	DWORD dwCvt = GetTickCount()-dwStart;
+
+	printf("utf8->utf16 %d bytes x %d: MultiByteToWideChar %u ms, SStrCpCvt %u ms\n",nLen,KLoops,dwWin,dwCvt);
+	delete []pBuf;
+}
@@ -0,0 +1,322 @@
+﻿/*
+	测试STileViewItemLocatorMasonry的定位结果，与逐个累加的结果比较
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <helper/STileViewItemLocator.h>
+#include <helper/SAdapterBase.h>
+#include <control/STileView.h>
+#include <vector>
+
+using namespace SOUI;
+
+class CCountAdapter : public SAdapterBase
+{
+public:
+	CCountAdapter(int nCount):m_nCount(nCount){}
+
+	virtual int getCount()
+	{
+		return m_nCount;
+	}
+
+	virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate)
+	{
+	}
+
+	int m_nCount;
+};
+
+//item宽100，间隔4，视图宽1000时每行9个
+static const int KMargin = 4;
+
+static STileViewItemLocatorMasonry * CreateLocator(ILvAdapter *pAdapter, int nWidth)
+{
+	STileViewItemLocatorMasonry *pLocator = new STileViewItemLocatorMasonry(L"50",L"100",SLayoutSize((float)KMargin,SLayoutSize::px));
+	pLocator->SetScale(100);
+	pLocator->SetTileViewWidth(nWidth);
+	pLocator->SetAdapter(pAdapter);
+	return pLocator;
+}
+
+//逐列累加计算每个item的顶部位置，返回总高度
+static int CalcTops(const std::vector<int> &arrHei, int nCols, std::vector<int> &arrTop)
+{
+	std::vector<int> arrCol(nCols,0);
+	arrTop.resize(arrHei.size());
+	for(size_t i=0;i<arrHei.size();i++)
+	{
+		arrTop[i] = arrCol[i%nCols];
+		arrCol[i%nCols] += arrHei[i] + KMargin;
+	}
+	int nMax = 0;
+	for(int i=0;i<nCols;i++) if(arrCol[i]>nMax) nMax = arrCol[i];
+	return arrHei.empty()?0:nMax+KMargin;
+}
+
+TEST(STileViewItemLocatorMasonry, position) {
+	srand(1);
+	for(int nTest=0;nTest<50;nTest++)
+	{
+		int nCount = rand()%200;
+		CAutoRefPtr<ILvAdapter> adapter;
+		adapter.Attach(new CCountAdapter(nCount));
+		CAutoRefPtr<STileViewItemLocatorMasonry> locator;
+		int nWidth = rand()%1200;
+		locator.Attach(CreateLocator(adapter,nWidth));
+
+		std::vector<int> arrHei(nCount,50);
+		for(int nUpdate=0;nUpdate<20 && nCount>0;nUpdate++)
+		{
+			if(nUpdate == 10)
+			{//改变列数后保留已经设置的高度
+				nWidth = rand()%1200;
+				locator->SetTileViewWidth(nWidth);
+			}
+			int iItem = rand()%nCount;
+			arrHei[iItem] = rand()%120;
+			locator->SetItemHeight(iItem,arrHei[iItem]);
+
+			int nCols = nWidth/(100+KMargin);
+			if(nCols == 0) nCols = 1;
+			std::vector<int> arrTop;
+			int nTotal = CalcTops(arrHei,nCols,arrTop);
+			ASSERT_EQ(locator->GetTotalHeight(),nTotal);
+			for(int i=0;i<nCount;i++)
+			{
+				ASSERT_EQ(locator->Item2Position(i),arrTop[i]);
+				CRect rc = locator->GetItemRect(i);
+				ASSERT_EQ(rc.top,arrTop[i]+KMargin);
+				ASSERT_EQ(rc.Height(),arrHei[i]);
+			}
+			for(int nPos=0;nPos<nTotal;nPos+=7)
+			{
+				int iFirst = nCount, iEnd = 0;
+				for(int i=0;i<nCount;i++)
+				{
+					if(arrTop[i]+arrHei[i]+KMargin > nPos && i < iFirst) iFirst = i;
+					if(nPos > 0 && arrTop[i] < nPos) iEnd = i+1;
+				}
+				ASSERT_EQ(locator->Position2Item(nPos),iFirst);
+				ASSERT_EQ(locator->Position2ItemEnd(nPos),iEnd);
+
+				//显示项只包含和[nPos,nPos+100)相交的item
+				SArray<int> arrVisible;
+				locator->GetVisibleItems(nPos,nPos+100,arrVisible);
+				size_t iVisible = 0;
+				for(int i=0;i<nCount;i++)
+				{
+					if(arrTop[i]+arrHei[i]+KMargin > nPos && arrTop[i] < nPos+100)
+					{
+						ASSERT_LT(iVisible,arrVisible.GetCount());
+						ASSERT_EQ(arrVisible[iVisible],i);
+						iVisible++;
+					}
+				}
+				ASSERT_EQ(iVisible,arrVisible.GetCount());
+			}
+		}
+	}
+}
+
+TEST(STileViewItemLocatorMasonry, million) {
+	const int KCount = 1000000;
+	CAutoRefPtr<ILvAdapter> adapter;
+	adapter.Attach(new CCountAdapter(KCount));
+	CAutoRefPtr<STileViewItemLocatorMasonry> locator;
+	locator.Attach(CreateLocator(adapter,1000));
+
+	//默认高度时与固定网格一致
+	const int KCols = 9, KRows = (KCount+KCols-1)/KCols;
+	EXPECT_EQ(locator->GetTotalHeight(),KRows*(50+KMargin)+KMargin);
+	EXPECT_EQ(locator->Item2Position(KCount-1),(KRows-1)*(50+KMargin));
+	EXPECT_EQ(locator->Position2Item(1000*(50+KMargin)),1000*KCols);
+
+	//修改一个item只影响同一列中后面的item
+	locator->SetItemHeight(KCols*10+3,150);
+	EXPECT_EQ(locator->Item2Position(KCols*11+3),11*(50+KMargin)+100);
+	EXPECT_EQ(locator->Item2Position(KCols*11+4),11*(50+KMargin));
+	//最后一行只有第0列，第3列比第0列少一行
+	EXPECT_EQ(locator->Item2Position((KRows-2)*KCols+3),(KRows-2)*(50+KMargin)+100);
+	EXPECT_EQ(locator->GetTotalHeight(),(KRows-1)*(50+KMargin)+KMargin+100);
+
+	//数据改变后恢复默认高度
+	locator->OnDataSetChanged();
+	EXPECT_EQ(locator->GetTotalHeight(),KRows*(50+KMargin)+KMargin);
+}
+
+//第0列的item很矮，其它列很高，滚动一段距离后各列显示的行相差很远
+TEST(STileViewItemLocatorMasonry, diverge) {
+	const int KCount = 1000000, KCols = 9, KPage = 600;
+	CAutoRefPtr<ILvAdapter> adapter;
+	adapter.Attach(new CCountAdapter(KCount));
+	CAutoRefPtr<STileViewItemLocatorMasonry> locator;
+	locator.Attach(CreateLocator(adapter,1000));
+	for(int i=0;i<KCount;i++)
+	{
+		locator->SetItemHeight(i,i%KCols==0?20:300);
+	}
+	int nPos = 100000;
+	//按index范围计算的显示区域覆盖了大量不可见的item
+	EXPECT_GT(locator->Position2ItemEnd(nPos+KPage)-locator->Position2Item(nPos),10000);
+	//按列查找时每列只有一屏左右
+	SArray<int> arrVisible;
+	locator->GetVisibleItems(nPos,nPos+KPage,arrVisible);
+	int nMax = (KPage/(20+KMargin)+2) + (KCols-1)*(KPage/(300+KMargin)+2);
+	EXPECT_LE((int)arrVisible.GetCount(),nMax);
+	EXPECT_GT((int)arrVisible.GetCount(),KPage/(20+KMargin));
+	for(size_t i=0;i<arrVisible.GetCount();i++)
+	{
+		CRect rc = locator->GetItemRect(arrVisible[i]);
+		EXPECT_TRUE(rc.bottom > nPos && rc.top-KMargin < nPos+KPage);
+		if(i>0) EXPECT_LT(arrVisible[i-1],arrVisible[i]);
+	}
+}
+
+//模拟滚动：位置连续变化，同时测量显示的item，返回每次操作的耗时(ns)
+static double QueryTime(int nCount, int nLoop)
+{
+	CAutoRefPtr<ILvAdapter> adapter;
+	adapter.Attach(new CCountAdapter(nCount));
+	CAutoRefPtr<STileViewItemLocatorMasonry> locator;
+	locator.Attach(CreateLocator(adapter,1000));
+	int nTotal = locator->GetTotalHeight();
+
+	double dBest = 0.0;
+	for(int nRound=0;nRound<3;nRound++)
+	{
+		LARGE_INTEGER liStart,liEnd,liFreq;
+		QueryPerformanceCounter(&liStart);
+		int nSum = 0;
+		for(int i=0;i<nLoop;i++)
+		{
+			int nPos = (int)((__int64)i*37%nTotal);
+			int iFirst = locator->Position2Item(nPos);
+			nSum += iFirst + locator->Position2ItemEnd(nPos+600);
+			if(iFirst < nCount) locator->SetItemHeight(iFirst,50+i%3);
+		}
+		QueryPerformanceCounter(&liEnd);
+		QueryPerformanceFrequency(&liFreq);
+		EXPECT_GE(nSum,0);
+		double dTime = (liEnd.QuadPart-liStart.QuadPart)*1000000000.0/liFreq.QuadPart/nLoop;
+		if(nRound==0 || dTime<dBest) dBest = dTime;
+	}
+	return dBest;
+}
+
+//查询和修改的复杂度为O(列数*log(行数))：item数增加1000倍，耗时只增加log的倍数(约2倍)，线性算法会增加约1000倍
+TEST(STileViewItemLocatorMasonry, complexity) {
+	double d1 = QueryTime(1000,20000);
+	double d2 = QueryTime(1000000,20000);
+	EXPECT_LT(d2,d1*8);
+}
+
+TEST(STileViewItemLocatorMasonry, DISABLED_bench) {
+	double d1 = QueryTime(1000,100000);
+	double d2 = QueryTime(1000000,100000);
+	printf("1K tiles: %.1fns/query, 1M tiles: %.1fns/query\n",d1,d2);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//STileView使用瀑布流定位器时只创建显示区域内的item
+
+//暴露显示项数量和滚动接口
+class CProbeTileView : public STileView
+{
+	SOUI_CLASS_NAME(CProbeTileView, L"probetileview")
+public:
+	int GetPanelCount() const
+	{
+		return (int)m_lstItems.GetCount();
+	}
+
+	void ScrollTo(int nPos)
+	{
+		OnScroll(TRUE,SB_THUMBPOSITION,nPos);
+	}
+};
+
+//第0列的item高20，其它列高300
+class CDivergeAdapter : public SAdapterBase
+{
+public:
+	CDivergeAdapter(int nCols):m_nCols(nCols){}
+
+	virtual int getCount()
+	{
+		return 100000;
+	}
+
+	virtual void getView(int position, SWindow * pItem, pugi::xml_node xmlTemplate)
+	{
+		if(pItem->GetChildrenCount() == 0)
+		{
+			pItem->InitFromXml(xmlTemplate.child(L"item"));
+		}
+	}
+
+	virtual SIZE getViewDesiredSize(int position,SWindow *pItem, LPCRECT prcContainer)
+	{
+		CSize sz(100,position%m_nCols==0?20:300);
+		return sz;
+	}
+
+	int m_nCols;
+};
+
+static const wchar_t KTileLayout[] =
+L"<SOUI width=\"800\" height=\"600\">"
+L"<root>"
+L"<probetileview pos=\"0,0,-0,-0\" name=\"tv_test\" marginSize=\"4\">"
+L"<template defHeight=\"50\" itemWidth=\"100\">"
+L"<item><text pos=\"0,0,-0,-0\" name=\"txt\"/></item>"
+L"</template>"
+L"</probetileview>"
+L"</root>"
+L"</SOUI>";
+
+TEST(STileView, masonryVisible) {
+	SComMgr comMgr;
+	CAutoRefPtr<IImgDecoderFactory> pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> pRenderFactory;
+	ASSERT_TRUE(comMgr.CreateRender_GDI((IObjRef**)&pRenderFactory)!=FALSE);
+	ASSERT_TRUE(comMgr.CreateImgDecoder((IObjRef**)&pImgDecoderFactory)!=FALSE);
+	pRenderFactory->SetImgDecoderFactory(pImgDecoderFactory);
+	SApplication *theApp = new SApplication(pRenderFactory,GetModuleHandle(NULL));
+	theApp->RegisterWindowClass<CProbeTileView>();
+	{
+		SHostWnd host;
+		host.Create(NULL,0,0,800,600);
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer(KTileLayout,sizeof(KTileLayout),pugi::parse_default,pugi::encoding_utf16);
+		host.InitFromXml(xmlDoc.child(L"SOUI"));
+		host.GetRoot()->UpdateLayout();
+		CProbeTileView *pTv = host.FindChildByName2<CProbeTileView>(L"tv_test");
+		ASSERT_TRUE(pTv != NULL);
+
+		CRect rcClient = pTv->GetClientRect();
+		int nCols = (rcClient.Width()-KMargin)/(100+KMargin);
+		if(nCols < 1) nCols = 1;
+		CAutoRefPtr<ILvAdapter> adapter;
+		adapter.Attach(new CDivergeAdapter(nCols));
+		pTv->SetAdapter(adapter);
+
+		//逐屏向下滚动，滚过的item都已经测量，第0列越来越领先其它列
+		int nPage = rcClient.Height();
+		int nMax = (nPage/(20+KMargin)+2) + (nCols-1)*(nPage/(300+KMargin)+2);
+		int nMaxPanels = 0;
+		for(int nPos=0;nPos<100000;nPos+=nPage/2)
+		{
+			pTv->ScrollTo(nPos);
+			if(pTv->GetPanelCount() > nMaxPanels) nMaxPanels = pTv->GetPanelCount();
+		}
+		STileViewItemLocator *pLocator = pTv->GetItemLocator();
+		int nPos = pTv->GetScrollPos(TRUE);
+		EXPECT_GT(pLocator->Position2ItemEnd(nPos+nPage)-pLocator->Position2Item(nPos),1000);
+		EXPECT_LE(nMaxPanels,nMax);
+		EXPECT_GT(nMaxPanels,0);
+		host.DestroyWindow();
+	}
+	delete theApp;
+}
@@ -0,0 +1,129 @@
+﻿/*
+	测试编译后的语言包
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include "translator/translator.h"
+
+using namespace SOUI;
+
+//生成nCtx个上下文，每个上下文nMsg条翻译，上下文c<i>中s<j>的翻译为t<i>_<j>，空白上下文中s<j>的翻译为t_<j>
+static SStringW MakeLangXml(int nCtx,int nMsg)
+{
+	SStringW strXml = L"<language name=\"cn\" guid=\"{AD5FEE23-6DAE-4d2c-9D0A-84A4A7E2B3B5}\">";
+	for(int i=-1;i<nCtx;i++)
+	{
+		SStringW strCtx;
+		if(i>=0) strCtx.Format(L"c%d",i);
+		strXml += SStringW().Format(L"<context name=\"%s\">",(LPCWSTR)strCtx);
+		for(int j=0;j<nMsg;j++)
+		{
+			strXml += SStringW().Format(L"<message><source>s%d</source><translation>t%s_%d</translation></message>",j,(LPCWSTR)strCtx.Mid(1),j);
+		}
+		strXml += L"</context>";
+	}
+	strXml += L"</language>";
+	return strXml;
+}
+
+static SStringW GetTempFile(LPCWSTR pszName)
+{
+	wchar_t szPath[MAX_PATH];
+	GetTempPathW(MAX_PATH,szPath);
+	return SStringW(szPath)+pszName;
+}
+
+static bool WriteXmlFile(LPCWSTR pszFile,const SStringW & strXml)
+{
+	pugi::xml_document xmlDoc;
+	if(!xmlDoc.load(strXml)) return false;
+	return xmlDoc.save_file(pszFile);
+}
+
+static CAutoRefPtr<ITranslator> CreateTranslator(ITranslatorMgr *pMgr,LPVOID pData,UINT uType)
+{
+	CAutoRefPtr<ITranslator> pTrans;
+	pMgr->CreateTranslator(&pTrans);
+	if(!pTrans->Load(pData,uType)) return NULL;
+	return pTrans;
+}
+
+TEST(Translator, compiled) {
+	SStringW strXmlFile = GetTempFile(L"souitest-lang.xml");
+	SStringW strLangFile = GetTempFile(L"souitest-lang.slp");
+	ASSERT_TRUE(WriteXmlFile(strXmlFile,MakeLangXml(4,100)));
+	ASSERT_TRUE(TRANSLATOR::SCompileLang(strXmlFile,strLangFile));
+
+	CAutoRefPtr<ITranslatorMgr> pMgr;
+	TRANSLATOR::SCreateInstance((IObjRef**)&pMgr);
+
+	pugi::xml_document xmlDoc;
+	xmlDoc.load_file(strXmlFile);
+	pugi::xml_node xmlLang = xmlDoc.child(L"language");
+	CAutoRefPtr<ITranslator> pXml = CreateTranslator(pMgr,&xmlLang,LD_XML);
+	CAutoRefPtr<ITranslator> pCompiled = CreateTranslator(pMgr,(LPVOID)(LPCWSTR)strLangFile,LD_COMPILEDFILE);
+	ASSERT_TRUE(pXml != NULL);
+	ASSERT_TRUE(pCompiled != NULL);
+	EXPECT_TRUE(pCompiled->name() == L"cn");
+	EXPECT_TRUE(IsEqualGUID(pXml->guid(),pCompiled->guid()));
+
+	ITranslator * arrTrans[2] = {pXml,pCompiled};
+	for(int i=0;i<2;i++)
+	{
+		SStringW strRet;
+		EXPECT_TRUE(arrTrans[i]->tr(L"s5",L"c2",strRet));
+		EXPECT_TRUE(strRet == L"t2_5");
+		//上下文中没有时从空白上下文中查找
+		EXPECT_TRUE(arrTrans[i]->tr(L"s5",L"c9",strRet));
+		EXPECT_TRUE(strRet == L"t_5");
+		EXPECT_FALSE(arrTrans[i]->tr(L"s100",L"c2",strRet));
+	}
+
+	pCompiled = NULL;
+	DeleteFileW(strXmlFile);
+	DeleteFileW(strLangFile);
+}
+
+//比较XML语言包与编译后的语言包的加载时间及查找时间
+TEST(Translator, DISABLED_lookup) {
+	const int KCtx = 50;
+	const int KMsg = 400;
+	const int KLoops = 10;
+	SStringW strXmlFile = GetTempFile(L"souitest-lang.xml");
+	SStringW strLangFile = GetTempFile(L"souitest-lang.slp");
+	ASSERT_TRUE(WriteXmlFile(strXmlFile,MakeLangXml(KCtx,KMsg)));
+	ASSERT_TRUE(TRANSLATOR::SCompileLang(strXmlFile,strLangFile));
+
+	CAutoRefPtr<ITranslatorMgr> pMgr;
+	TRANSLATOR::SCreateInstance((IObjRef**)&pMgr);
+
+	DWORD dwStart = GetTickCount();
+	pugi::xml_document xmlDoc;
+	xmlDoc.load_file(strXmlFile);
+	pugi::xml_node xmlLang = xmlDoc.child(L"language");
+	CAutoRefPtr<ITranslator> pXml = CreateTranslator(pMgr,&xmlLang,LD_XML);
+	DWORD dwLoadXml = GetTickCount()-dwStart;
+
+	dwStart = GetTickCount();
+	CAutoRefPtr<ITranslator> pCompiled = CreateTranslator(pMgr,(LPVOID)(LPCWSTR)strLangFile,LD_COMPILEDFILE);
+	DWORD dwLoadCompiled = GetTickCount()-dwStart;
+	ASSERT_TRUE(pCompiled != NULL);
+
+	SArray<SStringW> arrCtx,arrSrc;
+	for(int i=0;i<KCtx;i++) arrCtx.Add(SStringW().Format(L"c%d",i));
+	for(int j=0;j<KMsg;j++) arrSrc.Add(SStringW().Format(L"s%d",j));
+
+	dwStart = GetTickCount();
+	SStringW strRet;
+	for(int k=0;k<KLoops;k++) for(int i=0;i<KCtx;i++) for(int j=0;j<KMsg;j++)
+	{
+		pCompiled->tr(arrSrc[j],arrCtx[i],strRet);
+	}
+	DWORD dwLookup = GetTickCount()-dwStart;
+
+	printf("%d strings: load xml %u ms, load compiled %u ms, %d lookups %u ms\n",KCtx*KMsg,dwLoadXml,dwLoadCompiled,KLoops*KCtx*KMsg,dwLookup);
+
+	pCompiled = NULL;
+	DeleteFileW(strXmlFile);
+	DeleteFileW(strLangFile);
+}
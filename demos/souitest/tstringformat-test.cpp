@@ -0,0 +1,91 @@
+﻿/*
+	SStringT::Format/AppendFormat测试
+	计数器需要使用ENABLE_TSTRING_ALLOC_STATS(定义TSTRING_ALLOC_STATS)编译utilities和本测试
+	性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <windows.h>
+#include <string/tstring.h>
+#include <stdio.h>
+
+using namespace SOUI;
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+//超出栈缓冲的结果走堆上的慢速路径，内容必须完整
+TEST(TStringFormat, longResult) {
+	SStringW strLong;
+	for(int i=0;i<TSTRING_FORMAT_STACKBUF;i++) strLong += (wchar_t)(L'a'+i%26);
+	SStringW str;
+	str.Format(L"[%s]",(LPCWSTR)strLong);
+	EXPECT_EQ(TSTRING_FORMAT_STACKBUF+2,str.GetLength());
+	EXPECT_TRUE(str.Mid(1,TSTRING_FORMAT_STACKBUF) == strLong);
+
+	SStringW strShort;
+	strShort.Format(L"%d,%s",12,L"ab");
+	EXPECT_TRUE(strShort == L"12,ab");
+	strShort.AppendFormat(L"|%s",(LPCWSTR)strLong);
+	EXPECT_EQ(5+1+TSTRING_FORMAT_STACKBUF,strShort.GetLength());
+	EXPECT_TRUE(strShort.Right(TSTRING_FORMAT_STACKBUF) == strLong);
+}
+
+static void PrintStats(const char *pszName, double dTime, int nCalls, const TStringAllocStats &before)
+{
+	printf("%-24s %8.1fns  fast %6ld  slow %6ld  alloc %6ld  realloc %6ld\n",pszName,dTime*1000/nCalls,
+		_tstr_allocStats.nFormatFast-before.nFormatFast,_tstr_allocStats.nFormatSlow-before.nFormatSlow,
+		_tstr_allocStats.nAlloc-before.nAlloc,_tstr_allocStats.nRealloc-before.nRealloc);
+}
+
+TEST(TStringFormat, DISABLED_bench) {
+#ifndef TSTRING_ALLOC_STATS
+	printf("TSTRING_ALLOC_STATS is not defined, counters stay 0\n");
+#endif
+	const int KCalls = 100000;
+	SStringW strLong;
+	for(int i=0;i<TSTRING_FORMAT_STACKBUF;i++) strLong += (wchar_t)(L'a'+i%26);
+
+	TStringAllocStats before = _tstr_allocStats;
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KCalls;i++)
+	{
+		SStringW str;
+		str.Format(L"%d,%d,@%d,@%d",i,i+1,i+2,i+3);
+	}
+	PrintStats("Format short",Elapse(liStart),KCalls,before);
+
+	before = _tstr_allocStats;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KCalls;i++)
+	{
+		SStringW str;
+		str.Format(L"%d:%s",i,(LPCWSTR)strLong);
+	}
+	PrintStats("Format long",Elapse(liStart),KCalls,before);
+
+	before = _tstr_allocStats;
+	QueryPerformanceCounter(&liStart);
+	{
+		SStringW str;
+		for(int i=0;i<KCalls;i++)
+		{
+			str.AppendFormat(L"<item id=\"%d\"/>",i);
+		}
+	}
+	PrintStats("AppendFormat short",Elapse(liStart),KCalls,before);
+
+	before = _tstr_allocStats;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KCalls;i++)
+	{
+		SStringA str;
+		str.Format("%d,%s",i,"ansi");
+	}
+	PrintStats("Format short (char)",Elapse(liStart),KCalls,before);
+}
@@ -0,0 +1,159 @@
+﻿/*
+	SWindow::IsVisible(TRUE)/IsDisabled(TRUE)使用缓存状态的性能测试
+	需要render-gdi和imgdecoder模块，默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+
+using namespace SOUI;
+
+//每层10个子窗口，4层共11110个窗口，部分窗口隐藏或禁用
+static void AddChildren(SStringW &strXml, int nDepth, int nWid, int nHei)
+{
+	if(nDepth == 0) return;
+	for(int i=0;i<10;i++)
+	{
+		int w = nWid/5, h = nHei/2;
+		int x = (i%5)*w, y = (i/5)*h;
+		SStringW strAttr;
+		if(rand()%20==0) strAttr += L" visible=\"0\"";
+		if(rand()%20==0) strAttr += L" enable=\"0\"";
+		strXml += SStringW().Format(L"<window pos=\"%d,%d,@%d,@%d\" colorBkgnd=\"#%06x\"%s>",x,y,w,h,rand()&0xFFFFFF,(LPCWSTR)strAttr);
+		AddChildren(strXml,nDepth-1,w,h);
+		strXml += L"</window>";
+	}
+}
+
+static void CollectWindows(SWindow *pWnd, SArray<SWindow*> &arrWnds)
+{
+	arrWnds.Add(pWnd);
+	SWindow *pChild = pWnd->GetWindow(GSW_FIRSTCHILD);
+	while(pChild)
+	{
+		CollectWindows(pChild,arrWnds);
+		pChild = pChild->GetWindow(GSW_NEXTSIBLING);
+	}
+}
+
+//不使用缓存状态，逐级检查父窗口
+static BOOL SlowIsVisible(SWindow *pWnd)
+{
+	for(;pWnd;pWnd=pWnd->GetParent())
+	{
+		if(!pWnd->IsVisible(FALSE)) return FALSE;
+	}
+	return TRUE;
+}
+
+static BOOL SlowIsDisabled(SWindow *pWnd)
+{
+	for(;pWnd;pWnd=pWnd->GetParent())
+	{
+		if(pWnd->IsDisabled(FALSE)) return TRUE;
+	}
+	return FALSE;
+}
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+TEST(SWindowState, DISABLED_bench) {
+	SComMgr comMgr;
+	CAutoRefPtr<IImgDecoderFactory> pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> pRenderFactory;
+	ASSERT_TRUE(comMgr.CreateRender_GDI((IObjRef**)&pRenderFactory)!=FALSE);
+	ASSERT_TRUE(comMgr.CreateImgDecoder((IObjRef**)&pImgDecoderFactory)!=FALSE);
+	pRenderFactory->SetImgDecoderFactory(pImgDecoderFactory);
+	SApplication *theApp = new SApplication(pRenderFactory,GetModuleHandle(NULL));
+	{
+		srand(3);
+		SStringW strXml = L"<SOUI width=\"1000\" height=\"800\"><root>";
+		AddChildren(strXml,4,1000,800);
+		strXml += L"</root></SOUI>";
+		SHostWnd host;
+		host.Create(NULL,0,0,1000,800);
+		pugi::xml_document xmlDoc;
+		xmlDoc.load_buffer((LPCWSTR)strXml,strXml.GetLength()*sizeof(wchar_t),pugi::parse_default,pugi::encoding_utf16);
+		host.InitFromXml(xmlDoc.child(L"SOUI"));
+		host.GetRoot()->UpdateLayout();
+
+		SArray<SWindow*> arrWnds;
+		CollectWindows(host.GetRoot(),arrWnds);
+		int nWnds = (int)arrWnds.GetCount();
+
+		//缓存状态与逐级检查的结果一致
+		int nMismatch = 0;
+		for(int i=0;i<nWnds;i++)
+		{
+			if(!arrWnds[i]->IsVisible(TRUE) != !SlowIsVisible(arrWnds[i])) nMismatch++;
+			if(!arrWnds[i]->IsDisabled(TRUE) != !SlowIsDisabled(arrWnds[i])) nMismatch++;
+		}
+		EXPECT_EQ(nMismatch,0);
+
+		const int KLoops = 100;
+		int nCount = 0;
+		LARGE_INTEGER liStart;
+		QueryPerformanceCounter(&liStart);
+		for(int n=0;n<KLoops;n++)
+		{
+			for(int i=0;i<nWnds;i++)
+			{
+				if(arrWnds[i]->IsVisible(TRUE) && !arrWnds[i]->IsDisabled(TRUE)) nCount++;
+			}
+		}
+		double dCached = Elapse(liStart)*1000/(KLoops*nWnds);
+		QueryPerformanceCounter(&liStart);
+		for(int n=0;n<KLoops;n++)
+		{
+			for(int i=0;i<nWnds;i++)
+			{
+				if(SlowIsVisible(arrWnds[i]) && !SlowIsDisabled(arrWnds[i])) nCount--;
+			}
+		}
+		double dWalk = Elapse(liStart)*1000/(KLoops*nWnds);
+		EXPECT_EQ(nCount,0);
+
+		//整窗重绘
+		CAutoRefPtr<IRenderTarget> pRT;
+		pRenderFactory->CreateRenderTarget(&pRT,1000,800);
+		const int KPaints = 20;
+		QueryPerformanceCounter(&liStart);
+		for(int n=0;n<KPaints;n++)
+		{
+			host.GetRoot()->RedrawRegion(pRT,NULL);
+		}
+		double dPaint = Elapse(liStart)/1000/KPaints;
+
+		//命中测试
+		const int KPoints = 10000;
+		srand(4);
+		QueryPerformanceCounter(&liStart);
+		for(int i=0;i<KPoints;i++)
+		{
+			host.SwndFromPoint(CPoint(rand()%1000,rand()%800),FALSE);
+		}
+		double dHitTest = Elapse(liStart)/KPoints;
+
+		//显示隐藏第一层窗口，需要向下传递状态
+		SWindow *pTop = host.GetRoot()->GetWindow(GSW_FIRSTCHILD);
+		QueryPerformanceCounter(&liStart);
+		for(int n=0;n<KLoops;n++)
+		{
+			pTop->SetVisible(FALSE);
+			pTop->SetVisible(TRUE);
+		}
+		double dToggle = Elapse(liStart)/(KLoops*2);
+
+		printf("%d windows\n",nWnds);
+		printf("IsVisible(TRUE)+IsDisabled(TRUE): cached %.1fns, parent walk %.1fns\n",dCached,dWalk);
+		printf("repaint: %.3fms, hit test: %.3fus, toggle a 1111-window branch: %.3fus\n",dPaint,dHitTest,dToggle);
+		host.DestroyWindow();
+	}
+	delete theApp;
+}
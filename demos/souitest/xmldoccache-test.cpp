@@ -0,0 +1,145 @@
+﻿/*
+	测试已解析XML文档的缓存
+	需要render-gdi和imgdecoder模块，性能测试默认不运行，使用--gtest_also_run_disabled_tests运行
+*/
+#include <gtest/gtest.h>
+#include <souistd.h>
+#include <com-cfg.h>
+#include <stdio.h>
+
+using namespace SOUI;
+
+static double Elapse(LARGE_INTEGER liStart)
+{
+	LARGE_INTEGER liEnd,liFreq;
+	QueryPerformanceCounter(&liEnd);
+	QueryPerformanceFrequency(&liFreq);
+	return (liEnd.QuadPart-liStart.QuadPart)*1000000.0/liFreq.QuadPart;
+}
+
+static void WriteFileA(const SStringT &strPath, const SStringA &strData)
+{
+	FILE *f = _tfopen(strPath,_T("wb"));
+	if(!f) return;
+	fwrite((LPCSTR)strData,1,strData.GetLength(),f);
+	fclose(f);
+}
+
+class SXmlDocCacheTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_TRUE(m_comMgr.CreateRender_GDI((IObjRef**)&m_pRenderFactory)!=FALSE);
+		ASSERT_TRUE(m_comMgr.CreateImgDecoder((IObjRef**)&m_pImgDecoderFactory)!=FALSE);
+		m_pRenderFactory->SetImgDecoderFactory(m_pImgDecoderFactory);
+		m_theApp = new SApplication(m_pRenderFactory,GetModuleHandle(NULL));
+	}
+
+	virtual void TearDown()
+	{
+		delete m_theApp;
+	}
+
+	//在临时目录中生成文件夹资源包，layout:dlg为strLayout
+	IResProvider * CreateFilesProvider(LPCTSTR pszDir, const SStringA &strLayout)
+	{
+		TCHAR szPath[MAX_PATH];
+		GetTempPath(MAX_PATH,szPath);
+		m_strDir = SStringT(szPath) + pszDir;
+		CreateDirectory(m_strDir,NULL);
+		WriteFileA(m_strDir+_T("\\")+UIRES_INDEX,"<resource><layout><file name=\"dlg\" path=\"dlg.xml\"/></layout></resource>");
+		WriteFileA(m_strDir+_T("\\dlg.xml"),strLayout);
+
+		IResProvider *pResProvider = NULL;
+		CreateResProvider(RES_FILE,(IObjRef**)&pResProvider);
+		if(!pResProvider->Init((WPARAM)(LPCTSTR)m_strDir,0))
+		{
+			pResProvider->Release();
+			return NULL;
+		}
+		return pResProvider;
+	}
+
+	SComMgr m_comMgr;
+	CAutoRefPtr<IImgDecoderFactory> m_pImgDecoderFactory;
+	CAutoRefPtr<IRenderFactory> m_pRenderFactory;
+	SApplication *m_theApp;
+	SStringT m_strDir;
+};
+
+//类型和名称不区分大小写，资源文件被修改后缓存失效
+TEST_F(SXmlDocCacheTest, fileChange) {
+	IResProvider *pResProvider = CreateFilesProvider(_T("souitest-xmlcache"),"<SOUI title=\"v1\"/>");
+	ASSERT_TRUE(pResProvider!=NULL);
+	m_theApp->AddResProvider(pResProvider,NULL);
+
+	SXmlDocCacheStats before,after;
+	m_theApp->GetXmlDocCache().GetStats(before);
+	pugi::xml_document xmlDoc;
+	ASSERT_TRUE(m_theApp->LoadXmlDocment(xmlDoc,_T("dlg"),_T("layout"))!=FALSE);
+	EXPECT_STREQ(L"v1",xmlDoc.child(L"SOUI").attribute(L"title").value());
+	ASSERT_TRUE(m_theApp->LoadXmlDocment(xmlDoc,_T("DLG"),_T("LAYOUT"))!=FALSE);
+	m_theApp->GetXmlDocCache().GetStats(after);
+	EXPECT_EQ(1,after.nMisses-before.nMisses);
+	EXPECT_EQ(1,after.nHits-before.nHits);
+
+	WriteFileA(m_strDir+_T("\\dlg.xml"),"<SOUI title=\"v2\"/>");
+	Sleep(600);
+	ASSERT_TRUE(m_theApp->LoadXmlDocment(xmlDoc,_T("dlg"),_T("layout"))!=FALSE);
+	EXPECT_STREQ(L"v2",xmlDoc.child(L"SOUI").attribute(L"title").value());
+
+	m_theApp->RemoveResProvider(pResProvider);
+	pResProvider->Release();
+}
+
+//创建1000个对话框，比较使用缓存和每次读取解析布局的时间
+TEST_F(SXmlDocCacheTest, DISABLED_bench) {
+	SStringA strLayout = "<SOUI width=\"400\" height=\"300\"><root layout=\"vbox\">";
+	for(int i=0;i<50;i++)
+	{
+		strLayout += SStringA().Format("<window size=\"-2,20\" layout=\"hbox\"><text size=\"100,-1\">label %d</text>"
+			"<button size=\"80,-1\" name=\"btn%d\">ok</button></window>",i,i);
+	}
+	strLayout += "</root></SOUI>";
+	IResProvider *pResProvider = CreateFilesProvider(_T("souitest-xmlcache-bench"),strLayout);
+	ASSERT_TRUE(pResProvider!=NULL);
+	m_theApp->AddResProvider(pResProvider,NULL);
+
+	const int KDialogs = 1000;
+	SXmlDocCache &cache = m_theApp->GetXmlDocCache();
+	double dTime[2] = {0};
+	for(int n=0;n<2;n++)
+	{
+		cache.SetMaxSize(n==0?0:4*1024*1024);
+		LARGE_INTEGER liStart;
+		QueryPerformanceCounter(&liStart);
+		for(int i=0;i<KDialogs;i++)
+		{
+			SHostWnd host(_T("layout:dlg"));
+			host.Create(NULL);
+			host.DestroyWindow();
+		}
+		dTime[n] = Elapse(liStart)/1000;
+	}
+
+	//命中时的查找开销
+	const int KLookups = 100000;
+	pugi::xml_document xmlDoc;
+	LARGE_INTEGER liStart;
+	QueryPerformanceCounter(&liStart);
+	for(int i=0;i<KLookups;i++)
+	{
+		SCachedXmlDoc *pDoc = cache.Lookup(NULL,_T("layout"),_T("dlg"));
+		if(pDoc) pDoc->Release();
+	}
+	double dLookup = Elapse(liStart)*1000/KLookups;
+
+	SXmlDocCacheStats stats;
+	cache.GetStats(stats);
+	printf("%d dialogs: no cache %.1fms, cached %.1fms, lookup %.1fns, hits %d, misses %d\n",
+		KDialogs,dTime[0],dTime[1],dLookup,stats.nHits,stats.nMisses);
+
+	m_theApp->RemoveResProvider(pResProvider);
+	pResProvider->Release();
+}
@@ -3,6 +3,7 @@
 
 #include "stdafx.h"
 #include "tinyxml/tinyxml.h"
+#include "uirescore.h"
 
 const wchar_t  RB_HEADER_RC[]=
 L"/*<------------------------------------------------------------------------------------------------->*/\n"\
@@ -41,34 +42,6 @@ const wchar_t KXML_UIDEF[] = L"uidef";
 //ԶſʼID
 const int KStartID = 0x00010000; 
 
-//ļ޸ʱ
-__int64 GetLastWriteTime(LPCSTR pszFileName)
-{
-	__int64 tmFile=0;
-	WIN32_FIND_DATAA findFileData;
-	HANDLE hFind = FindFirstFileA(pszFileName, &findFileData);
-	if (hFind != INVALID_HANDLE_VALUE)
-	{
-		tmFile= *(__int64*)&findFileData.ftLastWriteTime;
-		FindClose(hFind);
-	}
-	return tmFile;
-}
-
-//ļ޸ʱ
-__int64 GetLastWriteTime(LPCWSTR pszFileName)
-{
-    __int64 tmFile=0;
-    WIN32_FIND_DATAW findFileData;
-    HANDLE hFind = FindFirstFileW(pszFileName, &findFileData);
-    if (hFind != INVALID_HANDLE_VALUE)
-    {
-        tmFile= *(__int64*)&findFileData.ftLastWriteTime;
-        FindClose(hFind);
-    }
-    return tmFile;
-}
-
 //бת˫б
 wstring BuildPath(LPCWSTR pszPath)
 {
@@ -138,9 +111,13 @@ public:
 };
 #pragma  pack(pop)
 
-void WriteFile(__int64 tmIdx, const std::string &strRes, const std::wstring &strOut, BOOL bWithHead = FALSE)
+void WriteFile(const std::string &strRes, const std::wstring &strOut, BOOL bWithHead = FALSE)
 {
-	//__int64 tmIdx=GetLastWriteTime(strIndexFile.c_str());
+	//ݵhashΪʱı䵫ʱдļⴥ±
+	uires::HASH64 hash = uires::HashData(strOut.c_str(),strOut.length()*sizeof(WCHAR));
+	if (bWithHead)
+		hash = uires::HashData(RB_HEADER_RC,wcslen(RB_HEADER_RC)*sizeof(WCHAR),hash);
+	__int64 tmIdx=(__int64)hash;
 	__int64 tmSave=FILEHEAD::ExactTimeStamp(strRes.c_str());
 	//write output string to target res file
 	if(tmIdx!=tmSave)
@@ -337,107 +314,72 @@ void MakeNameValid(const char * pszName,wchar_t * pszOut)
     MakeNameValid(szNameW,pszOut);
 }
 
-void ParseLayout(TiXmlElement *xmlNode,map<wstring,int> &vecName2ID,int & nStartId)
+//ļnameֵ˳ID
+void AssignLayoutID(const uires::LAYOUTNAME & layoutName,map<wstring,int> &vecName2ID,int & nStartId)
 {
-    if(!xmlNode) return;
-    
-    const char * pszAttrName = xmlNode->Attribute("name");
+    const char * pszAttrName = layoutName.strName.c_str();
 
-    if(pszAttrName)
-    {//nameԲŽid
-		wchar_t szName[100]={0};
-        int nID = nStartId;
+	wchar_t szName[100]={0};
+    int nID = nStartId;
 
-        MultiByteToWideChar(CP_ACP,0,pszAttrName,-1,szName,100);
-		bool isNameEmpty=true;
-        for(wchar_t *p=szName;*p;p++)
+    MultiByteToWideChar(CP_ACP,0,pszAttrName,-1,szName,100);
+	bool isNameEmpty=true;
+    for(wchar_t *p=szName;*p;p++)
+	{
+		if(*p != L' ' && *p != L'\t')
 		{
-			if(*p != L' ' && *p != L'\t')
-			{
-				isNameEmpty = false;
-				break;
-			}
+			isNameEmpty = false;
+			break;
 		}
-		if(!isNameEmpty)
+	}
+	if(!isNameEmpty)
+	{
+		if(vecName2ID.find(szName) == vecName2ID.end())
 		{
-			if(vecName2ID.find(szName) == vecName2ID.end())
+			const char *pszID = layoutName.bHasId?layoutName.strId.c_str():NULL;
+			if(!pszID)
+			{
+				nStartId++;
+			}else if(strnicmp(pszID,"ID",2) == 0)
+			{//IDΪIDIDOKIDCANCEL
+				if(stricmp(pszID,"IDOK")==0)
+					nID = IDOK;
+				if(stricmp(pszID,"IDCANCEL")==0)
+					nID = IDCANCEL;
+				if(stricmp(pszID,"IDABORT")==0)
+					nID = IDABORT;
+				if(stricmp(pszID,"IDRETRY")==0)
+					nID = IDRETRY;
+				if(stricmp(pszID,"IDIGNORE")==0)
+					nID = IDIGNORE;
+				if(stricmp(pszID,"IDYES")==0)
+					nID = IDYES;
+				if(stricmp(pszID,"IDNO")==0)
+					nID = IDNO;
+				if(stricmp(pszID,"IDCLOSE")==0)
+					nID = IDCLOSE;
+				if(stricmp(pszID,"IDHELP")==0)
+					nID = IDHELP;
+				if(stricmp(pszID,"IDTRYAGAIN")==0)
+					nID = IDTRYAGAIN;
+				if(stricmp(pszID,"IDCONTINUE")==0)
+					nID = IDCONTINUE;
+			}else
 			{
-				const char *pszID = xmlNode->Attribute("id");
-				if(!pszID)
-				{
-					nStartId++;
-				}else if(strnicmp(pszID,"ID",2) == 0)
-				{//IDΪIDIDOKIDCANCEL
-					if(stricmp(pszID,"IDOK")==0)
-						nID = IDOK;
-					if(stricmp(pszID,"IDCANCEL")==0)
-						nID = IDCANCEL;
-					if(stricmp(pszID,"IDABORT")==0)
-						nID = IDABORT;
-					if(stricmp(pszID,"IDRETRY")==0)
-						nID = IDRETRY;
-					if(stricmp(pszID,"IDIGNORE")==0)
-						nID = IDIGNORE;
-					if(stricmp(pszID,"IDYES")==0)
-						nID = IDYES;
-					if(stricmp(pszID,"IDNO")==0)
-						nID = IDNO;
-					if(stricmp(pszID,"IDCLOSE")==0)
-						nID = IDCLOSE;
-					if(stricmp(pszID,"IDHELP")==0)
-						nID = IDHELP;
-					if(stricmp(pszID,"IDTRYAGAIN")==0)
-						nID = IDTRYAGAIN;
-					if(stricmp(pszID,"IDCONTINUE")==0)
-						nID = IDCONTINUE;
-				}else
-				{
-					nID = atoi(pszID);
-				}
-				vecName2ID[szName] = nID;
+				nID = atoi(pszID);
 			}
-		}else
-		{
-			printf("Warning!!! a empty name was assigned to a window object!");
+			vecName2ID[szName] = nID;
 		}
-    }
-    TiXmlElement *pChild = xmlNode->FirstChildElement();
-    while(pChild)
-    {
-        ParseLayout(pChild,vecName2ID,nStartId);
-        pChild=pChild->NextSiblingElement();
-    }
-}
-
-void ParseLayoutFile(const wchar_t * pszFileName,map<wstring,int> &mapName2ID,int & nStartId)
-{
-    TiXmlDocument xmlLayout;
-    FILE *f = _wfopen(pszFileName,L"rb");
-    if(!f) return;
-    
-    if(xmlLayout.LoadFile(f))
-    {
-        TiXmlElement *pXmlNode = xmlLayout.RootElement();
-        //skin
-        if(stricmp(pXmlNode->Value(),"soui") == 0)
-            ParseLayout(pXmlNode->FirstChildElement("root"),mapName2ID,nStartId);
-        else if(stricmp(pXmlNode->Value(),"include") == 0 
-            || stricmp(pXmlNode->Value(),"menu") == 0   //smenu
-            || stricmp(pXmlNode->Value(),"menuRoot") == 0 //smenuex
-            )
-            ParseLayout(pXmlNode,mapName2ID,nStartId);
-    }else
-    {
-        wprintf(L"!!!err: Load Layout XML Failed! file name: %s\n",pszFileName);
-    }
-    fclose(f);
+	}else
+	{
+		printf("Warning!!! a empty name was assigned to a window object!");
+	}
 }
 
 //UIDefнString,Color Table
-__int64 ParseUIDefFile(map<string,string> &mapFiles, const wchar_t * pszFileName,map<string,int> &mapString,map<string,int> &mapColor)
+void ParseUIDefFile(map<string,string> &mapFiles, const wchar_t * pszFileName,map<string,int> &mapString,map<string,int> &mapColor)
 {
     TiXmlDocument xmlUidef;
-    __int64 tmStamp  = 0;
 
     if(xmlUidef.LoadFile(pszFileName))
     {
@@ -458,7 +400,6 @@ __int64 ParseUIDefFile(map<string,string> &mapFiles, const wchar_t * pszFileName
                         pXmlString = NULL;
                     }else
                     {
-                        tmStamp += GetLastWriteTime(it->second.c_str());
                         docString.LoadFile(it->second.c_str());
                         pXmlString = docString.FirstChildElement("string");
                     }
@@ -497,7 +438,6 @@ __int64 ParseUIDefFile(map<string,string> &mapFiles, const wchar_t * pszFileName
                     }else
                     {
                         docColor.LoadFile(it->second.c_str());
-                        tmStamp += GetLastWriteTime(it->second.c_str());
                         pXmlColor = docColor.FirstChildElement("color");
                     }
                 }
@@ -523,8 +463,6 @@ __int64 ParseUIDefFile(map<string,string> &mapFiles, const wchar_t * pszFileName
             }
         }
     }
-    
-    return tmStamp;
 }
 
 //uiresbuilder -p uires -i uires\uires.idx -r .\uires\winres.rc2 -h .\uires\resource.h idtable
@@ -534,11 +472,13 @@ int _tmain(int argc, _TCHAR* argv[])
 	string strIndexFile;
 	string strRes;		//rc2ļ
 	string strHeadFile; // head file
+	string strCacheFile;	//ֽļ
+	int nThreads = 0;	//߳,0ʾCPU
     BOOL bBuildIDMap=FALSE;  //Build ID map
 	int c;
 
 	printf("%s\n",GetCommandLineA());
-	while ((c = getopt(argc, argv, _T("i:r:p:h:"))) != EOF || optarg!=NULL)
+	while ((c = getopt(argc, argv, _T("i:r:p:h:c:j:"))) != EOF || optarg!=NULL)
 	{
 		switch (c)
 		{
@@ -546,6 +486,8 @@ int _tmain(int argc, _TCHAR* argv[])
 		case 'r':strRes=optarg;break;
 		case 'p':strSkinPath=optarg;break;
 		case 'h':strHeadFile=optarg;break;
+		case 'c':strCacheFile=optarg;break;
+		case 'j':nThreads=atoi(optarg);break;
         case EOF:
             if(_tcscmp(optarg ,_T("idtable"))==0) bBuildIDMap = TRUE;
             optind ++;
@@ -561,6 +503,8 @@ int _tmain(int argc, _TCHAR* argv[])
         printf("\tparam -p : define path of uires folder\n");
         printf("\tparam -r : define path of output .rc2 file\n");
         printf("\tparam -h : define path of output resource.h file\n");
+        printf("\tparam -c : define path of layout parse cache file. resource.h path + \".cache\" for default.\n");
+        printf("\tparam -j : define count of parse threads. count of cpu for default.\n");
         printf("\tparam idtable : define idtable is needed for resource.h. no id table for default.\n");
 		return 1;
 	}
@@ -650,8 +594,7 @@ int _tmain(int argc, _TCHAR* argv[])
 			strOut+=szRec;
 			it2++;
 		}
-        __int64 tmIdx=GetLastWriteTime(strIndexFile.c_str());
-		WriteFile(tmIdx, strRes, strOut, TRUE);
+		WriteFile(strRes, strOut, TRUE);
 	}
 
     //name,id,ֻԴlayoutԴXMLԴ
@@ -661,23 +604,64 @@ int _tmain(int argc, _TCHAR* argv[])
         map<string,int> mapString;
         map<string,int> mapColor;
 
-
-        __int64 tmResource = bBuildIDMap;
-        
 		mapNameID[L"_name_start"] = KStartID-1;//һ_name_startֹһΪյname-id顣
 
-        int nStartID = KStartID;
+        //ռֺͲ˵ļûиıļֱʹûеnameбļн
+        vector<uires::LAYOUTFILE> lstLayouts;
         vector<IDMAPRECORD>::iterator it2=vecIdMapRecord.begin();
         while(it2!=vecIdMapRecord.end())
         {
             if(wcsicmp(it2->szType,KXML_LAYOUT)==0 || wcsicmp(it2->szType,KXML_SMENU) == 0 || wcsicmp(it2->szType,KXML_SMENUEX) == 0)
             {//ֲֻ߲˵ļ
-                tmResource += GetLastWriteTime(it2->szPath);
-                ParseLayoutFile(it2->szPath,mapNameID,nStartID);
-            }else if(wcsicmp(it2->szType,KXML_UIDEF)==0)
+                char szPath[MAX_PATH*3];
+                WideCharToMultiByte(CP_UTF8,0,it2->szPath,-1,szPath,MAX_PATH*3,NULL,NULL);
+                uires::LAYOUTFILE layout;
+                layout.strPath = szPath;
+                lstLayouts.push_back(layout);
+            }
+            it2 ++;
+        }
+
+        if(strCacheFile.empty()) strCacheFile = strHeadFile + ".cache";
+        wchar_t wszCacheFile[MAX_PATH];
+        char szCacheFile[MAX_PATH*3];
+        MultiByteToWideChar(CP_ACP,0,strCacheFile.c_str(),-1,wszCacheFile,MAX_PATH);
+        WideCharToMultiByte(CP_UTF8,0,wszCacheFile,-1,szCacheFile,MAX_PATH*3,NULL,NULL);
+        uires::CLayoutCache layoutCache;
+        layoutCache.Load(szCacheFile);
+        int nParsed = layoutCache.ParseFiles(lstLayouts,nThreads);
+        if(layoutCache.IsDirty()) layoutCache.Save(szCacheFile);
+        int nCached = 0;
+        for(size_t i=0;i<lstLayouts.size();i++)
+        {
+            if(lstLayouts[i].bCached) nCached++;
+        }
+        printf("layout files: %d parsed, %d cached\n",nParsed,nCached);
+
+        //IDļе˳nameļе˳䣬ͽ˳޹
+        int nStartID = KStartID;
+        for(size_t i=0;i<lstLayouts.size();i++)
+        {
+            const uires::LAYOUTFILE & layout = lstLayouts[i];
+            if(layout.nStatus == uires::LS_PARSE_FAILED)
+            {
+                wchar_t szPath[MAX_PATH];
+                MultiByteToWideChar(CP_UTF8,0,layout.strPath.c_str(),-1,szPath,MAX_PATH);
+                wprintf(L"!!!err: Load Layout XML Failed! file name: %s\n",szPath);
+                continue;
+            }
+            for(size_t j=0;j<layout.lstNames.size();j++)
+            {
+                AssignLayoutID(layout.lstNames[j],mapNameID,nStartID);
+            }
+        }
+
+        it2=vecIdMapRecord.begin();
+        while(it2!=vecIdMapRecord.end())
+        {
+            if(wcsicmp(it2->szType,KXML_UIDEF)==0)
             {//ҵUIDEF
-                tmResource += GetLastWriteTime(it2->szPath);
-                tmResource += ParseUIDefFile(mapFiles,it2->szPath,mapString,mapColor);
+                ParseUIDefFile(mapFiles,it2->szPath,mapString,mapColor);
             }
             it2 ++;
         }
@@ -805,7 +789,7 @@ int _tmain(int argc, _TCHAR* argv[])
 
         strOut += L"}\r\n";
 
-		WriteFile(tmResource, strHeadFile, strOut, FALSE);
+		WriteFile(strHeadFile, strOut, FALSE);
 	}
 
 	return 0;
@@ -0,0 +1,235 @@
+/*
+	uirescorenameͲֻ
+	WindowsLinux
+*/
+#include <gtest/gtest.h>
+#include "uirescore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/utime.h>
+#define utime _utime
+#define utimbuf _utimbuf
+#else
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace uires;
+
+static void WriteFile(const std::string &strPath, const std::string &strData)
+{
+	FILE *f = fopen(strPath.c_str(),"wb");
+	ASSERT_TRUE(f != NULL);
+	fwrite(strData.data(),1,strData.size(),f);
+	fclose(f);
+}
+
+static void SetMTime(const std::string &strPath, time_t tm)
+{
+	struct utimbuf ut;
+	ut.actime = ut.modtime = tm;
+	utime(strPath.c_str(),&ut);
+}
+
+static std::string MakeLayout(int iFile, int nNames)
+{
+	std::string strXml = "<soui>\r\n<skin><img name=\"skin_not_counted\"/></skin><root>\r\n";
+	for(int i=0;i<nNames;i++)
+	{
+		char szLine[128];
+		sprintf(szLine,"<window name=\"n%d_%d\"%s/>\r\n",iFile,i,i%3?"":" id=\"100\"");
+		strXml += szLine;
+	}
+	strXml += "</root></soui>";
+	return strXml;
+}
+
+//ÿʹöʱĿ¼
+class LayoutCacheTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+#ifdef _WIN32
+		char szTemp[MAX_PATH];
+		GetTempPathA(MAX_PATH,szTemp);
+		char szDir[MAX_PATH];
+		sprintf(szDir,"%suirescore%u",szTemp,GetCurrentProcessId());
+		CreateDirectoryA(szDir,NULL);
+		m_strDir = szDir;
+#else
+		char szDir[] = "/tmp/uirescoreXXXXXX";
+		ASSERT_TRUE(mkdtemp(szDir) != NULL);
+		m_strDir = szDir;
+#endif
+		m_strCache = m_strDir + "/layout.cache";
+	}
+
+	virtual void TearDown()
+	{
+		for(size_t i=0;i<m_lstFiles.size();i++) remove(m_lstFiles[i].c_str());
+		remove(m_strCache.c_str());
+#ifdef _WIN32
+		RemoveDirectoryA(m_strDir.c_str());
+#else
+		rmdir(m_strDir.c_str());
+#endif
+	}
+
+	std::string AddFile(const std::string &strName, const std::string &strData)
+	{
+		std::string strPath = m_strDir + "/" + strName;
+		WriteFile(strPath,strData);
+		m_lstFiles.push_back(strPath);
+		return strPath;
+	}
+
+	std::vector<LAYOUTFILE> GetInputs() const
+	{
+		std::vector<LAYOUTFILE> lstFiles(m_lstFiles.size());
+		for(size_t i=0;i<m_lstFiles.size();i++) lstFiles[i].strPath = m_lstFiles[i];
+		return lstFiles;
+	}
+
+	std::string m_strDir;
+	std::string m_strCache;
+	std::vector<std::string> m_lstFiles;
+};
+
+TEST(uirescore, parse) {
+	std::vector<LAYOUTNAME> lstNames;
+	EXPECT_EQ(ParseLayoutData(MakeLayout(1,4),lstNames),LS_OK);
+	ASSERT_EQ(lstNames.size(),4u);	//skinеname
+	EXPECT_EQ(lstNames[0].strName,"n1_0");
+	EXPECT_TRUE(lstNames[0].bHasId);
+	EXPECT_EQ(lstNames[0].strId,"100");
+	EXPECT_FALSE(lstNames[1].bHasId);
+	EXPECT_EQ(lstNames[3].strName,"n1_3");
+
+	EXPECT_EQ(ParseLayoutData("<include><a name=\"x\"><b name=\"y\"/></a></include>",lstNames),LS_OK);
+	ASSERT_EQ(lstNames.size(),2u);
+	EXPECT_EQ(lstNames[1].strName,"y");
+
+	EXPECT_EQ(ParseLayoutData("<soui><root><window name=\"x\"></root>",lstNames),LS_PARSE_FAILED);
+	EXPECT_EQ(ParseLayoutData("",lstNames),LS_PARSE_FAILED);
+}
+
+//ÿִֻһ
+static void CountTask(int iTask, void *ctx)
+{
+	((int*)ctx)[iTask] ++;
+}
+
+TEST(uirescore, runparallel) {
+	const int KTasks = 1000;
+	std::vector<int> lstCount(KTasks,0);
+	RunParallel(KTasks,8,CountTask,&lstCount[0]);
+	for(int i=0;i<KTasks;i++) EXPECT_EQ(lstCount[i],1);
+}
+
+TEST_F(LayoutCacheTest, reuse) {
+	const int KFiles = 50;
+	for(int i=0;i<KFiles;i++)
+	{
+		char szName[32];
+		sprintf(szName,"%d.xml",i);
+		AddFile(szName,MakeLayout(i,20));
+	}
+	std::vector<LAYOUTFILE> lstFirst = GetInputs();
+	CLayoutCache cache;
+	EXPECT_FALSE(cache.Load(m_strCache));
+	EXPECT_EQ(cache.ParseFiles(lstFirst,4),KFiles);
+	EXPECT_TRUE(cache.IsDirty());
+	ASSERT_TRUE(cache.Save(m_strCache));
+
+	//ûиıļȫʹû棬һͬ
+	CLayoutCache cache2;
+	ASSERT_TRUE(cache2.Load(m_strCache));
+	std::vector<LAYOUTFILE> lstSecond = GetInputs();
+	EXPECT_EQ(cache2.ParseFiles(lstSecond,4),0);
+	EXPECT_FALSE(cache2.IsDirty());
+	for(int i=0;i<KFiles;i++)
+	{
+		EXPECT_TRUE(lstSecond[i].bCached);
+		EXPECT_EQ(lstSecond[i].hash,lstFirst[i].hash);
+		ASSERT_EQ(lstSecond[i].lstNames.size(),lstFirst[i].lstNames.size());
+		for(size_t j=0;j<lstFirst[i].lstNames.size();j++)
+			EXPECT_EQ(lstSecond[i].lstNames[j].strName,lstFirst[i].lstNames[j].strName);
+	}
+}
+
+TEST_F(LayoutCacheTest, stat) {
+	std::string strA = AddFile("a.xml",MakeLayout(1,5));
+	std::string strB = AddFile("b.xml",MakeLayout(2,5));
+	SetMTime(strA,1000000);
+	SetMTime(strB,1000000);
+	{
+		CLayoutCache cache;
+		std::vector<LAYOUTFILE> lstFiles = GetInputs();
+		EXPECT_EQ(cache.ParseFiles(lstFiles,2),2);
+		ASSERT_TRUE(cache.Save(m_strCache));
+	}
+
+	//ֻı޸ʱ䣺hashͬ½Ҫ»е޸ʱ
+	SetMTime(strA,2000000);
+	{
+		CLayoutCache cache;
+		ASSERT_TRUE(cache.Load(m_strCache));
+		std::vector<LAYOUTFILE> lstFiles = GetInputs();
+		EXPECT_EQ(cache.ParseFiles(lstFiles,2),0);
+		EXPECT_TRUE(cache.IsDirty());
+		ASSERT_TRUE(cache.Save(m_strCache));
+	}
+
+	//С޸ʱ䶼ʱȡļݱдҲʹû
+	WriteFile(strB,MakeLayout(3,5));
+	SetMTime(strB,1000000);
+	{
+		CLayoutCache cache;
+		ASSERT_TRUE(cache.Load(m_strCache));
+		std::vector<LAYOUTFILE> lstFiles = GetInputs();
+		EXPECT_EQ(cache.ParseFiles(lstFiles,2),0);
+		EXPECT_FALSE(cache.IsDirty());
+		EXPECT_EQ(lstFiles[1].lstNames[0].strName,"n2_0");
+	}
+
+	//޸ʱı½
+	SetMTime(strB,3000000);
+	{
+		CLayoutCache cache;
+		ASSERT_TRUE(cache.Load(m_strCache));
+		std::vector<LAYOUTFILE> lstFiles = GetInputs();
+		EXPECT_EQ(cache.ParseFiles(lstFiles,2),1);
+		EXPECT_TRUE(cache.IsDirty());
+		EXPECT_FALSE(lstFiles[1].bCached);
+		EXPECT_EQ(lstFiles[1].lstNames[0].strName,"n3_0");
+	}
+}
+
+TEST_F(LayoutCacheTest, corrupt) {
+	AddFile("a.xml",MakeLayout(1,5));
+	{
+		CLayoutCache cache;
+		std::vector<LAYOUTFILE> lstFiles = GetInputs();
+		cache.ParseFiles(lstFiles,1);
+		ASSERT_TRUE(cache.Save(m_strCache));
+	}
+	//ضϻļȫ½
+	std::string strData;
+	ASSERT_TRUE(ReadFileData(m_strCache,strData));
+	WriteFile(m_strCache,strData.substr(0,strData.size()/2));
+	CLayoutCache cache;
+	EXPECT_FALSE(cache.Load(m_strCache));
+	std::vector<LAYOUTFILE> lstFiles = GetInputs();
+	EXPECT_EQ(cache.ParseFiles(lstFiles,1),1);
+
+	//򲻿ļ뻺
+	std::vector<LAYOUTFILE> lstMissing(1);
+	lstMissing[0].strPath = m_strDir + "/missing.xml";
+	cache.ParseFiles(lstMissing,1);
+	EXPECT_EQ(lstMissing[0].nStatus,LS_OPEN_FAILED);
+}
@@ -965,7 +965,20 @@ bool TiXmlDocument::SaveFile() const
 bool TiXmlDocument::LoadFile( const wchar_t* _filename, TiXmlEncoding encoding )
 {
     // reading in binary mode so that tinyxml can normalize the EOL
+#ifdef _WIN32
     FILE* file = _wfopen( _filename, L"rb" );	
+#else
+    // no wide char fopen outside Windows: convert the name with the current locale
+    FILE* file = 0;
+    size_t len = wcstombs( 0, _filename, 0 );
+    if ( len != (size_t)-1 )
+    {
+        char* buf = new char[len+1];
+        wcstombs( buf, _filename, len+1 );
+        file = TiXmlFOpen( buf, "rb" );
+        delete [] buf;
+    }
+#endif
 
     if ( file )
     {
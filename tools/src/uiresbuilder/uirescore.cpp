@@ -0,0 +1,462 @@
+// uirescore.cpp : uiresbuilderƽ̨޹صĲ
+//
+
+#include "uirescore.h"
+#include "tinyxml/tinyxml.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <strings.h>
+#include <sys/stat.h>
+#define stricmp strcasecmp
+#endif
+
+namespace uires
+{
+	//ļʽı߽ıʱҪ޸İ汾
+	static const char KCacheMagic[8] = {'U','R','B','C','A','C','H','2'};
+
+	HASH64 HashData(const void *pData, size_t nLen, HASH64 seed)
+	{
+		const unsigned char *p = (const unsigned char*)pData;
+		HASH64 hash = seed;
+		for(size_t i=0;i<nLen;i++)
+		{
+			hash ^= p[i];
+			hash *= 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	bool ReadFileData(const std::string &strPath, std::string &strData)
+	{
+#ifdef _WIN32
+		wchar_t szPath[MAX_PATH];
+		if(!MultiByteToWideChar(CP_UTF8,0,strPath.c_str(),-1,szPath,MAX_PATH)) return false;
+		FILE *f = _wfopen(szPath,L"rb");
+#else
+		FILE *f = fopen(strPath.c_str(),"rb");
+#endif
+		if(!f) return false;
+		fseek(f,0,SEEK_END);
+		long nLen = ftell(f);
+		fseek(f,0,SEEK_SET);
+		bool bOk = nLen>=0;
+		if(bOk)
+		{
+			strData.resize(nLen);
+			bOk = nLen==0 || fread(&strData[0],nLen,1,f)==1;
+		}
+		fclose(f);
+		return bOk;
+	}
+
+	bool GetFileStat(const std::string &strPath, unsigned long long &nSize, long long &nMTime)
+	{
+#ifdef _WIN32
+		wchar_t szPath[MAX_PATH];
+		if(!MultiByteToWideChar(CP_UTF8,0,strPath.c_str(),-1,szPath,MAX_PATH)) return false;
+		WIN32_FILE_ATTRIBUTE_DATA attr;
+		if(!GetFileAttributesExW(szPath,GetFileExInfoStandard,&attr)) return false;
+		nSize = ((unsigned long long)attr.nFileSizeHigh<<32) | attr.nFileSizeLow;
+		nMTime = ((long long)attr.ftLastWriteTime.dwHighDateTime<<32) | attr.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat st;
+		if(stat(strPath.c_str(),&st)!=0) return false;
+		nSize = (unsigned long long)st.st_size;
+#ifdef __linux__
+		nMTime = (long long)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec;
+#else
+		nMTime = (long long)st.st_mtime;
+#endif
+#endif
+		return true;
+	}
+
+	int GetCpuCount()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		return (int)si.dwNumberOfProcessors;
+#else
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		return n>0?(int)n:1;
+#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// ̳߳أÿ̴߳ӹȡһ
+	struct TASKPOOL
+	{
+		FunTask fun;
+		void *ctx;
+		int nTasks;
+		volatile long iNext;
+	};
+
+	static int NextTask(TASKPOOL *pPool)
+	{
+#ifdef _WIN32
+		return (int)InterlockedIncrement(&pPool->iNext) - 1;
+#else
+		return (int)__sync_fetch_and_add(&pPool->iNext,1);
+#endif
+	}
+
+	static void WorkerLoop(TASKPOOL *pPool)
+	{
+		for(;;)
+		{
+			int iTask = NextTask(pPool);
+			if(iTask >= pPool->nTasks) break;
+			pPool->fun(iTask,pPool->ctx);
+		}
+	}
+
+#ifdef _WIN32
+	static unsigned int __stdcall WorkerProc(void *p)
+	{
+		WorkerLoop((TASKPOOL*)p);
+		return 0;
+	}
+#else
+	static void * WorkerProc(void *p)
+	{
+		WorkerLoop((TASKPOOL*)p);
+		return NULL;
+	}
+#endif
+
+	void RunParallel(int nTasks, int nThreads, FunTask fun, void *ctx)
+	{
+		TASKPOOL pool = {fun,ctx,nTasks,0};
+		if(nThreads > nTasks) nThreads = nTasks;
+		//ǰ߳ҲִֻҪⴴnThreads-1߳
+#ifdef _WIN32
+		std::vector<HANDLE> lstThreads;
+		for(int i=1;i<nThreads;i++)
+		{
+			HANDLE hThread = (HANDLE)_beginthreadex(NULL,0,WorkerProc,&pool,0,NULL);
+			if(hThread) lstThreads.push_back(hThread);
+		}
+		WorkerLoop(&pool);
+		for(size_t i=0;i<lstThreads.size();i++)
+		{
+			WaitForSingleObject(lstThreads[i],INFINITE);
+			CloseHandle(lstThreads[i]);
+		}
+#else
+		std::vector<pthread_t> lstThreads;
+		for(int i=1;i<nThreads;i++)
+		{
+			pthread_t thread;
+			if(pthread_create(&thread,NULL,WorkerProc,&pool)==0) lstThreads.push_back(thread);
+		}
+		WorkerLoop(&pool);
+		for(size_t i=0;i<lstThreads.size();i++)
+		{
+			pthread_join(lstThreads[i],NULL);
+		}
+#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	static void ParseLayout(TiXmlElement *xmlNode, std::vector<LAYOUTNAME> &lstNames)
+	{
+		if(!xmlNode) return;
+
+		const char * pszAttrName = xmlNode->Attribute("name");
+		if(pszAttrName)
+		{
+			LAYOUTNAME name;
+			name.strName = pszAttrName;
+			const char *pszID = xmlNode->Attribute("id");
+			name.bHasId = pszID != NULL;
+			if(pszID) name.strId = pszID;
+			lstNames.push_back(name);
+		}
+		TiXmlElement *pChild = xmlNode->FirstChildElement();
+		while(pChild)
+		{
+			ParseLayout(pChild,lstNames);
+			pChild=pChild->NextSiblingElement();
+		}
+	}
+
+	int ParseLayoutData(const std::string &strData, std::vector<LAYOUTNAME> &lstNames)
+	{
+		lstNames.clear();
+		if(strData.empty()) return LS_PARSE_FAILED;
+
+		//TiXmlDocument::LoadFileһȽͳһΪLF0
+		std::string strBuf;
+		strBuf.reserve(strData.size());
+		for(size_t i=0;i<strData.size() && strData[i];i++)
+		{
+			if(strData[i] == '\r')
+			{
+				strBuf += '\n';
+				if(i+1<strData.size() && strData[i+1]=='\n') i++;
+			}else
+			{
+				strBuf += strData[i];
+			}
+		}
+
+		TiXmlDocument xmlLayout;
+		xmlLayout.Parse(strBuf.c_str(),0,TIXML_DEFAULT_ENCODING);
+		if(xmlLayout.Error()) return LS_PARSE_FAILED;
+
+		TiXmlElement *pXmlNode = xmlLayout.RootElement();
+		if(!pXmlNode) return LS_OK;
+		//skin
+		if(stricmp(pXmlNode->Value(),"soui") == 0)
+			ParseLayout(pXmlNode->FirstChildElement("root"),lstNames);
+		else if(stricmp(pXmlNode->Value(),"include") == 0
+			|| stricmp(pXmlNode->Value(),"menu") == 0   //smenu
+			|| stricmp(pXmlNode->Value(),"menuRoot") == 0 //smenuex
+			)
+			ParseLayout(pXmlNode,lstNames);
+		return LS_OK;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// CLayoutCache
+	static void WriteU32(FILE *f, unsigned int v)
+	{
+		unsigned char buf[4] = {(unsigned char)v,(unsigned char)(v>>8),(unsigned char)(v>>16),(unsigned char)(v>>24)};
+		fwrite(buf,1,4,f);
+	}
+
+	static void WriteU64(FILE *f, HASH64 v)
+	{
+		WriteU32(f,(unsigned int)(v & 0xffffffff));
+		WriteU32(f,(unsigned int)(v >> 32));
+	}
+
+	static void WriteString(FILE *f, const std::string &str)
+	{
+		WriteU32(f,(unsigned int)str.size());
+		fwrite(str.data(),1,str.size(),f);
+	}
+
+	//С˶ȡԽʱfalse
+	class CReader
+	{
+	public:
+		CReader(const std::string &strData):m_strData(strData),m_nPos(0){}
+
+		bool ReadU32(unsigned int &v)
+		{
+			if(m_nPos+4 > m_strData.size()) return false;
+			const unsigned char *p = (const unsigned char*)m_strData.data()+m_nPos;
+			v = p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+			m_nPos += 4;
+			return true;
+		}
+
+		bool ReadU64(HASH64 &v)
+		{
+			unsigned int lo,hi;
+			if(!ReadU32(lo) || !ReadU32(hi)) return false;
+			v = ((HASH64)hi<<32) | lo;
+			return true;
+		}
+
+		bool ReadString(std::string &str)
+		{
+			unsigned int nLen;
+			if(!ReadU32(nLen) || nLen > m_strData.size()-m_nPos) return false;
+			str.assign(m_strData,m_nPos,nLen);
+			m_nPos += nLen;
+			return true;
+		}
+
+		bool ReadBytes(void *p, size_t nLen)
+		{
+			if(m_nPos+nLen > m_strData.size()) return false;
+			memcpy(p,m_strData.data()+m_nPos,nLen);
+			m_nPos += nLen;
+			return true;
+		}
+
+	protected:
+		const std::string &m_strData;
+		size_t m_nPos;
+	};
+
+	bool CLayoutCache::Load(const std::string &strFile)
+	{
+		m_mapFiles.clear();
+		m_bDirty = false;
+
+		std::string strData;
+		if(!ReadFileData(strFile,strData)) return false;
+		CReader reader(strData);
+		char szMagic[8];
+		unsigned int nFiles;
+		if(!reader.ReadBytes(szMagic,8) || memcmp(szMagic,KCacheMagic,8)!=0 || !reader.ReadU32(nFiles))
+			return false;
+
+		for(unsigned int i=0;i<nFiles;i++)
+		{
+			LAYOUTFILE file;
+			unsigned int nStatus,nNames;
+			HASH64 nSize,nMTime;
+			if(!reader.ReadString(file.strPath) || !reader.ReadU64(nSize) || !reader.ReadU64(nMTime)
+				|| !reader.ReadU64(file.hash) || !reader.ReadU32(nStatus) || !reader.ReadU32(nNames))
+			{//ļ𻵣ȫ½
+				m_mapFiles.clear();
+				return false;
+			}
+			file.nSize = nSize;
+			file.nMTime = (long long)nMTime;
+			file.nStatus = (int)nStatus;
+			file.bCached = true;
+			for(unsigned int j=0;j<nNames;j++)
+			{
+				LAYOUTNAME name;
+				unsigned int bHasId;
+				if(!reader.ReadString(name.strName) || !reader.ReadU32(bHasId) || !reader.ReadString(name.strId))
+				{
+					m_mapFiles.clear();
+					return false;
+				}
+				name.bHasId = bHasId!=0;
+				file.lstNames.push_back(name);
+			}
+			m_mapFiles[file.strPath] = file;
+		}
+		return true;
+	}
+
+	bool CLayoutCache::Save(const std::string &strFile) const
+	{
+#ifdef _WIN32
+		wchar_t szPath[MAX_PATH];
+		if(!MultiByteToWideChar(CP_UTF8,0,strFile.c_str(),-1,szPath,MAX_PATH)) return false;
+		FILE *f = _wfopen(szPath,L"wb");
+#else
+		FILE *f = fopen(strFile.c_str(),"wb");
+#endif
+		if(!f) return false;
+		fwrite(KCacheMagic,1,8,f);
+		WriteU32(f,(unsigned int)m_mapFiles.size());
+		std::map<std::string, LAYOUTFILE>::const_iterator it = m_mapFiles.begin();
+		for(;it!=m_mapFiles.end();it++)
+		{
+			const LAYOUTFILE &file = it->second;
+			WriteString(f,file.strPath);
+			WriteU64(f,file.nSize);
+			WriteU64(f,(HASH64)file.nMTime);
+			WriteU64(f,file.hash);
+			WriteU32(f,(unsigned int)file.nStatus);
+			WriteU32(f,(unsigned int)file.lstNames.size());
+			for(size_t i=0;i<file.lstNames.size();i++)
+			{
+				WriteString(f,file.lstNames[i].strName);
+				WriteU32(f,file.lstNames[i].bHasId?1:0);
+				WriteString(f,file.lstNames[i].strId);
+			}
+		}
+		bool bOk = ferror(f)==0;
+		fclose(f);
+		return bOk;
+	}
+
+	const LAYOUTFILE * CLayoutCache::Find(const std::string &strPath, HASH64 hash) const
+	{
+		std::map<std::string, LAYOUTFILE>::const_iterator it = m_mapFiles.find(strPath);
+		if(it == m_mapFiles.end() || it->second.hash != hash) return NULL;
+		return &it->second;
+	}
+
+	const LAYOUTFILE * CLayoutCache::Find(const std::string &strPath, unsigned long long nSize, long long nMTime) const
+	{
+		std::map<std::string, LAYOUTFILE>::const_iterator it = m_mapFiles.find(strPath);
+		if(it == m_mapFiles.end() || it->second.nSize != nSize || it->second.nMTime != nMTime) return NULL;
+		return &it->second;
+	}
+
+	struct PARSECONTEXT
+	{
+		const CLayoutCache *pCache;
+		std::vector<LAYOUTFILE> *pFiles;
+	};
+
+	//ִ߳Уֻʻ棬ֻдԼļ¼
+	static void ParseFileTask(int iTask, void *ctx)
+	{
+		PARSECONTEXT *pCtx = (PARSECONTEXT*)ctx;
+		LAYOUTFILE &file = (*pCtx->pFiles)[iTask];
+		file.lstNames.clear();
+		file.nSize = 0;
+		file.nMTime = 0;
+		file.hash = 0;
+		file.bCached = false;
+
+		//С޸ʱ䶼ûʱֱʹû棬ȡļ
+		const LAYOUTFILE *pCached = NULL;
+		if(GetFileStat(file.strPath,file.nSize,file.nMTime))
+		{
+			pCached = pCtx->pCache->Find(file.strPath,file.nSize,file.nMTime);
+		}
+		if(pCached)
+		{
+			file.hash = pCached->hash;
+			file.nStatus = pCached->nStatus;
+			file.lstNames = pCached->lstNames;
+			file.bCached = true;
+			return;
+		}
+
+		std::string strData;
+		if(!ReadFileData(file.strPath,strData))
+		{
+			file.nStatus = LS_OPEN_FAILED;
+			return;
+		}
+		file.hash = HashData(strData.data(),strData.size());
+		//ֻ޸ʱı(touch)ʱhash䣬Ҫ½
+		pCached = pCtx->pCache->Find(file.strPath,file.hash);
+		if(pCached)
+		{
+			file.nStatus = pCached->nStatus;
+			file.lstNames = pCached->lstNames;
+			file.bCached = true;
+		}else
+		{
+			file.nStatus = ParseLayoutData(strData,file.lstNames);
+		}
+	}
+
+	int CLayoutCache::ParseFiles(std::vector<LAYOUTFILE> &lstFiles, int nThreads)
+	{
+		if(nThreads <= 0) nThreads = GetCpuCount();
+		PARSECONTEXT ctx = {this,&lstFiles};
+		RunParallel((int)lstFiles.size(),nThreads,ParseFileTask,&ctx);
+
+		int nParsed = 0;
+		bool bStatChanged = false;
+		std::map<std::string, LAYOUTFILE> mapFiles;
+		for(size_t i=0;i<lstFiles.size();i++)
+		{
+			const LAYOUTFILE &file = lstFiles[i];
+			if(file.nStatus == LS_OPEN_FAILED) continue;
+			if(!file.bCached) nParsed++;
+			//û䵫޸ʱˣҲҪ»棬´βȡ
+			else if(!Find(file.strPath,file.nSize,file.nMTime)) bStatChanged = true;
+			mapFiles[file.strPath] = file;
+		}
+		if(nParsed>0 || bStatChanged || mapFiles.size()!=m_mapFiles.size()) m_bDirty = true;
+		m_mapFiles.swap(mapFiles);
+		return nParsed;
+	}
+}
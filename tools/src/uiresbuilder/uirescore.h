@@ -0,0 +1,88 @@
+// uirescore.h : uiresbuilderƽ̨޹صĲ֣Linux±
+//
+// ļhashֻ½ݸıļļhashͽ̳߳вִС
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace uires
+{
+	typedef unsigned long long HASH64;
+
+	//FNV-1a 64λhashһεĽΪseed
+	HASH64 HashData(const void *pData, size_t nLen, HASH64 seed = 0xcbf29ce484222325ULL);
+
+	//ȡļ·ΪUTF8
+	bool ReadFileData(const std::string &strPath, std::string &strData);
+
+	//ȡļС޸ʱ䣬ʱĵλƽֻ̨ڱȽǷı
+	bool GetFileStat(const std::string &strPath, unsigned long long &nSize, long long &nMTime);
+
+	int GetCpuCount();
+
+	//nThreadsִ߳nTasksfun(iTask,ctx)ǰ
+	typedef void (*FunTask)(int iTask, void *ctx);
+	void RunParallel(int nTasks, int nThreads, FunTask fun, void *ctx);
+
+	//ļһnameԵĽ㣬ĵ˳򱣴棬ɵ߷ID
+	struct LAYOUTNAME
+	{
+		std::string strName;
+		bool		bHasId;
+		std::string strId;
+	};
+
+	enum LAYOUTSTATUS
+	{
+		LS_OK = 0,
+		LS_OPEN_FAILED,		//ļ򲻿
+		LS_PARSE_FAILED,	//XMLʧ
+	};
+
+	struct LAYOUTFILE
+	{
+		std::string strPath;	//UTF8·
+		unsigned long long nSize;	//ļС
+		long long	nMTime;		//ļ޸ʱ
+		HASH64		hash;		//ļݵhash
+		int			nStatus;	//LAYOUTSTATUS
+		bool		bCached;	//ǷӻõĽ
+		std::vector<LAYOUTNAME> lstNames;
+	};
+
+	//XMLıȡnameбֱӼļĽȫһ
+	int ParseLayoutData(const std::string &strData, std::vector<LAYOUTNAME> &lstNames);
+
+	class CLayoutCache
+	{
+	public:
+		CLayoutCache() :m_bDirty(false) {}
+
+		bool Load(const std::string &strFile);
+		bool Save(const std::string &strFile) const;
+
+		const LAYOUTFILE * Find(const std::string &strPath, HASH64 hash) const;
+
+		//С޸ʱ䶼ûиıʱҪȡļhash
+		const LAYOUTFILE * Find(const std::string &strPath, unsigned long long nSize, long long nMTime) const;
+
+		/**
+		* ParseFiles
+		* @brief    ļûиıļʹûĽ
+		* @param    std::vector<LAYOUTFILE> & lstFiles --  ҪдstrPath
+		* @param    int nThreads --  ߳<=0ʱʹCPU
+		* @return   int -- ʵʽļ
+		* Describe  ȱȽļС޸ʱ䣬ıٱȽhashɺ󻺴ֻlstFilesеļ
+		*/
+		int ParseFiles(std::vector<LAYOUTFILE> &lstFiles, int nThreads);
+
+		bool IsDirty() const { return m_bDirty; }
+
+	protected:
+		std::map<std::string, LAYOUTFILE> m_mapFiles;
+		bool m_bDirty;
+	};
+}
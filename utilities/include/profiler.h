@@ -0,0 +1,104 @@
+﻿/********************************************************************
+	created:	2026/10/19
+	filename: 	profiler.h
+	author:		soui group
+
+	purpose:	帧性能分析器，记录代码段耗时并导出为Chrome trace格式(chrome://tracing)
+*********************************************************************/
+#pragma once
+#include "utilities-def.h"
+
+#include <windows.h>
+
+//定义SOUI_PROFILER时SPROFILE_SCOPE才会插入计时代码，运行时还需要调用SProfiler::Enable开始记录
+namespace SOUI
+{
+    class UTILITIES_API SProfiler
+    {
+    public:
+        /**
+        * Enable
+        * @brief    开始/停止记录
+        * @param    BOOL bEnable --  是否记录
+        * @return   void
+        */
+        static void Enable(BOOL bEnable);
+
+        static BOOL IsEnabled() {return s_bEnabled!=0;}
+
+        /**
+        * SetBufferSize
+        * @brief    设置每个线程环形缓冲区能保存的记录数，缓冲区满后覆盖最早的记录
+        * @param    UINT nEvents --  记录数，只对之后第一次记录的线程有效
+        * @return   void
+        */
+        static void SetBufferSize(UINT nEvents);
+
+        //当前时间，单位为QueryPerformanceCounter计数
+        static LONGLONG Now();
+
+        /**
+        * Record
+        * @brief    在当前线程的缓冲区中记录一段代码的执行时间
+        * @param    LPCSTR pszName --  名称，必须是常量字符串，导出时才读取
+        * @param    LPCWSTR pszArg --  附加参数，例如窗口类名，会被复制，可以为NULL
+        * @param    LONGLONG llStart --  开始时间，由Now获得
+        * @return   void
+        */
+        static void Record(LPCSTR pszName,LPCWSTR pszArg,LONGLONG llStart);
+
+        //所有线程缓冲区中的记录数
+        static UINT GetEventCount();
+
+        //清空所有记录，应该在停止记录后调用
+        static void Reset();
+
+        /**
+        * ExportChromeTrace
+        * @brief    将所有线程的记录导出为Chrome trace-event JSON文件
+        * @param    LPCWSTR pszFileName --  文件名
+        * @return   BOOL
+        * Describe  导出时正在写入的记录可能不完整，建议先停止记录
+        */
+        static BOOL ExportChromeTrace(LPCWSTR pszFileName);
+
+        static volatile LONG s_bEnabled;
+    };
+
+    /**
+    * @class      SProfileScope
+    * @brief      在作用域结束时记录作用域的执行时间
+    *
+    * Describe    没有开始记录时只有一次读取和比较
+    */
+    class SProfileScope
+    {
+    public:
+        SProfileScope(LPCSTR pszName,LPCWSTR pszArg=NULL)
+            :m_pszName(pszName),m_pszArg(pszArg),m_llStart(SProfiler::s_bEnabled?SProfiler::Now():0)
+        {
+        }
+
+        ~SProfileScope()
+        {
+            if(m_llStart) SProfiler::Record(m_pszName,m_pszArg,m_llStart);
+        }
+
+    protected:
+        LPCSTR      m_pszName;
+        LPCWSTR     m_pszArg;
+        LONGLONG    m_llStart;
+    };
+}//end of namespace SOUI
+
+#define SPROFILE_CAT2(a,b)  a##b
+#define SPROFILE_CAT(a,b)   SPROFILE_CAT2(a,b)
+
+#ifdef SOUI_PROFILER
+#define SPROFILE_SCOPE(name)            SOUI::SProfileScope SPROFILE_CAT(_sprofileScope,__LINE__)(name)
+//没有开始记录时不计算arg
+#define SPROFILE_SCOPE_ARG(name,arg)    SOUI::SProfileScope SPROFILE_CAT(_sprofileScope,__LINE__)(name,SOUI::SProfiler::s_bEnabled?(LPCWSTR)(arg):NULL)
+#else
+#define SPROFILE_SCOPE(name)
+#define SPROFILE_SCOPE_ARG(name,arg)
+#endif
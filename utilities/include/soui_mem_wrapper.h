@@ -9,8 +9,25 @@
 #pragma once
 #include "utilities-def.h"
 
+//编译utilities时定义SOUI_MEM_POOL启用按大小分级的内存池，小内存块由线程缓存分配，大内存块仍然使用CRT
+#define SOUI_MEM_CLASS_COUNT    16
+
 namespace SOUI
 {
+    /**
+    * @struct     SouiMemStats
+    * @brief      内存池统计数据
+    */
+    struct SouiMemStats
+    {
+        size_t  szLiveBytes;    /**<当前已分配的字节数*/
+        size_t  szPeakBytes;    /**<已分配字节数的峰值*/
+        size_t  szPoolBytes;    /**<内存池从CRT申请的字节数，和已分配字节数比较可以得到碎片率*/
+        LONG    nLargeAllocs;   /**<直接使用CRT分配的次数*/
+        UINT    uClassSize[SOUI_MEM_CLASS_COUNT];   /**<各级内存块的大小*/
+        LONG    nClassAllocs[SOUI_MEM_CLASS_COUNT]; /**<各级内存块的累计分配次数，两次采样的差值即为分配速率*/
+    };
+
     class UTILITIES_API soui_mem_wrapper
     {
     public:
@@ -18,5 +35,8 @@ namespace SOUI
         static void * SouiRealloc(void *p,size_t szMem);
         static void * SouiCalloc(size_t count, size_t szEle);
         static void   SouiFree(void *p);
+
+        //获取内存池统计数据，没有启用内存池时返回FALSE
+        static BOOL   SouiGetMemStats(SouiMemStats *pStats);
     };
 }
@@ -21,6 +21,39 @@ namespace SOUI
 
         static SStringW CvtW2W(const SStringW &str,unsigned int cp=CP_ACP);
 
+        /**
+        * Utf8ToUtf16
+        * @brief    UTF8转换为UTF16，转换结果写入调用者提供的缓冲区
+        * @param    const char * pszSrc --  UTF8字符串
+        * @param    int nSrcLen --  字节数，-1表示以0结尾，结果包含结尾的0
+        * @param    wchar_t * pszDst --  输出缓冲区
+        * @param    int nDstLen --  输出缓冲区的字符数，0表示只计算需要的长度
+        * @return   int -- 输出的字符数，缓冲区不足时返回0并设置ERROR_INSUFFICIENT_BUFFER
+        * Describe  与MultiByteToWideChar的参数及返回值相同。非法序列按最大子序列替换为U+FFFD，
+        *           结果UTF16的字符数不会超过UTF8的字节数
+        */
+        static int Utf8ToUtf16(const char *pszSrc,int nSrcLen,wchar_t *pszDst,int nDstLen);
+
+        /**
+        * Utf16ToUtf8
+        * @brief    UTF16转换为UTF8，转换结果写入调用者提供的缓冲区
+        * @param    const wchar_t * pszSrc --  UTF16字符串
+        * @param    int nSrcLen --  字符数，-1表示以0结尾，结果包含结尾的0
+        * @param    char * pszDst --  输出缓冲区
+        * @param    int nDstLen --  输出缓冲区的字节数，0表示只计算需要的长度
+        * @return   int -- 输出的字节数，缓冲区不足时返回0并设置ERROR_INSUFFICIENT_BUFFER
+        * Describe  不成对的代理项替换为U+FFFD
+        */
+        static int Utf16ToUtf8(const wchar_t *pszSrc,int nSrcLen,char *pszDst,int nDstLen);
+
+        //检查是否为合法的UTF8字符串，nLen为-1表示以0结尾
+        static bool IsValidUtf8(const char *pszSrc,int nLen=-1);
+
+        //转换到调用者提供的缓冲区，参数与MultiByteToWideChar相同，CP_UTF8使用内置的转换
+        static int ConvertA2W(const char *pszSrc,int nSrcLen,wchar_t *pszDst,int nDstLen,unsigned int cp=CP_ACP);
+
+        //转换到调用者提供的缓冲区，参数与WideCharToMultiByte相同，CP_UTF8使用内置的转换
+        static int ConvertW2A(const wchar_t *pszSrc,int nSrcLen,char *pszDst,int nDstLen,unsigned int cp=CP_ACP);
     };
 
 
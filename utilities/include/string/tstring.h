@@ -16,12 +16,42 @@
 #define TSTRING_PADDING 0
 #endif
 
+// size in characters of the stack buffer tried first by Format/AppendFormat
+#ifndef TSTRING_FORMAT_STACKBUF
+#define TSTRING_FORMAT_STACKBUF 256
+#endif
+
+// move constructor and move assignment need rvalue references (vs2010 and later)
+#if defined(_MSC_VER) && _MSC_VER >= 1600
+#define TSTRING_MOVE_SEMANTICS
+#endif
+
 #include "utilities-def.h"
 #include <soui_mem_wrapper.h>
 
 namespace SOUI
 {
 
+    // allocation counters, updated only when TSTRING_ALLOC_STATS is defined
+    struct TStringAllocStats
+    {
+        LONG nAlloc;        // new string buffers
+        LONG nRealloc;      // buffers grown in place
+        LONG nFree;         // buffers released
+        LONG nFormatFast;   // Format/AppendFormat calls that fit the stack buffer
+        LONG nFormatSlow;   // Format/AppendFormat calls that needed a heap buffer
+    };
+
+    extern UTILITIES_API TStringAllocStats _tstr_allocStats;
+
+#ifdef TSTRING_ALLOC_STATS
+#define TSTRING_STAT_INC(x) InterlockedIncrement(&_tstr_allocStats.x)
+#else
+#define TSTRING_STAT_INC(x)
+#endif
+
+    // define TSTRING_NO_ATOMIC_REFCOUNT when strings are never shared between threads
+    // to replace the interlocked reference counting with plain increments
     struct TStringData
     {
         long nRefs;            // Reference count: negative == locked
@@ -36,13 +66,24 @@ namespace SOUI
         inline void AddRef()
         {
             SASSERT(nRefs > 0);
+#ifdef TSTRING_NO_ATOMIC_REFCOUNT
+            ++nRefs;
+#else
             InterlockedIncrement(&nRefs);
+#endif
         }
         inline void Release()
         {
             SASSERT(nRefs != 0);
+#ifdef TSTRING_NO_ATOMIC_REFCOUNT
+            if (--nRefs <= 0)
+#else
             if (InterlockedDecrement(&nRefs) <= 0)
+#endif
+            {
+                TSTRING_STAT_INC(nFree);
                 soui_mem_wrapper::SouiFree(this);
+            }
         }
         inline bool IsShared() const
         {
@@ -176,6 +217,11 @@ namespace SOUI
             vsprintf_s(*ppszDst, len + 1, pszFormat, args);
             return len;
         }
+        // format into a caller supplied buffer, returns -1 if the buffer is too small
+        static int FormatBuf(char* pszDst, int nDstLen, const char* pszFormat, va_list args)
+        {
+            return _vsnprintf_s(pszDst, nDstLen, _TRUNCATE, pszFormat, args);
+        }
 
         static int LoadString(HINSTANCE hInst,
             UINT uID,
@@ -248,6 +294,11 @@ namespace SOUI
             vswprintf_s(*ppszDst, len + 1, pszFormat, args);
             return len;
         }
+        // format into a caller supplied buffer, returns -1 if the buffer is too small
+        static int FormatBuf(wchar_t* pszDst, int nDstLen, const wchar_t* pszFormat, va_list args)
+        {
+            return _vsnwprintf_s(pszDst, nDstLen, _TRUNCATE, pszFormat, args);
+        }
         static int LoadString(HINSTANCE hInst,
             UINT uID,
             wchar_t* lpBuffer,
@@ -285,6 +336,23 @@ namespace SOUI
                 *this = stringSrc.m_pszData;
             }
         }
+#ifdef TSTRING_MOVE_SEMANTICS
+        TStringT(TStringT&& stringSrc)
+        {
+            SASSERT(stringSrc.GetData()->nRefs != 0);
+            if (stringSrc.GetData()->nRefs >= 0)
+            {
+                // take over the buffer, the source becomes empty
+                m_pszData = stringSrc.m_pszData;
+                stringSrc.Init();
+            }
+            else
+            {
+                Init();
+                *this = stringSrc.m_pszData;
+            }
+        }
+#endif
         TStringT(tchar ch, int nLength = 1)
         {
             Init();
@@ -402,6 +470,28 @@ namespace SOUI
             }
             return *this;
         }
+#ifdef TSTRING_MOVE_SEMANTICS
+        TStringT& operator=(TStringT&& stringSrc)
+        {
+            if (this != &stringSrc)
+            {
+                TStringData* pData = GetData();
+                if ((pData->IsLocked() && pData != _tstr_initDataNil) || stringSrc.GetData()->IsLocked())
+                {
+                    // actual copy necessary since one of the strings is locked
+                    AssignCopy(stringSrc.GetData()->nDataLength, stringSrc.m_pszData);
+                }
+                else
+                {
+                    // take over the buffer, the source becomes empty
+                    Release();
+                    m_pszData = stringSrc.m_pszData;
+                    stringSrc.Init();
+                }
+            }
+            return *this;
+        }
+#endif
         TStringT& operator=(const tchar* psz)
         {
             TStringT strCopy(psz);
@@ -1128,8 +1218,24 @@ namespace SOUI
                 return FALSE;
             }
 
+            // try a stack buffer first, most formatted strings are short
+            tchar szBuf[TSTRING_FORMAT_STACKBUF];
+            int nLength = tchar_traits::FormatBuf(szBuf, TSTRING_FORMAT_STACKBUF, pszFormat, args);
+            if (nLength >= 0)
+            {
+                TSTRING_STAT_INC(nFormatFast);
+                if (nLength == 0)
+                {
+                    Empty();
+                    return FALSE;
+                }
+                AssignCopy(nLength, szBuf);
+                return TRUE;
+            }
+
+            TSTRING_STAT_INC(nFormatSlow);
             tchar* pszBuffer = NULL;
-            int nLength = tchar_traits::Format(&pszBuffer, pszFormat, args);
+            nLength = tchar_traits::Format(&pszBuffer, pszFormat, args);
             if (nLength > 0 && pszBuffer != NULL)
             {
                 *this = TStringT(pszBuffer, nLength);
@@ -1148,8 +1254,18 @@ namespace SOUI
             if (pszFormat == NULL || *pszFormat == '\0')
                 return;
 
+            tchar szBuf[TSTRING_FORMAT_STACKBUF];
+            int nLength = tchar_traits::FormatBuf(szBuf, TSTRING_FORMAT_STACKBUF, pszFormat, args);
+            if (nLength >= 0)
+            {
+                TSTRING_STAT_INC(nFormatFast);
+                ConcatInPlace(nLength, szBuf);
+                return;
+            }
+
+            TSTRING_STAT_INC(nFormatSlow);
             tchar* pszBuffer = NULL;
-            int nLength = tchar_traits::Format(&pszBuffer, pszFormat, args);
+            nLength = tchar_traits::Format(&pszBuffer, pszFormat, args);
             if (nLength > 0 && pszBuffer != NULL)
             {
                 *this += TStringT(pszBuffer, nLength);
@@ -1338,9 +1454,15 @@ namespace SOUI
             int nSize = sizeof(TStringData) + (nLength + 1 + TSTRING_PADDING) * sizeof(tchar);
             TStringData* pData;
             if (pOldData == NULL)
+            {
+                TSTRING_STAT_INC(nAlloc);
                 pData = (TStringData*)soui_mem_wrapper::SouiMalloc(nSize);
+            }
             else
+            {
+                TSTRING_STAT_INC(nRealloc);
                 pData = (TStringData*)soui_mem_wrapper::SouiRealloc(pOldData, nSize);
+            }
             if (pData == NULL)
                 return NULL;
 
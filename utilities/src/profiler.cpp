@@ -0,0 +1,217 @@
+﻿#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace SOUI
+{
+    namespace profiler
+    {
+        const UINT KDefBufferSize = 16384;
+        const int  KMaxArgLen = 23;
+
+        struct PROFILEEVENT
+        {
+            LPCSTR      pszName;
+            LONGLONG    llStart;
+            LONGLONG    llDur;
+            WCHAR       szArg[KMaxArgLen+1];
+        };
+
+        //每个线程一个环形缓冲区，只有所属线程写入，线程退出后保留到Reset以便导出
+        struct THREADBUFFER
+        {
+            DWORD           dwThreadId;
+            UINT            nSize;
+            volatile LONG   nWrite;     //累计写入数，nWrite%nSize为下一个写入位置
+            PROFILEEVENT *  pEvents;
+            THREADBUFFER *  pNext;
+        };
+
+        //全部使用零初始化的全局变量，静态对象构造前后都可以安全调用
+        static volatile LONG    s_nInitState = 0;   //0:未初始化 1:正在初始化 2:初始化完成
+        static CRITICAL_SECTION s_csBuffers;
+        static THREADBUFFER *   s_pBuffers = NULL;
+        static DWORD            s_dwTls = TLS_OUT_OF_INDEXES;
+        static UINT             s_nBufferSize = KDefBufferSize;
+        static LARGE_INTEGER    s_freq;
+
+        static void Init()
+        {
+            if(s_nInitState == 2) return;
+            if(InterlockedCompareExchange(&s_nInitState,1,0) != 0)
+            {//其它线程正在初始化
+                while(s_nInitState != 2) Sleep(0);
+                return;
+            }
+            InitializeCriticalSection(&s_csBuffers);
+            QueryPerformanceFrequency(&s_freq);
+            s_dwTls = TlsAlloc();
+            InterlockedExchange(&s_nInitState,2);
+        }
+
+        static THREADBUFFER * GetBuffer()
+        {
+            //TlsGetValue会修改LastError，不能影响调用者
+            DWORD dwErr = GetLastError();
+            THREADBUFFER *pBuf = (THREADBUFFER*)TlsGetValue(s_dwTls);
+            if(!pBuf)
+            {
+                pBuf = (THREADBUFFER*)calloc(1,sizeof(THREADBUFFER));
+                if(pBuf)
+                {
+                    pBuf->dwThreadId = GetCurrentThreadId();
+                    pBuf->nSize = s_nBufferSize;
+                    pBuf->pEvents = (PROFILEEVENT*)malloc(sizeof(PROFILEEVENT)*pBuf->nSize);
+                    if(!pBuf->pEvents)
+                    {
+                        free(pBuf);
+                        pBuf = NULL;
+                    }
+                }
+                if(pBuf)
+                {
+                    TlsSetValue(s_dwTls,pBuf);
+                    EnterCriticalSection(&s_csBuffers);
+                    pBuf->pNext = s_pBuffers;
+                    s_pBuffers = pBuf;
+                    LeaveCriticalSection(&s_csBuffers);
+                }
+            }
+            SetLastError(dwErr);
+            return pBuf;
+        }
+
+        //输出JSON字符串，转换为UTF8并转义
+        static void WriteJsonString(FILE *f,LPCWSTR psz)
+        {
+            fputc('"',f);
+            for(;*psz;psz++)
+            {
+                WCHAR c = *psz;
+                if(c == '"' || c == '\\')
+                {
+                    fputc('\\',f);
+                    fputc(c,f);
+                }else if(c < 0x20)
+                {
+                    fprintf(f,"\\u%04x",c);
+                }else if(c < 0x80)
+                {
+                    fputc(c,f);
+                }else
+                {
+                    char szUtf8[8];
+                    int nLen = WideCharToMultiByte(CP_UTF8,0,&c,1,szUtf8,8,NULL,NULL);
+                    if(nLen > 0) fwrite(szUtf8,1,nLen,f);
+                }
+            }
+            fputc('"',f);
+        }
+    }
+
+    using namespace profiler;
+
+    volatile LONG SProfiler::s_bEnabled = 0;
+
+    void SProfiler::Enable(BOOL bEnable)
+    {
+        Init();
+        InterlockedExchange(&s_bEnabled,bEnable?1:0);
+    }
+
+    void SProfiler::SetBufferSize(UINT nEvents)
+    {
+        if(nEvents > 0) s_nBufferSize = nEvents;
+    }
+
+    LONGLONG SProfiler::Now()
+    {
+        LARGE_INTEGER li;
+        QueryPerformanceCounter(&li);
+        return li.QuadPart;
+    }
+
+    void SProfiler::Record(LPCSTR pszName,LPCWSTR pszArg,LONGLONG llStart)
+    {
+        LONGLONG llEnd = Now();
+        Init();
+        THREADBUFFER *pBuf = GetBuffer();
+        if(!pBuf) return;
+
+        PROFILEEVENT &evt = pBuf->pEvents[(UINT)pBuf->nWrite % pBuf->nSize];
+        evt.pszName = pszName;
+        evt.llStart = llStart;
+        evt.llDur = llEnd - llStart;
+        int i = 0;
+        if(pszArg)
+        {
+            for(;i<KMaxArgLen && pszArg[i];i++) evt.szArg[i] = pszArg[i];
+        }
+        evt.szArg[i] = 0;
+        //先写记录再更新计数，导出线程只读取已经完成的记录；只有所属线程写入，不需要原子操作
+        pBuf->nWrite = pBuf->nWrite + 1;
+    }
+
+    UINT SProfiler::GetEventCount()
+    {
+        Init();
+        UINT nCount = 0;
+        EnterCriticalSection(&s_csBuffers);
+        for(THREADBUFFER *pBuf = s_pBuffers;pBuf;pBuf=pBuf->pNext)
+        {
+            UINT nWrite = (UINT)pBuf->nWrite;
+            nCount += nWrite < pBuf->nSize ? nWrite : pBuf->nSize;
+        }
+        LeaveCriticalSection(&s_csBuffers);
+        return nCount;
+    }
+
+    void SProfiler::Reset()
+    {
+        Init();
+        EnterCriticalSection(&s_csBuffers);
+        for(THREADBUFFER *pBuf = s_pBuffers;pBuf;pBuf=pBuf->pNext)
+        {
+            InterlockedExchange(&pBuf->nWrite,0);
+        }
+        LeaveCriticalSection(&s_csBuffers);
+    }
+
+    BOOL SProfiler::ExportChromeTrace(LPCWSTR pszFileName)
+    {
+        Init();
+        FILE *f = _wfopen(pszFileName,L"wb");
+        if(!f) return FALSE;
+
+        DWORD dwPid = GetCurrentProcessId();
+        double dScale = 1000000.0/s_freq.QuadPart; //QPC计数转换为us
+        BOOL bFirst = TRUE;
+        fputs("{\"traceEvents\":[\n",f);
+        EnterCriticalSection(&s_csBuffers);
+        for(THREADBUFFER *pBuf = s_pBuffers;pBuf;pBuf=pBuf->pNext)
+        {
+            UINT nWrite = (UINT)pBuf->nWrite;
+            UINT nCount = nWrite < pBuf->nSize ? nWrite : pBuf->nSize;
+            for(UINT i=nWrite-nCount;i!=nWrite;i++)
+            {
+                const PROFILEEVENT &evt = pBuf->pEvents[i%pBuf->nSize];
+                if(!bFirst) fputs(",\n",f);
+                bFirst = FALSE;
+                fprintf(f,"{\"name\":\"%s\",\"cat\":\"soui\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u",
+                    evt.pszName,evt.llStart*dScale,evt.llDur*dScale,dwPid,pBuf->dwThreadId);
+                if(evt.szArg[0])
+                {
+                    fputs(",\"args\":{\"arg\":",f);
+                    WriteJsonString(f,evt.szArg);
+                    fputc('}',f);
+                }
+                fputc('}',f);
+            }
+        }
+        LeaveCriticalSection(&s_csBuffers);
+        fputs("\n],\"displayTimeUnit\":\"ms\"}\n",f);
+        fclose(f);
+        return TRUE;
+    }
+
+}//end of namespace SOUI
@@ -83,6 +83,12 @@
 #	define PUGI__NO_INLINE
 #endif
 
+// SSE2 is always available on x64; on x86 it depends on /arch
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#	define PUGI__SSE2
+#	include <emmintrin.h>
+#endif
+
 // Simple static assertion
 #define PUGI__STATIC_ASSERT(cond) { static const char condition_failed[(cond) ? 1 : -1] = {0}; (void)condition_failed[0]; }
 
@@ -849,6 +855,40 @@ PUGI__NS_BEGIN
 	typedef wchar_selector<sizeof(wchar_t)>::counter wchar_counter;
 	typedef wchar_selector<sizeof(wchar_t)>::writer wchar_writer;
 
+#ifdef PUGI__SSE2
+	// output for a block of 16 ascii bytes; writers without a specialization use Traits::low
+	template <typename Traits> struct ascii_block
+	{
+		static typename Traits::value_type process(typename Traits::value_type result, const uint8_t* data, __m128i)
+		{
+			for (size_t i = 0; i < 16; ++i) result = Traits::low(result, data[i]);
+
+			return result;
+		}
+	};
+
+	template <> struct ascii_block<utf16_counter>
+	{
+		static utf16_counter::value_type process(utf16_counter::value_type result, const uint8_t*, __m128i)
+		{
+			return result + 16;
+		}
+	};
+
+	template <> struct ascii_block<utf16_writer>
+	{
+		static utf16_writer::value_type process(utf16_writer::value_type result, const uint8_t*, __m128i block)
+		{
+			__m128i zero = _mm_setzero_si128();
+
+			_mm_storeu_si128(static_cast<__m128i*>(static_cast<void*>(result)), _mm_unpacklo_epi8(block, zero));
+			_mm_storeu_si128(static_cast<__m128i*>(static_cast<void*>(result + 8)), _mm_unpackhi_epi8(block, zero));
+
+			return result + 16;
+		}
+	};
+#endif
+
 	template <typename Traits, typename opt_swap = opt_false> struct utf_decoder
 	{
 		static inline typename Traits::value_type decode_utf8_block(const uint8_t* data, size_t size, typename Traits::value_type result)
@@ -866,6 +906,19 @@ PUGI__NS_BEGIN
 					data += 1;
 					size -= 1;
 
+				#ifdef PUGI__SSE2
+					// process 16-byte ascii blocks
+					while (size >= 16)
+					{
+						__m128i block = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(data)));
+						if (_mm_movemask_epi8(block)) break;
+
+						result = ascii_block<Traits>::process(result, data, block);
+						data += 16;
+						size -= 16;
+					}
+				#endif
+
 					// process aligned single-byte (ascii) blocks
 					if ((reinterpret_cast<uintptr_t>(data) & 3) == 0)
 					{
@@ -1,10 +1,400 @@
-﻿#include "soui_mem_wrapper.h"
+﻿#include <windows.h>
+#include "soui_mem_wrapper.h"
 #include <malloc.h>
+#include <string.h>
 #include "utilities-def.h"
 
 namespace SOUI
 {
-    
+#ifdef SOUI_MEM_POOL
+
+    /*
+    * 内存池说明：
+    * 1. 不超过KMaxPoolSize的内存按大小分为SOUI_MEM_CLASS_COUNT级，每级有一个中心空闲链表，
+    *    中心空闲链表为空时从CRT申请KChunkSize大小的内存切分成内存块。
+    * 2. 每个线程为每一级保存一个空闲链表，分配和释放只访问本线程的链表，不需要加锁。
+    *    线程链表为空时从中心链表批量取回，超过KMaxCacheCount时批量归还中心链表。
+    * 3. 每个内存块前有一个BLOCKHEADER，释放时据此判断内存块的级别或者是否由CRT分配。
+    * 4. 从CRT申请的内存块在进程退出前不会释放。
+    */
+    namespace mempool
+    {
+        enum{
+            KMaxPoolSize = 512,                 //超过该大小直接使用CRT分配
+            KChunkSize = 64*1024,               //每次从CRT申请的内存大小
+            KBatchCount = 32,                   //线程链表和中心链表之间每次转移的内存块数
+            KMaxCacheCount = KBatchCount*2,     //每级线程链表最多保存的内存块数
+            KMagicPool = 0x5350,
+            KMagicLarge = 0x534C,
+        };
+
+        //分级主要覆盖16-256字节，和字符串、数组及链表节点的实际分布一致
+        static const UINT s_classSize[SOUI_MEM_CLASS_COUNT] =
+        {
+            16,32,48,64,80,96,112,128,
+            160,192,224,256,320,384,448,512
+        };
+
+        struct BLOCKHEADER
+        {
+            size_t  szMem;      //调用者申请的大小
+            USHORT  iClass;
+            USHORT  wMagic;
+        };
+        C_ASSERT(sizeof(BLOCKHEADER) % MEMORY_ALLOCATION_ALIGNMENT == 0);
+
+        struct FREEBLOCK
+        {
+            FREEBLOCK * pNext;
+        };
+
+        struct CENTRALLIST
+        {
+            CRITICAL_SECTION    cs;
+            FREEBLOCK *         pFree;
+        };
+
+        struct THREADCACHE
+        {
+            FREEBLOCK *     pFree[SOUI_MEM_CLASS_COUNT];
+            UINT            nFree[SOUI_MEM_CLASS_COUNT];
+            LONG            nAllocs[SOUI_MEM_CLASS_COUNT];
+            THREADCACHE *   pPrev;
+            THREADCACHE *   pNext;
+        };
+
+        typedef VOID (WINAPI *FunFlsCallback)(PVOID);
+        typedef DWORD (WINAPI *FunFlsAlloc)(FunFlsCallback);
+        typedef PVOID (WINAPI *FunFlsGetValue)(DWORD);
+        typedef BOOL (WINAPI *FunFlsSetValue)(DWORD,PVOID);
+
+        //全部使用零初始化的全局变量，静态对象构造前后都可以安全调用
+        static volatile LONG    s_nInitState = 0;   //0:未初始化 1:正在初始化 2:初始化完成
+        static BYTE             s_classOfSize[KMaxPoolSize/16+1];
+        static CENTRALLIST      s_central[SOUI_MEM_CLASS_COUNT];
+        static CRITICAL_SECTION s_csCaches;         //保护线程缓存列表及已退出线程的统计
+        static THREADCACHE *    s_pCaches = NULL;
+        static LONG             s_nRetiredAllocs[SOUI_MEM_CLASS_COUNT];
+        static volatile LONG_PTR s_szLive = 0;
+        static volatile LONG_PTR s_szPeak = 0;
+        static volatile LONG_PTR s_szPool = 0;
+        static volatile LONG    s_nLargeAllocs = 0;
+
+        static DWORD            s_dwTls = TLS_OUT_OF_INDEXES;
+        static FunFlsGetValue   s_funFlsGetValue = NULL;
+        static FunFlsSetValue   s_funFlsSetValue = NULL;
+
+#ifdef _WIN64
+#define InterlockedAddSize(p,v)         InterlockedExchangeAdd64((volatile LONGLONG*)(p),(LONGLONG)(v))
+#define InterlockedCasSize(p,v,c)       InterlockedCompareExchange64((volatile LONGLONG*)(p),(LONGLONG)(v),(LONGLONG)(c))
+#else
+#define InterlockedAddSize(p,v)         InterlockedExchangeAdd((volatile LONG*)(p),(LONG)(v))
+#define InterlockedCasSize(p,v,c)       InterlockedCompareExchange((volatile LONG*)(p),(LONG)(v),(LONG)(c))
+#endif
+
+        static void AddLiveBytes(LONG_PTR szDelta)
+        {
+            LONG_PTR szLive = (LONG_PTR)InterlockedAddSize(&s_szLive,szDelta) + szDelta;
+            if(szDelta <= 0) return;
+            LONG_PTR szPeak = s_szPeak;
+            while(szLive > szPeak)
+            {
+                LONG_PTR szPrev = (LONG_PTR)InterlockedCasSize(&s_szPeak,szLive,szPeak);
+                if(szPrev == szPeak) break;
+                szPeak = szPrev;
+            }
+        }
+
+        static void ReleaseCache(THREADCACHE *pCache,int iClass,UINT nCount);
+
+        //线程退出时将空闲内存块归还中心链表
+        static VOID WINAPI OnThreadExit(PVOID pData)
+        {
+            THREADCACHE *pCache = (THREADCACHE*)pData;
+            if(!pCache) return;
+            for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+            {
+                ReleaseCache(pCache,i,pCache->nFree[i]);
+            }
+            EnterCriticalSection(&s_csCaches);
+            for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+            {
+                s_nRetiredAllocs[i] += pCache->nAllocs[i];
+            }
+            if(pCache->pPrev) pCache->pPrev->pNext = pCache->pNext;
+            else s_pCaches = pCache->pNext;
+            if(pCache->pNext) pCache->pNext->pPrev = pCache->pPrev;
+            LeaveCriticalSection(&s_csCaches);
+            free(pCache);
+        }
+
+        static void Init()
+        {
+            if(s_nInitState == 2) return;
+            if(InterlockedCompareExchange(&s_nInitState,1,0) != 0)
+            {//其它线程正在初始化
+                while(s_nInitState != 2) Sleep(0);
+                return;
+            }
+
+            int iClass = 0;
+            for(int i=0;i<=KMaxPoolSize/16;i++)
+            {
+                while(s_classSize[iClass] < (UINT)i*16) iClass++;
+                s_classOfSize[i] = (BYTE)iClass;
+            }
+            for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+            {
+                InitializeCriticalSection(&s_central[i].cs);
+            }
+            InitializeCriticalSection(&s_csCaches);
+
+            //优先使用FLS，线程退出时可以回收线程缓存；XP不支持FLS，线程退出时缓存的内存块不再回收
+            HMODULE hKernel = GetModuleHandle(TEXT("kernel32.dll"));
+            FunFlsAlloc funFlsAlloc = (FunFlsAlloc)GetProcAddress(hKernel,"FlsAlloc");
+            if(funFlsAlloc)
+            {
+                s_dwTls = funFlsAlloc(OnThreadExit);
+                if(s_dwTls != TLS_OUT_OF_INDEXES)
+                {
+                    s_funFlsGetValue = (FunFlsGetValue)GetProcAddress(hKernel,"FlsGetValue");
+                    s_funFlsSetValue = (FunFlsSetValue)GetProcAddress(hKernel,"FlsSetValue");
+                }
+            }
+            if(!s_funFlsGetValue)
+            {
+                s_dwTls = TlsAlloc();
+            }
+            InterlockedExchange(&s_nInitState,2);
+        }
+
+        static THREADCACHE * GetCache()
+        {
+            //TlsGetValue会修改LastError，不能影响调用者
+            DWORD dwErr = GetLastError();
+            THREADCACHE *pCache = (THREADCACHE*)(s_funFlsGetValue?s_funFlsGetValue(s_dwTls):TlsGetValue(s_dwTls));
+            if(!pCache)
+            {
+                pCache = (THREADCACHE*)calloc(1,sizeof(THREADCACHE));
+                if(pCache)
+                {
+                    if(s_funFlsSetValue) s_funFlsSetValue(s_dwTls,pCache);
+                    else TlsSetValue(s_dwTls,pCache);
+
+                    EnterCriticalSection(&s_csCaches);
+                    pCache->pNext = s_pCaches;
+                    if(s_pCaches) s_pCaches->pPrev = pCache;
+                    s_pCaches = pCache;
+                    LeaveCriticalSection(&s_csCaches);
+                }
+            }
+            SetLastError(dwErr);
+            return pCache;
+        }
+
+        //从CRT申请一块内存切分成iClass级的内存块，调用前需要锁定中心链表
+        static void AllocChunk(int iClass)
+        {
+            size_t szBlock = sizeof(BLOCKHEADER) + s_classSize[iClass];
+            BYTE *pChunk = (BYTE*)malloc(KChunkSize);
+            if(!pChunk) return;
+            InterlockedAddSize(&s_szPool,KChunkSize);
+
+            CENTRALLIST & central = s_central[iClass];
+            for(size_t i=KChunkSize/szBlock;i>0;i--)
+            {//逆序插入，分配时按地址顺序取出
+                FREEBLOCK *pBlock = (FREEBLOCK*)(pChunk + (i-1)*szBlock);
+                pBlock->pNext = central.pFree;
+                central.pFree = pBlock;
+            }
+        }
+
+        static BOOL FillCache(THREADCACHE *pCache,int iClass)
+        {
+            CENTRALLIST & central = s_central[iClass];
+            EnterCriticalSection(&central.cs);
+            if(!central.pFree) AllocChunk(iClass);
+            for(int i=0;i<KBatchCount && central.pFree;i++)
+            {
+                FREEBLOCK *pBlock = central.pFree;
+                central.pFree = pBlock->pNext;
+                pBlock->pNext = pCache->pFree[iClass];
+                pCache->pFree[iClass] = pBlock;
+                pCache->nFree[iClass]++;
+            }
+            LeaveCriticalSection(&central.cs);
+            return pCache->pFree[iClass] != NULL;
+        }
+
+        static void ReleaseCache(THREADCACHE *pCache,int iClass,UINT nCount)
+        {
+            if(nCount == 0) return;
+            CENTRALLIST & central = s_central[iClass];
+            EnterCriticalSection(&central.cs);
+            for(UINT i=0;i<nCount && pCache->pFree[iClass];i++)
+            {
+                FREEBLOCK *pBlock = pCache->pFree[iClass];
+                pCache->pFree[iClass] = pBlock->pNext;
+                pCache->nFree[iClass]--;
+                pBlock->pNext = central.pFree;
+                central.pFree = pBlock;
+            }
+            LeaveCriticalSection(&central.cs);
+        }
+
+        static void * LargeAlloc(size_t szMem)
+        {
+            if(szMem > (size_t)-1 - sizeof(BLOCKHEADER)) return NULL;
+            BLOCKHEADER *pHeader = (BLOCKHEADER*)malloc(sizeof(BLOCKHEADER) + szMem);
+            if(!pHeader) return NULL;
+            pHeader->szMem = szMem;
+            pHeader->iClass = SOUI_MEM_CLASS_COUNT;
+            pHeader->wMagic = KMagicLarge;
+            InterlockedIncrement(&s_nLargeAllocs);
+            AddLiveBytes((LONG_PTR)szMem);
+            return pHeader + 1;
+        }
+
+        static void * PoolAlloc(size_t szMem)
+        {
+            int iClass = s_classOfSize[(szMem+15)>>4];
+            THREADCACHE *pCache = GetCache();
+            if(!pCache) return NULL;
+            if(!pCache->pFree[iClass] && !FillCache(pCache,iClass)) return NULL;
+
+            FREEBLOCK *pBlock = pCache->pFree[iClass];
+            pCache->pFree[iClass] = pBlock->pNext;
+            pCache->nFree[iClass]--;
+            pCache->nAllocs[iClass]++;
+
+            BLOCKHEADER *pHeader = (BLOCKHEADER*)pBlock;
+            pHeader->szMem = szMem;
+            pHeader->iClass = (USHORT)iClass;
+            pHeader->wMagic = KMagicPool;
+            AddLiveBytes((LONG_PTR)szMem);
+            return pHeader + 1;
+        }
+
+        static void PoolFree(BLOCKHEADER *pHeader)
+        {
+            int iClass = pHeader->iClass;
+            pHeader->wMagic = 0;//重复释放时可以检测到
+            FREEBLOCK *pBlock = (FREEBLOCK*)pHeader;
+            THREADCACHE *pCache = GetCache();
+            if(!pCache)
+            {//无法分配线程缓存，直接归还中心链表
+                CENTRALLIST & central = s_central[iClass];
+                EnterCriticalSection(&central.cs);
+                pBlock->pNext = central.pFree;
+                central.pFree = pBlock;
+                LeaveCriticalSection(&central.cs);
+                return;
+            }
+            //其它线程分配的内存块也放入本线程的链表
+            pBlock->pNext = pCache->pFree[iClass];
+            pCache->pFree[iClass] = pBlock;
+            if(++pCache->nFree[iClass] > KMaxCacheCount)
+            {
+                ReleaseCache(pCache,iClass,KBatchCount);
+            }
+        }
+    }//namespace mempool
+
+    using namespace mempool;
+
+    void * soui_mem_wrapper::SouiMalloc( size_t szMem )
+    {
+        Init();
+        if(szMem > KMaxPoolSize) return LargeAlloc(szMem);
+        return PoolAlloc(szMem);
+    }
+
+    void * soui_mem_wrapper::SouiRealloc( void *p,size_t szMem )
+    {
+        if(!p) return SouiMalloc(szMem);
+        if(szMem == 0)
+        {
+            SouiFree(p);
+            return NULL;
+        }
+
+        BLOCKHEADER *pHeader = (BLOCKHEADER*)p - 1;
+        SASSERT(pHeader->wMagic == KMagicPool || pHeader->wMagic == KMagicLarge);
+        size_t szOld = pHeader->szMem;
+        if(pHeader->wMagic == KMagicPool && szMem <= s_classSize[pHeader->iClass])
+        {//当前内存块足够大
+            pHeader->szMem = szMem;
+            AddLiveBytes((LONG_PTR)szMem - (LONG_PTR)szOld);
+            return p;
+        }
+        if(pHeader->wMagic == KMagicLarge && szMem > KMaxPoolSize)
+        {
+            if(szMem > (size_t)-1 - sizeof(BLOCKHEADER)) return NULL;
+            BLOCKHEADER *pNewHeader = (BLOCKHEADER*)realloc(pHeader,sizeof(BLOCKHEADER) + szMem);
+            if(!pNewHeader) return NULL;
+            pNewHeader->szMem = szMem;
+            AddLiveBytes((LONG_PTR)szMem - (LONG_PTR)szOld);
+            return pNewHeader + 1;
+        }
+
+        void *pNew = SouiMalloc(szMem);
+        if(!pNew) return NULL;
+        memcpy(pNew,p,szOld<szMem?szOld:szMem);
+        SouiFree(p);
+        return pNew;
+    }
+
+    void * soui_mem_wrapper::SouiCalloc( size_t count, size_t szEle )
+    {
+        if(szEle && count > (size_t)-1/szEle) return NULL;
+        size_t szMem = count*szEle;
+        void *p = SouiMalloc(szMem);
+        if(p) memset(p,0,szMem);
+        return p;
+    }
+
+    void soui_mem_wrapper::SouiFree( void *p )
+    {
+        if(!p) return;
+        BLOCKHEADER *pHeader = (BLOCKHEADER*)p - 1;
+        SASSERT(pHeader->wMagic == KMagicPool || pHeader->wMagic == KMagicLarge);
+        AddLiveBytes(-(LONG_PTR)pHeader->szMem);
+        if(pHeader->wMagic == KMagicLarge)
+        {
+            pHeader->wMagic = 0;
+            free(pHeader);
+        }else
+        {
+            PoolFree(pHeader);
+        }
+    }
+
+    BOOL soui_mem_wrapper::SouiGetMemStats(SouiMemStats *pStats)
+    {
+        Init();
+        pStats->szLiveBytes = (size_t)s_szLive;
+        pStats->szPeakBytes = (size_t)s_szPeak;
+        pStats->szPoolBytes = (size_t)s_szPool;
+        pStats->nLargeAllocs = s_nLargeAllocs;
+        EnterCriticalSection(&s_csCaches);
+        for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+        {
+            pStats->uClassSize[i] = s_classSize[i];
+            pStats->nClassAllocs[i] = s_nRetiredAllocs[i];
+        }
+        for(THREADCACHE *pCache = s_pCaches;pCache;pCache = pCache->pNext)
+        {
+            for(int i=0;i<SOUI_MEM_CLASS_COUNT;i++)
+            {
+                pStats->nClassAllocs[i] += pCache->nAllocs[i];
+            }
+        }
+        LeaveCriticalSection(&s_csCaches);
+        return TRUE;
+    }
+
+#else//SOUI_MEM_POOL
+
     void * soui_mem_wrapper::SouiMalloc( size_t szMem )
     {
         return malloc(szMem);
@@ -25,5 +415,12 @@ namespace SOUI
         free(p);
     }
 
+    BOOL soui_mem_wrapper::SouiGetMemStats(SouiMemStats *pStats)
+    {
+        memset(pStats,0,sizeof(SouiMemStats));
+        return FALSE;
+    }
+
+#endif//SOUI_MEM_POOL
 
 }
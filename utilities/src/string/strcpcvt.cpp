@@ -1,8 +1,283 @@
 ﻿#include "string/strcpcvt.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define STRCPCVT_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace SOUI
 {
 
+//////////////////////////////////////////////////////////////////////////
+// UTF8 <-> UTF16
+// ASCII字符用SSE2每次处理16个，其它字符逐个转换
+
+static const unsigned int KInvalidChar = 0xFFFFFFFF;
+static const unsigned int KReplacementChar = 0xFFFD;
+
+//计算从pSrc开始的ASCII字符数
+static int CountAscii(const char *pSrc,int nLen)
+{
+    int i=0;
+#ifdef STRCPCVT_SSE2
+    for(;i+16<=nLen;i+=16)
+    {
+        if(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(pSrc+i)))) break;
+    }
+#endif
+    while(i<nLen && (unsigned char)pSrc[i]<0x80) i++;
+    return i;
+}
+
+//从pSrc开始的ASCII字符直接扩展为wchar_t，返回处理的字符数
+static int WidenAscii(const char *pSrc,int nLen,wchar_t *pDst)
+{
+    int i=0;
+#ifdef STRCPCVT_SSE2
+    __m128i zero = _mm_setzero_si128();
+    for(;i+16<=nLen;i+=16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        if(_mm_movemask_epi8(v)) break;
+        _mm_storeu_si128((__m128i*)(pDst+i),_mm_unpacklo_epi8(v,zero));
+        _mm_storeu_si128((__m128i*)(pDst+i+8),_mm_unpackhi_epi8(v,zero));
+    }
+#endif
+    for(;i<nLen && (unsigned char)pSrc[i]<0x80;i++) pDst[i]=pSrc[i];
+    return i;
+}
+
+//计算从pSrc开始的小于0x80的字符数
+static int CountAscii16(const wchar_t *pSrc,int nLen)
+{
+    int i=0;
+#ifdef STRCPCVT_SSE2
+    __m128i mask = _mm_set1_epi16((short)0xFF80);
+    __m128i zero = _mm_setzero_si128();
+    for(;i+8<=nLen;i+=8)
+    {
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pSrc+i)),mask);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi16(v,zero)) != 0xFFFF) break;
+    }
+#endif
+    while(i<nLen && pSrc[i]<0x80) i++;
+    return i;
+}
+
+//从pSrc开始的小于0x80的字符直接压缩为char，返回处理的字符数
+static int NarrowAscii(const wchar_t *pSrc,int nLen,char *pDst)
+{
+    int i=0;
+#ifdef STRCPCVT_SSE2
+    __m128i mask = _mm_set1_epi16((short)0xFF80);
+    __m128i zero = _mm_setzero_si128();
+    for(;i+16<=nLen;i+=16)
+    {
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        __m128i v2 = _mm_loadu_si128((const __m128i*)(pSrc+i+8));
+        __m128i v = _mm_and_si128(_mm_or_si128(v1,v2),mask);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi16(v,zero)) != 0xFFFF) break;
+        _mm_storeu_si128((__m128i*)(pDst+i),_mm_packus_epi16(v1,v2));
+    }
+#endif
+    for(;i<nLen && pSrc[i]<0x80;i++) pDst[i]=(char)pSrc[i];
+    return i;
+}
+
+//解码一个非ASCII的UTF8字符，*pnUsed返回使用的字节数，非法序列返回KInvalidChar
+//非法序列按Unicode推荐的最大子序列处理：前导字节及其后合法的后续字节作为一个非法字符
+static unsigned int DecodeUtf8(const unsigned char *p,int nLen,int *pnUsed)
+{
+    unsigned char c = p[0];
+    unsigned int cp;
+    int nTrail;
+    unsigned char lo = 0x80, hi = 0xBF;
+    if(c>=0xC2 && c<=0xDF)
+    {
+        nTrail = 1;
+        cp = c & 0x1F;
+    }else if(c>=0xE0 && c<=0xEF)
+    {
+        nTrail = 2;
+        cp = c & 0x0F;
+        if(c==0xE0) lo = 0xA0;      //过长编码
+        else if(c==0xED) hi = 0x9F; //代理项
+    }else if(c>=0xF0 && c<=0xF4)
+    {
+        nTrail = 3;
+        cp = c & 0x07;
+        if(c==0xF0) lo = 0x90;      //过长编码
+        else if(c==0xF4) hi = 0x8F; //超过U+10FFFF
+    }else
+    {
+        *pnUsed = 1;
+        return KInvalidChar;
+    }
+
+    int i=1;
+    for(;i<=nTrail && i<nLen;i++)
+    {
+        if(p[i]<lo || p[i]>hi) break;
+        lo = 0x80;
+        hi = 0xBF;
+        cp = (cp<<6) | (p[i] & 0x3F);
+    }
+    *pnUsed = i;
+    return i==nTrail+1?cp:KInvalidChar;
+}
+
+int SStrCpCvt::Utf8ToUtf16(const char *pszSrc,int nSrcLen,wchar_t *pszDst,int nDstLen)
+{
+    if(nSrcLen<0) nSrcLen = (int)strlen(pszSrc)+1;
+    if(nDstLen==0) pszDst = NULL;
+
+    const unsigned char *p = (const unsigned char*)pszSrc;
+    int i=0, n=0;
+    while(i<nSrcLen)
+    {
+        if(p[i]<0x80)
+        {
+            int nAscii;
+            if(pszDst)
+            {
+                nAscii = WidenAscii(pszSrc+i,nSrcLen-i<nDstLen-n?nSrcLen-i:nDstLen-n,pszDst+n);
+                if(nAscii==0) goto overflow;
+            }else
+            {
+                nAscii = CountAscii(pszSrc+i,nSrcLen-i);
+            }
+            i += nAscii;
+            n += nAscii;
+            continue;
+        }
+
+        int nUsed;
+        unsigned int cp = DecodeUtf8(p+i,nSrcLen-i,&nUsed);
+        i += nUsed;
+        if(cp==KInvalidChar) cp = KReplacementChar;
+        int nUnits = cp>=0x10000?2:1;
+        if(pszDst)
+        {
+            if(n+nUnits>nDstLen) goto overflow;
+            if(nUnits==2)
+            {
+                cp -= 0x10000;
+                pszDst[n] = (wchar_t)(0xD800 + (cp>>10));
+                pszDst[n+1] = (wchar_t)(0xDC00 + (cp&0x3FF));
+            }else
+            {
+                pszDst[n] = (wchar_t)cp;
+            }
+        }
+        n += nUnits;
+    }
+    return n;
+
+overflow:
+    SetLastError(ERROR_INSUFFICIENT_BUFFER);
+    return 0;
+}
+
+int SStrCpCvt::Utf16ToUtf8(const wchar_t *pszSrc,int nSrcLen,char *pszDst,int nDstLen)
+{
+    if(nSrcLen<0) nSrcLen = (int)wcslen(pszSrc)+1;
+    if(nDstLen==0) pszDst = NULL;
+
+    int i=0, n=0;
+    while(i<nSrcLen)
+    {
+        if(pszSrc[i]<0x80)
+        {
+            int nAscii;
+            if(pszDst)
+            {
+                nAscii = NarrowAscii(pszSrc+i,nSrcLen-i<nDstLen-n?nSrcLen-i:nDstLen-n,pszDst+n);
+                if(nAscii==0) goto overflow;
+            }else
+            {
+                nAscii = CountAscii16(pszSrc+i,nSrcLen-i);
+            }
+            i += nAscii;
+            n += nAscii;
+            continue;
+        }
+
+        unsigned int cp = pszSrc[i++];
+        if(cp>=0xD800 && cp<=0xDFFF)
+        {
+            if(cp<=0xDBFF && i<nSrcLen && pszSrc[i]>=0xDC00 && pszSrc[i]<=0xDFFF)
+            {
+                cp = 0x10000 + ((cp-0xD800)<<10) + (pszSrc[i]-0xDC00);
+                i++;
+            }else
+            {//不成对的代理项
+                cp = KReplacementChar;
+            }
+        }
+
+        int nBytes = cp<0x800?2:(cp<0x10000?3:4);
+        if(pszDst)
+        {
+            if(n+nBytes>nDstLen) goto overflow;
+            char *pOut = pszDst+n;
+            switch(nBytes)
+            {
+            case 2:
+                pOut[0] = (char)(0xC0 | (cp>>6));
+                pOut[1] = (char)(0x80 | (cp&0x3F));
+                break;
+            case 3:
+                pOut[0] = (char)(0xE0 | (cp>>12));
+                pOut[1] = (char)(0x80 | ((cp>>6)&0x3F));
+                pOut[2] = (char)(0x80 | (cp&0x3F));
+                break;
+            default:
+                pOut[0] = (char)(0xF0 | (cp>>18));
+                pOut[1] = (char)(0x80 | ((cp>>12)&0x3F));
+                pOut[2] = (char)(0x80 | ((cp>>6)&0x3F));
+                pOut[3] = (char)(0x80 | (cp&0x3F));
+                break;
+            }
+        }
+        n += nBytes;
+    }
+    return n;
+
+overflow:
+    SetLastError(ERROR_INSUFFICIENT_BUFFER);
+    return 0;
+}
+
+bool SStrCpCvt::IsValidUtf8(const char *pszSrc,int nLen)
+{
+    if(nLen<0) nLen = (int)strlen(pszSrc);
+    const unsigned char *p = (const unsigned char*)pszSrc;
+    int i=0;
+    while(i<nLen)
+    {
+        i += CountAscii(pszSrc+i,nLen-i);
+        if(i==nLen) break;
+        int nUsed;
+        if(DecodeUtf8(p+i,nLen-i,&nUsed)==KInvalidChar) return false;
+        i += nUsed;
+    }
+    return true;
+}
+
+int SStrCpCvt::ConvertA2W(const char *pszSrc,int nSrcLen,wchar_t *pszDst,int nDstLen,unsigned int cp/*=CP_ACP*/)
+{
+    if(cp==CP_UTF8) return Utf8ToUtf16(pszSrc,nSrcLen,pszDst,nDstLen);
+    return MultiByteToWideChar(cp,0,pszSrc,nSrcLen,pszDst,nDstLen);
+}
+
+int SStrCpCvt::ConvertW2A(const wchar_t *pszSrc,int nSrcLen,char *pszDst,int nDstLen,unsigned int cp/*=CP_ACP*/)
+{
+    if(cp==CP_UTF8) return Utf16ToUtf8(pszSrc,nSrcLen,pszDst,nDstLen);
+    return WideCharToMultiByte(cp,0,pszSrc,nSrcLen,pszDst,nDstLen,NULL,NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 SStringW SStrCpCvt::CvtW2W( const SStringW &str,unsigned int)
 {
     return str;
@@ -19,6 +294,16 @@ SStringA SStrCpCvt::CvtA2A( const SStringA & str,unsigned int cpFrom/*=CP_UTF8*/
 SStringW SStrCpCvt::CvtA2W( const SStringA & str,unsigned int cp/*=CP_ACP*/,unsigned int cp2/*=0*/ )
 {
     UNREFERENCED_PARAMETER(cp2);
+    if(cp==CP_UTF8)
+    {//UTF16的字符数不会超过UTF8的字节数，直接转换到结果的缓冲区
+        SStringW strRet;
+        int nLen = str.GetLength();
+        if(nLen==0) return strRet;
+        wchar_t *pBuf = strRet.GetBufferSetLength(nLen);
+        int nRet = Utf8ToUtf16(str,nLen,pBuf,nLen);
+        strRet.ReleaseBuffer(nRet);
+        return strRet;
+    }
     wchar_t szBuf[1024];
     int nRet=MultiByteToWideChar(cp,0,str,str.GetLength(),szBuf,1024);
     if(nRet>0)
@@ -42,6 +327,16 @@ SStringW SStrCpCvt::CvtA2W( const SStringA & str,unsigned int cp/*=CP_ACP*/,unsi
 
 SStringA SStrCpCvt::CvtW2A( const SStringW & str,unsigned int cp/*=CP_ACP*/ )
 {
+    if(cp==CP_UTF8)
+    {
+        SStringA strRet;
+        int nLen = Utf16ToUtf8(str,str.GetLength(),NULL,0);
+        if(nLen==0) return strRet;
+        char *pBuf = strRet.GetBufferSetLength(nLen);
+        Utf16ToUtf8(str,str.GetLength(),pBuf,nLen);
+        strRet.ReleaseBuffer(nLen);
+        return strRet;
+    }
     char szBuf[1024];
     int nRet=WideCharToMultiByte(cp,0,str,str.GetLength(),szBuf,1024,NULL,NULL);
     if(nRet>0) return SStringA(szBuf,nRet);
@@ -13,6 +13,8 @@ namespace SOUI
     const void* _tstr_initPszNil = (const void*)(((unsigned char*)&_tstr_rgInitData) + sizeof(TStringData));
 
     HINSTANCE    _tstr_Instance = NULL;
+
+    UTILITIES_API TStringAllocStats _tstr_allocStats = { 0 };
     
     void UTILITIES_API InitLoadString(HINSTANCE hInst)
     {
@@ -27,6 +27,7 @@ else{
 HEADERS += include/gdialpha.h \
            include/souicoll.h \
            include/trace.h \
+           include/profiler.h \
            include/snew.h \
            include/utilities-def.h \
            include/utilities.h \
@@ -50,6 +51,7 @@ HEADERS += include/gdialpha.h \
            
 SOURCES += src/gdialpha.cpp \
            src/trace.cpp \
+           src/profiler.cpp \
            src/utilities.cpp \
            src/soui_mem_wrapper.cpp\
            src/pugixml/pugixml.cpp \